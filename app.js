@@ -10,11 +10,24 @@ app.use(express.json());
 const path = require("path");
 const fileUpload = require("express-fileupload");
 app.use(fileUpload());
-app.use(express.static(path.join(__dirname + "/uploads")));
+// .svgz files are gzip compressed SVG, browsers decompress them when told the encoding
+const isSVGFile = (name) => /\.svgz?$/i.test(name);
+const setSVGZHeaders = (res, filePath) => {
+	if (filePath.toLowerCase().endsWith(".svgz")) {
+		res.set("Content-Encoding", "gzip");
+		res.type("image/svg+xml");
+	}
+};
+app.use(
+	express.static(path.join(__dirname + "/uploads"), {
+		setHeaders: setSVGZHeaders,
+	})
+);
 
 // Minimization
 const fs2 = require("node:fs/promises");
 const fs = require("fs");
+const crypto = require("crypto");
 const JavaScriptObfuscator = require("javascript-obfuscator");
 const { add } = require("nodemon/lib/rules");
 const { create } = require("domain");
@@ -42,11 +55,74 @@ let lib = ffi.Library("./parser/libsvgparser", {
 		"bool",
 		["string", "string", "string", "string", "int", "int"],
 	],
+	setAttributeByIDWrapper: [
+		"bool",
+		["string", "string", "string", "string", "int"],
+	],
 	addComponentWrapper: ["bool", ["string", "string", "int", "string"]],
+	addShapesWrapper: ["bool", ["string", "string", "int", "string"]],
+	getElementsAtPointWrapper: ["string", ["string", "string", "float", "float"]],
+	getSVGBoundsWrapper: ["string", ["string", "string"]],
+	copySVGThumbnailWrapper: [
+		"int",
+		["string", "string", "int", "int", "pointer", "int"],
+	],
+	getSVGDataWrapper: ["string", ["string", "string"]],
+	getSVGDataCacheStatsWrapper: ["string", []],
+	getSVGETagWrapper: ["string", ["string"]],
+	queryCorpusWrapper: [
+		"string",
+		["string", "string", "string", "float", "float", "string"],
+	],
+	updateSearchIndex: ["int", ["string", "string"]],
+	searchSVGIndexWrapper: ["string", ["string", "string"]],
 	scaleShape: ["bool", ["string", "string", "int", "int"]],
 	createNewSVG: ["bool", ["string", "string", "string"]],
+	setParserStatsEnabled: ["void", ["bool"]],
+	getParserStats: ["string", []],
+	resetParserStats: ["void", []],
+	useAccountingAllocator: ["void", []],
+	beginSVGMemoryScope: ["void", ["string"]],
+	endSVGMemoryScope: ["void", []],
+	getSVGMemoryStats: ["string", []],
+	resetSVGMemoryStats: ["void", []],
+	setSVGMaxDepth: ["void", ["int"]],
 });
 
+// SVG_MEMORY_ACCOUNTING=on counts the memory used by every library call, served at /memoryStats.
+// The allocator has to be installed before the library allocates anything
+if (process.env.SVG_MEMORY_ACCOUNTING === "on") {
+	lib.useAccountingAllocator();
+	const untracked = ["beginSVGMemoryScope", "endSVGMemoryScope", "getSVGMemoryStats", "resetSVGMemoryStats"];
+	for (const name of Object.keys(lib).filter((name) => !untracked.includes(name))) {
+		const call = lib[name];
+		lib[name] = (...args) => {
+			lib.beginSVGMemoryScope(name);
+			try {
+				return call(...args);
+			} finally {
+				lib.endSVGMemoryScope();
+			}
+		};
+		// Scopes count the calling thread, so calls made with .async on a worker thread are not counted
+		lib[name].async = call.async;
+	}
+}
+
+// Per phase parser timings, served at /parserStats.  PARSER_STATS=off skips the clock reads
+lib.setParserStatsEnabled(process.env.PARSER_STATS !== "off");
+
+// SVG_MAX_DEPTH rejects uploads nested more deeply than the library's default of 256 elements, or accepts deeper ones
+if (process.env.SVG_MAX_DEPTH) lib.setSVGMaxDepth(parseInt(process.env.SVG_MAX_DEPTH, 10) || 0);
+
+// Index of uploads/ served at /search.  Only files added or changed since the last run are parsed, and the
+// library keeps the index up to date as it writes files
+lib.updateSearchIndex("./uploads", "./parser/xsd/svg.xsd");
+
+// Listing ETag of uploads/ when the search index was last brought up to date.  Files only need indexing again
+// once the listing differs from it
+let indexedListing = null;
+
 /* ~~~~~ Given Routes (Leave Alone) ~~~~~ */
 
 // Send HTML at root, do not change
@@ -83,7 +159,7 @@ app.post("/upload", async (req, res) => {
 	}
 	let uploadFile = req.files.uploadFile;
 
-	if (!uploadFile.name.toLowerCase().endsWith(".svg")) {
+	if (!isSVGFile(uploadFile.name)) {
 		return res.status(406).send("Not an SVG File, please try again");
 	}
 
@@ -105,7 +181,11 @@ app.post("/upload", async (req, res) => {
 app.get("/uploads/:name", function (req, res) {
 	fs.stat("uploads/" + req.params.name, function (err, stat) {
 		if (err == null) {
-			res.sendFile(path.join(__dirname + "/uploads/" + req.params.name));
+			res.sendFile(path.join(__dirname + "/uploads/" + req.params.name), {
+				headers: req.params.name.toLowerCase().endsWith(".svgz")
+					? { "Content-Encoding": "gzip", "Content-Type": "image/svg+xml" }
+					: {},
+			});
 		} else {
 			console.log("Error in file downloading route: " + err);
 			res.send("");
@@ -117,9 +197,37 @@ app.get("/uploads/:name", function (req, res) {
 
 app.get("/load", async (req, res) => {
 	const result = await fs2.readdir(path.join(".", "uploads"));
-	const filedata = result.filter((file) => file.endsWith(".svg"));
+	const filedata = result.filter(isSVGFile);
 	const data = [];
 
+	// The listing only changes when a file is added, removed or changed, so its ETag
+	// combines the content hash and stats of every file
+	const listingHash = crypto.createHash("sha1");
+	filedata.forEach((file) => {
+		const { size, mtimeMs } = fs.statSync(`uploads/${file}`);
+		const etag = lib.getSVGETagWrapper(`./uploads/${file}`);
+		listingHash.update(`${file}:${etag}:${size}:${mtimeMs}\n`);
+	});
+	const listing = listingHash.digest("hex");
+
+	// Files were added, removed or changed since the index was last updated, possibly outside the library's writes.
+	// Only changed files are parsed, on a worker thread
+	if (listing !== indexedListing) {
+		indexedListing = listing;
+		lib.updateSearchIndex.async("./uploads", "./parser/xsd/svg.xsd", (err, numFiles) => {
+			if (err || numFiles < 0) {
+				console.log("Error updating the search index: " + (err || numFiles));
+				indexedListing = null;
+			}
+		});
+	}
+
+	res.set("ETag", `"${listing}"`);
+	res.set("Cache-Control", "no-cache");
+	if (req.fresh) {
+		return res.status(304).end();
+	}
+
 	filedata.forEach(async (file, i) => {
 		const stats = fs.statSync(`uploads/${file}`);
 		const isValidFile = lib.validateSVGWrapper(
@@ -164,99 +272,170 @@ app.get("/load", async (req, res) => {
 
 app.get("/getUploadedFiles", async (req, res) => {
 	const result = await fs2.readdir(path.join(".", "uploads"));
-	const filedata = result.filter((file) => file.endsWith(".svg"));
+	const filedata = result.filter(isSVGFile);
 	res.json(filedata);
 });
 
 app.get("/getSVGData/:name", async (req, res) => {
 	const file = req.params.name;
 
-	const isValidFile = lib.validateSVGWrapper(
+	// The ETag is the content hash of the file, answered without parsing it
+	const etag = lib.getSVGETagWrapper(`./uploads/${file}`);
+	if (etag !== "") {
+		res.set("ETag", etag);
+		res.set("Cache-Control", "no-cache");
+		if (req.fresh) {
+			return res.status(304).end();
+		}
+	}
+
+	// The library caches the response until the file changes, {} if the file is not valid
+	const json = lib.getSVGDataWrapper(
 		`./uploads/${file}`,
 		"./parser/xsd/svg.xsd"
 	);
+	res.type("json").send(json);
+});
 
-	let data = {};
-
-	if (!isValidFile) {
-		console.log("not a valid svg file");
+// Bounding boxes of the file and its top level components.  The library keeps them until the file changes
+app.get("/getBounds/:name", async (req, res) => {
+	const json = lib.getSVGBoundsWrapper(
+		`./uploads/${req.params.name}`,
+		"./parser/xsd/svg.xsd"
+	);
+	if (json === null) {
+		res.status(404).send("Invalid file");
 	} else {
-		const titleANDdesc = lib.getSVGTitleAndDesc(
-			`./uploads/${file}`,
-			"./parser/xsd/svg.xsd"
-		);
-		const [title, desc] = titleANDdesc.split(":");
+		res.type("json").send(json);
+	}
+});
 
-		const rectangles = JSON.parse(
-			lib.getSVGRects(`./uploads/${file}`, "./parser/xsd/svg.xsd")
-		);
+// IDs of the rectangles and circles containing a point, e.g. /elementsAtPoint/quad01.svg?x=10&y=20.  The library
+// keeps the struct and its spatial index until the file changes
+app.get("/elementsAtPoint/:name", async (req, res) => {
+	const x = parseFloat(req.query.x);
+	const y = parseFloat(req.query.y);
+	if (!Number.isFinite(x) || !Number.isFinite(y)) {
+		res.status(400).send("Expected a point as x and y");
+		return;
+	}
 
-		const circles = JSON.parse(
-			lib.getSVGCircs(`./uploads/${file}`, "./parser/xsd/svg.xsd")
-		);
-		const paths = JSON.parse(
-			lib.getSVGPaths(`./uploads/${file}`, "./parser/xsd/svg.xsd")
-		);
-		const groups = JSON.parse(
-			lib.getSVGGroups(`./uploads/${file}`, "./parser/xsd/svg.xsd")
-		);
+	const json = lib.getElementsAtPointWrapper(
+		`./uploads/${req.params.name}`,
+		"./parser/xsd/svg.xsd",
+		x,
+		y
+	);
+	if (json === null) {
+		res.status(404).send("Invalid file");
+	} else {
+		res.type("json").send(json);
+	}
+});
 
-		data = {
-			valid: true,
-			title: title,
-			desc: desc,
-			rectangles,
-			circles,
-			paths,
-			groups,
-		};
+// Size thumbnails are drawn at when the request does not give one, and the largest they may be drawn at
+const THUMBNAIL_SIZE = 200;
+const MAX_THUMBNAIL_SIZE = 512;
+
+// PNG thumbnail of a file at most w by h pixels, e.g. /thumbnail/quad01.svg?w=200&h=200.  The library caches
+// it until the file changes.  It is drawn on the library's threads, so the cold thumbnails of a listing do not
+// hold up other requests
+app.get("/thumbnail/:name", async (req, res) => {
+	const file = `./uploads/${req.params.name}`;
+	const schemaFile = "./parser/xsd/svg.xsd";
+	const size = (value) =>
+		Math.min(Math.max(parseInt(value, 10) || THUMBNAIL_SIZE, 1), MAX_THUMBNAIL_SIZE);
+	const width = size(req.query.w);
+	const height = size(req.query.h);
+
+	// The thumbnail changes with the file and the size it is drawn at
+	const etag = lib.getSVGETagWrapper(file);
+	if (etag !== "") {
+		res.set("ETag", `${etag.slice(0, -1)}-${width}x${height}"`);
+		res.set("Cache-Control", "no-cache");
+		if (req.fresh) {
+			return res.status(304).end();
+		}
+	}
 
-		// Get other attributes for all circles in component
-		const rectOtherAttr = lib.getRectOtherAttributes(
-			`./uploads/${file}`,
-			"./parser/xsd/svg.xsd"
-		);
-		const rectOtherAttributes = rectOtherAttr.split("|");
-		rectOtherAttributes.pop();
+	const send = (err, buffer, length) => {
+		if (err || length < 0) {
+			res.status(404).send("Invalid file");
+		} else if (length > buffer.length) {
+			// The file changed to a larger thumbnail between the two calls
+			res.status(503).send("Thumbnail changed, try again");
+		} else {
+			res.type("png").send(buffer.subarray(0, length));
+		}
+	};
 
-		// Get other attributes for all rectangles in component
-		const circOtherAttr = lib.getCircOtherAttributes(
-			`./uploads/${file}`,
-			"./parser/xsd/svg.xsd"
+	// The length of the PNG is returned even when it does not fit, so a larger buffer can be passed
+	const buffer = Buffer.alloc(65536);
+	lib.copySVGThumbnailWrapper.async(file, schemaFile, width, height, buffer, buffer.length, (err, length) => {
+		if (err || length <= buffer.length) {
+			return send(err, buffer, length);
+		}
+		const larger = Buffer.alloc(length);
+		lib.copySVGThumbnailWrapper.async(file, schemaFile, width, height, larger, larger.length, (err, length) =>
+			send(err, larger, length)
 		);
-		const circOtherAttributes = circOtherAttr.split("|");
-		circOtherAttributes.pop();
+	});
+});
 
-		// Get other attributes for all paths in component
-		const pathOtherAttr = lib.getPathOtherAttributes(
-			`./uploads/${file}`,
-			"./parser/xsd/svg.xsd"
-		);
-		const pathOtherAttributes = pathOtherAttr.split("|");
-		pathOtherAttributes.pop();
+// Files in uploads/ with matching elements, e.g. /corpusQuery?type=circleArea&min=10&max=50.
+// The query runs on the library's threads, off the event loop
+app.get("/corpusQuery", async (req, res) => {
+	const { type, text = "" } = req.query;
+	const min = parseFloat(req.query.min ?? 0);
+	const max = parseFloat(req.query.max ?? min);
 
-		// Get other attributes for all groups in component
-		const groupOtherAttr = lib.getGroupOtherAttributes(
-			`./uploads/${file}`,
-			"./parser/xsd/svg.xsd"
-		);
-		const groupOtherAttributes = groupOtherAttr.split("|");
-		groupOtherAttributes.pop();
+	lib.queryCorpusWrapper.async(
+		"./uploads",
+		"./parser/xsd/svg.xsd",
+		String(type),
+		min,
+		max,
+		String(text),
+		function (err, json) {
+			if (err || json === null) {
+				res.status(400).send("Invalid corpus query");
+			} else {
+				res.type("json").send(json);
+			}
+		}
+	);
+});
 
-		data.rectangles.forEach((item, i) => {
-			item.otherAttributes = rectOtherAttributes[i];
-		});
-		data.circles.forEach((item, i) => {
-			item.otherAttributes = circOtherAttributes[i];
-		});
-		data.paths.forEach((item, i) => {
-			item.otherAttributes = pathOtherAttributes[i];
-		});
-		data.groups.forEach((item, i) => {
-			item.otherAttributes = groupOtherAttributes[i];
-		});
+// Files in uploads/ matching every term, e.g. /search?q=type:circle title:sun*
+app.get("/search", async (req, res) => {
+	const json = lib.searchSVGIndexWrapper("./uploads", String(req.query.q ?? ""));
+	if (json === null) {
+		res.status(400).send("Invalid search");
+	} else {
+		res.type("json").send(json);
 	}
-	res.send(data);
+});
+
+app.get("/cacheStats", async (req, res) => {
+	res.type("json").send(lib.getSVGDataCacheStatsWrapper());
+});
+
+app.get("/parserStats", async (req, res) => {
+	res.type("json").send(lib.getParserStats());
+});
+
+app.delete("/parserStats", async (req, res) => {
+	lib.resetParserStats();
+	res.sendStatus(204);
+});
+
+app.get("/memoryStats", async (req, res) => {
+	res.type("json").send(lib.getSVGMemoryStats());
+});
+
+app.delete("/memoryStats", async (req, res) => {
+	lib.resetSVGMemoryStats();
+	res.sendStatus(204);
 });
 
 app.post("/setAttribute", async (req, res) => {
@@ -299,6 +478,41 @@ app.post("/setAttribute", async (req, res) => {
 	}
 });
 
+// Sets an attribute of any element by its ID, including shapes inside groups.  IDs follow document order: top
+// level rectangles, circles and paths, then each group followed by its contents
+app.post("/setAttributeByID", async (req, res) => {
+	let { file, id, name, value } = req.body;
+
+	if (!Number.isInteger(id) || id < 0) {
+		res.status(400).send("Expected an element ID");
+		return;
+	}
+	if (typeof name !== "string" || typeof value !== "string") {
+		res.status(400).send("Expected an attribute name and value");
+		return;
+	}
+
+	if (name === "w") name = "width";
+	if (name === "h") name = "height";
+
+	const isSuccess = lib.setAttributeByIDWrapper(
+		`./uploads/${file}`,
+		"./parser/xsd/svg.xsd",
+		name,
+		value,
+		id
+	);
+
+	if (!isSuccess) {
+		res.status(406).send(
+			`Invalid name: ${name} or value ${value} while setting attribute of element ${id}`
+		);
+	} else {
+		const data = { file, id, name, value, isSuccess };
+		res.status(200).json(data);
+	}
+});
+
 app.post("/addShape", async (req, res) => {
 	let { file, shape } = req.body;
 
@@ -330,6 +544,40 @@ app.post("/addShape", async (req, res) => {
 	}
 });
 
+app.post("/addShapes", async (req, res) => {
+	let { file, shapes, groupID } = req.body;
+
+	const isObject = (shape) => typeof shape === "object" && shape !== null && !Array.isArray(shape);
+	if (!Array.isArray(shapes) || !shapes.every(isObject)) {
+		res.status(400).send("Expected an array of shapes");
+		return;
+	}
+
+	// -1 adds the shapes to the top level of the image
+	if (groupID === undefined) groupID = -1;
+	if (!Number.isInteger(groupID) || groupID < -1 || groupID > 2147483647) {
+		res.status(400).send("Expected a group ID, or -1 for the top level");
+		return;
+	}
+
+	for (const shape of shapes) {
+		if (shape.units === "none") shape.units = "";
+	}
+
+	let isSuccess = lib.addShapesWrapper(
+		`./uploads/${file}`,
+		"./parser/xsd/svg.xsd",
+		groupID,
+		JSON.stringify(shapes)
+	);
+	if (!isSuccess) {
+		res.status(406).send(`Error adding shapes to ${file}, try again.`);
+	} else {
+		const data = { file, numShapes: shapes.length };
+		res.status(200).json(data);
+	}
+});
+
 app.post("/scaleShape", async (req, res) => {
 	const { file, shape, scaleVal } = req.body;
 	let elementType = -1;
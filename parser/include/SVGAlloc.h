@@ -0,0 +1,62 @@
+/**
+ * @file SVGAlloc.h
+ * @author Anthony Vidovic (1130891)
+ * @brief Header file for the allocator the parser library allocates and frees all of its memory with
+ * @version 0.1
+ * @date 2022-04-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef SVGALLOC_H
+#define SVGALLOC_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+//Functions the library allocates, resizes and frees memory with.  They behave like malloc, realloc and free
+typedef struct {
+    void* (*malloc)(size_t size);
+    void* (*realloc)(void* ptr, size_t size);
+    void (*free)(void* ptr);
+} SVGAllocator;
+
+/** Function to replacing the allocator of the library.  Every struct, list and string returned by the library is
+ * allocated with it, and must be freed with svgFree (or deleteSVG, freeList, ...) rather than free
+ *@pre Nothing allocated by the previous allocator is still in use
+ *@post The library allocates with the given functions
+ *@param allocator - the functions to use, or NULL for malloc, realloc and free
+ **/
+void setSVGAllocator(const SVGAllocator* allocator);
+
+/** Function to installing the accounting allocator, which counts live bytes, peak bytes and allocations for
+ * getSVGMemoryStats.  libxml2 is set to allocate through it too, so the counts include parsed documents
+ *@pre No other function of the library or of libxml2 has been called
+ *@post The library and libxml2 allocate with the accounting allocator
+ **/
+void useAccountingAllocator(void);
+
+// Functions that allocate and free memory with the current allocator
+void* svgMalloc(size_t size);
+void* svgCalloc(size_t count, size_t size);
+void* svgRealloc(void* ptr, size_t size);
+void svgFree(void* ptr);
+
+/** Functions to attributing memory use to a top level call.  Every allocation and free made by the calling thread
+ * between beginSVGMemoryScope and endSVGMemoryScope is counted against the name, including those of scopes nested in it.
+ * Scopes are ignored unless the accounting allocator is installed
+ **/
+void beginSVGMemoryScope(const char* name);
+void endSVGMemoryScope(void);
+
+/** Function to returning the counts of the accounting allocator as a newly allocated JSON string - live and peak
+ * bytes and allocations overall, and per scope name the number of calls, allocations and bytes allocated per call,
+ * the largest peak above the memory in use when a call began, and the bytes calls left allocated
+ **/
+char* getSVGMemoryStats(void);
+
+// Function that sets the counts of every scope back to zero, and the peak back to the bytes in use
+void resetSVGMemoryStats(void);
+
+#endif
@@ -14,10 +14,13 @@
 
 // ~~~~~ Includes ~~~~~ //
 #include <stdlib.h>
+#include <stdint.h>
 #include "SVGParser.h"
 #include <ctype.h>
 #include <strings.h>
 #include <math.h>
+#include <zlib.h>
+#include <sys/stat.h>
 
 #ifndef M_PI
     #define M_PI 3.14159265358979323846
@@ -28,16 +31,18 @@
 /* ----------------------- */
 
 // ~~~~~ Helper Prototypes for module 1 ~~~~~ //
-void addElementsToSVG(SVG* svg, xmlNode* a_node);
-char *removeAllExceptDigits(char *string);
-char *prependChar(char before, char *str);
-char *checkForUnits(char *string);
-void iterateGroup(xmlNode* a_node, Group *g);
+bool addElementsToSVG(SVG* svg, xmlNode* a_node);
+bool parseLength(const char *str, float *value, lengthUnit *unit);
+const char *lengthUnitName(lengthUnit unit);
+lengthUnit lengthUnitFromName(const char *name);
+void setLengthField(const char *attrValue, float *field, lengthUnit *units);
+bool iterateGroup(xmlNode* a_node, Group *g);
 Attribute *newAttribute(xmlAttr* attribute);
 Rectangle* createRectangle(xmlNode* cur_node, xmlAttr* attribute);
 Circle* createCircle(xmlNode* cur_node, xmlAttr* attribute);
 Path* createPath(xmlNode* cur_node, xmlAttr* attribute);
 Group* createGroup(xmlNode* cur_node, xmlAttr* attribute);
+SVG* svgFromDoc(xmlDoc *doc);
 
 // ~~~~~ Helper Prototypes for module 2 ~~~~~ //
 void findRectanglesInGroup(List *group, List *rectangles);
@@ -60,7 +65,6 @@ void addRectanglesToParent(xmlNodePtr node, List *rectangles);
 void addCirclesToParent(xmlNodePtr node, List *circles);
 void addPathsToParent(xmlNodePtr node, List *paths);
 void addGroupsToParent(xmlNodePtr node, List *groups);
-char* removeDigitsFromStr(char *stringToStrip);
 bool extensionMatches(const char *fileName, char *extension);
 bool isValidRectangles(List *rectangles);
 bool isValidCircles(List *circles);
@@ -68,13 +72,17 @@ bool isValidPaths(List *paths);
 bool isValidGroups(List *groups);
 bool isValidAttributes(List *attributes);
 int validateAgainstXSD(xmlDoc *doc, const char *schemaFile);
+xmlSchemaPtr compileSchema(const char *schemaFile);
+int validateWithSchema(xmlDoc *doc, xmlSchemaPtr schema);
 bool updateAttribute(Attribute*attr, List *otherAttributes);
+bool setCircleAttribute(SVG *img, Circle *circle, Attribute *newAttribute);
+bool setRectAttribute(SVG *img, Rectangle *rect, Attribute *newAttribute);
+bool setPathAttribute(SVG *img, Node *pathNode, Attribute *newAttribute);
+bool setGroupAttribute(SVG *img, Group *group, Attribute *newAttribute);
 Circle* getCirleAtPos(List *circles, int pos);
 Rectangle* getRectAtPos(List *rectangles, int pos);
 Path* getPathAtPos(List *paths, int pos);
 Group* getGroupAtPos(List *groups, int pos);
-char *extractValue(char *key, const char *string);
-char *extractIntValue(char *key, const char *string);
 
 /* ----------------------- */
 /* Assignment 3 Prototypes */
@@ -92,10 +100,394 @@ char *getCircOtherAttributes(char *filename, char *schemaFile);
 char *getPathOtherAttributes(char *filename, char *schemaFile);
 char *getGroupOtherAttributes(char *filename, char *schemaFile);
 bool setAttributeWrapper(char *filename, char *schemaFile, char *name, char *value, int index, int elementType);
+bool setAttributeByIDWrapper(char *filename, char *schemaFile, char *name, char *value, int id);
 bool addComponentWrapper(char *filename ,char *schemaFile, int elementType, char *json);
+bool addShapesWrapper(char *filename, char *schemaFile, int groupID, char *json);
 bool scaleShape(char *filename, char *schemaFile, int elementType, int scaleVal);
 void scaleRectsInGroups(int scaleVal, List *groups);
 void scaleCircsInGroups(int scaleVal, List *groups);
 bool createNewSVG(char *filename, char *schemaFile, char *json);
 
+/* ----------------------- */
+/* Element Index Prototypes */
+/* ----------------------- */
+void initSVGCaches(SVG *svg);
+void freeSVGCaches(SVG *svg);
+void invalidateViews(SVG *svg);
+void markSVGModified(SVG *svg);
+void initElementTable(SVG *svg);
+bool buildElementTable(SVG *svg);
+bool addGroupToElementTable(SVG *svg, Group *g);
+bool reserveElements(SVG *svg, int count);
+bool registerElement(SVG *svg, elementType type, Node *node);
+void computeSVGTotals(const SVG *svg, SVGTotals *totals);
+double rectAreaKey(const Rectangle *rect);
+double circleAreaKey(const Circle *circle);
+AreaIndex* getRectAreaIndex(const SVG *svg);
+AreaIndex* getCircleAreaIndex(const SVG *svg);
+void freeAreaIndex(AreaIndex *index);
+void invalidateAreaIndexes(SVG *svg);
+void insertAreaKey(AreaIndex *index, double key);
+void replaceAreaKey(AreaIndex *index, double oldKey, double newKey);
+int countAreaKeys(const AreaIndex *index, double minKey, double maxKey);
+bool checkSVGTotals(const SVG *svg);
+
+/* ----------------------- */
+/* Number Conversion Prototypes */
+/* ----------------------- */
+// Large enough for any string written by formatFloat
+#define FLOAT_STRING_SIZE 32
+float parseFloat(const char *str, const char **end);
+int formatFloat(float value, char *buffer);
+int formatFloatFixed(float value, int decimals, char *buffer);
+
+/* ----------------------- */
+/* JSON Prototypes */
+/* ----------------------- */
+typedef enum {
+    JSON_OBJECT, JSON_ARRAY, JSON_STRING, JSON_NUMBER, JSON_TRUE, JSON_FALSE, JSON_NULL
+} jsonType;
+
+// A value, or an object key, of a JSON document.  Offsets point into the JSON string
+typedef struct {
+    jsonType type;
+    // Offset of the first character, and one past the last character, including quotes and brackets
+    int start;
+    int end;
+    // Number of values in an object or array, 0 otherwise
+    int size;
+    // Index of the enclosing object or array, -1 for the root
+    int parent;
+    // Index of the first token after this value and everything nested in it
+    int next;
+} JsonToken;
+
+// Tokens of a JSON document in document order.  An object's tokens alternate key, value
+typedef struct {
+    const char *json;
+    JsonToken *tokens;
+    int numTokens;
+    int capacity;
+} JsonDocument;
+
+bool parseJSON(const char *json, JsonDocument *doc);
+void freeJSON(JsonDocument *doc);
+int jsonObjectGet(const JsonDocument *doc, int object, const char *key);
+int jsonGetString(const JsonDocument *doc, int token, char *buffer, size_t size);
+Rectangle* rectFromJSON(const JsonDocument *doc, int object);
+Circle* circleFromJSON(const JsonDocument *doc, int object);
+Path* pathFromJSON(const JsonDocument *doc, int object);
+
+/* ----------------------- */
+/* Spatial Index Prototypes */
+/* ----------------------- */
+SpatialIndex* getSpatialIndex(const SVG *svg);
+void freeSpatialIndex(SpatialIndex *index);
+void invalidateSpatialIndex(SVG *svg);
+char *getElementsAtPointWrapper(char *filename, char *schemaFile, float x, float y);
+
+/* ----------------------- */
+/* Writer Prototypes */
+/* ----------------------- */
+bool serializeSVG(const SVG *svg, const char *fileName, const SVGWriteOptions *options);
+
+/* ----------------------- */
+/* Compression Prototypes */
+/* ----------------------- */
+bool isSVGFileName(const char *fileName);
+bool isCompressedFileName(const char *fileName);
+xmlDoc* readSVGDoc(const char *fileName);
+
+/* ----------------------- */
+/* File Cache Prototypes */
+/* ----------------------- */
+// Counters of the cache of /getSVGData responses and thumbnails
+typedef struct {
+    unsigned long hits;
+    unsigned long misses;
+    // Entries dropped to stay within the limit
+    unsigned long evictions;
+    int entries;
+    // Combined size of the cached responses and thumbnails, and the most they may use
+    size_t bytes;
+    size_t limit;
+} SVGCacheStats;
+
+// Growable string a response is built in
+typedef struct {
+    char *data;
+    size_t length;
+    size_t capacity;
+    // Set once an allocation fails, after which appends are skipped and the contents are incomplete
+    bool failed;
+} StringBuffer;
+
+bool initStringBuffer(StringBuffer *buffer, size_t capacity);
+bool appendBytes(StringBuffer *buffer, const char *str, size_t length);
+bool appendString(StringBuffer *buffer, const char *str);
+bool appendJSONString(StringBuffer *buffer, const char *str);
+const char* getCachedSVGData(const char *filename, const char *schemaFile, size_t *length);
+void invalidateCachedSVGData(const char *filename);
+void setSVGDataCacheLimit(size_t bytes);
+SVGCacheStats getSVGDataCacheStats(void);
+// Hash of an empty file, updateSVGFileHash continues from it
+#define SVG_HASH_SEED 0xcbf29ce484222325ULL
+
+bool getSVGFileHash(const char *filename, uint64_t *hash);
+uint64_t updateSVGFileHash(uint64_t hash, const void *bytes, size_t length);
+void recordSVGFileHash(const char *filename, uint64_t hash);
+const char *getSVGDataWrapper(char *filename, char *schemaFile);
+const char *getSVGETagWrapper(char *filename);
+const unsigned char* getCachedSVGThumbnail(const char *filename, const char *schemaFile, int maxWidth, int maxHeight,
+                                           size_t *length);
+int copySVGThumbnailWrapper(char *filename, char *schemaFile, int maxWidth, int maxHeight, unsigned char *buffer,
+                            int capacity);
+char *getSVGDataCacheStatsWrapper(void);
+
+/* ----------------------- */
+/* Corpus Query Prototypes */
+/* ----------------------- */
+// Questions queryCorpus asks of every file
+typedef enum {
+    // Rectangles or circles with an area from minValue to maxValue, rounded up as numRectsInAreaRange does
+    CORPUS_RECT_AREA,
+    CORPUS_CIRCLE_AREA,
+    // Paths whose data is text
+    CORPUS_PATH_DATA,
+    // Groups holding minValue elements
+    CORPUS_GROUP_LEN
+} corpusQueryType;
+
+typedef struct {
+    corpusQueryType type;
+    float minValue;
+    float maxValue;
+    const char *text;
+    // Files that are not valid against it are skipped.  NULL to only parse the files
+    const char *schemaFile;
+    // Worker threads, 0 for one per online core
+    int threads;
+} SVGCorpusQuery;
+
+// Receives each file with a match, named within the directory queried
+typedef void (*SVGCorpusCallback)(const char *fileName, int matches, void *context);
+
+// An svg file found in a directory
+typedef struct {
+    char *path;
+    // Name of the file within the directory
+    const char *name;
+    struct stat info;
+} CorpusFile;
+
+int queryCorpus(const char *directory, const SVGCorpusQuery *query, SVGCorpusCallback callback, void *context);
+void invalidateCorpusFile(const char *filename);
+void setCorpusCacheLimit(long elements);
+CorpusFile* listCorpusFiles(const char *directory, int *numFiles);
+void freeCorpusFiles(CorpusFile *files, int numFiles);
+bool useCachedSVG(const char *fileName, const char *schemaFile, void (*use)(SVG *svg, void *context), void *context);
+char *queryCorpusWrapper(char *directory, char *schemaFile, char *type, float minValue, float maxValue, char *text);
+
+/* ----------------------- */
+/* Search Index Prototypes */
+/* ----------------------- */
+// Receives each file a search finds, named within the directory searched, with its title and description
+typedef void (*SVGSearchCallback)(const char *fileName, const char *title, const char *description, void *context);
+
+int updateSearchIndex(const char *directory, const char *schemaFile);
+void indexWrittenSVG(const SVG *svg, const char *fileName);
+int searchSVGIndex(const char *directory, const char *query, SVGSearchCallback callback, void *context);
+char *searchSVGIndexWrapper(char *directory, char *query);
+
+/* ----------------------- */
+/* Path Data Prototypes */
+/* ----------------------- */
+typedef enum { PATH_MOVE, PATH_LINE, PATH_CUBIC, PATH_ARC } pathSegmentType;
+
+// What one command of path data draws, in absolute coordinates
+typedef struct {
+    pathSegmentType type;
+    // Start at index 0 and end at index 3.  Indexes 1 and 2 hold the control points of a cubic curve, and repeat
+    // the start and end of a line.  A move has only its end
+    double x[4];
+    double y[4];
+    // Arc parameters, as the arc command gives them
+    double rx;
+    double ry;
+    double rotation;
+    bool largeArc;
+    bool sweep;
+    // Set on the line a close path draws back to the start of its subpath
+    bool closes;
+} PathSegment;
+
+// Ellipse an arc segment is drawn on.  The arc is swept from start through delta radians, negative if clockwise
+typedef struct {
+    double cx;
+    double cy;
+    double rx;
+    double ry;
+    double cosPhi;
+    double sinPhi;
+    double start;
+    double delta;
+} ArcCenter;
+
+typedef void (*PathSegmentCallback)(const PathSegment *segment, void *context);
+
+bool walkPathData(const char *data, PathSegmentCallback callback, void *context);
+bool getArcCenter(const PathSegment *arc, ArcCenter *center);
+void arcPoint(const ArcCenter *center, double angle, double *x, double *y);
+
+/* ----------------------- */
+/* Bounds Prototypes */
+/* ----------------------- */
+bool getPathBounds(const char *data, BoundingBox *box);
+void freeBoundsCache(BoundsCache *cache);
+void invalidateBounds(SVG *svg);
+char *getSVGBoundsWrapper(char *filename, char *schemaFile);
+
+/* ----------------------- */
+/* Raster Prototypes */
+/* ----------------------- */
+unsigned char* rasterizeSVG(const SVG *svg, int maxWidth, int maxHeight, int *width, int *height);
+unsigned char* encodePNG(const unsigned char *rgba, int width, int height, size_t *length);
+
+/* ----------------------- */
+/* Statistics Prototypes */
+/* ----------------------- */
+// Phases timed and counted for getParserStats
+typedef enum {
+    // Reading and parsing a file into an xmlDoc
+    STAT_READ,
+    // Compiling an XSD schema
+    STAT_SCHEMA_COMPILE,
+    // Validating an xmlDoc against a compiled schema
+    STAT_VALIDATE,
+    // Building an svg struct from an xmlDoc
+    STAT_BUILD,
+    // Building an xmlDoc from an svg struct
+    STAT_DOM,
+    // Serializing components as JSON
+    STAT_JSON,
+    // Writing an svg struct to a file
+    STAT_WRITE,
+    STAT_NUM_PHASES
+} statPhase;
+
+// Start of a timed phase
+typedef struct {
+    // Monotonic clock in nanoseconds, 0 if stats are disabled
+    uint64_t ns;
+    // Allocations made on the thread before the phase
+    unsigned long long allocations;
+} PhaseTimer;
+
+PhaseTimer startPhase(void);
+void endPhase(statPhase phase, const PhaseTimer *timer, size_t bytes, size_t elements);
+
+/* ----------------------- */
+/* Allocator Prototypes */
+/* ----------------------- */
+unsigned long long threadAllocationCount(void);
+
+/* ----------------------- */
+/* Traversal Prototypes */
+/* ----------------------- */
+// Walk over nested groups in document order, kept on a heap allocated stack so that nesting depth is limited
+// by memory rather than by the call stack
+typedef struct {
+    // Next node to visit in each list being walked, [0] in the list the walk began with
+    Node **cursors;
+    int depth;
+    int capacity;
+    // Node of the group returned last, whose nested groups the next call walks into
+    Node *current;
+    // Set if the stack could not grow, which ends the walk early
+    bool failed;
+} GroupWalk;
+
+// Types of element a visitor is called for, combined with |
+#define VISIT_RECTS (1 << RECT)
+#define VISIT_CIRCLES (1 << CIRC)
+#define VISIT_PATHS (1 << PATH)
+#define VISIT_GROUPS (1 << GROUP)
+#define VISIT_SHAPES (VISIT_RECTS | VISIT_CIRCLES | VISIT_PATHS)
+#define VISIT_ALL (VISIT_SHAPES | VISIT_GROUPS)
+
+// Element passed to the visitors of a walk
+typedef struct {
+    elementType type;
+    // The Rectangle, Circle, Path or Group
+    void *data;
+    // Group holding the element, NULL for the top level
+    Group *parent;
+    // Nesting level, 1 for the top level
+    int depth;
+} VisitedElement;
+
+// Callbacks run by visitSVG and visitGroups on the elements of the types in the mask that the predicate accepts.
+// Lists that no visitor wants are never iterated, and groups are not walked into below the deepest maxDepth
+typedef struct {
+    int types;
+    // Deepest level visited, 0 for every level
+    int maxDepth;
+    // NULL accepts every element
+    bool (*matches)(const VisitedElement *element, const void *arg);
+    const void *arg;
+    void (*visit)(const VisitedElement *element, void *context);
+    void *context;
+} SVGVisitor;
+
+// Most visitors a single walk runs
+#define MAX_WALK_VISITORS 16
+
+void* growStack(void *items, int *capacity, size_t itemSize);
+void beginGroupWalk(GroupWalk *walk, const List *groups);
+Group* nextGroup(GroupWalk *walk);
+void skipNestedGroups(GroupWalk *walk);
+void endGroupWalk(GroupWalk *walk);
+bool visitSVG(const SVG *svg, const SVGVisitor *visitors, int numVisitors);
+bool visitGroups(const List *groups, const SVGVisitor *visitors, int numVisitors);
+void appendElement(const VisitedElement *element, void *list);
+void countElement(const VisitedElement *element, void *count);
+List* otherAttributesOf(const VisitedElement *element);
+bool rectHasArea(const VisitedElement *element, const void *area);
+bool circleHasArea(const VisitedElement *element, const void *area);
+bool pathHasData(const VisitedElement *element, const void *data);
+bool groupHasLength(const VisitedElement *element, const void *len);
+void countOtherAttributes(const VisitedElement *element, void *found);
+
+/* ----------------------- */
+/* Generator Prototypes */
+/* ----------------------- */
+// Most attributes generateSVG gives an element
+#define GENERATOR_MAX_ATTRIBUTES 8
+
+// Shape and size of a struct made by generateSVG
+typedef struct {
+    // Structs generated from the same options and seed are identical
+    unsigned int seed;
+    // Number of shapes in the whole struct, spread over the top level and every group
+    int rects;
+    int circles;
+    int paths;
+    // Levels of nested groups, and the number of groups at the top level and in every group above the deepest level
+    int groupDepth;
+    int groupFanout;
+    // Attributes of every element, up to GENERATOR_MAX_ATTRIBUTES, and the length of their class values
+    int attributes;
+    int classLength;
+    // Lines, curves and arcs drawn by every path
+    int pathCommands;
+    // Percentage of rectangles and circles given a unit
+    int unitPercent;
+    // Size of the image.  Every shape starts inside it
+    float width;
+    float height;
+} SVGGeneratorOptions;
+
+void initGeneratorOptions(SVGGeneratorOptions *options);
+SVG* generateSVG(const SVGGeneratorOptions *options);
+
 #endif
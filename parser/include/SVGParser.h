@@ -8,11 +8,17 @@
 #include <libxml/xmlwriter.h>
 #include <libxml/xmlschemastypes.h>
 #include "LinkedListAPI.h"
+#include "SVGAlloc.h"
 
 typedef enum COMP{
     SVG_IMG, CIRC, RECT, PATH, GROUP
 } elementType;
 
+//Length unit identifier of an SVG length.  UNIT_INVALID marks a value that is not a valid length
+typedef enum {
+    UNIT_NONE, UNIT_CM, UNIT_PX, UNIT_EM, UNIT_EX, UNIT_PT, UNIT_PC, UNIT_MM, UNIT_IN, UNIT_PERCENT, UNIT_INVALID
+} lengthUnit;
+
 //Represents a generic SVG element/XML node Attribute
 typedef struct  {
     //Attribute name.  Must not be NULL
@@ -49,8 +55,8 @@ typedef struct {
     //Rectangle height.  Must be >= 0
     float height;
 
-    //Units for the rectable coordinates and size.  May be empty.
-    char units[50];
+    //Units for the rectable coordinates and size.  UNIT_NONE if there are none.
+    lengthUnit units;
 
     //Additional rectangle attributes - i.e. attributes of the rect XML element.  
 	//All objects in the list will be of type Attribute.  It must not be NULL.  It may be empty.
@@ -67,8 +73,8 @@ typedef struct {
     //Circle radius. Must be >= 0
     float r;
 
-    //Units for the circle coordinates and size.  May be empty.
-    char units[50];
+    //Units for the circle coordinates and size.  UNIT_NONE if there are none.
+    lengthUnit units;
 
     //Additional circle attributes - i.e. attributes of the circle XML element.  
     //All objects in the list will be of type Attribute.  It must not be NULL.  It may be empty.
@@ -88,6 +94,77 @@ typedef struct {
 
 } Path;
 
+//Entry in the flat element table of an SVG struct - maps an element ID to the element
+typedef struct {
+    //Type of the element - RECT, CIRC, PATH or GROUP
+    elementType type;
+    //List node holding the element.  Storing the node rather than the element keeps the entry
+    //valid when the element is reallocated in place (e.g. when a path's data changes)
+    Node* node;
+} ElementRef;
+
+//Running totals for an SVG struct, including elements nested in groups
+typedef struct {
+    //Number of rectangles, circles, paths and groups in the struct
+    int rects;
+    int circles;
+    int paths;
+    int groups;
+    //Number of Attribute structs in all otherAttributes lists - the value returned by numAttr
+    int attributes;
+    //Deepest group nesting level.  0 if there are no groups, 1 if no group contains another group
+    int maxGroupDepth;
+    //Combined length of the data of all paths, not counting terminators
+    size_t pathBytes;
+} SVGTotals;
+
+//Sorted index of the rounded up areas of a set of shapes, used to answer area queries by binary search
+typedef struct {
+    //ceil() of the area of every indexed shape, in ascending order
+    double* areas;
+    //Number of areas in the index
+    int length;
+    //Allocated size of the areas array
+    int capacity;
+} AreaIndex;
+
+//Axis aligned bounding box, in the user units of the shape coordinates
+typedef struct {
+    float minX;
+    float minY;
+    float maxX;
+    float maxY;
+} BoundingBox;
+
+//One level of a packed R-tree.  Box i of a level covers boxes [i * fanout, (i + 1) * fanout) of the level below
+typedef struct {
+    BoundingBox* boxes;
+    int length;
+} RTreeLevel;
+
+//Spatial index of all rectangles and circles in an SVG struct, bulk loaded as a packed R-tree
+typedef struct {
+    //levels[0] holds one box per indexed element, levels[numLevels - 1] is the root level
+    RTreeLevel* levels;
+    int numLevels;
+    //Element ID of every box in levels[0]
+    int* ids;
+} SpatialIndex;
+
+//Bounding boxes of every element in an SVG struct.  An element that draws nothing has an empty box,
+//one whose minX is greater than its maxX
+typedef struct {
+    //Box of every element, indexed by element ID.  A group's box covers everything nested in it
+    BoundingBox* boxes;
+    int length;
+    //Box of everything in the struct
+    BoundingBox document;
+    //Open addressing table from the address of each element to its ID, tableSize slots, empty slots are NULL
+    const void** keys;
+    int* ids;
+    int tableSize;
+} BoundsCache;
+
 // The main struct, representing an svg elemnt of the format
 // While a full SVG struct might have multiple svg components, we will assume that all of our input
 // structs will only have one
@@ -120,8 +197,64 @@ typedef struct {
     //All objects in the list will be of type Attribute.  It must not be NULL.  It may be empty.  
     //Do not put the namespace here, since it already has its own field
     List* otherAttributes;
+
+    //Flat table of every rectangle, circle, path and group in the struct, indexed by element ID.
+    //IDs are assigned in document order when the struct is loaded and components added later are
+    //appended, so an ID never changes for the lifetime of the struct.  May be NULL if there are no elements.
+    ElementRef* elements;
+    //Number of entries in the elements table
+    int numElements;
+    //Allocated size of the elements table
+    int elementsCapacity;
+
+    //The views and indexes below are caches, built without locking by the queries that need them, even the ones
+    //that take a const SVG*.  Functions must not be called on the same struct from several threads at once, not even
+    //read-only queries; threads that share a struct take turns.  Different structs may be used on different threads.
+
+    //Flattened views of every rectangle, circle, path and group in the struct, including ones nested in groups.
+    //Built on first use and discarded when the struct is modified.  NULL when not built.
+    List* rectView;
+    List* circleView;
+    List* pathView;
+    List* groupView;
+
+    //Running totals, computed when the struct is loaded and kept up to date by setAttribute,
+    //setAttributeByID and addComponent
+    SVGTotals totals;
+
+    //Area indexes of all rectangles and circles in the struct, including ones nested in groups.
+    //Built by the first area query and kept up to date as shapes are added or resized.  NULL when not built.
+    AreaIndex* rectAreas;
+    AreaIndex* circleAreas;
+
+    //Spatial index of all rectangles and circles in the struct, including ones nested in groups.
+    //Built by the first spatial query and discarded when the struct is modified.  NULL when not built.
+    SpatialIndex* spatialIndex;
+
+    //Bounding boxes of every element in the struct.
+    //Built by the first bounds query and discarded when the struct is modified.  NULL when not built.
+    BoundsCache* bounds;
 } SVG;
 
+//Precision of SVGWriteOptions that writes every length exactly.  It is 0, so a zeroed struct writes full precision
+#define SVG_FULL_PRECISION 0
+//Precision of SVGWriteOptions that rounds every length to a whole number
+#define SVG_WHOLE_NUMBERS -1
+
+//Output options for writeSVGWithOptions
+typedef struct {
+    //Write the whole document on one line, without indentation
+    bool compact;
+    //Most digits written after the decimal point of a length, SVG_WHOLE_NUMBERS for none, or
+    //SVG_FULL_PRECISION for the shortest string that reads back as the same float
+    int precision;
+    //Implies compact.  Also drops the XML declaration, attributes set to their default value, the leading
+    //zero of lengths and redundant whitespace in path data
+    bool minify;
+    //zlib compression level of .svgz files, from 1 (fastest) to 9 (smallest), or 0 for zlib's default
+    int compressionLevel;
+} SVGWriteOptions;
+
 //A1
 
 /* Public API - main */
@@ -134,7 +267,7 @@ typedef struct {
 		or 
 		An error occurred, and NULL was returned
  *@return the pinter to the new struct or NULL
- *@param fileName - a string containing the name of the SVG file
+ *@param fileName - a string containing the name of the SVG file.  Files ending in .svgz are read as gzip compressed
 **/
 SVG* createSVG(const char* fileName);
 
@@ -178,6 +311,27 @@ List* getGroups(const SVG* img);
 List* getPaths(const SVG* img);
 
 
+/* The four "get...View" functions below return the same elements as the "get..." functions above, but the List
+ is cached in the struct and owned by it.  Repeated calls return the same List without walking the struct again.
+
+ *@pre SVG struct exists, is not null, and has not been freed
+ *@post SVG struct has not been modified, but its cached views may have been built
+ *@return a List of pointers to the components in the struct.  Do not free it, and do not use it after the struct
+  is modified with setAttribute, setAttributeByID or addComponent.
+
+ *@param obj - a pointer to an SVG struct
+ */
+
+// Function that returns the cached list of all rectangles in the struct.
+const List* getRectView(const SVG* img);
+// Function that returns the cached list of all circles in the struct.
+const List* getCircleView(const SVG* img);
+// Function that returns the cached list of all groups in the struct.
+const List* getGroupView(const SVG* img);
+// Function that returns the cached list of all paths in the struct.
+const List* getPathView(const SVG* img);
+
+
 /* For the four "num..." functions below, you need to search the SVG struct for components that match the search 
   criterion.  You may wish to write some sort of a generic searcher fucntion that accepts a struct, a predicate function,
   and a dummy search record as arguments.  We will discuss such search functions in class
@@ -196,6 +350,10 @@ List* getPaths(const SVG* img);
 int numRectsWithArea(const SVG* img, float area);
 // Function that returns the number of all circles with the specified area
 int numCirclesWithArea(const SVG* img, float area);
+// Function that returns the number of all rectangles whose area is between minArea and maxArea, inclusive
+int numRectsInAreaRange(const SVG* img, float minArea, float maxArea);
+// Function that returns the number of all circles whose area is between minArea and maxArea, inclusive
+int numCirclesInAreaRange(const SVG* img, float minArea, float maxArea);
 // Function that returns the number of all paths with the specified data - i.e. Path.data field
 int numPathsWithdata(const SVG* img, const char* data);
 // Function that returns the number of all groups with the specified length - see A1 Module 2 for details
@@ -211,6 +369,66 @@ int numGroupsWithLen(const SVG* img, int len);
 int numAttr(const SVG* img);
 
 
+/*  Function that returns the running totals of an SVG struct in constant time.
+    When the library is built with SVG_CHECK_TOTALS defined the totals are checked against a full walk of the struct.
+    *@pre SVG struct  exists, is not null, and has not been freed.  
+    *@post SVG has not been modified in any way
+    *@return the totals of the SVG, or all zeroes if img is NULL
+    *@param obj - a pointer to an SVG struct
+*/
+SVGTotals getSVGTotals(const SVG* img);
+
+
+/*  Spatial queries over all rectangles and circles in an SVG struct, including ones nested in groups.
+    Coordinates are compared as stored - units are ignored.  Circles are matched against the circle itself, 
+    rectangles against their x, y, width and height.  The first query builds a spatial index that is reused until 
+    the struct is modified.
+    *@pre SVG struct  exists, is not null, and has not been freed.  numFound is not NULL.
+    *@post SVG has not been modified in any way, other than caching the spatial index
+    *@return a newly allocated array of element IDs (see getElementByID) that the caller must free, 
+    *        or NULL if nothing was found or memory ran out.  numFound is set to the length of the array
+    *@param obj - a pointer to an SVG struct
+*/
+// Function that returns every shape containing the point (x, y)
+int* findElementsAtPoint(const SVG* img, float x, float y, int* numFound);
+// Function that returns every shape intersecting the region [minX, maxX] x [minY, maxY]
+int* findElementsInRegion(const SVG* img, float minX, float minY, float maxX, float maxY, int* numFound);
+// Function that returns the k shapes closest to the point (x, y), closest first
+int* findNearestElements(const SVG* img, float x, float y, int k, int* numFound);
+
+
+/*  Bounding boxes of the elements in an SVG struct, in the coordinates they are stored in - units and strokes are
+    ignored.  Rectangles and circles are boxed by their geometry, paths by the points and the extremes of the
+    curves and arcs their data draws, and groups by everything nested in them.  The first query computes every
+    box, they are reused until the struct is modified.
+    *@pre SVG struct  exists, is not null, and has not been freed.  box is not NULL.
+    *@post SVG has not been modified in any way, other than caching the boxes
+    *@return true if box was set, false if the element does not exist or draws nothing
+    *@param obj - a pointer to an SVG struct
+*/
+// Function that returns the box of the element with the given ID (see getElementByID)
+bool getElementBounds(const SVG* img, int id, BoundingBox* box);
+// Function that returns the box of a Rectangle, Circle, Path or Group of the struct, of the given type
+bool getComponentBounds(const SVG* img, elementType type, const void* element, BoundingBox* box);
+// Function that returns the box of everything in the struct
+bool getSVGBounds(const SVG* img, BoundingBox* box);
+
+
+/** Function to rendering an SVG struct as a PNG image, for thumbnails.
+ *  The image shows the viewBox of the svg, or its width and height, or else everything it draws, scaled to fit
+ *  in maxWidth by maxHeight pixels while keeping its proportions.  Rectangles, circles and paths are filled and
+ *  stroked with the paint and transforms they have or inherit from their groups; units and clipping are ignored.
+ *@pre SVG struct  exists, is not null, and has not been freed.  length is not NULL.
+ *@post SVG has not been modified in any way, other than caching its bounding boxes
+ *@return a newly allocated PNG file that the caller must free, or NULL if it cannot be rendered.
+ *        length is set to its size in bytes
+ *@param
+    img - a pointer to an SVG struct
+    maxWidth, maxHeight - largest size of the image, in pixels
+ **/
+unsigned char* renderSVGThumbnail(const SVG* img, int maxWidth, int maxHeight, size_t* length);
+
+
 /* ******************************* A2 stuff *************************** */
 /** Function to validating an existing an SVG struct against a SVG schema file
  *@pre 
@@ -234,7 +452,7 @@ bool validateSVG(const SVG* img, const char* schemaFile);
 		or 
 		An error occurred, or SVG file was invalid, and NULL was returned
  *@return the pinter to the new struct or NULL
- *@param fileName - a string containing the name of the SVG file
+ *@param fileName - a string containing the name of the SVG file.  Files ending in .svgz are read as gzip compressed
 **/
 SVG* createValidSVG(const char* fileName, const char* schemaFile);
 
@@ -247,10 +465,24 @@ SVG* createValidSVG(const char* fileName, const char* schemaFile);
  *@return a boolean value indicating success or failure of the write
  *@param
     doc - a pointer to a SVG struct
- 	fileName - the name of the output file
+ 	fileName - the name of the output file.  Files ending in .svgz are written gzip compressed
  **/
 bool writeSVG(const SVG* img, const char* fileName);
 
+/** Function to writing an SVG struct into a file in SVG format, with control over the size of the output.
+ *@pre
+    SVG struct exists, is valid, and and is not NULL.
+    fileName is not NULL, has the correct extension
+ *@post SVG struct has not been modified in any way, and a file representing the
+    SVG contents in SVG format has been created
+ *@return a boolean value indicating success or failure of the write
+ *@param
+    doc - a pointer to a SVG struct
+ 	fileName - the name of the output file
+    options - output options, or NULL for the indented, full precision output of writeSVG
+ **/
+bool writeSVGWithOptions(const SVG* img, const char* fileName, const SVGWriteOptions* options);
+
 /** Function to setting an attribute in an SVG or component
  *@pre
     SVG object exists, is valid, and and is not NULL.
@@ -265,6 +497,30 @@ bool writeSVG(const SVG* img, const char* fileName);
  **/
 bool setAttribute(SVG* img, elementType elemType, int elemIndex, Attribute* newAttribute);
 
+/** Function to setting an attribute in any element of an SVG, including elements nested in groups
+ *@pre
+    SVG object exists, is valid, and and is not NULL.
+    newAttribute is not NULL
+ *@post The appropriate attribute was set corectly
+ *@return a boolean value indicating success or failure of the function
+ *@param
+    struct - a pointer to an SVG struct
+    elemID - ID of the element to modify, as assigned in the struct's element table
+    newAttribute - struct containing name and value of the updated attribute
+ **/
+bool setAttributeByID(SVG* img, int elemID, Attribute* newAttribute);
+
+/** Function to looking up an element of an SVG by its ID in constant time
+ *@pre SVG object exists and is not NULL
+ *@post SVG struct has not been modified in any way
+ *@return a pointer to the Rectangle, Circle, Path or Group with the given ID, or NULL if there is none
+ *@param
+    struct - a pointer to an SVG struct
+    elemID - ID of the element to look up
+    elemType - if not NULL, set to the type of the element that was found
+ **/
+void* getElementByID(const SVG* img, int elemID, elementType* elemType);
+
 /** Function to adding an element - Circle, Rectngle, or Path - to an SVG
  *@pre
     SVG object exists, is valid, and and is not NULL.
@@ -278,6 +534,43 @@ bool setAttribute(SVG* img, elementType elemType, int elemIndex, Attribute* newA
  **/
 void addComponent(SVG* img, elementType type, void* newElement);
 
+/** Function to adding many shapes to an SVG at once.  Either every shape is added or none is
+ *@pre SVG object exists, is valid, and is not NULL
+ *@post The shapes were appended to the group, or to the top level of the SVG, and given new element IDs
+ *@return the number of shapes added, or -1 if the input or the group is invalid
+ *@param
+    struct - a pointer to an SVG struct
+    groupID - element ID of the group to add to (see getElementByID), or -1 for the top level
+ **/
+// Function that adds a JSON array of rectangle, circle and path objects, in the format written by
+// rectToJSON, circleToJSON and pathToJSON.  An object may name its type with a "type" key of "rect", "circle" or "path"
+int addShapesJSON(SVG* img, int groupID, const char* json);
+// Function that adds numShapes rectangles (RECT, 4 floats each: x, y, width, height) or
+// circles (CIRC, 3 floats each: cx, cy, r) stored back to back in values
+int addShapesPacked(SVG* img, int groupID, elementType type, const float* values, int numShapes, lengthUnit units);
+
+/** Functions to timing the phases of the parser - reading files, compiling schemas, validating, building structs
+ and xmlDocs, serializing JSON and writing files.  Each phase counts its calls, time, bytes read or written and
+ elements handled, summed over all threads.  Counting is off until enabled, and costs almost nothing while off
+ **/
+// Function that turns counting on or off
+void setParserStatsEnabled(bool enabled);
+// Function that returns the counts of every phase as a newly allocated JSON string
+char* getParserStats(void);
+// Function that sets every count back to zero
+void resetParserStats(void);
+
+/** Functions to limiting how deeply elements may be nested in the files read by createSVG and createValidSVG,
+ the svg element being at depth 1.  Files nested deeper are rejected.  The default is the deepest nesting libxml2
+ accepts with its default options.  Above it files are parsed with XML_PARSE_HUGE, which also lifts libxml2's limits
+ on the length of text and names, and libxml2 2.12 and later still reject documents nested deeper than 2048 elements.
+ Structs built in memory may be nested to any depth
+ **/
+#define SVG_DEFAULT_MAX_DEPTH 256
+// Function that sets the deepest nesting accepted, or restores the default for values below 1
+void setSVGMaxDepth(int depth);
+int getSVGMaxDepth(void);
+
 /** Function to converting an Attribute into a JSON string
 *@pre Attribute is not NULL
 *@post Attribute has not been modified in any way
@@ -0,0 +1,218 @@
+/**
+ * @file CorpusGen.c
+ * @author Anthony Vidovic (1130891)
+ * @brief Command line tool writing synthetic svg files made by generateSVG. Built by `make corpusgen`
+ * @version 0.1
+ * @date 2022-04-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * Usage: CorpusGen [options] <output.svg|output.svgz>
+ *
+ *   -s seed       seed of the generator (1)
+ *   -r count      rectangles (100)
+ *   -c count      circles (100)
+ *   -p count      paths (100)
+ *   -d depth      levels of nested groups (2)
+ *   -f fanout     groups at the top level and in each group above the deepest level (4)
+ *   -a count      attributes of every element, up to 8 (2)
+ *   -l length     length of class attribute values (8)
+ *   -n count      commands of every path (8)
+ *   -u percent    percentage of rectangles and circles with a unit (0)
+ *   -b size       scale the shape counts to write a file of about this size, e.g. 1K, 50M, 1G
+ *   -m            write compact, minified output
+ *   -v            validate the written file against xsd/svg.xsd
+ */
+
+// getopt is POSIX, not C11
+#define _POSIX_C_SOURCE 200809L
+
+// ~~~~~ Includes ~~~~~ //
+#include "SVGHelper.h"
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define SCHEMA_FILE "xsd/svg.xsd"
+
+// Shapes in the sample written to estimate the size of each shape when scaling to a target size
+#define SAMPLE_SHAPES 3000
+
+static void usage(const char *program) {
+    fprintf(stderr, "Usage: %s [-s seed] [-r rects] [-c circles] [-p paths] [-d depth] [-f fanout] [-a attributes]\n"
+                    "       [-l classLength] [-n pathCommands] [-u unitPercent] [-b size] [-m] [-v] <output.svg|output.svgz>\n", program);
+}
+
+/**
+ * @brief parses a non-negative count
+ *
+ * @param str
+ * @param value
+ * @return true
+ * @return false if str is not a number in the range of an int
+ */
+static bool parseCount(const char *str, int *value) {
+    char *end;
+    long n = strtol(str, &end, 10);
+    if(end == str || *end != '\0' || n < 0 || n > 0x7fffffff) return false;
+
+    *value = (int)n;
+    return true;
+}
+
+/**
+ * @brief parses a size in bytes with an optional K, M or G suffix
+ *
+ * @param str
+ * @param bytes
+ * @return true
+ * @return false
+ */
+static bool parseSize(const char *str, double *bytes) {
+    char *end;
+    double n = strtod(str, &end);
+    if(end == str || n <= 0) return false;
+
+    if(*end == 'K' || *end == 'k') n *= 1024, end++;
+    else if(*end == 'M' || *end == 'm') n *= 1024 * 1024, end++;
+    else if(*end == 'G' || *end == 'g') n *= 1024 * 1024 * 1024, end++;
+
+    *bytes = n;
+    return *end == '\0';
+}
+
+/**
+ * @brief generates a struct and writes it to a file
+ *
+ * @param options
+ * @param fileName
+ * @param writeOptions
+ * @param size set to the size of the written file
+ * @return true
+ * @return false if the options are invalid or the file cannot be written
+ */
+static bool generateFile(const SVGGeneratorOptions *options, const char *fileName, const SVGWriteOptions *writeOptions, double *size) {
+    SVG *svg = generateSVG(options);
+    if(svg == NULL) return false;
+
+    bool written = writeSVGWithOptions(svg, fileName, writeOptions);
+    deleteSVG(svg);
+
+    struct stat st;
+    if(!written || stat(fileName, &st) != 0) return false;
+
+    *size = (double)st.st_size;
+    return true;
+}
+
+/**
+ * @brief scales the shape counts of the options to write a file of about the target size.  A sample with the
+ * same mix of shapes is written first to measure the size of each shape, and a file without shapes to measure the
+ * fixed cost of the groups and header.  The groups are dropped if they would take up most of a small target
+ *
+ * @param options
+ * @param fileName
+ * @param writeOptions
+ * @param target
+ * @return true
+ * @return false if the sample cannot be written
+ */
+static bool scaleToSize(SVGGeneratorOptions *options, const char *fileName, const SVGWriteOptions *writeOptions, double target) {
+    double shapes = (double)options->rects + options->circles + options->paths;
+    if(shapes == 0) {
+        options->rects = options->circles = options->paths = 1;
+        shapes = 3;
+    }
+
+    SVGGeneratorOptions sample = *options, empty = *options;
+    double ratio = SAMPLE_SHAPES / shapes;
+    sample.rects = (int)(options->rects * ratio + 0.5);
+    sample.circles = (int)(options->circles * ratio + 0.5);
+    sample.paths = (int)(options->paths * ratio + 0.5);
+    empty.rects = empty.circles = empty.paths = 0;
+
+    double sampleSize, emptySize;
+    if(!generateFile(&empty, fileName, writeOptions, &emptySize)) return false;
+
+    // Small targets are filled with shapes rather than empty groups
+    if(emptySize > target / 2 && options->groupDepth > 0) {
+        options->groupDepth = sample.groupDepth = empty.groupDepth = 0;
+        if(!generateFile(&empty, fileName, writeOptions, &emptySize)) return false;
+    }
+
+    if(!generateFile(&sample, fileName, writeOptions, &sampleSize)) return false;
+
+    double bytesPerShape = (sampleSize - emptySize) / (sample.rects + sample.circles + sample.paths);
+    double scale = target > emptySize ? (target - emptySize) / bytesPerShape / SAMPLE_SHAPES : 0;
+    if(scale * (sample.rects + sample.circles + sample.paths) > 0x7fffffff) return false;
+
+    options->rects = (int)(sample.rects * scale + 0.5);
+    options->circles = (int)(sample.circles * scale + 0.5);
+    options->paths = (int)(sample.paths * scale + 0.5);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    SVGGeneratorOptions options;
+    initGeneratorOptions(&options);
+
+    SVGWriteOptions writeOptions = { false, SVG_FULL_PRECISION, false, 0 };
+    double targetSize = 0;
+    bool validate = false;
+    bool valid = true;
+
+    int opt;
+    while((opt = getopt(argc, argv, "s:r:c:p:d:f:a:l:n:u:b:mv")) != -1) {
+        int seed = 0;
+        switch(opt) {
+            case 's': valid = parseCount(optarg, &seed); options.seed = seed; break;
+            case 'r': valid = parseCount(optarg, &options.rects); break;
+            case 'c': valid = parseCount(optarg, &options.circles); break;
+            case 'p': valid = parseCount(optarg, &options.paths); break;
+            case 'd': valid = parseCount(optarg, &options.groupDepth); break;
+            case 'f': valid = parseCount(optarg, &options.groupFanout); break;
+            case 'a': valid = parseCount(optarg, &options.attributes) && options.attributes <= GENERATOR_MAX_ATTRIBUTES; break;
+            case 'l': valid = parseCount(optarg, &options.classLength); break;
+            case 'n': valid = parseCount(optarg, &options.pathCommands); break;
+            case 'u': valid = parseCount(optarg, &options.unitPercent) && options.unitPercent <= 100; break;
+            case 'b': valid = parseSize(optarg, &targetSize); break;
+            case 'm': writeOptions.minify = true; break;
+            case 'v': validate = true; break;
+            default: valid = false;
+        }
+
+        if(!valid) {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if(optind != argc - 1 || !isSVGFileName(argv[optind])) {
+        usage(argv[0]);
+        return 1;
+    }
+    const char *fileName = argv[optind];
+
+    if(targetSize > 0 && !scaleToSize(&options, fileName, &writeOptions, targetSize)) {
+        fprintf(stderr, "Cannot generate a file of the requested size\n");
+        return 1;
+    }
+
+    double size;
+    if(!generateFile(&options, fileName, &writeOptions, &size)) {
+        fprintf(stderr, "Cannot generate %s\n", fileName);
+        return 1;
+    }
+
+    printf("%s: %.0f bytes, %d rectangles, %d circles, %d paths\n", fileName, size, options.rects, options.circles, options.paths);
+
+    if(validate) {
+        SVG *svg = createValidSVG(fileName, SCHEMA_FILE);
+        bool isValid = svg != NULL && validateSVG(svg, SCHEMA_FILE);
+        deleteSVG(svg);
+
+        printf("%s\n", isValid ? "valid" : "INVALID");
+        if(!isValid) return 2;
+    }
+
+    return 0;
+}
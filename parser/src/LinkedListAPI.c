@@ -1,4 +1,5 @@
 #include "LinkedListAPI.h"
+#include "SVGAlloc.h"
 #include "assert.h"
 
 /** Function to initialize the list metadata head to the appropriate function pointers. Allocates memory to the struct.
@@ -13,7 +14,10 @@ List * initializeList(char* (*printFunction)(void* toBePrinted),void (*deleteFun
     assert(deleteFunction != NULL);
     assert(compareFunction != NULL);
 
-    List * tmpList = malloc(sizeof(List));
+    List * tmpList = svgMalloc(sizeof(List));
+	if (tmpList == NULL){
+		return NULL;
+	}
 	
 	tmpList->head = NULL;
 	tmpList->tail = NULL;
@@ -37,7 +41,7 @@ List * initializeList(char* (*printFunction)(void* toBePrinted),void (*deleteFun
 void freeList(List* list){	
 
     clearList(list);
-	free(list);
+	svgFree(list);
 }
 
 /** Clears the list: frees the contents of the list - Node structs and data stored in them - 
@@ -63,7 +67,7 @@ void clearList(List* list){
 		list->deleteData(list->head->data);
 		tmp = list->head;
 		list->head = list->head->next;
-		free(tmp);
+		svgFree(tmp);
 	}
 	
 	list->head = NULL;
@@ -81,7 +85,7 @@ void clearList(List* list){
 * @param data - is a void * pointer to any data type.  Data must be allocated on the heap.
 **/
 Node* initializeNode(void* data){
-	Node* tmpNode = (Node*)malloc(sizeof(Node));
+	Node* tmpNode = (Node*)svgMalloc(sizeof(Node));
 	
 	if (tmpNode == NULL){
 		return NULL;
@@ -195,7 +199,7 @@ void* deleteDataFromList(List* list, void* toBeDeleted){
 			}
 			
 			void* data = delNode->data;
-			free(delNode);
+			svgFree(delNode);
 			
 			(list->length)--;
 
@@ -249,8 +253,8 @@ void insertSorted(List *list, void *toBeAdded){
 		
 			//printf("Inserting %s before %s\n", newDescr, currDescr);
 
-			free(currDescr);
-			free(newDescr);
+			svgFree(currDescr);
+			svgFree(newDescr);
 		
 			Node* newNode = initializeNode(toBeAdded);
 			newNode->next = currNode;
@@ -279,18 +283,18 @@ char* toString(List * list){
 	ListIterator iter = createIterator(list);
 	char* str;
 		
-	str = (char*)malloc(sizeof(char));
+	str = (char*)svgMalloc(sizeof(char));
 	strcpy(str, "");
 	
 	void* elem;
 	while((elem = nextElement(&iter)) != NULL){
 		char* currDescr = list->printData(elem);
 		int newLen = strlen(str)+50+strlen(currDescr);
-		str = (char*)realloc(str, newLen);
+		str = (char*)svgRealloc(str, newLen);
 		strcat(str, "\n");
 		strcat(str, currDescr);
 		
-		free(currDescr);
+		svgFree(currDescr);
 	}
 	
 	return str;
@@ -0,0 +1,240 @@
+/**
+ * @file NumberCheck.c
+ * @author Anthony Vidovic (1130891)
+ * @brief Checks parseFloat and formatFloat against the C library over random floats. Built and run by
+ * `make numcheck`
+ * @version 0.1
+ * @date 2022-04-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * Usage: NumberCheck [count] [seed]
+ *
+ * Runs count cases (default 1000000) of each check, from a fixed seed so a failure can be run again:
+ *  - bit patterns: random finite floats are formatted and parsed back, and must come back bit for bit, read
+ *    the same by strtof, and use no more significant digits than the shortest %.{p}g that round-trips
+ *  - short decimals: numbers of 1 to 9 digits with a random point and exponent are parsed, and must match strtof
+ *  - halfway: the exact midpoints between neighbouring floats, and the decimals just above and below them, are
+ *    parsed, and must match strtof, which rounds them correctly
+ * Prints the first failures and exits with status 1 if any case fails.
+ */
+
+// ~~~~~ Includes ~~~~~ //
+#include "SVGHelper.h"
+#include <float.h>
+
+// Failures printed for each check, the rest are only counted
+#define MAX_REPORTED 10
+
+// State of the xorshift generator the cases are drawn from
+static uint64_t rngState = 0x9e3779b97f4a7c15ULL;
+
+/**
+ * @brief returns the next 64 random bits
+ *
+ * @return uint64_t
+ */
+static uint64_t nextRandom(void) {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 7;
+    rngState ^= rngState << 17;
+    return rngState;
+}
+
+/**
+ * @brief returns the bits of a float
+ *
+ * @param value
+ * @return uint32_t
+ */
+static uint32_t floatBits(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+/**
+ * @brief returns a random finite float, every bit pattern being as likely
+ *
+ * @return float
+ */
+static float randomFloat(void) {
+    float value;
+    do {
+        uint32_t bits = (uint32_t)nextRandom();
+        memcpy(&value, &bits, sizeof(value));
+    } while(!isfinite(value));
+
+    return value;
+}
+
+/**
+ * @brief returns the number of significant digits of a decimal string, not counting leading or trailing zeros
+ *
+ * @param str
+ * @return int
+ */
+static int significantDigits(const char *str) {
+    int first = -1, last = -1, position = 0;
+
+    for(const char *c = str; *c != '\0' && *c != 'e' && *c != 'E'; c++) {
+        if(!isdigit((unsigned char)*c)) continue;
+        if(*c != '0') {
+            if(first < 0) first = position;
+            last = position;
+        }
+        position++;
+    }
+
+    return first < 0 ? 1 : last - first + 1;
+}
+
+/**
+ * @brief returns the fewest significant digits %.{p}g needs to write a float so that strtof reads it back
+ *
+ * @param value
+ * @return int
+ */
+static int shortestPrintf(float value) {
+    char buffer[64];
+
+    for(int precision = 1; precision < 9; precision++) {
+        snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+        if(floatBits(strtof(buffer, NULL)) == floatBits(value)) return precision;
+    }
+
+    return 9;
+}
+
+/**
+ * @brief parses a string with parseFloat and strtof and counts a failure if they differ or stop at different places
+ *
+ * @param check name of the check, for the report
+ * @param str
+ * @param failures
+ */
+static void compareWithStrtof(const char *check, const char *str, int *failures) {
+    const char *end;
+    char *expectedEnd;
+    float value = parseFloat(str, &end);
+    float expected = strtof(str, &expectedEnd);
+
+    if(floatBits(value) == floatBits(expected) && end == expectedEnd) return;
+
+    if((*failures)++ < MAX_REPORTED)
+        printf("%s: \"%s\" parsed as %.9g (0x%08x), strtof gives %.9g (0x%08x)\n", check, str, value,
+               floatBits(value), expected, floatBits(expected));
+}
+
+/**
+ * @brief formats random bit patterns and parses them back
+ *
+ * @param count
+ * @return int number of failures
+ */
+static int checkBitPatterns(int count) {
+    int failures = 0;
+
+    for(int i = 0; i < count; i++) {
+        float value = randomFloat();
+        char buffer[FLOAT_STRING_SIZE];
+        int length = formatFloat(value, buffer);
+
+        const char *end;
+        float parsed = parseFloat(buffer, &end);
+        float expected = strtof(buffer, NULL);
+        bool roundTrips = floatBits(parsed) == floatBits(value) && end == buffer + length &&
+                          floatBits(expected) == floatBits(value);
+
+        int shortest = shortestPrintf(value);
+        bool isShortest = significantDigits(buffer) <= shortest;
+
+        if((!roundTrips || !isShortest) && failures++ < MAX_REPORTED)
+            printf("bit patterns: 0x%08x formatted as \"%s\", read back as 0x%08x by parseFloat and 0x%08x by strtof, "
+                   "%d significant digits where %%.%dg round-trips\n", floatBits(value), buffer, floatBits(parsed),
+                   floatBits(expected), significantDigits(buffer), shortest);
+    }
+
+    return failures;
+}
+
+/**
+ * @brief parses random decimals of 1 to 9 digits, with a random decimal point and exponent
+ *
+ * @param count
+ * @return int number of failures
+ */
+static int checkShortDecimals(int count) {
+    int failures = 0;
+
+    for(int i = 0; i < count; i++) {
+        char digits[16], str[64];
+        int numDigits = 1 + (int)(nextRandom() % 9);
+        for(int d = 0; d < numDigits; d++) digits[d] = (char)('0' + nextRandom() % 10);
+        digits[numDigits] = '\0';
+
+        // The point goes anywhere in the digits, or nowhere
+        int point = (int)(nextRandom() % (numDigits + 2)) - 1;
+        int exponent = (int)(nextRandom() % 91) - 50;
+        const char *sign = nextRandom() % 2 ? "-" : "";
+
+        if(point < 0) snprintf(str, sizeof(str), "%s%se%d", sign, digits, exponent);
+        else snprintf(str, sizeof(str), "%s%.*s.%se%d", sign, point, digits, digits + point, exponent);
+
+        compareWithStrtof("short decimals", str, &failures);
+    }
+
+    return failures;
+}
+
+/**
+ * @brief parses the exact midpoint between a random float and the next one up, and decimals just above and below it
+ *
+ * @param count
+ * @return int number of failures
+ */
+static int checkHalfway(int count) {
+    int failures = 0;
+
+    for(int i = 0; i < count; i++) {
+        float low = fabsf(randomFloat());
+        if(low == FLT_MAX) continue;
+
+        // The midpoint of two floats is exact in a double, and glibc prints doubles exactly
+        double midpoint = ((double)low + (double)nextafterf(low, INFINITY)) / 2;
+        char str[256];
+        snprintf(str, sizeof(str), "%.160e", midpoint);
+        compareWithStrtof("halfway", str, &failures);
+
+        // The digits are exact, so a 1 after them puts the decimal just above the midpoint
+        char above[256];
+        char *e = strchr(str, 'e');
+        snprintf(above, sizeof(above), "%.*s1%s", (int)(e - str), str, e);
+        compareWithStrtof("above halfway", above, &failures);
+
+        snprintf(str, sizeof(str), "%.160e", nextafter(midpoint, 0));
+        compareWithStrtof("below halfway", str, &failures);
+    }
+
+    return failures;
+}
+
+int main(int argc, char **argv) {
+    int count = argc > 1 ? atoi(argv[1]) : 1000000;
+    if(argc > 2) rngState = strtoull(argv[2], NULL, 0);
+    if(count <= 0 || rngState == 0) {
+        fprintf(stderr, "Usage: %s [count] [seed]\n", argv[0]);
+        return 1;
+    }
+
+    int bitFailures = checkBitPatterns(count);
+    printf("bit patterns: %d checked, %d failed\n", count, bitFailures);
+
+    int decimalFailures = checkShortDecimals(count);
+    printf("short decimals: %d checked, %d failed\n", count, decimalFailures);
+
+    int halfwayFailures = checkHalfway(count);
+    printf("halfway: %d checked, %d failed\n", count, halfwayFailures);
+
+    return bitFailures + decimalFailures + halfwayFailures > 0 ? 1 : 0;
+}
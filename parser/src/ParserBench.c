@@ -0,0 +1,791 @@
+/**
+ * @file ParserBench.c
+ * @author Anthony Vidovic (1130891)
+ * @brief Microbenchmarks of the parser library's public API over synthetic documents. Built and run by `make bench`
+ * @version 0.1
+ * @date 2022-04-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * Usage: ParserBench <output.json> [small|medium|huge ...] [benchmark ...]
+ *
+ * Every benchmark runs in its own child process, so its peak RSS is its own and a benchmark that
+ * runs past BENCH_TIMEOUT seconds (default 120) is reported as timed out instead of stalling the suite.
+ * A benchmark that crashes is reported as crashed, and makes the suite exit with status 1.  Naming
+ * benchmarks, or the start of their names, runs only those.
+ *
+ * The nested benchmarks run on a chain of groups each nested in the one before, as many levels deep
+ * as the size has shapes, so `ParserBench out.json huge nested` walks one million levels of nesting.
+ * The number benchmarks convert as many numbers as the size has shapes, typical svg coordinates with a
+ * quarter of them spread over the whole range of floats, next to the C library's conversions.  parseLength
+ * reads the same numbers as geometry attributes, most of them with a unit.
+ * renderThumbnail draws the corpus as a PNG of at most THUMBNAIL_SIZE pixels square, the size the server's listing
+ * asks for, so one operation is one cold thumbnail.
+ * addShapesJSON adds the corpus's shapes, as the JSON of its rectangles, circles and paths, to an empty struct, and
+ * addShapesPacked adds as many rectangles from packed floats.  The empty struct is made outside the timing.
+ * writeSVGDOM writes the corpus the way writeSVG did before it streamed, through an xmlDoc built with SVGtoDOC.
+ * writeSVGCompact, writeSVGMinify and writeSVGPrecision write it with writeSVGWithOptions: on one line, minified,
+ * and with lengths rounded to whole numbers, since the corpus has a single decimal.  writeSVGZ writes it gzip compressed
+ * at the zlib level BENCH_SVGZ_LEVEL (1 to 9, default 0 for zlib's default), and createSVGZ reads that file back.
+ * Benchmarks that leave a scratch file report its size as bytesWritten, createSVGZ the size of the file it reads.
+ * itemsPerSecond counts the shapes, levels or numbers each iteration goes through.  rssGrowthKB is how far the peak
+ * RSS rose while timing above what setup reached, the memory the operation itself needs at its peak.
+ * createSVG also reports heapBytesPerShape, the heap a loaded corpus keeps divided by its shapes, where glibc has
+ * mallinfo2.
+ */
+
+// fork, pipes and clock_gettime are POSIX, not C11
+#define _POSIX_C_SOURCE 200809L
+
+// ~~~~~ Includes ~~~~~ //
+#include "SVGHelper.h"
+#include <time.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#define SCHEMA_FILE "xsd/svg.xsd"
+
+// A benchmark is repeated until it has run for at least this long
+#define MIN_BENCH_NS 500000000LL
+#define MAX_ITERATIONS 1000000
+
+// Width and height of the thumbnails of renderThumbnail
+#define THUMBNAIL_SIZE 400
+
+// compressionLevel of writeSVGZ, from BENCH_SVGZ_LEVEL
+static int svgzLevel = 0;
+
+/* ----------------------- */
+/* Allocation Counting */
+/* ----------------------- */
+
+static unsigned long long allocCount = 0;
+static unsigned long long allocBytes = 0;
+
+#ifdef __GLIBC__
+// glibc supports replacing malloc, and calls made inside libc and libxml2 go through the replacement too
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+void *malloc(size_t size) {
+    allocCount++;
+    allocBytes += size;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    allocCount++;
+    allocBytes += count * size;
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    allocCount++;
+    allocBytes += size;
+    return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr) {
+    __libc_free(ptr);
+}
+#define COUNTS_ALLOCATIONS true
+#else
+#define COUNTS_ALLOCATIONS false
+#endif
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+#include <malloc.h>
+
+// Bytes malloc has handed out and not had back, or -1 without mallinfo2
+static long long heapInUse(void) {
+    return (long long)mallinfo2().uordblks;
+}
+#else
+static long long heapInUse(void) {
+    return -1;
+}
+#endif
+
+/* ----------------------- */
+/* Synthetic Corpus */
+/* ----------------------- */
+
+// A document size the suite runs at
+typedef struct {
+    const char *name;
+    int shapes;
+} CorpusSize;
+
+static const CorpusSize corpusSizes[] = {
+    { "small", 100 },
+    { "medium", 10000 },
+    { "huge", 1000000 },
+};
+
+/**
+ * @brief writes the corpus document of a size: generateSVG's default mix of attributes and paths, with the
+ * shapes split evenly between rectangles, circles and paths in two levels of groups.  The seed is fixed, so every
+ * run sees the same document
+ *
+ * @param fileName
+ * @param shapes
+ * @return true
+ * @return false if the file cannot be written
+ */
+static bool writeCorpus(const char *fileName, int shapes) {
+    SVGGeneratorOptions options;
+    initGeneratorOptions(&options);
+    options.rects = shapes - 2 * (shapes / 3);
+    options.circles = shapes / 3;
+    options.paths = shapes / 3;
+    options.groupFanout = shapes >= 10000 ? 16 : 4;
+
+    SVG *svg = generateSVG(&options);
+    bool written = writeSVG(svg, fileName);
+
+    deleteSVG(svg);
+    return written;
+}
+
+/**
+ * @brief gzip compresses a file at svgzLevel, which for the corpus gives the file writeSVGZ writes without
+ * loading the corpus
+ *
+ * @param fileName
+ * @param compressedFile
+ * @return true
+ * @return false if a file cannot be read or written
+ */
+static bool compressFile(const char *fileName, const char *compressedFile) {
+    FILE *in = fopen(fileName, "rb");
+    if(in == NULL) return false;
+
+    char mode[8];
+    snprintf(mode, sizeof(mode), svgzLevel > 0 ? "wb%d" : "wb", svgzLevel);
+    gzFile out = gzopen(compressedFile, mode);
+
+    char buffer[65536];
+    size_t n;
+    bool written = out != NULL;
+    while(written && (n = fread(buffer, 1, sizeof(buffer), in)) > 0) written = gzwrite(out, buffer, n) == (int)n;
+
+    fclose(in);
+    if(out != NULL && gzclose(out) != Z_OK) written = false;
+    return written;
+}
+
+/**
+ * @brief generates a chain of groups, each nested in the one before, with a rectangle, circle or path
+ * in every third group on average
+ *
+ * @param depth number of groups
+ * @return SVG*
+ */
+static SVG* generateNested(int depth) {
+    SVGGeneratorOptions options;
+    initGeneratorOptions(&options);
+    options.rects = depth / 9;
+    options.circles = depth / 9;
+    options.paths = depth / 9;
+    options.groupDepth = depth;
+    options.groupFanout = 1;
+
+    return generateSVG(&options);
+}
+
+/* ----------------------- */
+/* Numbers */
+/* ----------------------- */
+
+// Numbers the number benchmarks convert, as text, as the floats the text reads as, and as lengths with units
+typedef struct {
+    char **strings;
+    float *values;
+    char **lengths;
+    int count;
+} NumberInputs;
+
+// Units the lengths are written with, in turn
+static const char *lengthSuffixes[] = { "px", "", "em", "%", "mm", " pt", "in", "cm" };
+
+/**
+ * @brief makes the numbers of a size: coordinates of up to three decimals, as svg files write them, with every
+ * fourth number drawn from the whole range of floats.  The seed is fixed, so every run sees the same numbers
+ *
+ * @param inputs
+ * @param count
+ */
+static void makeNumbers(NumberInputs *inputs, int count) {
+    inputs->strings = svgMalloc(sizeof(char*) * count);
+    inputs->values = svgMalloc(sizeof(float) * count);
+    inputs->lengths = svgMalloc(sizeof(char*) * count);
+    inputs->count = count;
+
+    uint32_t seed = 12345;
+    for(int i = 0; i < count; i++) {
+        char text[64];
+        seed = seed * 1664525 + 1013904223;
+
+        if(i % 4 == 3) {
+            // Clearing a bit of the exponent leaves out infinities and nans
+            uint32_t bits = seed & 0xfeffffff;
+            float value;
+            memcpy(&value, &bits, sizeof(value));
+            snprintf(text, sizeof(text), "%.9g", value);
+        } else {
+            snprintf(text, sizeof(text), "%.*f", (int)(seed >> 30), ((int)(seed % 2000000) - 1000000) / 1000.0);
+        }
+
+        inputs->strings[i] = svgMalloc(strlen(text) + 1);
+        strcpy(inputs->strings[i], text);
+        inputs->values[i] = strtof(text, NULL);
+
+        const char *suffix = lengthSuffixes[i % (sizeof(lengthSuffixes) / sizeof(lengthSuffixes[0]))];
+        inputs->lengths[i] = svgMalloc(strlen(text) + strlen(suffix) + 1);
+        strcpy(inputs->lengths[i], text);
+        strcat(inputs->lengths[i], suffix);
+    }
+}
+
+/**
+ * @brief frees the numbers of makeNumbers
+ *
+ * @param inputs
+ */
+static void freeNumbers(NumberInputs *inputs) {
+    for(int i = 0; i < inputs->count; i++) {
+        svgFree(inputs->strings[i]);
+        svgFree(inputs->lengths[i]);
+    }
+    svgFree(inputs->strings);
+    svgFree(inputs->values);
+    svgFree(inputs->lengths);
+}
+
+/* ----------------------- */
+/* Benchmarks */
+/* ----------------------- */
+
+// State a benchmark runs against, set up before timing starts
+typedef struct {
+    const char *corpusFile;
+    const char *scratchFile;
+    // scratchFile with the .svgz extension
+    char compressedFile[80];
+    SVG *svg;
+    // Levels of nesting of the nested benchmarks
+    int depth;
+    NumberInputs numbers;
+    // Shapes the bulk benchmarks add to target, made on the first prepare
+    char *shapesJSON;
+    float *packedRects;
+    SVG *target;
+    // Keeps the compiler from dropping conversions whose results are not used
+    volatile float sink;
+} BenchContext;
+
+typedef struct {
+    const char *name;
+    // Needs the corpus loaded into ctx->svg before timing starts
+    bool needsSVG;
+    // Runs on the chain of nested groups of generateNested rather than on the corpus
+    bool nested;
+    // Runs on the numbers of makeNumbers rather than on the corpus
+    bool numbers;
+    void (*run)(BenchContext *ctx);
+    // Runs before every iteration, outside the timing and allocation counts.  May be NULL
+    void (*prepare)(BenchContext *ctx);
+} Benchmark;
+
+static void benchCreateSVG(BenchContext *ctx) {
+    deleteSVG(createSVG(ctx->corpusFile));
+}
+
+static void benchCreateValidSVG(BenchContext *ctx) {
+    deleteSVG(createValidSVG(ctx->corpusFile, SCHEMA_FILE));
+}
+
+static void benchValidateSVG(BenchContext *ctx) {
+    validateSVG(ctx->svg, SCHEMA_FILE);
+}
+
+static void benchWriteSVG(BenchContext *ctx) {
+    writeSVG(ctx->svg, ctx->scratchFile);
+}
+
+static void benchWriteSVGDOM(BenchContext *ctx) {
+    xmlDoc *doc = SVGtoDOC(ctx->svg);
+    xmlSaveFormatFileEnc(ctx->scratchFile, doc, "UTF-8", 1);
+    xmlFreeDoc(doc);
+}
+
+static void benchWriteSVGCompact(BenchContext *ctx) {
+    SVGWriteOptions options = { true, SVG_FULL_PRECISION, false, 0 };
+    writeSVGWithOptions(ctx->svg, ctx->scratchFile, &options);
+}
+
+static void benchWriteSVGMinify(BenchContext *ctx) {
+    SVGWriteOptions options = { false, SVG_FULL_PRECISION, true, 0 };
+    writeSVGWithOptions(ctx->svg, ctx->scratchFile, &options);
+}
+
+static void benchWriteSVGPrecision(BenchContext *ctx) {
+    SVGWriteOptions options = { false, SVG_WHOLE_NUMBERS, false, 0 };
+    writeSVGWithOptions(ctx->svg, ctx->scratchFile, &options);
+}
+
+static void benchWriteSVGZ(BenchContext *ctx) {
+    SVGWriteOptions options = { false, SVG_FULL_PRECISION, false, svgzLevel };
+    writeSVGWithOptions(ctx->svg, ctx->compressedFile, &options);
+}
+
+static void benchCreateSVGZ(BenchContext *ctx) {
+    deleteSVG(createSVG(ctx->compressedFile));
+}
+
+static void benchRectListToJSON(BenchContext *ctx) {
+    List *rects = getRects(ctx->svg);
+    svgFree(rectListToJSON(rects));
+    freeList(rects);
+}
+
+static void benchCircListToJSON(BenchContext *ctx) {
+    List *circles = getCircles(ctx->svg);
+    svgFree(circListToJSON(circles));
+    freeList(circles);
+}
+
+static void benchPathListToJSON(BenchContext *ctx) {
+    List *paths = getPaths(ctx->svg);
+    svgFree(pathListToJSON(paths));
+    freeList(paths);
+}
+
+static void benchGroupListToJSON(BenchContext *ctx) {
+    List *groups = getGroups(ctx->svg);
+    svgFree(groupListToJSON(groups));
+    freeList(groups);
+}
+
+static void benchScaleShape(BenchContext *ctx) {
+    // Scaling by 1 leaves the file as it was, so every iteration does the same work
+    scaleShape((char*)ctx->scratchFile, SCHEMA_FILE, RECT, 1);
+}
+
+static void benchRenderThumbnail(BenchContext *ctx) {
+    size_t length;
+    svgFree(renderSVGThumbnail(ctx->svg, THUMBNAIL_SIZE, THUMBNAIL_SIZE, &length));
+}
+
+/**
+ * @brief returns the corpus's rectangles, circles and paths as one JSON array, in the format of rectToJSON,
+ * circleToJSON and pathToJSON
+ *
+ * @param svg
+ * @return char*
+ */
+static char* corpusShapesJSON(const SVG *svg) {
+    List *lists[3] = { getRects(svg), getCircles(svg), getPaths(svg) };
+    StringBuffer json;
+    initStringBuffer(&json, 256);
+    appendString(&json, "[");
+
+    for(int i = 0; i < 3; i++) {
+        ListIterator iter = createIterator(lists[i]);
+        void *shape;
+        while((shape = nextElement(&iter)) != NULL) {
+            char *shapeJSON = i == 0 ? rectToJSON(shape) : i == 1 ? circleToJSON(shape) : pathToJSON(shape);
+            if(json.length > 1) appendString(&json, ",");
+            appendString(&json, shapeJSON);
+            svgFree(shapeJSON);
+        }
+        freeList(lists[i]);
+    }
+
+    appendString(&json, "]");
+    return json.data;
+}
+
+static void prepareAddShapes(BenchContext *ctx) {
+    if(ctx->shapesJSON == NULL) {
+        ctx->shapesJSON = corpusShapesJSON(ctx->svg);
+
+        // The corpus's rectangles, repeated until there are as many as the corpus has shapes
+        List *rects = getRects(ctx->svg);
+        ctx->packedRects = svgMalloc(sizeof(float) * 4 * ctx->depth);
+        ListIterator iter = createIterator(rects);
+        for(int i = 0; i < ctx->depth; i++) {
+            Rectangle *rect = nextElement(&iter);
+            if(rect == NULL) {
+                iter = createIterator(rects);
+                rect = nextElement(&iter);
+            }
+            float *values = ctx->packedRects + 4 * i;
+            values[0] = rect->x;
+            values[1] = rect->y;
+            values[2] = rect->width;
+            values[3] = rect->height;
+        }
+        freeList(rects);
+    }
+
+    SVGGeneratorOptions options;
+    initGeneratorOptions(&options);
+    options.rects = 0;
+    options.circles = 0;
+    options.paths = 0;
+    options.groupDepth = 0;
+
+    deleteSVG(ctx->target);
+    ctx->target = generateSVG(&options);
+}
+
+static void benchAddShapesJSON(BenchContext *ctx) {
+    addShapesJSON(ctx->target, -1, ctx->shapesJSON);
+}
+
+static void benchAddShapesPacked(BenchContext *ctx) {
+    addShapesPacked(ctx->target, -1, RECT, ctx->packedRects, ctx->depth, UNIT_NONE);
+}
+
+static void benchNestedBuild(BenchContext *ctx) {
+    // Builds the element table and totals, and frees the chain
+    deleteSVG(generateNested(ctx->depth));
+}
+
+static void benchNestedQuery(BenchContext *ctx) {
+    numGroupsWithLen(ctx->svg, 1);
+    numPathsWithdata(ctx->svg, "");
+    scaleRectsInGroups(1, ctx->svg->groups);
+
+    // Every later query needs the IDs, so a table that cannot be rebuilt ends the benchmark as crashed
+    if(!buildElementTable(ctx->svg)) abort();
+}
+
+static void benchParseFloat(BenchContext *ctx) {
+    float sum = 0;
+    for(int i = 0; i < ctx->numbers.count; i++) sum += parseFloat(ctx->numbers.strings[i], NULL);
+    ctx->sink = sum;
+}
+
+static void benchParseFloatStrtof(BenchContext *ctx) {
+    float sum = 0;
+    for(int i = 0; i < ctx->numbers.count; i++) sum += strtof(ctx->numbers.strings[i], NULL);
+    ctx->sink = sum;
+}
+
+static void benchFormatFloat(BenchContext *ctx) {
+    char buffer[FLOAT_STRING_SIZE];
+    int length = 0;
+    for(int i = 0; i < ctx->numbers.count; i++) length += formatFloat(ctx->numbers.values[i], buffer);
+    ctx->sink = (float)length;
+}
+
+static void benchFormatFloatPrintf(BenchContext *ctx) {
+    // Nine significant digits is the fewest that always round-trips a float through printf
+    char buffer[FLOAT_STRING_SIZE];
+    int length = 0;
+    for(int i = 0; i < ctx->numbers.count; i++)
+        length += snprintf(buffer, sizeof(buffer), "%.9g", ctx->numbers.values[i]);
+    ctx->sink = (float)length;
+}
+
+static void benchParseLength(BenchContext *ctx) {
+    float sum = 0, value;
+    lengthUnit unit;
+    for(int i = 0; i < ctx->numbers.count; i++)
+        if(parseLength(ctx->numbers.lengths[i], &value, &unit)) sum += value;
+    ctx->sink = sum;
+}
+
+static const Benchmark benchmarks[] = {
+    { "createSVG", false, false, false, benchCreateSVG },
+    { "createValidSVG", false, false, false, benchCreateValidSVG },
+    { "validateSVG", true, false, false, benchValidateSVG },
+    { "writeSVG", true, false, false, benchWriteSVG },
+    { "writeSVGDOM", true, false, false, benchWriteSVGDOM },
+    { "writeSVGCompact", true, false, false, benchWriteSVGCompact },
+    { "writeSVGMinify", true, false, false, benchWriteSVGMinify },
+    { "writeSVGPrecision", true, false, false, benchWriteSVGPrecision },
+    { "writeSVGZ", true, false, false, benchWriteSVGZ },
+    { "createSVGZ", false, false, false, benchCreateSVGZ },
+    { "rectListToJSON", true, false, false, benchRectListToJSON },
+    { "circListToJSON", true, false, false, benchCircListToJSON },
+    { "pathListToJSON", true, false, false, benchPathListToJSON },
+    { "groupListToJSON", true, false, false, benchGroupListToJSON },
+    { "scaleShape", true, false, false, benchScaleShape },
+    { "renderThumbnail", true, false, false, benchRenderThumbnail },
+    { "addShapesJSON", true, false, false, benchAddShapesJSON, prepareAddShapes },
+    { "addShapesPacked", true, false, false, benchAddShapesPacked, prepareAddShapes },
+    { "nestedBuild", false, true, false, benchNestedBuild },
+    { "nestedQuery", true, true, false, benchNestedQuery },
+    { "nestedValidate", true, true, false, benchValidateSVG },
+    { "nestedWrite", true, true, false, benchWriteSVG },
+    { "parseFloat", false, false, true, benchParseFloat },
+    { "parseFloatStrtof", false, false, true, benchParseFloatStrtof },
+    { "formatFloat", false, false, true, benchFormatFloat },
+    { "formatFloatPrintf", false, false, true, benchFormatFloatPrintf },
+    { "parseLength", false, false, true, benchParseLength },
+};
+
+/**
+ * @brief returns the monotonic clock in nanoseconds
+ *
+ * @return long long
+ */
+static long long nowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * @brief returns the peak resident set size of this process in kilobytes
+ *
+ * @return long
+ */
+static long peakRssKB(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+/**
+ * @brief runs one benchmark in the calling process and writes its result as a JSON object to fd
+ *
+ * @param bench
+ * @param size
+ * @param corpusFile
+ * @param scratchFile
+ * @param fd
+ */
+static void runBenchmark(const Benchmark *bench, const CorpusSize *size, const char *corpusFile, const char *scratchFile, int fd) {
+    BenchContext ctx = { corpusFile, scratchFile, "", NULL, size->shapes, { NULL, NULL, NULL, 0 }, NULL, NULL, NULL, 0 };
+    snprintf(ctx.compressedFile, sizeof(ctx.compressedFile), "%sz", scratchFile);
+
+    if(bench->numbers) makeNumbers(&ctx.numbers, size->shapes);
+    if(bench->needsSVG) ctx.svg = bench->nested ? generateNested(ctx.depth) : createSVG(corpusFile);
+
+    // The scratch file left after timing is the one the benchmark wrote
+    remove(scratchFile);
+    remove(ctx.compressedFile);
+    if(strcmp(bench->name, "scaleShape") == 0) writeSVG(ctx.svg, scratchFile);
+    if(strcmp(bench->name, "createSVGZ") == 0) compressFile(corpusFile, ctx.compressedFile);
+
+    allocCount = 0;
+    allocBytes = 0;
+    long setupRssKB = peakRssKB();
+
+    long long start = nowNs();
+    long long elapsed = 0;
+    int iterations = 0;
+
+    while(iterations < MAX_ITERATIONS && (iterations == 0 || elapsed < MIN_BENCH_NS)) {
+        if(bench->prepare != NULL) {
+            // Moving the start forward leaves the time prepare takes out of elapsed
+            long long paused = nowNs();
+            unsigned long long allocs = allocCount, bytes = allocBytes;
+            bench->prepare(&ctx);
+            allocCount = allocs;
+            allocBytes = bytes;
+            start += nowNs() - paused;
+        }
+        bench->run(&ctx);
+        iterations++;
+        elapsed = nowNs() - start;
+    }
+
+    unsigned long long allocs = allocCount;
+    unsigned long long bytes = allocBytes;
+    long peakKB = peakRssKB();
+
+    char written[96] = "";
+    struct stat info;
+    if(stat(scratchFile, &info) == 0 || stat(ctx.compressedFile, &info) == 0)
+        snprintf(written, sizeof(written), ",\"bytesWritten\":%lld", (long long)info.st_size);
+
+    // One more load, after the peak RSS is read, measures what a loaded struct keeps on the heap
+    long long heapBefore = heapInUse();
+    if(strcmp(bench->name, "createSVG") == 0 && heapBefore >= 0) {
+        SVG *svg = createSVG(corpusFile);
+        size_t used = strlen(written);
+        if(svg != NULL) snprintf(written + used, sizeof(written) - used, ",\"heapBytesPerShape\":%.1f",
+                                 (double)(heapInUse() - heapBefore) / size->shapes);
+        deleteSVG(svg);
+    }
+
+    char result[512];
+    int len = snprintf(result, sizeof(result),
+                       "{\"name\":\"%s\",\"size\":\"%s\",\"shapes\":%d,\"iterations\":%d,\"nsPerOp\":%.1f,"
+                       "\"itemsPerSecond\":%.0f,\"allocsPerOp\":%.1f,\"allocBytesPerOp\":%.1f,\"peakRssKB\":%ld,"
+                       "\"rssGrowthKB\":%ld%s,\"timedOut\":false,\"crashed\":false}",
+                       bench->name, size->name, size->shapes, iterations, (double)elapsed / iterations,
+                       (double)size->shapes * iterations * 1e9 / elapsed,
+                       COUNTS_ALLOCATIONS ? (double)allocs / iterations : -1.0,
+                       COUNTS_ALLOCATIONS ? (double)bytes / iterations : -1.0, peakKB, peakKB - setupRssKB, written);
+
+    if(write(fd, result, len) != len) _exit(1);
+    remove(ctx.compressedFile);
+    deleteSVG(ctx.svg);
+    deleteSVG(ctx.target);
+    svgFree(ctx.shapesJSON);
+    svgFree(ctx.packedRects);
+    if(bench->numbers) freeNumbers(&ctx.numbers);
+}
+
+/**
+ * @brief runs one benchmark in a child process with a time limit
+ *
+ * @param bench
+ * @param size
+ * @param corpusFile
+ * @param scratchFile
+ * @param timeout seconds
+ * @param result buffer for the JSON result
+ * @param resultSize
+ * @return true if the benchmark crashed
+ */
+static bool runIsolated(const Benchmark *bench, const CorpusSize *size, const char *corpusFile, const char *scratchFile,
+                        int timeout, char *result, size_t resultSize) {
+    int fds[2];
+    pid_t pid = -1;
+
+    if(pipe(fds) == 0) pid = fork();
+
+    if(pid == 0) {
+        close(fds[0]);
+        alarm(timeout);
+        runBenchmark(bench, size, corpusFile, scratchFile, fds[1]);
+        _exit(0);
+    }
+
+    size_t len = 0;
+    int status = 0;
+    if(pid > 0) {
+        close(fds[1]);
+        ssize_t n;
+        while(len < resultSize - 1 && (n = read(fds[0], result + len, resultSize - 1 - len)) > 0) len += n;
+        close(fds[0]);
+        waitpid(pid, &status, 0);
+    }
+    result[len] = '\0';
+
+    // The alarm ends a benchmark that runs too long, any other signal is a crash
+    bool crashed = pid > 0 && WIFSIGNALED(status) && WTERMSIG(status) != SIGALRM;
+
+    if(len == 0) {
+        snprintf(result, resultSize, "{\"name\":\"%s\",\"size\":\"%s\",\"shapes\":%d,\"timedOut\":%s,\"crashed\":%s}",
+                 bench->name, size->name, size->shapes, crashed ? "false" : "true", crashed ? "true" : "false");
+    }
+
+    return crashed;
+}
+
+/**
+ * @brief returns true if an argument names a size
+ *
+ * @param arg
+ * @return true
+ * @return false
+ */
+static bool isSizeName(const char *arg) {
+    for(size_t s = 0; s < sizeof(corpusSizes) / sizeof(corpusSizes[0]); s++)
+        if(strcmp(arg, corpusSizes[s].name) == 0) return true;
+
+    return false;
+}
+
+/**
+ * @brief returns true if the arguments select a benchmark: they name no benchmarks, or one of them starts its name
+ *
+ * @param bench
+ * @param argc
+ * @param argv
+ * @return true
+ * @return false
+ */
+static bool isSelected(const Benchmark *bench, int argc, char **argv) {
+    bool named = false;
+
+    for(int i = 2; i < argc; i++) {
+        if(isSizeName(argv[i])) continue;
+        if(strncmp(bench->name, argv[i], strlen(argv[i])) == 0) return true;
+        named = true;
+    }
+
+    return !named;
+}
+
+int main(int argc, char **argv) {
+    if(argc < 2) {
+        fprintf(stderr, "Usage: %s <output.json> [small|medium|huge ...] [benchmark ...]\n", argv[0]);
+        return 1;
+    }
+
+    const char *timeoutEnv = getenv("BENCH_TIMEOUT");
+    int timeout = timeoutEnv != NULL && atoi(timeoutEnv) > 0 ? atoi(timeoutEnv) : 120;
+
+    const char *levelEnv = getenv("BENCH_SVGZ_LEVEL");
+    if(levelEnv != NULL && atoi(levelEnv) >= 1 && atoi(levelEnv) <= 9) svgzLevel = atoi(levelEnv);
+
+    FILE *out = fopen(argv[1], "w");
+    if(out == NULL) {
+        fprintf(stderr, "Cannot write %s\n", argv[1]);
+        return 1;
+    }
+
+    bool sizeNamed = false, corpusNeeded = false;
+    for(int i = 2; i < argc; i++) sizeNamed = sizeNamed || isSizeName(argv[i]);
+    for(size_t b = 0; b < sizeof(benchmarks) / sizeof(benchmarks[0]); b++)
+        corpusNeeded = corpusNeeded || (!benchmarks[b].nested && !benchmarks[b].numbers &&
+                                        isSelected(&benchmarks[b], argc, argv));
+
+    fprintf(out, "{\"countsAllocations\":%s,\"svgzLevel\":%d,\"timestamp\":%lld,\"results\":[",
+            COUNTS_ALLOCATIONS ? "true" : "false", svgzLevel, (long long)time(NULL));
+    bool first = true, crashed = false;
+
+    for(size_t s = 0; s < sizeof(corpusSizes) / sizeof(corpusSizes[0]); s++) {
+        const CorpusSize *size = &corpusSizes[s];
+
+        bool selected = !sizeNamed;
+        for(int i = 2; i < argc; i++) selected = selected || strcmp(argv[i], size->name) == 0;
+        if(!selected) continue;
+
+        char corpusFile[64], scratchFile[64];
+        snprintf(corpusFile, sizeof(corpusFile), "/tmp/svgbench_%d_%s.svg", (int)getpid(), size->name);
+        snprintf(scratchFile, sizeof(scratchFile), "/tmp/svgbench_%d_%s_out.svg", (int)getpid(), size->name);
+
+        if(corpusNeeded && !writeCorpus(corpusFile, size->shapes)) {
+            fprintf(stderr, "Cannot write %s\n", corpusFile);
+            continue;
+        }
+
+        for(size_t b = 0; b < sizeof(benchmarks) / sizeof(benchmarks[0]); b++) {
+            if(!isSelected(&benchmarks[b], argc, argv)) continue;
+
+            char result[512];
+            crashed = runIsolated(&benchmarks[b], size, corpusFile, scratchFile, timeout, result, sizeof(result)) || crashed;
+
+            fprintf(out, "%s\n  %s", first ? "" : ",", result);
+            printf("%s\n", result);
+            fflush(stdout);
+            first = false;
+        }
+
+        remove(corpusFile);
+        remove(scratchFile);
+    }
+
+    fprintf(out, "\n]}\n");
+    fclose(out);
+    return crashed ? 1 : 0;
+}
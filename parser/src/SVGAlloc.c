@@ -0,0 +1,330 @@
+/**
+ * @file SVGAlloc.c
+ * @author Anthony Vidovic (1130891)
+ * @brief Pluggable allocator of the library, and an accounting allocator that attributes memory use to top level calls
+ * @version 0.1
+ * @date 2022-04-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+// ~~~~~ Includes ~~~~~ //
+#include "SVGHelper.h"
+#include <stdatomic.h>
+#include <stdint.h>
+
+// Most scopes counted at once on a thread.  Scopes nested deeper are counted only in the scopes enclosing them
+#define MAX_SCOPE_DEPTH 32
+// Most distinct scope names counted
+#define MAX_SCOPE_NAMES 128
+#define SCOPE_NAME_SIZE 64
+
+static void* accountingMalloc(size_t size);
+static void* accountingRealloc(void* ptr, size_t size);
+static void accountingFree(void* ptr);
+
+static const SVGAllocator standardAllocator = { malloc, realloc, free };
+static const SVGAllocator accountingAllocator = { accountingMalloc, accountingRealloc, accountingFree };
+static SVGAllocator allocator = { malloc, realloc, free };
+static bool accounting = false;
+
+/**
+ * @brief replaces the allocator of the library
+ *
+ * @param newAllocator NULL for malloc, realloc and free
+ */
+void setSVGAllocator(const SVGAllocator *newAllocator) {
+    allocator = newAllocator != NULL ? *newAllocator : standardAllocator;
+    accounting = allocator.malloc == accountingMalloc;
+}
+
+void* svgMalloc(size_t size) {
+    return allocator.malloc(size);
+}
+
+/**
+ * @brief allocates zeroed memory for count items of size bytes
+ *
+ * @param count
+ * @param size
+ * @return void* NULL if the size overflows or the allocation fails
+ */
+void* svgCalloc(size_t count, size_t size) {
+    if(size != 0 && count > SIZE_MAX / size) return NULL;
+
+    void *ptr = allocator.malloc(count * size);
+    if(ptr != NULL) memset(ptr, 0, count * size);
+
+    return ptr;
+}
+
+void* svgRealloc(void* ptr, size_t size) {
+    return allocator.realloc(ptr, size);
+}
+
+void svgFree(void* ptr) {
+    if(ptr != NULL) allocator.free(ptr);
+}
+
+/* ----------------------- */
+/* Accounting Allocator */
+/* ----------------------- */
+
+// Stored in front of every block of the accounting allocator.  The union keeps the block aligned
+typedef union {
+    size_t size;
+    max_align_t align;
+} BlockHeader;
+
+// Counts over all threads
+static atomic_size_t liveBytes = 0;
+static atomic_size_t peakBytes = 0;
+static atomic_ullong totalAllocations = 0;
+static atomic_ullong totalFrees = 0;
+
+// Counts of the calling thread, read by scopes.  Memory freed on another thread than it was allocated on
+// can make threadLive negative
+static _Thread_local unsigned long long threadAllocations = 0;
+static _Thread_local unsigned long long threadBytes = 0;
+static _Thread_local long long threadLive = 0;
+static _Thread_local long long threadPeak = 0;
+
+// Counts of the calling thread when a scope began
+typedef struct {
+    char name[SCOPE_NAME_SIZE];
+    unsigned long long allocations;
+    unsigned long long bytes;
+    long long live;
+    // Peak of the enclosing scope, restored when this one ends
+    long long outerPeak;
+} ScopeFrame;
+
+static _Thread_local ScopeFrame scopeStack[MAX_SCOPE_DEPTH];
+static _Thread_local int scopeDepth = 0;
+
+// Totals of every call of a scope name
+typedef struct {
+    char name[SCOPE_NAME_SIZE];
+    unsigned long calls;
+    unsigned long long allocations;
+    unsigned long long bytes;
+    long long maxPeak;
+    long long retained;
+} ScopeTotals;
+
+static ScopeTotals scopeTotals[MAX_SCOPE_NAMES];
+static int numScopeNames = 0;
+// Guards scopeTotals, taken once per scope end
+static atomic_flag scopeLock = ATOMIC_FLAG_INIT;
+
+/**
+ * @brief counts an allocation of size bytes
+ *
+ * @param size
+ */
+static void countAllocation(size_t size) {
+    size_t live = atomic_fetch_add_explicit(&liveBytes, size, memory_order_relaxed) + size;
+    size_t peak = atomic_load_explicit(&peakBytes, memory_order_relaxed);
+    while(live > peak && !atomic_compare_exchange_weak_explicit(&peakBytes, &peak, live, memory_order_relaxed, memory_order_relaxed));
+    atomic_fetch_add_explicit(&totalAllocations, 1, memory_order_relaxed);
+
+    threadAllocations++;
+    threadBytes += size;
+    threadLive += size;
+    if(threadLive > threadPeak) threadPeak = threadLive;
+}
+
+/**
+ * @brief counts a free of size bytes
+ *
+ * @param size
+ */
+static void countFree(size_t size) {
+    atomic_fetch_sub_explicit(&liveBytes, size, memory_order_relaxed);
+    atomic_fetch_add_explicit(&totalFrees, 1, memory_order_relaxed);
+    threadLive -= size;
+}
+
+static void* accountingMalloc(size_t size) {
+    if(size > SIZE_MAX - sizeof(BlockHeader)) return NULL;
+
+    BlockHeader *header = malloc(sizeof(BlockHeader) + size);
+    if(header == NULL) return NULL;
+
+    header->size = size;
+    countAllocation(size);
+    return header + 1;
+}
+
+static void accountingFree(void* ptr) {
+    if(ptr == NULL) return;
+
+    BlockHeader *header = (BlockHeader*)ptr - 1;
+    countFree(header->size);
+    free(header);
+}
+
+/**
+ * @brief resizes a block.  A resize is counted as an allocation of the new size and a free of the old one
+ *
+ * @param ptr
+ * @param size
+ * @return void*
+ */
+static void* accountingRealloc(void* ptr, size_t size) {
+    if(ptr == NULL) return accountingMalloc(size);
+    if(size > SIZE_MAX - sizeof(BlockHeader)) return NULL;
+
+    BlockHeader *header = (BlockHeader*)ptr - 1;
+    size_t oldSize = header->size;
+
+    header = realloc(header, sizeof(BlockHeader) + size);
+    if(header == NULL) return NULL;
+
+    header->size = size;
+    countFree(oldSize);
+    countAllocation(size);
+    return header + 1;
+}
+
+static char* accountingStrdup(const char* str) {
+    size_t length = strlen(str) + 1;
+    char *copy = accountingMalloc(length);
+    if(copy != NULL) memcpy(copy, str, length);
+
+    return copy;
+}
+
+/**
+ * @brief installs the accounting allocator for the library and libxml2
+ *
+ */
+void useAccountingAllocator(void) {
+    setSVGAllocator(&accountingAllocator);
+    xmlMemSetup(accountingFree, accountingMalloc, accountingRealloc, accountingStrdup);
+}
+
+/**
+ * @brief returns the number of allocations made by the calling thread through the accounting allocator
+ *
+ * @return unsigned long long always 0 if the accounting allocator is not installed
+ */
+unsigned long long threadAllocationCount(void) {
+    return threadAllocations;
+}
+
+/**
+ * @brief starts counting the memory use of the calling thread against a name
+ *
+ * @param name
+ */
+void beginSVGMemoryScope(const char* name) {
+    if(!accounting) return;
+
+    if(scopeDepth < MAX_SCOPE_DEPTH) {
+        ScopeFrame *frame = &scopeStack[scopeDepth];
+
+        // Keep names safe to write into JSON
+        int len = 0;
+        for(; name != NULL && *name != '\0' && len < SCOPE_NAME_SIZE - 1; name++)
+            if(isalnum((unsigned char)*name) || *name == '_' || *name == '/' || *name == '.') frame->name[len++] = *name;
+        frame->name[len] = '\0';
+
+        frame->allocations = threadAllocations;
+        frame->bytes = threadBytes;
+        frame->live = threadLive;
+        frame->outerPeak = threadPeak;
+        threadPeak = threadLive;
+    }
+    scopeDepth++;
+}
+
+/**
+ * @brief adds the counts of a finished scope to the totals of its name
+ *
+ * @param frame
+ */
+static void recordScope(const ScopeFrame *frame) {
+    while(atomic_flag_test_and_set_explicit(&scopeLock, memory_order_acquire));
+
+    int i = 0;
+    while(i < numScopeNames && strcmp(scopeTotals[i].name, frame->name) != 0) i++;
+
+    if(i == numScopeNames && numScopeNames < MAX_SCOPE_NAMES) {
+        memset(&scopeTotals[i], 0, sizeof(ScopeTotals));
+        strcpy(scopeTotals[i].name, frame->name);
+        numScopeNames++;
+    }
+
+    if(i < numScopeNames) {
+        ScopeTotals *totals = &scopeTotals[i];
+        long long peak = threadPeak - frame->live;
+
+        totals->calls++;
+        totals->allocations += threadAllocations - frame->allocations;
+        totals->bytes += threadBytes - frame->bytes;
+        totals->retained += threadLive - frame->live;
+        if(peak > totals->maxPeak) totals->maxPeak = peak;
+    }
+
+    atomic_flag_clear_explicit(&scopeLock, memory_order_release);
+}
+
+/**
+ * @brief ends the innermost scope of the calling thread
+ *
+ */
+void endSVGMemoryScope(void) {
+    if(!accounting || scopeDepth == 0) return;
+
+    scopeDepth--;
+    if(scopeDepth >= MAX_SCOPE_DEPTH) return;
+
+    const ScopeFrame *frame = &scopeStack[scopeDepth];
+    recordScope(frame);
+
+    if(frame->outerPeak > threadPeak) threadPeak = frame->outerPeak;
+}
+
+/**
+ * @brief returns the counts of the accounting allocator as JSON:
+ * {"accounting":true,"liveBytes":0,"peakBytes":0,"allocations":0,"frees":0,"scopes":{"name":{"calls":1,...},...}}
+ *
+ * @return char*
+ */
+char* getSVGMemoryStats(void) {
+    // Each scope takes at most SCOPE_NAME_SIZE characters and 6 numbers of up to 20 digits
+    size_t size = 256 + (size_t)MAX_SCOPE_NAMES * (SCOPE_NAME_SIZE + 256);
+    char *json = svgMalloc(size);
+
+    int len = snprintf(json, size, "{\"accounting\":%s,\"liveBytes\":%zu,\"peakBytes\":%zu,\"allocations\":%llu,\"frees\":%llu,\"scopes\":{",
+                       accounting ? "true" : "false", atomic_load(&liveBytes), atomic_load(&peakBytes),
+                       atomic_load(&totalAllocations), atomic_load(&totalFrees));
+
+    while(atomic_flag_test_and_set_explicit(&scopeLock, memory_order_acquire));
+    for(int i = 0; i < numScopeNames; i++) {
+        const ScopeTotals *totals = &scopeTotals[i];
+        len += snprintf(json + len, size - len, "%s\"%s\":{\"calls\":%lu,\"allocationsPerCall\":%.1f,\"bytesPerCall\":%.1f,\"peakBytes\":%lld,\"retainedBytes\":%lld}",
+                        i > 0 ? "," : "", totals->name, totals->calls, (double)totals->allocations / totals->calls,
+                        (double)totals->bytes / totals->calls, totals->maxPeak, totals->retained);
+    }
+    atomic_flag_clear_explicit(&scopeLock, memory_order_release);
+
+    snprintf(json + len, size - len, "}}");
+    return json;
+}
+
+/**
+ * @brief clears the counts of every scope, and sets the peak to the bytes in use
+ *
+ */
+void resetSVGMemoryStats(void) {
+    while(atomic_flag_test_and_set_explicit(&scopeLock, memory_order_acquire));
+    numScopeNames = 0;
+    atomic_flag_clear_explicit(&scopeLock, memory_order_release);
+
+    atomic_store(&peakBytes, atomic_load(&liveBytes));
+    atomic_store(&totalAllocations, 0);
+    atomic_store(&totalFrees, 0);
+}
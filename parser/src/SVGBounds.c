@@ -0,0 +1,553 @@
+/**
+ * @file SVGBounds.c
+ * @author Anthony Vidovic (1130891)
+ * @brief Bounding boxes of the rectangles, circles, paths and groups of an svg struct, and of the whole struct,
+ * computed once and kept until the struct is modified
+ * @version 0.1
+ * @date 2022-04-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+// ~~~~~ Includes ~~~~~ //
+#include "SVGHelper.h"
+
+// Extrema of a curve closer to an end than this, in the curve's parameter, are covered by the end itself
+#define CURVE_EPSILON 1e-9
+
+/**
+ * @brief returns a box that covers nothing.  Adding a point to it gives the box of that point
+ *
+ * @return BoundingBox
+ */
+static BoundingBox emptyBox(void) {
+    BoundingBox box = { INFINITY, INFINITY, -INFINITY, -INFINITY };
+    return box;
+}
+
+/**
+ * @brief returns true if a box covers nothing, like the box of emptyBox
+ *
+ * @param box
+ * @return true
+ * @return false if the box covers at least a point
+ */
+static bool boxIsEmpty(const BoundingBox *box) {
+    return !(box->minX <= box->maxX && box->minY <= box->maxY);
+}
+
+/**
+ * @brief grows a box to cover a point.  Points that are not finite are left out
+ *
+ * @param box
+ * @param x
+ * @param y
+ */
+static void addPoint(BoundingBox *box, double x, double y) {
+    if(!isfinite(x) || !isfinite(y)) return;
+
+    if(x < box->minX) box->minX = x;
+    if(x > box->maxX) box->maxX = x;
+    if(y < box->minY) box->minY = y;
+    if(y > box->maxY) box->maxY = y;
+}
+
+/**
+ * @brief grows a box to cover another box
+ *
+ * @param box
+ * @param other may be empty
+ */
+static void addBox(BoundingBox *box, const BoundingBox *other) {
+    if(boxIsEmpty(other)) return;
+
+    addPoint(box, other->minX, other->minY);
+    addPoint(box, other->maxX, other->maxY);
+}
+
+/**
+ * @brief finds where one coordinate of a cubic Bezier curve turns, the roots of its derivative in (0, 1)
+ *
+ * @param p0
+ * @param p1
+ * @param p2
+ * @param p3
+ * @param roots set to at most 2 parameters
+ * @return int number of roots
+ */
+static int cubicTurns(double p0, double p1, double p2, double p3, double *roots) {
+    // The derivative divided by 3 is a t^2 + b t + c
+    double a = -p0 + 3 * p1 - 3 * p2 + p3;
+    double b = 2 * (p0 - 2 * p1 + p2);
+    double c = p1 - p0;
+    double found[2];
+    int numFound = 0;
+
+    if(fabs(a) < CURVE_EPSILON) {
+        if(fabs(b) >= CURVE_EPSILON) found[numFound++] = -c / b;
+    } else {
+        double disc = b * b - 4 * a * c;
+        if(disc >= 0) {
+            double root = sqrt(disc);
+            found[numFound++] = (-b + root) / (2 * a);
+            found[numFound++] = (-b - root) / (2 * a);
+        }
+    }
+
+    int numRoots = 0;
+    for(int i = 0; i < numFound; i++) {
+        if(found[i] > CURVE_EPSILON && found[i] < 1 - CURVE_EPSILON) roots[numRoots++] = found[i];
+    }
+    return numRoots;
+}
+
+/**
+ * @brief grows a box to cover a cubic Bezier curve: its end points and the points where it turns
+ *
+ * @param box
+ * @param x coordinates of the start, the two control points and the end
+ * @param y
+ */
+static void addCubic(BoundingBox *box, const double *x, const double *y) {
+    addPoint(box, x[0], y[0]);
+    addPoint(box, x[3], y[3]);
+
+    double roots[4];
+    int numRoots = cubicTurns(x[0], x[1], x[2], x[3], roots);
+    numRoots += cubicTurns(y[0], y[1], y[2], y[3], roots + numRoots);
+
+    for(int i = 0; i < numRoots; i++) {
+        double t = roots[i], u = 1 - t;
+        double w0 = u * u * u, w1 = 3 * u * u * t, w2 = 3 * u * t * t, w3 = t * t * t;
+        addPoint(box, w0 * x[0] + w1 * x[1] + w2 * x[2] + w3 * x[3], w0 * y[0] + w1 * y[1] + w2 * y[2] + w3 * y[3]);
+    }
+}
+
+/**
+ * @brief returns true if an angle is on an arc swept from start through delta radians
+ *
+ * @param angle
+ * @param start
+ * @param delta negative for an arc swept clockwise
+ * @return true
+ * @return false
+ */
+static bool angleOnArc(double angle, double start, double delta) {
+    double offset = fmod(delta >= 0 ? angle - start : start - angle, 2 * M_PI);
+    if(offset < 0) offset += 2 * M_PI;
+
+    return offset <= fabs(delta);
+}
+
+/**
+ * @brief grows a box to cover an elliptical arc: its end points, and the points of its ellipse where x or y
+ * turns that lie on the swept part
+ *
+ * @param box
+ * @param arc
+ */
+static void addArc(BoundingBox *box, const PathSegment *arc) {
+    addPoint(box, arc->x[0], arc->y[0]);
+    addPoint(box, arc->x[3], arc->y[3]);
+
+    ArcCenter center;
+    if(!getArcCenter(arc, &center)) return;
+
+    // x turns where tan(angle) = -ry sin(phi) / (rx cos(phi)), y where tan(angle) = ry cos(phi) / (rx sin(phi))
+    double turnX = atan2(-center.ry * center.sinPhi, center.rx * center.cosPhi);
+    double turnY = atan2(center.ry * center.cosPhi, center.rx * center.sinPhi);
+    double turns[4] = { turnX, turnX + M_PI, turnY, turnY + M_PI };
+
+    for(int i = 0; i < 4; i++) {
+        if(!angleOnArc(turns[i], center.start, center.delta)) continue;
+
+        double x, y;
+        arcPoint(&center, turns[i], &x, &y);
+        addPoint(box, x, y);
+    }
+}
+
+/**
+ * @brief grows the box passed as the context to cover a path segment
+ *
+ * @param segment
+ * @param box
+ */
+static void addPathSegment(const PathSegment *segment, void *box) {
+    switch(segment->type) {
+        case PATH_LINE:
+            addPoint(box, segment->x[0], segment->y[0]);
+            addPoint(box, segment->x[3], segment->y[3]);
+            break;
+        case PATH_CUBIC:
+            addCubic(box, segment->x, segment->y);
+            break;
+        case PATH_ARC:
+            addArc(box, segment);
+            break;
+        default:
+            // Moves that draw nothing are left out
+            break;
+    }
+}
+
+/**
+ * @brief computes the bounding box of path data from its commands: the points drawn through, and the extremes
+ * of its curves and arcs.  The data is read up to its first error, as a renderer draws it.  The stroke is
+ * not included
+ *
+ * @param data
+ * @param box set to the box, empty if the data draws nothing
+ * @return true
+ * @return false if the data draws nothing
+ */
+bool getPathBounds(const char *data, BoundingBox *box) {
+    *box = emptyBox();
+    walkPathData(data, addPathSegment, box);
+
+    return !boxIsEmpty(box);
+}
+
+/**
+ * @brief computes the bounding box of a rectangle, circle or path from its geometry
+ *
+ * @param type
+ * @param element
+ * @return BoundingBox empty for groups, and for shapes that are not finite
+ */
+static BoundingBox shapeBounds(elementType type, const void *element) {
+    BoundingBox box = emptyBox();
+
+    if(type == RECT) {
+        const Rectangle *r = (const Rectangle*)element;
+        addPoint(&box, r->x, r->y);
+        addPoint(&box, (double)r->x + r->width, (double)r->y + r->height);
+    } else if(type == CIRC) {
+        const Circle *c = (const Circle*)element;
+        if(isfinite(c->r)) {
+            addPoint(&box, (double)c->cx - c->r, (double)c->cy - c->r);
+            addPoint(&box, (double)c->cx + c->r, (double)c->cy + c->r);
+        }
+    } else if(type == PATH) {
+        getPathBounds(((const Path*)element)->data, &box);
+    }
+
+    return box;
+}
+
+/**
+ * @brief returns the slot of an element's address in the address table of a cache
+ *
+ * @param cache
+ * @param element
+ * @return int the slot holding the element, or the empty slot where it would go
+ */
+static int boundsSlot(const BoundsCache *cache, const void *element) {
+    uint64_t key = (uint64_t)(uintptr_t)element;
+    int mask = cache->tableSize - 1;
+    // Fibonacci hashing spreads the aligned addresses over the table
+    int slot = (int)((key * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+
+    while(cache->keys[slot] != NULL && cache->keys[slot] != element) slot = (slot + 1) & mask;
+    return slot;
+}
+
+/**
+ * @brief returns the box of an element of the struct a cache was built for
+ *
+ * @param cache
+ * @param type
+ * @param element
+ * @return BoundingBox
+ */
+static BoundingBox cachedBounds(const BoundsCache *cache, elementType type, const void *element) {
+    int slot = boundsSlot(cache, element);
+    if(cache->keys[slot] != NULL) return cache->boxes[cache->ids[slot]];
+
+    return shapeBounds(type, element);
+}
+
+/**
+ * @brief grows a box to cover the cached boxes of the shapes and groups in a set of lists
+ *
+ * @param cache
+ * @param box
+ * @param rectangles
+ * @param circles
+ * @param paths
+ * @param groups
+ */
+static void addChildBounds(const BoundsCache *cache, BoundingBox *box, const List *rectangles, const List *circles,
+                           const List *paths, const List *groups) {
+    const List *lists[] = { rectangles, circles, paths, groups };
+    const elementType listTypes[] = { RECT, CIRC, PATH, GROUP };
+
+    for(int i = 0; i < 4; i++) {
+        for(Node *cur = lists[i]->head; cur; cur = cur->next) {
+            BoundingBox child = cachedBounds(cache, listTypes[i], cur->data);
+            addBox(box, &child);
+        }
+    }
+}
+
+/**
+ * @brief frees a bounds cache
+ *
+ * @param cache
+ */
+void freeBoundsCache(BoundsCache *cache) {
+    if(cache == NULL) return;
+
+    svgFree(cache->boxes);
+    svgFree(cache->keys);
+    svgFree(cache->ids);
+    svgFree(cache);
+}
+
+/**
+ * @brief discards the bounding boxes of an svg struct, they are computed again by the next bounds query
+ *
+ * @param svg
+ */
+void invalidateBounds(SVG *svg) {
+    if(svg == NULL) return;
+
+    freeBoundsCache(svg->bounds);
+    svg->bounds = NULL;
+}
+
+/**
+ * @brief computes the box of every element of an svg struct, and of the struct.  Shapes are computed from
+ * their geometry, then groups from the boxes of their children, the groups nested deepest first
+ *
+ * @param svg
+ * @return BoundsCache* NULL if it cannot be allocated
+ */
+static BoundsCache* buildBounds(const SVG *svg) {
+    BoundsCache *cache = svgCalloc(1, sizeof(BoundsCache));
+    if(cache == NULL) return NULL;
+
+    cache->length = svg->numElements;
+    cache->boxes = svgMalloc(sizeof(BoundingBox) * (cache->length > 0 ? cache->length : 1));
+
+    // The table is at most half full
+    cache->tableSize = 16;
+    while(cache->tableSize < 2 * cache->length) cache->tableSize *= 2;
+    cache->keys = svgCalloc(cache->tableSize, sizeof(void*));
+    cache->ids = svgMalloc(sizeof(int) * cache->tableSize);
+
+    if(cache->boxes == NULL || cache->keys == NULL || cache->ids == NULL) {
+        freeBoundsCache(cache);
+        return NULL;
+    }
+
+    for(int id = 0; id < cache->length; id++) {
+        const ElementRef *ref = &svg->elements[id];
+        cache->boxes[id] = shapeBounds(ref->type, ref->node->data);
+
+        int slot = boundsSlot(cache, ref->node->data);
+        cache->keys[slot] = ref->node->data;
+        cache->ids[slot] = id;
+    }
+
+    // A walk returns each group before the groups nested in it, so groups are boxed in the reverse order
+    Group **groups = NULL;
+    int numGroups = 0, capacity = 0;
+    GroupWalk walk;
+    beginGroupWalk(&walk, svg->groups);
+
+    for(Group *g = nextGroup(&walk); g; g = nextGroup(&walk)) {
+        if(numGroups == capacity) {
+            Group **grown = growStack(groups, &capacity, sizeof(Group*));
+            if(grown == NULL) {
+                walk.failed = true;
+                break;
+            }
+            groups = grown;
+        }
+        groups[numGroups++] = g;
+    }
+
+    bool failed = walk.failed;
+    endGroupWalk(&walk);
+    if(failed) {
+        svgFree(groups);
+        freeBoundsCache(cache);
+        return NULL;
+    }
+
+    for(int i = numGroups - 1; i >= 0; i--) {
+        const Group *g = groups[i];
+        int slot = boundsSlot(cache, g);
+        if(cache->keys[slot] == NULL) continue;
+
+        BoundingBox box = emptyBox();
+        addChildBounds(cache, &box, g->rectangles, g->circles, g->paths, g->groups);
+        cache->boxes[cache->ids[slot]] = box;
+    }
+    svgFree(groups);
+
+    cache->document = emptyBox();
+    addChildBounds(cache, &cache->document, svg->rectangles, svg->circles, svg->paths, svg->groups);
+
+    return cache;
+}
+
+/**
+ * @brief returns the bounds cache of an svg struct, building it if needed
+ *
+ * @param svg
+ * @return BoundsCache* NULL if it cannot be built
+ */
+static BoundsCache* getBoundsCache(const SVG *svg) {
+    // The boxes are a cache, computing them does not change the document
+    SVG *img = (SVG*)svg;
+
+    if(img->bounds == NULL) img->bounds = buildBounds(svg);
+    return img->bounds;
+}
+
+/**
+ * @brief Function that returns the bounding box of the element with the given ID
+ *
+ * @param img
+ * @param id
+ * @param box
+ * @return true
+ * @return false if there is no such element, or it draws nothing
+ */
+bool getElementBounds(const SVG* img, int id, BoundingBox* box) {
+    if(img == NULL || box == NULL || id < 0 || id >= img->numElements) return false;
+
+    BoundsCache *cache = getBoundsCache(img);
+    if(cache == NULL) return false;
+
+    *box = cache->boxes[id];
+    return !boxIsEmpty(box);
+}
+
+/**
+ * @brief Function that returns the bounding box of a rectangle, circle, path or group of the struct
+ *
+ * @param img
+ * @param type
+ * @param element
+ * @param box
+ * @return true
+ * @return false if the element draws nothing
+ */
+bool getComponentBounds(const SVG* img, elementType type, const void* element, BoundingBox* box) {
+    if(img == NULL || element == NULL || box == NULL) return false;
+
+    BoundsCache *cache = getBoundsCache(img);
+    if(cache == NULL) return false;
+
+    *box = cachedBounds(cache, type, element);
+    return !boxIsEmpty(box);
+}
+
+/**
+ * @brief Function that returns the bounding box of everything an svg struct draws
+ *
+ * @param img
+ * @param box
+ * @return true
+ * @return false if the struct draws nothing
+ */
+bool getSVGBounds(const SVG* img, BoundingBox* box) {
+    if(img == NULL || box == NULL) return false;
+
+    BoundsCache *cache = getBoundsCache(img);
+    if(cache == NULL) return false;
+
+    *box = cache->document;
+    return !boxIsEmpty(box);
+}
+
+/**
+ * @brief appends a box as JSON, null if it is empty
+ *
+ * @param buffer
+ * @param box
+ */
+static void appendBoxJSON(StringBuffer *buffer, const BoundingBox *box) {
+    if(boxIsEmpty(box)) {
+        appendString(buffer, "null");
+        return;
+    }
+
+    char minX[FLOAT_STRING_SIZE], minY[FLOAT_STRING_SIZE], maxX[FLOAT_STRING_SIZE], maxY[FLOAT_STRING_SIZE];
+    formatFloat(box->minX, minX);
+    formatFloat(box->minY, minY);
+    formatFloat(box->maxX, maxX);
+    formatFloat(box->maxY, maxY);
+
+    char json[4 * FLOAT_STRING_SIZE + 48];
+    snprintf(json, sizeof(json), "{\"minX\":%s,\"minY\":%s,\"maxX\":%s,\"maxY\":%s}", minX, minY, maxX, maxY);
+    appendString(buffer, json);
+}
+
+/**
+ * @brief appends the boxes of the elements of a list as a JSON array
+ *
+ * @param buffer
+ * @param cache
+ * @param type
+ * @param list
+ */
+static void appendListBoundsJSON(StringBuffer *buffer, const BoundsCache *cache, elementType type, const List *list) {
+    appendString(buffer, "[");
+    for(Node *cur = list->head; cur; cur = cur->next) {
+        BoundingBox box = cachedBounds(cache, type, cur->data);
+        if(cur != list->head) appendString(buffer, ",");
+        appendBoxJSON(buffer, &box);
+    }
+    appendString(buffer, "]");
+}
+
+/**
+ * @brief builds the JSON of getSVGBoundsWrapper for a cached struct
+ *
+ * @param svg
+ * @param context set to the JSON
+ */
+static void boundsToJSON(SVG *svg, void *context) {
+    BoundsCache *cache = getBoundsCache(svg);
+    if(cache == NULL) return;
+
+    StringBuffer buffer;
+    if(!initStringBuffer(&buffer, 256)) return;
+    appendString(&buffer, "{\"svg\":");
+    appendBoxJSON(&buffer, &cache->document);
+    appendString(&buffer, ",\"rects\":");
+    appendListBoundsJSON(&buffer, cache, RECT, svg->rectangles);
+    appendString(&buffer, ",\"circles\":");
+    appendListBoundsJSON(&buffer, cache, CIRC, svg->circles);
+    appendString(&buffer, ",\"paths\":");
+    appendListBoundsJSON(&buffer, cache, PATH, svg->paths);
+    appendString(&buffer, ",\"groups\":");
+    appendListBoundsJSON(&buffer, cache, GROUP, svg->groups);
+    if(!appendString(&buffer, "}")) {
+        svgFree(buffer.data);
+        return;
+    }
+
+    *(char**)context = buffer.data;
+}
+
+/**
+ * @brief returns the bounding boxes of a file for the server as
+ * {"svg":{"minX":0,"minY":0,"maxX":10,"maxY":10},"rects":[...],"circles":[...],"paths":[...],"groups":[...]},
+ * with a box for each top level component in the order of getSVGRects and the other lists, and null for
+ * anything that draws nothing.  The struct and its boxes are cached until the file changes
+ *
+ * @param filename
+ * @param schemaFile
+ * @return char* NULL if the file cannot be read or is not valid, or the JSON cannot be allocated
+ */
+char *getSVGBoundsWrapper(char *filename, char *schemaFile) {
+    char *json = NULL;
+    useCachedSVG(filename, schemaFile, boundsToJSON, &json);
+    return json;
+}
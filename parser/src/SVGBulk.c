@@ -0,0 +1,284 @@
+/**
+ * @file SVGBulk.c
+ * @author Anthony Vidovic (1130891)
+ * @brief Adding many shapes to an svg struct at once
+ * @version 0.1
+ * @date 2022-04-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+// ~~~~~ Includes ~~~~~ //
+#include "SVGHelper.h"
+
+/**
+ * @brief finds the lists a bulk add appends to: the lists of a group, or the top level lists of the image
+ *
+ * @param img
+ * @param groupID element ID of a group, or -1 for the top level of the image
+ * @param target set to the group, or NULL for the top level
+ * @return true
+ * @return false if groupID is not -1 and is not the ID of a group
+ */
+static bool findTarget(const SVG *img, int groupID, Group **target) {
+    *target = NULL;
+    if(groupID == -1) return true;
+
+    elementType type;
+    Group *group = getElementByID(img, groupID, &type);
+    if(group == NULL || type != GROUP) return false;
+
+    *target = group;
+    return true;
+}
+
+/**
+ * @brief appends one shape to a group or to the top level of an image, registering it and updating the totals.
+ * The caches are invalidated once by the caller rather than per shape
+ *
+ * @param img
+ * @param target group to add to, or NULL for the top level
+ * @param type RECT, CIRC or PATH
+ * @param shape
+ */
+static void appendShape(SVG *img, Group *target, elementType type, void *shape) {
+    List *list = NULL;
+    List *attributes = NULL;
+
+    if(type == RECT) {
+        list = target ? target->rectangles : img->rectangles;
+        attributes = ((Rectangle*)shape)->otherAttributes;
+        img->totals.rects++;
+    } else if(type == CIRC) {
+        list = target ? target->circles : img->circles;
+        attributes = ((Circle*)shape)->otherAttributes;
+        img->totals.circles++;
+    } else {
+        list = target ? target->paths : img->paths;
+        attributes = ((Path*)shape)->otherAttributes;
+        img->totals.paths++;
+        img->totals.pathBytes += strlen(((Path*)shape)->data);
+    }
+
+    insertBack(list, shape);
+    registerElement(img, type, list->tail);
+    img->totals.attributes += attributes->length;
+}
+
+/**
+ * @brief frees a shape that was never added to an image
+ *
+ * @param type
+ * @param shape
+ */
+static void deleteShape(elementType type, void *shape) {
+    if(type == RECT) deleteRectangle(shape);
+    else if(type == CIRC) deleteCircle(shape);
+    else deletePath(shape);
+}
+
+/**
+ * @brief returns the type of a shape object: its "type" key if it has one, otherwise inferred from
+ * its keys - "d" is a path, "r" is a circle, anything else is a rectangle
+ *
+ * @param doc
+ * @param object
+ * @param type set to RECT, CIRC or PATH
+ * @return true
+ * @return false if the "type" key names something other than a shape
+ */
+static bool shapeType(const JsonDocument *doc, int object, elementType *type) {
+    int token = jsonObjectGet(doc, object, "type");
+
+    if(token < 0) {
+        if(jsonObjectGet(doc, object, "d") >= 0) *type = PATH;
+        else if(jsonObjectGet(doc, object, "r") >= 0) *type = CIRC;
+        else *type = RECT;
+        return true;
+    }
+
+    char name[16];
+    int len = jsonGetString(doc, token, name, sizeof(name));
+    if(doc->tokens[token].type != JSON_STRING || len < 0 || (size_t)len >= sizeof(name)) return false;
+
+    if(strcmp(name, "rect") == 0 || strcmp(name, "rectangle") == 0) *type = RECT;
+    else if(strcmp(name, "circle") == 0) *type = CIRC;
+    else if(strcmp(name, "path") == 0) *type = PATH;
+    else return false;
+
+    return true;
+}
+
+/**
+ * @brief adds every shape of a JSON array to an svg struct. Each object is read like rectFromJSON,
+ * circleFromJSON or pathFromJSON, and may carry a "type" key of "rect", "circle" or "path".
+ * Either every shape is added or none is
+ *
+ * @param img
+ * @param groupID element ID of the group to add to, or -1 for the top level
+ * @param json array of shape objects
+ * @return int number of shapes added, -1 if the JSON, a shape or the group is invalid
+ */
+int addShapesJSON(SVG* img, int groupID, const char* json) {
+    Group *target;
+    if(img == NULL || json == NULL || !findTarget(img, groupID, &target)) return -1;
+
+    JsonDocument doc;
+    if(!parseJSON(json, &doc) || doc.tokens[0].type != JSON_ARRAY) {
+        freeJSON(&doc);
+        return -1;
+    }
+
+    int count = doc.tokens[0].size;
+    void **shapes = svgMalloc(sizeof(void*) * (count + 1));
+    elementType *types = svgMalloc(sizeof(elementType) * (count + 1));
+    if(shapes == NULL || types == NULL) {
+        svgFree(shapes);
+        svgFree(types);
+        freeJSON(&doc);
+        return -1;
+    }
+
+    // Every shape is built before any is added, so a bad shape leaves the struct untouched
+    int built = 0;
+    bool valid = true;
+    for(int token = 1; built < count; built++, token = doc.tokens[token].next) {
+        if(!shapeType(&doc, token, &types[built])) {
+            valid = false;
+            break;
+        }
+
+        if(types[built] == RECT) shapes[built] = rectFromJSON(&doc, token);
+        else if(types[built] == CIRC) shapes[built] = circleFromJSON(&doc, token);
+        else shapes[built] = pathFromJSON(&doc, token);
+
+        if(shapes[built] == NULL) {
+            valid = false;
+            break;
+        }
+    }
+    freeJSON(&doc);
+
+    // The element table has room for every shape before the first is added, so adding them cannot fail halfway
+    valid = valid && reserveElements(img, count);
+    if(valid) {
+        for(int i = 0; i < count; i++) appendShape(img, target, types[i], shapes[i]);
+
+        markSVGModified(img);
+        invalidateAreaIndexes(img);
+    } else {
+        for(int i = 0; i < built; i++) deleteShape(types[i], shapes[i]);
+    }
+
+    svgFree(shapes);
+    svgFree(types);
+    return valid ? count : -1;
+}
+
+/**
+ * @brief builds a rectangle or circle from a record of packed floats
+ *
+ * @param type RECT or CIRC
+ * @param record x, y, width, height (RECT) or cx, cy, r (CIRC)
+ * @param units
+ * @return void* NULL if it cannot be allocated
+ */
+static void* packedShape(elementType type, const float *record, lengthUnit units) {
+    if(type == RECT) {
+        Rectangle *rect = svgMalloc(sizeof(Rectangle));
+        if(rect == NULL) return NULL;
+
+        rect->x = record[0];
+        rect->y = record[1];
+        rect->width = record[2];
+        rect->height = record[3];
+        rect->units = units;
+        rect->otherAttributes = initializeList(&attributeToString, &deleteAttribute, &compareAttributes);
+        if(rect->otherAttributes == NULL) {
+            svgFree(rect);
+            return NULL;
+        }
+        return rect;
+    }
+
+    Circle *circle = svgMalloc(sizeof(Circle));
+    if(circle == NULL) return NULL;
+
+    circle->cx = record[0];
+    circle->cy = record[1];
+    circle->r = record[2];
+    circle->units = units;
+    circle->otherAttributes = initializeList(&attributeToString, &deleteAttribute, &compareAttributes);
+    if(circle->otherAttributes == NULL) {
+        svgFree(circle);
+        return NULL;
+    }
+    return circle;
+}
+
+/**
+ * @brief adds shapes stored as packed floats to an svg struct: x, y, width, height per rectangle,
+ * or cx, cy, r per circle.  Either every shape is added or none is
+ *
+ * @param img
+ * @param groupID element ID of the group to add to, or -1 for the top level
+ * @param type RECT or CIRC
+ * @param values numShapes records of 4 (RECT) or 3 (CIRC) floats
+ * @param numShapes
+ * @param units units of every added shape
+ * @return int number of shapes added, -1 if the arguments or the group are invalid, or the shapes cannot be
+ * allocated
+ */
+int addShapesPacked(SVG* img, int groupID, elementType type, const float* values, int numShapes, lengthUnit units) {
+    Group *target;
+    if(img == NULL || (values == NULL && numShapes > 0) || numShapes < 0) return -1;
+    if((type != RECT && type != CIRC) || units < UNIT_NONE || units >= UNIT_INVALID) return -1;
+    if(!findTarget(img, groupID, &target)) return -1;
+
+    void **shapes = svgMalloc(sizeof(void*) * (numShapes + 1));
+    if(shapes == NULL) return -1;
+
+    // As in addShapesJSON, every shape is built and the element table grown before any is added
+    int stride = type == RECT ? 4 : 3;
+    int built = 0;
+    while(built < numShapes && (shapes[built] = packedShape(type, &values[built * stride], units)) != NULL) built++;
+
+    bool valid = built == numShapes && reserveElements(img, numShapes);
+    if(valid) {
+        for(int i = 0; i < numShapes; i++) appendShape(img, target, type, shapes[i]);
+
+        markSVGModified(img);
+        invalidateAreaIndexes(img);
+    } else {
+        for(int i = 0; i < built; i++) deleteShape(type, shapes[i]);
+    }
+
+    svgFree(shapes);
+    return valid ? numShapes : -1;
+}
+
+/**
+ * @brief adds a JSON array of shapes to an svg file, validating and writing the file once
+ *
+ * @param filename
+ * @param schemaFile
+ * @param groupID element ID of the group to add to, or -1 for the top level
+ * @param json
+ * @return true
+ * @return false if the file, a shape or the result is invalid. The file is not written unless every shape is added
+ */
+bool addShapesWrapper(char *filename, char *schemaFile, int groupID, char *json) {
+    SVG *svg = createValidSVG(filename, schemaFile);
+
+    bool isValid = validateSVG(svg, schemaFile);
+    if(!isValid || addShapesJSON(svg, groupID, json) < 0) {
+        deleteSVG(svg);
+        return false;
+    }
+
+    isValid = validateSVG(svg, schemaFile) && writeSVG(svg, filename);
+
+    deleteSVG(svg);
+    return isValid;
+}
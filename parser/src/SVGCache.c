@@ -0,0 +1,953 @@
+/**
+ * @file SVGCache.c
+ * @author Anthony Vidovic (1130891)
+ * @brief Per file cache of the serialized JSON description of svg files, as sent by the server's /getSVGData
+ * route, of their content hashes, used as ETags, and of their PNG thumbnails
+ * @version 0.1
+ * @date 2022-04-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+// stat's nanosecond modification time is POSIX, not C11
+#define _POSIX_C_SOURCE 200809L
+
+// ~~~~~ Includes ~~~~~ //
+#include "SVGHelper.h"
+#include <sys/stat.h>
+#include <limits.h>
+#include <pthread.h>
+
+// Default limit on the combined size of the cached responses and thumbnails
+#define DEFAULT_CACHE_LIMIT (64 * 1024 * 1024)
+
+// 64 bit FNV-1a prime, the offset basis is SVG_HASH_SEED
+#define FNV_PRIME 0x100000001b3ULL
+
+// Buckets of the table the cached files are found by
+#define CACHE_BUCKETS 1024
+
+// What is cached about a file.  It is used only while the file still has the size, modification time and
+// inode it had when the entry was made
+typedef struct CacheEntry {
+    char *path;
+    // Response and the schema it was validated against.  NULL if only the hash is known
+    char *schemaFile;
+    off_t size;
+    struct timespec mtime;
+    dev_t device;
+    ino_t inode;
+    char *json;
+    size_t length;
+    // Content hash of the file, valid if hasHash is set
+    uint64_t hash;
+    bool hasHash;
+    // PNG thumbnail at most thumbnailWidth by thumbnailHeight pixels, drawn from the file if it was valid against
+    // thumbnailSchema.  NULL if none was drawn
+    unsigned char *thumbnail;
+    size_t thumbnailLength;
+    int thumbnailWidth;
+    int thumbnailHeight;
+    char *thumbnailSchema;
+    // Least recently used order, most recent first
+    struct CacheEntry *prev;
+    struct CacheEntry *next;
+    // Next entry in the same bucket
+    struct CacheEntry *chain;
+} CacheEntry;
+
+// Guards every entry, the counters and the limit.  Files are parsed and thumbnails drawn with it released
+static pthread_mutex_t cacheLock = PTHREAD_MUTEX_INITIALIZER;
+
+static CacheEntry *cacheBuckets[CACHE_BUCKETS] = { NULL };
+static CacheEntry *cacheHead = NULL;
+static CacheEntry *cacheTail = NULL;
+static size_t cacheBytes = 0;
+static size_t cacheLimit = DEFAULT_CACHE_LIMIT;
+static SVGCacheStats cacheStats = { 0 };
+
+// A response or thumbnail too large to cache, kept until the thread's next lookup so the returned pointer stays valid
+static _Thread_local char *uncachedJSON = NULL;
+static _Thread_local unsigned char *uncachedThumbnail = NULL;
+
+// Copy of the last response getSVGDataWrapper returned on the thread
+static _Thread_local char *wrapperJSON = NULL;
+
+/**
+ * @brief starts an empty string buffer
+ *
+ * @param buffer
+ * @param capacity bytes allocated to begin with, at least 1
+ * @return true
+ * @return false if it cannot be allocated, leaving the buffer failed
+ */
+bool initStringBuffer(StringBuffer *buffer, size_t capacity) {
+    buffer->data = svgMalloc(capacity);
+    buffer->length = 0;
+    buffer->capacity = capacity;
+    buffer->failed = buffer->data == NULL;
+    if(buffer->failed) return false;
+
+    buffer->data[0] = '\0';
+    return true;
+}
+
+/**
+ * @brief appends bytes to a string buffer, keeping it terminated.  If the buffer cannot grow its contents are
+ * kept as they were and it is marked failed, so a caller may check once after building it
+ *
+ * @param buffer
+ * @param str
+ * @param length
+ * @return true
+ * @return false if the buffer has failed
+ */
+bool appendBytes(StringBuffer *buffer, const char *str, size_t length) {
+    if(buffer->failed) return false;
+
+    if(buffer->length + length + 1 > buffer->capacity) {
+        size_t capacity = buffer->capacity * 2;
+        while(capacity < buffer->length + length + 1) capacity *= 2;
+
+        char *data = svgRealloc(buffer->data, capacity);
+        if(data == NULL) {
+            buffer->failed = true;
+            return false;
+        }
+        buffer->data = data;
+        buffer->capacity = capacity;
+    }
+
+    memcpy(buffer->data + buffer->length, str, length);
+    buffer->length += length;
+    buffer->data[buffer->length] = '\0';
+    return true;
+}
+
+/**
+ * @brief appends a string to a string buffer
+ *
+ * @param buffer
+ * @param str
+ * @return true
+ * @return false if the buffer has failed
+ */
+bool appendString(StringBuffer *buffer, const char *str) {
+    return appendBytes(buffer, str, strlen(str));
+}
+
+/**
+ * @brief appends a string as a quoted JSON string, escaping quotes, backslashes and control characters
+ *
+ * @param buffer
+ * @param str
+ * @return true
+ * @return false if the buffer has failed
+ */
+bool appendJSONString(StringBuffer *buffer, const char *str) {
+    appendBytes(buffer, "\"", 1);
+
+    const char *run = str;
+    for(const char *c = str; *c && !buffer->failed; c++) {
+        unsigned char ch = (unsigned char)*c;
+        if(ch != '"' && ch != '\\' && ch >= 0x20) continue;
+
+        appendBytes(buffer, run, c - run);
+        run = c + 1;
+
+        char escaped[8];
+        if(ch == '"' || ch == '\\') snprintf(escaped, sizeof(escaped), "\\%c", ch);
+        else if(ch == '\n') strcpy(escaped, "\\n");
+        else if(ch == '\t') strcpy(escaped, "\\t");
+        else if(ch == '\r') strcpy(escaped, "\\r");
+        else snprintf(escaped, sizeof(escaped), "\\u%04x", ch);
+        appendString(buffer, escaped);
+    }
+
+    appendString(buffer, run);
+    return appendBytes(buffer, "\"", 1);
+}
+
+/**
+ * @brief appends the JSON of one shape or group with its other attributes added as a string of JSON,
+ * the form the front end expects
+ *
+ * @param buffer
+ * @param json object written by rectToJSON, circleToJSON, pathToJSON or groupToJSON, freed here
+ * @param otherAttributes
+ */
+static void appendComponent(StringBuffer *buffer, char *json, const List *otherAttributes) {
+    char *attributes = attrListToJSON(otherAttributes);
+
+    // Drop the closing brace of the object to add the key
+    appendBytes(buffer, json, strlen(json) - 1);
+    appendString(buffer, strcmp(json, "{}") == 0 ? "\"otherAttributes\":" : ",\"otherAttributes\":");
+    appendJSONString(buffer, attributes);
+    appendBytes(buffer, "}", 1);
+
+    svgFree(attributes);
+    svgFree(json);
+}
+
+// Arrays of the /getSVGData response, in the order a walk visits the top level
+#define NUM_DATA_SECTIONS 4
+static const elementType sectionTypes[NUM_DATA_SECTIONS] = { RECT, CIRC, PATH, GROUP };
+static const char *sectionNames[NUM_DATA_SECTIONS] = { "rectangles", "circles", "paths", "groups" };
+
+// Context of the visitor writing the arrays of the response
+typedef struct {
+    StringBuffer *buffer;
+    // Index of the array being written, -1 before the first
+    int section;
+    // Components written to the array so far
+    int count;
+} DataSections;
+
+/**
+ * @brief closes the array being written and opens the following ones up to a section, leaving
+ * the arrays of types without components empty
+ *
+ * @param sections
+ * @param section
+ */
+static void openSection(DataSections *sections, int section) {
+    while(sections->section < section) {
+        appendString(sections->buffer, sections->section < 0 ? ",\"" : "],\"");
+        sections->section++;
+        appendString(sections->buffer, sectionNames[sections->section]);
+        appendString(sections->buffer, "\":[");
+        sections->count = 0;
+    }
+}
+
+/**
+ * @brief visitor that writes a top level component to its array of the response, with its other attributes
+ *
+ * @param element
+ * @param context the DataSections being written
+ */
+static void appendDataComponent(const VisitedElement *element, void *context) {
+    DataSections *sections = (DataSections*)context;
+
+    int section = 0;
+    while(sectionTypes[section] != element->type) section++;
+    openSection(sections, section);
+    if(sections->count++ > 0) appendBytes(sections->buffer, ",", 1);
+
+    char *json;
+    switch(element->type) {
+        case RECT: json = rectToJSON((Rectangle*)element->data); break;
+        case CIRC: json = circleToJSON((Circle*)element->data); break;
+        case PATH: json = pathToJSON((Path*)element->data); break;
+        default: json = groupToJSON((Group*)element->data); break;
+    }
+    appendComponent(sections->buffer, json, otherAttributesOf(element));
+}
+
+/**
+ * @brief builds the /getSVGData response for an svg struct: its title, description and top level
+ * components, each with its other attributes.  The components are written and counted in one walk of the top level
+ *
+ * @param svg
+ * @param length set to the length of the response
+ * @return char* NULL if it cannot be allocated
+ */
+static char* buildSVGData(const SVG *svg, size_t *length) {
+    PhaseTimer start = startPhase();
+    StringBuffer buffer;
+    if(!initStringBuffer(&buffer, 4096)) return NULL;
+
+    appendString(&buffer, "{\"valid\":true,\"title\":");
+    appendJSONString(&buffer, svg->title);
+    appendString(&buffer, ",\"desc\":");
+    appendJSONString(&buffer, svg->description);
+
+    DataSections sections = { &buffer, -1, 0 };
+    int elements = 0;
+    SVGVisitor visitors[] = {
+        { VISIT_ALL, 1, NULL, NULL, &appendDataComponent, &sections },
+        { VISIT_ALL, 1, NULL, NULL, &countElement, &elements }
+    };
+    visitSVG(svg, visitors, 2);
+
+    openSection(&sections, NUM_DATA_SECTIONS - 1);
+    if(!appendString(&buffer, "]}")) {
+        svgFree(buffer.data);
+        return NULL;
+    }
+    endPhase(STAT_JSON, &start, buffer.length, elements);
+
+    *length = buffer.length;
+    return buffer.data;
+}
+
+/**
+ * @brief hashes bytes with 64 bit FNV-1a, continuing from a previous hash
+ *
+ * @param hash SVG_HASH_SEED for the first block
+ * @param bytes
+ * @param length
+ * @return uint64_t
+ */
+static uint64_t hashBytes(uint64_t hash, const unsigned char *bytes, size_t length) {
+    for(size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
+
+/**
+ * @brief returns the bucket of a path
+ *
+ * @param path
+ * @return CacheEntry**
+ */
+static CacheEntry** cacheBucketOf(const char *path) {
+    return &cacheBuckets[hashBytes(SVG_HASH_SEED, (const unsigned char*)path, strlen(path)) % CACHE_BUCKETS];
+}
+
+/**
+ * @brief unlinks an entry from the cache and frees it
+ *
+ * @param entry
+ */
+static void removeEntry(CacheEntry *entry) {
+    CacheEntry **link = cacheBucketOf(entry->path);
+    while(*link != entry) link = &(*link)->chain;
+    *link = entry->chain;
+
+    if(entry->prev) entry->prev->next = entry->next;
+    else cacheHead = entry->next;
+
+    if(entry->next) entry->next->prev = entry->prev;
+    else cacheTail = entry->prev;
+
+    cacheBytes -= entry->length + entry->thumbnailLength;
+    cacheStats.entries--;
+
+    svgFree(entry->path);
+    svgFree(entry->schemaFile);
+    svgFree(entry->json);
+    svgFree(entry->thumbnail);
+    svgFree(entry->thumbnailSchema);
+    svgFree(entry);
+}
+
+/**
+ * @brief drops the response of an entry, keeping the rest of what is known about the file
+ *
+ * @param entry
+ */
+static void dropResponse(CacheEntry *entry) {
+    cacheBytes -= entry->length;
+    svgFree(entry->json);
+    svgFree(entry->schemaFile);
+
+    entry->json = NULL;
+    entry->schemaFile = NULL;
+    entry->length = 0;
+}
+
+/**
+ * @brief drops the thumbnail of an entry, keeping the rest of what is known about the file
+ *
+ * @param entry
+ */
+static void dropThumbnail(CacheEntry *entry) {
+    cacheBytes -= entry->thumbnailLength;
+    svgFree(entry->thumbnail);
+    svgFree(entry->thumbnailSchema);
+
+    entry->thumbnail = NULL;
+    entry->thumbnailSchema = NULL;
+    entry->thumbnailLength = 0;
+}
+
+/**
+ * @brief makes an entry the most recently used
+ *
+ * @param entry
+ */
+static void moveToFront(CacheEntry *entry) {
+    if(entry == cacheHead) return;
+
+    entry->prev->next = entry->next;
+    if(entry->next) entry->next->prev = entry->prev;
+    else cacheTail = entry->prev;
+
+    entry->prev = NULL;
+    entry->next = cacheHead;
+    cacheHead->prev = entry;
+    cacheHead = entry;
+}
+
+/**
+ * @brief evicts the least recently used entries until the cache fits in its limit
+ */
+static void enforceCacheLimit(void) {
+    while(cacheTail != NULL && cacheBytes > cacheLimit) {
+        removeEntry(cacheTail);
+        cacheStats.evictions++;
+    }
+}
+
+/**
+ * @brief finds the entry of a file
+ *
+ * @param path
+ * @return CacheEntry* NULL if the file has no entry
+ */
+static CacheEntry* findEntry(const char *path) {
+    for(CacheEntry *entry = *cacheBucketOf(path); entry; entry = entry->chain)
+        if(strcmp(entry->path, path) == 0) return entry;
+
+    return NULL;
+}
+
+/**
+ * @brief finds the entry of a file and makes it the most recently used, dropping it if the file changed
+ *
+ * @param path
+ * @param info current status of the file
+ * @return CacheEntry* NULL if the file has no current entry
+ */
+static CacheEntry* findCurrentEntry(const char *path, const struct stat *info) {
+    CacheEntry *entry = findEntry(path);
+    if(entry == NULL) return NULL;
+
+    bool current = entry->size == info->st_size && entry->mtime.tv_sec == info->st_mtim.tv_sec &&
+                   entry->mtime.tv_nsec == info->st_mtim.tv_nsec && entry->device == info->st_dev &&
+                   entry->inode == info->st_ino;
+
+    if(!current) {
+        removeEntry(entry);
+        return NULL;
+    }
+
+    moveToFront(entry);
+    return entry;
+}
+
+/**
+ * @brief adds an empty entry for a file as the most recently used
+ *
+ * @param path
+ * @param info current status of the file
+ * @return CacheEntry* NULL if it cannot be allocated
+ */
+static CacheEntry* addEntry(const char *path, const struct stat *info) {
+    CacheEntry *entry = svgMalloc(sizeof(CacheEntry));
+    if(entry == NULL) return NULL;
+
+    entry->path = svgMalloc(strlen(path) + 1);
+    if(entry->path == NULL) {
+        svgFree(entry);
+        return NULL;
+    }
+    strcpy(entry->path, path);
+    entry->schemaFile = NULL;
+    entry->size = info->st_size;
+    entry->mtime = info->st_mtim;
+    entry->device = info->st_dev;
+    entry->inode = info->st_ino;
+    entry->json = NULL;
+    entry->length = 0;
+    entry->hasHash = false;
+    entry->thumbnail = NULL;
+    entry->thumbnailLength = 0;
+    entry->thumbnailWidth = 0;
+    entry->thumbnailHeight = 0;
+    entry->thumbnailSchema = NULL;
+
+    CacheEntry **bucket = cacheBucketOf(path);
+    entry->chain = *bucket;
+    *bucket = entry;
+
+    entry->prev = NULL;
+    entry->next = cacheHead;
+    if(cacheHead) cacheHead->prev = entry;
+    else cacheTail = entry;
+    cacheHead = entry;
+
+    cacheStats.entries++;
+    return entry;
+}
+
+// A cached response or thumbnail passed to the function of useSVGData or useSVGThumbnail
+typedef void (*CachedBytesUse)(const void *bytes, size_t length, void *context);
+
+// Bytes returned by getCachedSVGData and getCachedSVGThumbnail, for rememberBytes
+typedef struct {
+    const void *bytes;
+    size_t length;
+} CachedBytes;
+
+/**
+ * @brief remembers where cached bytes are, for the lookups that return a pointer into the cache
+ *
+ * @param bytes
+ * @param length
+ * @param context the CachedBytes
+ */
+static void rememberBytes(const void *bytes, size_t length, void *context) {
+    CachedBytes *found = (CachedBytes*)context;
+    found->bytes = bytes;
+    found->length = length;
+}
+
+/**
+ * @brief finds the /getSVGData response of a file, building and caching it on a miss, and passes it to a function
+ * while the cache is locked, so that no other thread frees it while it is used
+ *
+ * @param filename
+ * @param schemaFile
+ * @param use called with the response and its length, must not call a cache function
+ * @param context passed to use
+ * @return true
+ * @return false if the file does not exist or the response cannot be allocated, and use was not called
+ */
+static bool useSVGData(const char *filename, const char *schemaFile, CachedBytesUse use, void *context) {
+    svgFree(uncachedJSON);
+    uncachedJSON = NULL;
+
+    struct stat info;
+    if(filename == NULL || schemaFile == NULL || stat(filename, &info) != 0) return false;
+
+    pthread_mutex_lock(&cacheLock);
+    CacheEntry *entry = findCurrentEntry(filename, &info);
+    if(entry != NULL && entry->json != NULL && strcmp(entry->schemaFile, schemaFile) == 0) {
+        cacheStats.hits++;
+        use(entry->json, entry->length, context);
+        pthread_mutex_unlock(&cacheLock);
+        return true;
+    }
+    cacheStats.misses++;
+    pthread_mutex_unlock(&cacheLock);
+
+    size_t jsonLength;
+    char *json;
+    SVG *svg = createValidSVG(filename, schemaFile);
+
+    if(svg != NULL && validateSVG(svg, schemaFile)) {
+        json = buildSVGData(svg, &jsonLength);
+    } else {
+        json = svgMalloc(3);
+        if(json != NULL) strcpy(json, "{}");
+        jsonLength = 2;
+    }
+    deleteSVG(svg);
+
+    // Nothing is cached if the response cannot be allocated
+    if(json == NULL) return false;
+
+    char *schemaCopy = svgMalloc(strlen(schemaFile) + 1);
+    if(schemaCopy != NULL) strcpy(schemaCopy, schemaFile);
+
+    pthread_mutex_lock(&cacheLock);
+    entry = NULL;
+    if(jsonLength <= cacheLimit && schemaCopy != NULL) {
+        // Another thread may have dropped or replaced the entry while the file was parsed
+        entry = findCurrentEntry(filename, &info);
+        if(entry == NULL) entry = addEntry(filename, &info);
+    }
+
+    // A response larger than the cache, or one there is no memory to cache, is returned uncached
+    if(entry == NULL) {
+        svgFree(schemaCopy);
+        uncachedJSON = json;
+        use(json, jsonLength, context);
+        pthread_mutex_unlock(&cacheLock);
+        return true;
+    }
+
+    // A response validated against another schema is replaced, and the thumbnail is dropped if both do not fit,
+    // so that the entry is not evicted with the response it returns
+    dropResponse(entry);
+    if(jsonLength + entry->thumbnailLength > cacheLimit) dropThumbnail(entry);
+
+    entry->schemaFile = schemaCopy;
+    entry->json = json;
+    entry->length = jsonLength;
+    cacheBytes += jsonLength;
+
+    // The entry is the most recently used, so it is evicted last
+    enforceCacheLimit();
+    use(json, jsonLength, context);
+    pthread_mutex_unlock(&cacheLock);
+    return true;
+}
+
+/**
+ * @brief returns the /getSVGData response for a file: its title, description and top level components as
+ * JSON, or {} if the file is not valid. Responses are cached until the file changes, so a hit costs one stat
+ *
+ * @param filename
+ * @param schemaFile
+ * @param length if not NULL, set to the length of the response
+ * @return const char* owned by the cache and valid until the thread's next call to a cache function or writeSVG -
+ * callers must not free it.  Another thread's lookup may evict it, so callers on several threads copy the
+ * response instead, as getSVGDataWrapper does.  NULL if the file does not exist or the response cannot be allocated
+ */
+const char* getCachedSVGData(const char *filename, const char *schemaFile, size_t *length) {
+    CachedBytes found = { NULL, 0 };
+    if(!useSVGData(filename, schemaFile, rememberBytes, &found)) return NULL;
+
+    if(length) *length = found.length;
+    return found.bytes;
+}
+
+// Size a thumbnail is drawn at and the PNG it was drawn as, for drawThumbnail
+typedef struct {
+    int maxWidth;
+    int maxHeight;
+    unsigned char *png;
+    size_t length;
+} ThumbnailRequest;
+
+/**
+ * @brief draws the thumbnail of a struct, for useCachedSVG
+ *
+ * @param svg
+ * @param context the ThumbnailRequest, its png set to NULL if the struct cannot be drawn
+ */
+static void drawThumbnail(SVG *svg, void *context) {
+    ThumbnailRequest *request = (ThumbnailRequest*)context;
+    request->png = renderSVGThumbnail(svg, request->maxWidth, request->maxHeight, &request->length);
+}
+
+/**
+ * @brief finds the PNG thumbnail of a file, drawing and caching it on a miss, and passes it to a function while the
+ * cache is locked.  The thumbnail is drawn with the cache unlocked, so other threads' hits do not wait for it
+ *
+ * @param filename
+ * @param schemaFile
+ * @param maxWidth
+ * @param maxHeight
+ * @param use called with the PNG and its length, must not call a cache function
+ * @param context passed to use
+ * @return true
+ * @return false if the file does not exist, is not valid or cannot be drawn, and use was not called
+ */
+static bool useSVGThumbnail(const char *filename, const char *schemaFile, int maxWidth, int maxHeight,
+                            CachedBytesUse use, void *context) {
+    svgFree(uncachedThumbnail);
+    uncachedThumbnail = NULL;
+
+    struct stat info;
+    if(filename == NULL || schemaFile == NULL || stat(filename, &info) != 0) return false;
+
+    pthread_mutex_lock(&cacheLock);
+    CacheEntry *entry = findCurrentEntry(filename, &info);
+    if(entry != NULL && entry->thumbnail != NULL && entry->thumbnailWidth == maxWidth &&
+       entry->thumbnailHeight == maxHeight && strcmp(entry->thumbnailSchema, schemaFile) == 0) {
+        cacheStats.hits++;
+        use(entry->thumbnail, entry->thumbnailLength, context);
+        pthread_mutex_unlock(&cacheLock);
+        return true;
+    }
+    cacheStats.misses++;
+    pthread_mutex_unlock(&cacheLock);
+
+    ThumbnailRequest request = { maxWidth, maxHeight, NULL, 0 };
+    if(!useCachedSVG(filename, schemaFile, drawThumbnail, &request) || request.png == NULL) return false;
+
+    char *schemaCopy = svgMalloc(strlen(schemaFile) + 1);
+    if(schemaCopy != NULL) strcpy(schemaCopy, schemaFile);
+
+    pthread_mutex_lock(&cacheLock);
+    entry = NULL;
+    if(request.length <= cacheLimit && schemaCopy != NULL) {
+        entry = findCurrentEntry(filename, &info);
+        if(entry == NULL) entry = addEntry(filename, &info);
+    }
+
+    if(entry == NULL) {
+        svgFree(schemaCopy);
+        uncachedThumbnail = request.png;
+        use(request.png, request.length, context);
+        pthread_mutex_unlock(&cacheLock);
+        return true;
+    }
+
+    // A thumbnail of another size replaces the last one, as does the response in useSVGData
+    dropThumbnail(entry);
+    if(request.length + entry->length > cacheLimit) dropResponse(entry);
+
+    entry->thumbnailSchema = schemaCopy;
+    entry->thumbnail = request.png;
+    entry->thumbnailLength = request.length;
+    entry->thumbnailWidth = maxWidth;
+    entry->thumbnailHeight = maxHeight;
+    cacheBytes += request.length;
+
+    enforceCacheLimit();
+    use(request.png, request.length, context);
+    pthread_mutex_unlock(&cacheLock);
+    return true;
+}
+
+/**
+ * @brief returns a PNG thumbnail of a file, drawn by renderSVGThumbnail at most maxWidth by maxHeight pixels.
+ * The last thumbnail drawn of each file is cached until the file changes, so a hit costs one stat, and a miss
+ * draws from the struct the corpus queries share
+ *
+ * @param filename
+ * @param schemaFile
+ * @param maxWidth
+ * @param maxHeight
+ * @param length set to the size of the PNG
+ * @return const unsigned char* owned by the cache and valid until the thread's next call to a cache function or
+ * writeSVG.  Another thread's lookup may evict it, so callers on several threads copy the PNG instead, as
+ * copySVGThumbnailWrapper does.  NULL if the file does not exist, is not valid or cannot be drawn
+ */
+const unsigned char* getCachedSVGThumbnail(const char *filename, const char *schemaFile, int maxWidth, int maxHeight,
+                                           size_t *length) {
+    CachedBytes found = { NULL, 0 };
+    if(length == NULL || !useSVGThumbnail(filename, schemaFile, maxWidth, maxHeight, rememberBytes, &found))
+        return NULL;
+
+    *length = found.length;
+    return found.bytes;
+}
+
+/**
+ * @brief returns a 64 bit hash of the contents of a file. The file is read only the first time its hash is
+ * asked for, or after it changes, so the hash can be used as an ETag without parsing the file
+ *
+ * @param filename
+ * @param hash set to the hash
+ * @return true
+ * @return false if the file cannot be read or there is no memory to read it
+ */
+bool getSVGFileHash(const char *filename, uint64_t *hash) {
+    struct stat info;
+    if(filename == NULL || hash == NULL || stat(filename, &info) != 0) return false;
+
+    pthread_mutex_lock(&cacheLock);
+    CacheEntry *entry = findCurrentEntry(filename, &info);
+    bool known = entry != NULL && entry->hasHash;
+    if(known) *hash = entry->hash;
+    pthread_mutex_unlock(&cacheLock);
+    if(known) return true;
+
+    FILE *fp = fopen(filename, "rb");
+    if(fp == NULL) return false;
+
+    unsigned char *buffer = svgMalloc(65536);
+    if(buffer == NULL) {
+        fclose(fp);
+        return false;
+    }
+
+    uint64_t h = SVG_HASH_SEED;
+    size_t n;
+    while((n = fread(buffer, 1, 65536, fp)) > 0) h = hashBytes(h, buffer, n);
+
+    bool readAll = !ferror(fp);
+    svgFree(buffer);
+    fclose(fp);
+    if(!readAll) return false;
+
+    pthread_mutex_lock(&cacheLock);
+    // The hash is still returned if there is no memory to remember it
+    entry = findCurrentEntry(filename, &info);
+    if(entry == NULL) entry = addEntry(filename, &info);
+    if(entry != NULL) {
+        entry->hash = h;
+        entry->hasHash = true;
+    }
+    pthread_mutex_unlock(&cacheLock);
+
+    *hash = h;
+    return true;
+}
+
+/**
+ * @brief continues a content hash with the next bytes of a file, for writers that record the hash
+ * of what they write with recordSVGFileHash
+ *
+ * @param hash SVG_HASH_SEED for the first bytes
+ * @param bytes
+ * @param length
+ * @return uint64_t
+ */
+uint64_t updateSVGFileHash(uint64_t hash, const void *bytes, size_t length) {
+    return hashBytes(hash, bytes, length);
+}
+
+/**
+ * @brief records the content hash of a file that was just written, so asking for it does not read the file back
+ *
+ * @param filename
+ * @param hash hash of every byte written, built with updateSVGFileHash
+ */
+void recordSVGFileHash(const char *filename, uint64_t hash) {
+    struct stat info;
+    if(filename == NULL || stat(filename, &info) != 0) return;
+
+    pthread_mutex_lock(&cacheLock);
+    CacheEntry *entry = findCurrentEntry(filename, &info);
+    if(entry == NULL) entry = addEntry(filename, &info);
+
+    if(entry != NULL) {
+        entry->hash = hash;
+        entry->hasHash = true;
+    }
+    pthread_mutex_unlock(&cacheLock);
+}
+
+/**
+ * @brief drops the cached response and hash of a file. Called by writeSVG, since a file written within the
+ * resolution of its modification time could otherwise keep the same key
+ *
+ * @param filename
+ */
+void invalidateCachedSVGData(const char *filename) {
+    if(filename == NULL) return;
+
+    pthread_mutex_lock(&cacheLock);
+    CacheEntry *entry = findEntry(filename);
+    if(entry != NULL) removeEntry(entry);
+    pthread_mutex_unlock(&cacheLock);
+}
+
+/**
+ * @brief sets the most memory the cached responses and thumbnails may use, evicting entries if needed
+ *
+ * @param bytes 0 disables the cache
+ */
+void setSVGDataCacheLimit(size_t bytes) {
+    pthread_mutex_lock(&cacheLock);
+    cacheLimit = bytes;
+    enforceCacheLimit();
+    pthread_mutex_unlock(&cacheLock);
+}
+
+/**
+ * @brief returns the counters of the response cache
+ *
+ * @return SVGCacheStats
+ */
+SVGCacheStats getSVGDataCacheStats(void) {
+    pthread_mutex_lock(&cacheLock);
+    SVGCacheStats stats = cacheStats;
+    stats.bytes = cacheBytes;
+    stats.limit = cacheLimit;
+    pthread_mutex_unlock(&cacheLock);
+
+    return stats;
+}
+
+/**
+ * @brief copies a response into the thread's copy for getSVGDataWrapper
+ *
+ * @param bytes
+ * @param length
+ * @param context unused
+ */
+static void copyResponse(const void *bytes, size_t length, void *context) {
+    wrapperJSON = svgMalloc(length + 1);
+    if(wrapperJSON == NULL) return;
+
+    memcpy(wrapperJSON, bytes, length);
+    wrapperJSON[length] = '\0';
+}
+
+/**
+ * @brief returns the /getSVGData response for a file, for the server.  The response is copied while the cache is
+ * locked, so the server may call it while other threads use the cache
+ *
+ * @param filename
+ * @param schemaFile
+ * @return const char* valid until the thread's next call.  {} if the file does not exist or the response cannot be
+ * allocated
+ */
+const char *getSVGDataWrapper(char *filename, char *schemaFile) {
+    svgFree(wrapperJSON);
+    wrapperJSON = NULL;
+
+    useSVGData(filename, schemaFile, copyResponse, NULL);
+    return wrapperJSON != NULL ? wrapperJSON : "{}";
+}
+
+// Buffer the server passes to copySVGThumbnailWrapper
+typedef struct {
+    unsigned char *buffer;
+    int capacity;
+    size_t length;
+} ThumbnailCopy;
+
+/**
+ * @brief copies a thumbnail into the server's buffer if it fits, for copySVGThumbnailWrapper
+ *
+ * @param bytes
+ * @param length
+ * @param context the ThumbnailCopy, its length set
+ */
+static void copyThumbnail(const void *bytes, size_t length, void *context) {
+    ThumbnailCopy *copy = (ThumbnailCopy*)context;
+
+    copy->length = length;
+    if(copy->buffer != NULL && copy->capacity >= 0 && length <= (size_t)copy->capacity)
+        memcpy(copy->buffer, bytes, length);
+}
+
+/**
+ * @brief copies the PNG thumbnail of a file into a buffer, for the server, which cannot take bytes from a
+ * returned pointer.  The PNG is copied while the cache is locked, so the server may call it on several threads
+ *
+ * @param filename
+ * @param schemaFile
+ * @param maxWidth
+ * @param maxHeight
+ * @param buffer
+ * @param capacity size of the buffer
+ * @return int size of the PNG, copied only if it fits, so a larger buffer can be passed again.  -1 if the file
+ * does not exist, is not valid or cannot be drawn
+ */
+int copySVGThumbnailWrapper(char *filename, char *schemaFile, int maxWidth, int maxHeight, unsigned char *buffer,
+                            int capacity) {
+    ThumbnailCopy copy = { buffer, capacity, 0 };
+    if(!useSVGThumbnail(filename, schemaFile, maxWidth, maxHeight, copyThumbnail, &copy) || copy.length > INT_MAX)
+        return -1;
+
+    return (int)copy.length;
+}
+
+/**
+ * @brief returns the counters of the response cache as JSON, with the hit ratio
+ *
+ * @return char* NULL if it cannot be allocated
+ */
+char *getSVGDataCacheStatsWrapper(void) {
+    SVGCacheStats stats = getSVGDataCacheStats();
+    unsigned long lookups = stats.hits + stats.misses;
+
+    char *json = svgMalloc(256);
+    if(json == NULL) return NULL;
+
+    snprintf(json, 256, "{\"hits\":%lu,\"misses\":%lu,\"evictions\":%lu,\"hitRatio\":%.4f,\"entries\":%d,\"bytes\":%zu,\"limit\":%zu}",
+             stats.hits, stats.misses, stats.evictions, lookups > 0 ? (double)stats.hits / lookups : 0.0,
+             stats.entries, stats.bytes, stats.limit);
+
+    return json;
+}
+
+/**
+ * @brief returns the ETag of a file: its content hash as a quoted hex string
+ *
+ * @param filename
+ * @return const char* in a buffer overwritten by the thread's next call, "" if the file cannot be read
+ */
+const char *getSVGETagWrapper(char *filename) {
+    static _Thread_local char etag[24];
+    uint64_t hash;
+
+    if(!getSVGFileHash(filename, &hash)) return "";
+
+    snprintf(etag, sizeof(etag), "\"%016llx\"", (unsigned long long)hash);
+    return etag;
+}
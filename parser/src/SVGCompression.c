@@ -0,0 +1,106 @@
+/**
+ * @file SVGCompression.c
+ * @author Anthony Vidovic (1130891)
+ * @brief Reading gzip compressed (.svgz) files
+ * @version 0.1
+ * @date 2022-04-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+// ~~~~~ Includes ~~~~~ //
+#include "SVGHelper.h"
+
+// Size of zlib's input and output buffers, larger than its default to cut down on read calls
+#define GZIP_BUFFER_SIZE 131072
+
+/**
+ * @brief returns true if a file name has an extension read and written as SVG, .svg or .svgz
+ *
+ * @param fileName
+ * @return true
+ * @return false
+ */
+bool isSVGFileName(const char *fileName) {
+    return extensionMatches(fileName, ".svg") || extensionMatches(fileName, ".svgz");
+}
+
+/**
+ * @brief returns true if a file is read and written gzip compressed, which SVG files ending in .svgz are
+ *
+ * @param fileName
+ * @return true
+ * @return false
+ */
+bool isCompressedFileName(const char *fileName) {
+    return extensionMatches(fileName, ".svgz");
+}
+
+/**
+ * @brief xmlInputReadCallback that decompresses the next part of a gzip file
+ *
+ * @param context gzFile
+ * @param buffer
+ * @param len
+ * @return int number of bytes read, -1 on error
+ */
+static int gzipRead(void *context, char *buffer, int len) {
+    return gzread((gzFile)context, buffer, len);
+}
+
+/**
+ * @brief xmlInputCloseCallback that closes a gzip file
+ *
+ * @param context gzFile
+ * @return int 0 on success, -1 on error
+ */
+static int gzipClose(void *context) {
+    return gzclose((gzFile)context) == Z_OK ? 0 : -1;
+}
+
+/**
+ * @brief returns the size of a file, read only when the read phase is being timed
+ *
+ * @param fileName
+ * @return size_t 0 if the file cannot be opened
+ */
+static size_t fileSize(const char *fileName) {
+    FILE *fp = fopen(fileName, "rb");
+    if(fp == NULL) return 0;
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fclose(fp);
+
+    return size > 0 ? (size_t)size : 0;
+}
+
+/**
+ * @brief parses an svg file into an xmlDoc. A .svgz file is decompressed as libxml2 reads it, so the
+ * uncompressed document is never held in memory or on disk
+ *
+ * @param fileName
+ * @return xmlDoc* NULL if the file cannot be read or is not well formed
+ */
+xmlDoc* readSVGDoc(const char *fileName) {
+    PhaseTimer start = startPhase();
+    xmlDoc *doc = NULL;
+
+    // libxml2 rejects documents nested deeper than SVG_DEFAULT_MAX_DEPTH elements unless told to parse huge documents
+    int options = getSVGMaxDepth() > SVG_DEFAULT_MAX_DEPTH ? XML_PARSE_HUGE : 0;
+
+    if(!isCompressedFileName(fileName)) {
+        doc = xmlReadFile(fileName, NULL, options);
+    } else {
+        gzFile gz = gzopen(fileName, "rb");
+        if(gz == NULL) return NULL;
+        gzbuffer(gz, GZIP_BUFFER_SIZE);
+
+        // xmlReadIO closes the file through gzipClose, even when parsing fails
+        doc = xmlReadIO(gzipRead, gzipClose, gz, fileName, NULL, options);
+    }
+
+    endPhase(STAT_READ, &start, start.ns != 0 ? fileSize(fileName) : 0, 0);
+    return doc;
+}
@@ -0,0 +1,602 @@
+/**
+ * @file SVGCorpus.c
+ * @author Anthony Vidovic (1130891)
+ * @brief Queries run over every svg file in a directory on a pool of worker threads, and the cache of parsed
+ * files they share
+ * @version 0.1
+ * @date 2022-04-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+// stat's nanosecond modification time, directory reading and threads are POSIX, not C11
+#define _POSIX_C_SOURCE 200809L
+
+// ~~~~~ Includes ~~~~~ //
+#include "SVGHelper.h"
+#include <dirent.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Default limit on the combined number of elements of the cached structs
+#define DEFAULT_CORPUS_CACHE_LIMIT (256 * 1024)
+
+// Buckets of the table the cached files are found by
+#define CORPUS_BUCKETS 1024
+
+// Most worker threads a query runs on
+#define MAX_CORPUS_THREADS 64
+
+// A parsed file kept between queries.  It is used only while the file still has the size, modification time
+// and inode it had when it was parsed
+typedef struct CorpusEntry {
+    char *path;
+    off_t size;
+    struct timespec mtime;
+    dev_t device;
+    ino_t inode;
+    // Schema the file was validated against, NULL if it was only parsed
+    char *schemaFile;
+    // NULL if the file could not be parsed, or is not valid against schemaFile
+    SVG *svg;
+    // Least recently used order, most recent first
+    struct CorpusEntry *prev;
+    struct CorpusEntry *next;
+    // Next entry in the same bucket
+    struct CorpusEntry *chain;
+} CorpusEntry;
+
+// The cache is shared by the workers of a query.  An entry in use by a worker is taken out of the cache, so
+// the lazily built indexes of its struct are only touched by one thread at a time
+static pthread_mutex_t corpusLock = PTHREAD_MUTEX_INITIALIZER;
+static CorpusEntry *corpusBuckets[CORPUS_BUCKETS] = { NULL };
+static CorpusEntry *corpusHead = NULL;
+static CorpusEntry *corpusTail = NULL;
+static long corpusElements = 0;
+static long corpusLimit = DEFAULT_CORPUS_CACHE_LIMIT;
+
+// State shared by the workers of a query
+typedef struct {
+    const SVGCorpusQuery *query;
+    CorpusFile *files;
+    int numFiles;
+    // Index of the next file to be taken by a worker
+    atomic_int next;
+    // Compiled once for the query, NULL if files are not validated
+    xmlSchemaPtr schema;
+    SVGCorpusCallback callback;
+    void *context;
+    // Held while the callback runs, so it is never called from two threads at once
+    pthread_mutex_t resultLock;
+    atomic_int matchedFiles;
+} CorpusRun;
+
+/**
+ * @brief returns the bucket of a path
+ *
+ * @param path
+ * @return CorpusEntry**
+ */
+static CorpusEntry** bucketOf(const char *path) {
+    return &corpusBuckets[updateSVGFileHash(SVG_HASH_SEED, path, strlen(path)) % CORPUS_BUCKETS];
+}
+
+/**
+ * @brief returns the number of elements an entry counts for against the cache limit
+ *
+ * @param entry
+ * @return long at least 1, so that entries of files without a struct are also limited
+ */
+static long entryWeight(const CorpusEntry *entry) {
+    return entry->svg != NULL ? entry->svg->numElements + 1 : 1;
+}
+
+/**
+ * @brief frees an entry that is not in the cache, and its struct
+ *
+ * @param entry
+ */
+static void freeEntry(CorpusEntry *entry) {
+    deleteSVG(entry->svg);
+    svgFree(entry->path);
+    svgFree(entry->schemaFile);
+    svgFree(entry);
+}
+
+/**
+ * @brief takes an entry out of the cache.  The caller holds corpusLock
+ *
+ * @param entry
+ */
+static void unlinkEntry(CorpusEntry *entry) {
+    CorpusEntry **link = bucketOf(entry->path);
+    while(*link != entry) link = &(*link)->chain;
+    *link = entry->chain;
+
+    if(entry->prev) entry->prev->next = entry->next;
+    else corpusHead = entry->next;
+
+    if(entry->next) entry->next->prev = entry->prev;
+    else corpusTail = entry->prev;
+
+    corpusElements -= entryWeight(entry);
+}
+
+/**
+ * @brief finds the entry of a path.  The caller holds corpusLock
+ *
+ * @param path
+ * @return CorpusEntry* NULL if the path has no entry
+ */
+static CorpusEntry* findCorpusEntry(const char *path) {
+    for(CorpusEntry *entry = *bucketOf(path); entry; entry = entry->chain)
+        if(strcmp(entry->path, path) == 0) return entry;
+
+    return NULL;
+}
+
+/**
+ * @brief returns true if an entry answers a query on a file: the file has not changed, and it was checked
+ * against the schema of the query.  A struct validated against a schema also answers queries without one
+ *
+ * @param entry
+ * @param info current status of the file
+ * @param schemaFile schema of the query, NULL if files are not validated
+ * @return true
+ * @return false
+ */
+static bool entryAnswers(const CorpusEntry *entry, const struct stat *info, const char *schemaFile) {
+    bool current = entry->size == info->st_size && entry->mtime.tv_sec == info->st_mtim.tv_sec &&
+                   entry->mtime.tv_nsec == info->st_mtim.tv_nsec && entry->device == info->st_dev &&
+                   entry->inode == info->st_ino;
+    if(!current) return false;
+
+    if(schemaFile == NULL) return entry->svg != NULL || entry->schemaFile == NULL;
+    return entry->schemaFile != NULL && strcmp(entry->schemaFile, schemaFile) == 0;
+}
+
+/**
+ * @brief takes the entry of a file out of the cache for a worker, dropping it if it does not answer the query
+ *
+ * @param file
+ * @param schemaFile
+ * @return CorpusEntry* NULL if the file has to be parsed
+ */
+static CorpusEntry* takeEntry(const CorpusFile *file, const char *schemaFile) {
+    pthread_mutex_lock(&corpusLock);
+    CorpusEntry *entry = findCorpusEntry(file->path);
+    if(entry != NULL) unlinkEntry(entry);
+    pthread_mutex_unlock(&corpusLock);
+
+    if(entry != NULL && !entryAnswers(entry, &file->info, schemaFile)) {
+        freeEntry(entry);
+        return NULL;
+    }
+
+    return entry;
+}
+
+/**
+ * @brief puts an entry back in the cache as the most recently used, replacing any entry another worker added
+ * for the same file, and evicts the least recently used entries until the cache fits in its limit
+ *
+ * @param entry
+ */
+static void returnEntry(CorpusEntry *entry) {
+    // Evicted structs are freed after the lock is released
+    CorpusEntry *evicted = NULL;
+
+    pthread_mutex_lock(&corpusLock);
+    CorpusEntry *old = findCorpusEntry(entry->path);
+    if(old != NULL) {
+        unlinkEntry(old);
+        old->next = evicted;
+        evicted = old;
+    }
+
+    CorpusEntry **bucket = bucketOf(entry->path);
+    entry->chain = *bucket;
+    *bucket = entry;
+
+    entry->prev = NULL;
+    entry->next = corpusHead;
+    if(corpusHead) corpusHead->prev = entry;
+    else corpusTail = entry;
+    corpusHead = entry;
+    corpusElements += entryWeight(entry);
+
+    while(corpusTail != NULL && corpusElements > corpusLimit) {
+        CorpusEntry *last = corpusTail;
+        unlinkEntry(last);
+        last->next = evicted;
+        evicted = last;
+    }
+    pthread_mutex_unlock(&corpusLock);
+
+    while(evicted != NULL) {
+        CorpusEntry *next = evicted->next;
+        freeEntry(evicted);
+        evicted = next;
+    }
+}
+
+/**
+ * @brief parses a file, and validates it if there is a schema, into a new entry.  libxml2's global state
+ * is left alone, so that workers can parse at the same time
+ *
+ * @param file
+ * @param schemaFile name of the schema, NULL if the file is only parsed
+ * @param schema schemaFile compiled
+ * @return CorpusEntry* NULL if the entry or the struct of a valid file cannot be allocated.  An entry whose
+ * struct is NULL records that the file is not valid
+ */
+static CorpusEntry* loadEntry(const CorpusFile *file, const char *schemaFile, xmlSchemaPtr schema) {
+    CorpusEntry *entry = svgCalloc(1, sizeof(CorpusEntry));
+    if(entry == NULL) return NULL;
+
+    entry->path = svgMalloc(strlen(file->path) + 1);
+    if(entry->path == NULL) {
+        freeEntry(entry);
+        return NULL;
+    }
+    strcpy(entry->path, file->path);
+    entry->size = file->info.st_size;
+    entry->mtime = file->info.st_mtim;
+    entry->device = file->info.st_dev;
+    entry->inode = file->info.st_ino;
+    entry->schemaFile = NULL;
+    entry->svg = NULL;
+
+    if(schemaFile != NULL) {
+        entry->schemaFile = svgMalloc(strlen(schemaFile) + 1);
+        if(entry->schemaFile == NULL) {
+            freeEntry(entry);
+            return NULL;
+        }
+        strcpy(entry->schemaFile, schemaFile);
+    }
+
+    xmlDoc *doc = readSVGDoc(file->path);
+    bool valid = doc != NULL && (schema == NULL || validateWithSchema(doc, schema) == 0);
+    if(valid) entry->svg = svgFromDoc(doc);
+    xmlFreeDoc(doc);
+
+    // A valid file whose struct could not be built is not cached as invalid, it is parsed again next time
+    if(valid && entry->svg == NULL) {
+        freeEntry(entry);
+        return NULL;
+    }
+
+    return entry;
+}
+
+/**
+ * @brief counts the matches of a query in a struct, using the struct's area indexes for area queries
+ *
+ * @param svg
+ * @param query
+ * @return int
+ */
+static int countMatches(const SVG *svg, const SVGCorpusQuery *query) {
+    switch(query->type) {
+        case CORPUS_RECT_AREA: return numRectsInAreaRange(svg, query->minValue, query->maxValue);
+        case CORPUS_CIRCLE_AREA: return numCirclesInAreaRange(svg, query->minValue, query->maxValue);
+        case CORPUS_PATH_DATA: return numPathsWithdata(svg, query->text);
+        case CORPUS_GROUP_LEN: return numGroupsWithLen(svg, (int)query->minValue);
+        default: return 0;
+    }
+}
+
+/**
+ * @brief runs a query on files taken from the shared list until every file has been taken
+ *
+ * @param arg the CorpusRun
+ * @return void* NULL
+ */
+static void* corpusWorker(void *arg) {
+    CorpusRun *run = (CorpusRun*)arg;
+
+    for(int i = atomic_fetch_add(&run->next, 1); i < run->numFiles; i = atomic_fetch_add(&run->next, 1)) {
+        const CorpusFile *file = &run->files[i];
+
+        CorpusEntry *entry = takeEntry(file, run->query->schemaFile);
+        if(entry == NULL) entry = loadEntry(file, run->query->schemaFile, run->schema);
+        if(entry == NULL) continue;
+
+        int matches = entry->svg != NULL ? countMatches(entry->svg, run->query) : 0;
+
+        // The entry may be evicted and freed as soon as it is back in the cache
+        returnEntry(entry);
+
+        if(matches > 0) {
+            pthread_mutex_lock(&run->resultLock);
+            run->callback(file->name, matches, run->context);
+            pthread_mutex_unlock(&run->resultLock);
+            atomic_fetch_add(&run->matchedFiles, 1);
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief orders files largest first, so that the last files taken by the workers are the quickest
+ *
+ * @param first
+ * @param second
+ * @return int
+ */
+static int compareFileSizes(const void *first, const void *second) {
+    off_t a = ((const CorpusFile*)first)->info.st_size;
+    off_t b = ((const CorpusFile*)second)->info.st_size;
+    return (a < b) - (a > b);
+}
+
+/**
+ * @brief lists the svg files of a directory, largest first
+ *
+ * @param directory
+ * @param numFiles set to the number of files found
+ * @return CorpusFile* NULL if the directory cannot be read
+ */
+CorpusFile* listCorpusFiles(const char *directory, int *numFiles) {
+    DIR *dir = opendir(directory);
+    if(dir == NULL) return NULL;
+
+    CorpusFile *files = NULL;
+    int capacity = 0;
+    *numFiles = 0;
+
+    for(struct dirent *ent = readdir(dir); ent; ent = readdir(dir)) {
+        if(!isSVGFileName(ent->d_name)) continue;
+
+        size_t dirLength = strlen(directory);
+        char *path = svgMalloc(dirLength + strlen(ent->d_name) + 2);
+        sprintf(path, "%s/%s", directory, ent->d_name);
+
+        struct stat info;
+        if(stat(path, &info) != 0 || !S_ISREG(info.st_mode)) {
+            svgFree(path);
+            continue;
+        }
+
+        if(*numFiles == capacity) {
+            CorpusFile *grown = growStack(files, &capacity, sizeof(CorpusFile));
+            if(grown == NULL) {
+                svgFree(path);
+                break;
+            }
+            files = grown;
+        }
+
+        files[*numFiles].path = path;
+        files[*numFiles].name = path + dirLength + 1;
+        files[*numFiles].info = info;
+        (*numFiles)++;
+    }
+    closedir(dir);
+
+    if(*numFiles > 1) qsort(files, *numFiles, sizeof(CorpusFile), compareFileSizes);
+    return files != NULL ? files : svgMalloc(sizeof(CorpusFile));
+}
+
+/**
+ * @brief frees the files returned by listCorpusFiles
+ *
+ * @param files
+ * @param numFiles
+ */
+void freeCorpusFiles(CorpusFile *files, int numFiles) {
+    if(files == NULL) return;
+
+    for(int i = 0; i < numFiles; i++) svgFree(files[i].path);
+    svgFree(files);
+}
+
+/**
+ * @brief runs a query on every svg file in a directory, on a pool of worker threads.  Files parsed by earlier
+ * queries are reused while they are unchanged, along with any area index built for them.  Each file with a
+ * match is passed to the callback as soon as its worker finishes it, so results arrive in no particular order
+ *
+ * @param directory
+ * @param query
+ * @param callback called with the name of the file within the directory and its number of matches, from one
+ * thread at a time
+ * @param context passed to the callback
+ * @return int number of files with a match, or -1 if the directory cannot be read or the schema cannot be compiled
+ */
+int queryCorpus(const char *directory, const SVGCorpusQuery *query, SVGCorpusCallback callback, void *context) {
+    if(directory == NULL || query == NULL || callback == NULL) return -1;
+    if(query->type == CORPUS_PATH_DATA && query->text == NULL) return -1;
+
+    CorpusRun run;
+    run.query = query;
+    run.callback = callback;
+    run.context = context;
+    run.schema = NULL;
+    atomic_init(&run.next, 0);
+    atomic_init(&run.matchedFiles, 0);
+
+    // Initializes libxml2's global state before the workers parse, which it needs to be thread safe
+    xmlInitParser();
+
+    if(query->schemaFile != NULL) {
+        if(!extensionMatches(query->schemaFile, ".xsd")) return -1;
+        run.schema = compileSchema(query->schemaFile);
+        if(run.schema == NULL) return -1;
+    }
+
+    run.files = listCorpusFiles(directory, &run.numFiles);
+    if(run.files == NULL) {
+        if(run.schema != NULL) xmlSchemaFree(run.schema);
+        return -1;
+    }
+
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int numThreads = query->threads > 0 ? query->threads : (cores > 0 ? (int)cores : 1);
+    if(numThreads > MAX_CORPUS_THREADS) numThreads = MAX_CORPUS_THREADS;
+    if(numThreads > run.numFiles) numThreads = run.numFiles;
+
+    pthread_mutex_init(&run.resultLock, NULL);
+
+    // The calling thread is one of the workers.  If a thread cannot be started the others take its files
+    pthread_t threads[MAX_CORPUS_THREADS];
+    int started = 0;
+    while(started < numThreads - 1 && pthread_create(&threads[started], NULL, corpusWorker, &run) == 0)
+        started++;
+
+    corpusWorker(&run);
+    for(int i = 0; i < started; i++) pthread_join(threads[i], NULL);
+
+    pthread_mutex_destroy(&run.resultLock);
+    if(run.schema != NULL) xmlSchemaFree(run.schema);
+
+    freeCorpusFiles(run.files, run.numFiles);
+
+    return atomic_load(&run.matchedFiles);
+}
+
+/**
+ * @brief runs a function on the struct of a file, from the cache the corpus queries share.  The file is parsed
+ * only if it changed since it was cached, so that the indexes and boxes built for its struct are reused by
+ * every call until then
+ *
+ * @param fileName
+ * @param schemaFile the file is used only if it is valid against it.  May be NULL or empty to only parse the file
+ * @param use called with the struct, which it may read and build the caches of but must not modify or free
+ * @param context passed to use
+ * @return true
+ * @return false if the file cannot be read or parsed, is not valid, or there is no memory to build its struct,
+ * and use was not called
+ */
+bool useCachedSVG(const char *fileName, const char *schemaFile, void (*use)(SVG *svg, void *context), void *context) {
+    if(fileName == NULL || use == NULL) return false;
+    if(schemaFile != NULL && schemaFile[0] == '\0') schemaFile = NULL;
+    if(schemaFile != NULL && !extensionMatches(schemaFile, ".xsd")) return false;
+
+    CorpusFile file = { (char*)fileName, fileName, { 0 } };
+    if(stat(fileName, &file.info) != 0 || !S_ISREG(file.info.st_mode)) return false;
+
+    CorpusEntry *entry = takeEntry(&file, schemaFile);
+    if(entry == NULL) {
+        // The schema is only compiled when the file has to be parsed again
+        xmlSchemaPtr schema = NULL;
+        if(schemaFile != NULL) {
+            schema = compileSchema(schemaFile);
+            if(schema == NULL) return false;
+        }
+
+        entry = loadEntry(&file, schemaFile, schema);
+        if(schema != NULL) xmlSchemaFree(schema);
+        if(entry == NULL) return false;
+    }
+
+    bool used = entry->svg != NULL;
+    if(used) use(entry->svg, context);
+
+    returnEntry(entry);
+    return used;
+}
+
+/**
+ * @brief drops the cached struct of a file, called when the library writes the file
+ *
+ * @param filename
+ */
+void invalidateCorpusFile(const char *filename) {
+    if(filename == NULL) return;
+
+    pthread_mutex_lock(&corpusLock);
+    CorpusEntry *entry = findCorpusEntry(filename);
+    if(entry != NULL) unlinkEntry(entry);
+    pthread_mutex_unlock(&corpusLock);
+
+    if(entry != NULL) freeEntry(entry);
+}
+
+/**
+ * @brief sets the most elements the cached structs may hold, evicting structs if needed
+ *
+ * @param elements 0 disables the cache
+ */
+void setCorpusCacheLimit(long elements) {
+    CorpusEntry *evicted = NULL;
+
+    pthread_mutex_lock(&corpusLock);
+    corpusLimit = elements > 0 ? elements : 0;
+
+    while(corpusTail != NULL && corpusElements > corpusLimit) {
+        CorpusEntry *last = corpusTail;
+        unlinkEntry(last);
+        last->next = evicted;
+        evicted = last;
+    }
+    pthread_mutex_unlock(&corpusLock);
+
+    while(evicted != NULL) {
+        CorpusEntry *next = evicted->next;
+        freeEntry(evicted);
+        evicted = next;
+    }
+}
+
+/**
+ * @brief callback of queryCorpusWrapper, adding a file to the JSON array of results
+ *
+ * @param fileName
+ * @param matches
+ * @param context the StringBuffer of the array
+ */
+static void appendCorpusResult(const char *fileName, int matches, void *context) {
+    StringBuffer *results = (StringBuffer*)context;
+
+    appendString(results, results->length > 1 ? ",{\"file\":" : "{\"file\":");
+    appendJSONString(results, fileName);
+
+    char count[32];
+    snprintf(count, sizeof(count), ",\"matches\":%d}", matches);
+    appendString(results, count);
+}
+
+/**
+ * @brief runs a corpus query for the server, returning [{"file":"name.svg","matches":2},...] in the order
+ * the files were finished
+ *
+ * @param directory
+ * @param schemaFile files that are not valid against it are skipped.  May be empty to only parse the files
+ * @param type rectArea, circleArea, pathData or groupLen
+ * @param minValue smallest area, or the group length
+ * @param maxValue largest area
+ * @param text path data
+ * @return char* NULL if the query cannot be run
+ */
+char *queryCorpusWrapper(char *directory, char *schemaFile, char *type, float minValue, float maxValue, char *text) {
+    if(type == NULL) return NULL;
+
+    SVGCorpusQuery query = { CORPUS_RECT_AREA, minValue, maxValue, text, NULL, 0 };
+    if(schemaFile != NULL && schemaFile[0] != '\0') query.schemaFile = schemaFile;
+
+    if(strcmp(type, "rectArea") == 0) query.type = CORPUS_RECT_AREA;
+    else if(strcmp(type, "circleArea") == 0) query.type = CORPUS_CIRCLE_AREA;
+    else if(strcmp(type, "pathData") == 0) query.type = CORPUS_PATH_DATA;
+    else if(strcmp(type, "groupLen") == 0) query.type = CORPUS_GROUP_LEN;
+    else return NULL;
+
+    StringBuffer results;
+    if(!initStringBuffer(&results, 256)) return NULL;
+    appendString(&results, "[");
+
+    if(queryCorpus(directory, &query, appendCorpusResult, &results) < 0) {
+        svgFree(results.data);
+        return NULL;
+    }
+
+    if(!appendString(&results, "]")) {
+        svgFree(results.data);
+        return NULL;
+    }
+    return results.data;
+}
@@ -0,0 +1,332 @@
+/**
+ * @file SVGGenerator.c
+ * @author Anthony Vidovic (1130891)
+ * @brief Generating synthetic svg structs of a configurable shape and size, for benchmarks and stress tests
+ * @version 0.1
+ * @date 2022-04-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+// ~~~~~ Includes ~~~~~ //
+#include "SVGHelper.h"
+#include <stdint.h>
+
+// Most groups a generated struct may have
+#define MAX_GENERATED_GROUPS 50000000
+
+// Presentation attributes given to generated elements, in the order they are added.  Every one is allowed
+// on rect, circle, path and g by svg.xsd.  The values of class are generated, the others are picked from a short list
+static const char *attributeNames[GENERATOR_MAX_ATTRIBUTES] = {
+    "fill", "stroke", "class", "stroke-width", "opacity", "fill-opacity", "stroke-opacity", "stroke-linecap"
+};
+
+static const char *attributeValues[GENERATOR_MAX_ATTRIBUTES][4] = {
+    { "red", "#3366cc", "none", "green" },
+    { "black", "blue", "#999", "none" },
+    { NULL, NULL, NULL, NULL },
+    { "1", "2", "0.5", "4" },
+    { "1", "0.75", "0.5", "0.25" },
+    { "1", "0.9", "0.6", "0.3" },
+    { "1", "0.8", "0.5", "0.2" },
+    { "butt", "round", "square", "round" },
+};
+
+// Units given to the shapes that have one
+static const lengthUnit generatedUnits[] = { UNIT_PX, UNIT_CM, UNIT_MM, UNIT_IN, UNIT_PT, UNIT_PC, UNIT_EM, UNIT_EX, UNIT_PERCENT };
+
+/**
+ * @brief sets the default generator options: 100 rectangles, circles and paths each in two levels of 4
+ * groups, with 2 attributes per element and 8 commands per path
+ *
+ * @param options
+ */
+void initGeneratorOptions(SVGGeneratorOptions *options) {
+    if(options == NULL) return;
+
+    options->seed = 1;
+    options->rects = 100;
+    options->circles = 100;
+    options->paths = 100;
+    options->groupDepth = 2;
+    options->groupFanout = 4;
+    options->attributes = 2;
+    options->classLength = 8;
+    options->pathCommands = 8;
+    options->unitPercent = 0;
+    options->width = 1000;
+    options->height = 1000;
+}
+
+/**
+ * @brief returns the next number of a xorshift generator.  The sequence depends only on the seed,
+ * so a seed generates the same struct on every platform
+ *
+ * @param state
+ * @return uint32_t
+ */
+static uint32_t nextRandom(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+/**
+ * @brief returns a random float in [0, limit) with one decimal place
+ *
+ * @param state
+ * @param limit
+ * @return float
+ */
+static float randomCoordinate(uint32_t *state, float limit) {
+    uint32_t steps = limit >= 1 ? (uint32_t)(limit * 10) : 10;
+    return (float)(nextRandom(state) % steps) / 10;
+}
+
+/**
+ * @brief creates an attribute with the given name and value
+ *
+ * @param name
+ * @param value
+ * @return Attribute*
+ */
+static Attribute *createAttribute(const char *name, const char *value) {
+    Attribute *attr = svgMalloc(sizeof(Attribute) + (strlen(value) + 1) * sizeof(char));
+    attr->name = svgMalloc(sizeof(char) * (strlen(name) + 1));
+
+    strcpy(attr->name, name);
+    strcpy(attr->value, value);
+
+    return attr;
+}
+
+/**
+ * @brief creates the generated attributes of an element
+ *
+ * @param options
+ * @param state
+ * @return List*
+ */
+static List *generateAttributes(const SVGGeneratorOptions *options, uint32_t *state) {
+    List *list = initializeList(&attributeToString, &deleteAttribute, &compareAttributes);
+
+    int count = options->attributes < GENERATOR_MAX_ATTRIBUTES ? options->attributes : GENERATOR_MAX_ATTRIBUTES;
+    for(int i = 0; i < count; i++) {
+        if(attributeValues[i][0] != NULL) {
+            insertBack(list, createAttribute(attributeNames[i], attributeValues[i][nextRandom(state) % 4]));
+            continue;
+        }
+
+        // class is a space separated list of lowercase words of up to 8 letters
+        int length = options->classLength > 0 ? options->classLength : 1;
+        char *value = svgMalloc(length + 1);
+        for(int c = 0; c < length; c++) {
+            value[c] = (c % 9 == 8 && c != length - 1) ? ' ' : 'a' + nextRandom(state) % 26;
+        }
+        value[length] = '\0';
+
+        insertBack(list, createAttribute(attributeNames[i], value));
+        svgFree(value);
+    }
+
+    return list;
+}
+
+/**
+ * @brief returns the unit of a generated rectangle or circle
+ *
+ * @param options
+ * @param state
+ * @return lengthUnit
+ */
+static lengthUnit generateUnit(const SVGGeneratorOptions *options, uint32_t *state) {
+    if((int)(nextRandom(state) % 100) >= options->unitPercent) return UNIT_NONE;
+    return generatedUnits[nextRandom(state) % (sizeof(generatedUnits) / sizeof(generatedUnits[0]))];
+}
+
+static Rectangle *generateRectangle(const SVGGeneratorOptions *options, uint32_t *state) {
+    Rectangle *rect = svgMalloc(sizeof(Rectangle));
+    rect->x = randomCoordinate(state, options->width);
+    rect->y = randomCoordinate(state, options->height);
+    rect->width = randomCoordinate(state, options->width / 10) + 1;
+    rect->height = randomCoordinate(state, options->height / 10) + 1;
+    rect->units = generateUnit(options, state);
+    rect->otherAttributes = generateAttributes(options, state);
+
+    return rect;
+}
+
+static Circle *generateCircle(const SVGGeneratorOptions *options, uint32_t *state) {
+    Circle *circle = svgMalloc(sizeof(Circle));
+    circle->cx = randomCoordinate(state, options->width);
+    circle->cy = randomCoordinate(state, options->height);
+    circle->r = randomCoordinate(state, options->width / 20) + 1;
+    circle->units = generateUnit(options, state);
+    circle->otherAttributes = generateAttributes(options, state);
+
+    return circle;
+}
+
+/**
+ * @brief creates a path that moves to a random point, then draws pathCommands lines, curves and arcs,
+ * and closes the shape
+ *
+ * @param options
+ * @param state
+ * @return Path*
+ */
+static Path *generatePath(const SVGGeneratorOptions *options, uint32_t *state) {
+    int commands = options->pathCommands > 0 ? options->pathCommands : 1;
+
+    // Each command has at most 7 numbers, each followed by a separator
+    size_t size = (size_t)(commands + 1) * (7 * (FLOAT_STRING_SIZE + 1) + 2) + 2;
+    Path *path = svgMalloc(sizeof(Path) + size);
+    char *cur = path->data;
+
+    for(int i = 0; i <= commands; i++) {
+        int numbers = 2;
+        if(i == 0) {
+            *cur++ = 'M';
+        } else {
+            switch(nextRandom(state) % 4) {
+                case 0: *cur++ = 'L'; break;
+                case 1: *cur++ = 'Q'; numbers = 4; break;
+                case 2: *cur++ = 'C'; numbers = 6; break;
+                default:
+                    // Radii, rotation and flags, then the end point
+                    cur += sprintf(cur, "A %d %d 0 %d %d", 1 + (int)(nextRandom(state) % 50), 1 + (int)(nextRandom(state) % 50),
+                                   (int)(nextRandom(state) % 2), (int)(nextRandom(state) % 2));
+            }
+        }
+
+        for(int n = 0; n < numbers; n++) {
+            *cur++ = ' ';
+            cur += formatFloat(randomCoordinate(state, n % 2 == 0 ? options->width : options->height), cur);
+        }
+        *cur++ = ' ';
+    }
+    strcpy(cur, "Z");
+
+    path->otherAttributes = generateAttributes(options, state);
+    return path;
+}
+
+static Group *generateGroup(const SVGGeneratorOptions *options, uint32_t *state) {
+    Group *g = svgMalloc(sizeof(Group));
+    g->rectangles = initializeList(&rectangleToString, &deleteRectangle, &compareRectangles);
+    g->circles = initializeList(&circleToString, &deleteCircle, &compareCircles);
+    g->paths = initializeList(&pathToString, &deletePath, &comparePaths);
+    g->groups = initializeList(&groupToString, &deleteGroup, &compareGroups);
+    g->otherAttributes = generateAttributes(options, state);
+
+    return g;
+}
+
+/**
+ * @brief returns the number of groups generated by the options: groupFanout groups at the top level, and
+ * groupFanout groups in every group less than groupDepth levels deep
+ *
+ * @param options
+ * @return long long number of groups, or -1 if there are more than MAX_GENERATED_GROUPS
+ */
+static long long countGeneratedGroups(const SVGGeneratorOptions *options) {
+    if(options->groupDepth <= 0 || options->groupFanout <= 0) return 0;
+
+    long long total = 0, level = 1;
+    for(int depth = 0; depth < options->groupDepth; depth++) {
+        level *= options->groupFanout;
+        total += level;
+        if(total > MAX_GENERATED_GROUPS) return -1;
+    }
+
+    return total;
+}
+
+/**
+ * @brief generates an svg struct from a seed.  Shapes are spread at random over the top level and every group,
+ * and their coordinates, sizes, units and attribute values are random.  The same options always generate the same
+ * struct, which writeSVG writes as a file valid against svg.xsd
+ *
+ * @param options NULL for the defaults of initGeneratorOptions
+ * @return SVG* NULL if the options are invalid, describe more than MAX_GENERATED_GROUPS groups, or the element
+ * table cannot be allocated
+ */
+SVG* generateSVG(const SVGGeneratorOptions *options) {
+    SVGGeneratorOptions defaults;
+    if(options == NULL) {
+        initGeneratorOptions(&defaults);
+        options = &defaults;
+    }
+
+    if(options->rects < 0 || options->circles < 0 || options->paths < 0 || options->attributes < 0) return NULL;
+    if(!(options->width > 0) || !(options->height > 0)) return NULL;
+
+    long long numGroups = countGeneratedGroups(options);
+    if(numGroups < 0) return NULL;
+
+    // A zero seed would make the xorshift sequence all zeroes
+    uint32_t state = options->seed != 0 ? options->seed : 0x9e3779b9u;
+
+    SVG *svg = svgMalloc(sizeof(SVG));
+    svg->rectangles = initializeList(&rectangleToString, &deleteRectangle, &compareRectangles);
+    svg->circles = initializeList(&circleToString, &deleteCircle, &compareCircles);
+    svg->paths = initializeList(&pathToString, &deletePath, &comparePaths);
+    svg->groups = initializeList(&groupToString, &deleteGroup, &compareGroups);
+    svg->otherAttributes = initializeList(&attributeToString, &deleteAttribute, &compareAttributes);
+    strcpy(svg->namespace, "http://www.w3.org/2000/svg");
+    snprintf(svg->title, sizeof(svg->title), "Generated document");
+    snprintf(svg->description, sizeof(svg->description), "Seed %u: %d rectangles, %d circles, %d paths, %lld groups",
+             options->seed, options->rects, options->circles, options->paths, numGroups);
+    initSVGCaches(svg);
+
+    char value[FLOAT_STRING_SIZE];
+    formatFloat(options->width, value);
+    insertBack(svg->otherAttributes, createAttribute("width", value));
+    formatFloat(options->height, value);
+    insertBack(svg->otherAttributes, createAttribute("height", value));
+
+    // Groups are created a level at a time, so a deep chain of groups needs no recursion
+    Group **groups = svgMalloc(sizeof(Group*) * (numGroups + 1));
+    long long created = 0, levelStart = 0;
+
+    for(int depth = 0; depth < options->groupDepth && numGroups > 0; depth++) {
+        long long levelEnd = created;
+        long long parents = depth == 0 ? 1 : levelEnd - levelStart;
+
+        for(long long p = 0; p < parents; p++) {
+            List *parent = depth == 0 ? svg->groups : groups[levelStart + p]->groups;
+            for(int i = 0; i < options->groupFanout; i++) {
+                groups[created] = generateGroup(options, &state);
+                insertBack(parent, groups[created++]);
+            }
+        }
+
+        levelStart = levelEnd;
+    }
+
+    // Each shape goes to the top level or to a random group
+    for(int i = 0; i < options->rects; i++) {
+        long long container = nextRandom(&state) % (numGroups + 1);
+        insertBack(container == numGroups ? svg->rectangles : groups[container]->rectangles, generateRectangle(options, &state));
+    }
+    for(int i = 0; i < options->circles; i++) {
+        long long container = nextRandom(&state) % (numGroups + 1);
+        insertBack(container == numGroups ? svg->circles : groups[container]->circles, generateCircle(options, &state));
+    }
+    for(int i = 0; i < options->paths; i++) {
+        long long container = nextRandom(&state) % (numGroups + 1);
+        insertBack(container == numGroups ? svg->paths : groups[container]->paths, generatePath(options, &state));
+    }
+    svgFree(groups);
+
+    if(!buildElementTable(svg)) {
+        deleteSVG(svg);
+        return NULL;
+    }
+    computeSVGTotals(svg, &svg->totals);
+
+    return svg;
+}
@@ -12,24 +12,61 @@
 // ~~~~~ Includes ~~~~~ //
 #include "SVGHelper.h"
 
+// Element the walk of addElements has descended into, and the group it and its siblings were added to
+typedef struct {
+    xmlNode *node;
+    Group *container;
+} ElementFrame;
+
 /**
- * @brief iterates xml tree starting from the root node,
- * will sort/add elements and attributes into svg struct
- * 
- * @param svg pointer to SVG struct
- * @param a_node 
+ * @brief walks a node, its siblings and every node nested in them in document order, sorting elements into the
+ * svg struct or into groups.  Shapes are added to the innermost group enclosing them.  The nodes descended into
+ * are kept on a heap allocated stack, so deep nesting cannot overflow the call stack
+ *
+ * @param svg struct to add elements outside of any group to, NULL when walking the contents of a group
+ * @param g group to add elements outside of any nested group to, NULL for the top level of svg
+ * @param a_node first node to walk
+ * @return true
+ * @return false if elements are nested more than getSVGMaxDepth levels deep, counting a_node as 1, or memory runs out
  */
-void addElementsToSVG(SVG* svg, xmlNode* a_node) {
-    xmlNode* cur_node = NULL;
+static bool addElements(SVG* svg, Group *g, xmlNode* a_node) {
+    ElementFrame *stack = NULL;
+    int depth = 0, capacity = 0;
+    int maxDepth = getSVGMaxDepth();
+
+    xmlNode* cur_node = a_node;
+    // Group the current node and its siblings are added to
+    Group *container = g;
+
+    while(cur_node) {
+        // Group the children of the current node are added to
+        Group *childContainer = container;
 
-    // Keep looping to the next node until there is none 
-    for (cur_node = a_node; cur_node; cur_node = cur_node->next) {
         if (cur_node->type == XML_ELEMENT_NODE) {
             xmlAttr* attribute = cur_node->properties;
             char *name = (char*)cur_node->name;
-            
-            if (strcasecmp(name, "SVG") == 0) {
-                char* namespace = malloc(sizeof(char) * (xmlStrlen(cur_node->ns->href) + 1));
+
+            if (depth >= maxDepth) {
+                svgFree(stack);
+                return false;
+            }
+
+            if (strcasecmp(name, "G") == 0) {
+                // The group's children are added to it as the walk descends
+                childContainer = createGroup(cur_node, attribute);
+                insertBack(container != NULL ? container->groups : svg->groups, childContainer);
+            }
+            else if (container != NULL) {
+                if (strcasecmp(name, "RECT") == 0) {
+                    insertBack(container->rectangles, createRectangle(cur_node, attribute));
+                } else if (strcasecmp(name, "CIRCLE") == 0) {
+                    insertBack(container->circles, createCircle(cur_node, attribute));
+                } else if (strcasecmp(name, "PATH") == 0) {
+                    insertBack(container->paths, createPath(cur_node, attribute));
+                }
+            }
+            else if (strcasecmp(name, "SVG") == 0) {
+                char* namespace = svgMalloc(sizeof(char) * (xmlStrlen(cur_node->ns->href) + 1));
 
                 if((char*)cur_node->ns->href != NULL) 
                     strcpy(namespace, (char*)cur_node->ns->href);
@@ -41,7 +78,7 @@ void addElementsToSVG(SVG* svg, xmlNode* a_node) {
                     insertBack(svg->otherAttributes, newAttribute(attribute));
                     attribute = attribute->next;
                 }    
-                free(namespace);
+                svgFree(namespace);
             }
             else if (strcasecmp(name, "TITLE") == 0) {
                 snprintf(svg->title, sizeof(svg->title), (char*)cur_node->children->content);
@@ -49,10 +86,6 @@ void addElementsToSVG(SVG* svg, xmlNode* a_node) {
             else if (strcasecmp(name, "DESC") == 0) {
                 snprintf(svg->description, sizeof(svg->description), (char*)cur_node->children->content);
             }
-            else if (strcasecmp(name, "G") == 0) {
-                insertBack(svg->groups, createGroup(cur_node, attribute));
-                continue;
-            }
             else if (strcasecmp(name, "PATH") == 0) {
                 insertBack(svg->paths, createPath(cur_node, attribute));
             }
@@ -63,9 +96,50 @@ void addElementsToSVG(SVG* svg, xmlNode* a_node) {
                 insertBack(svg->rectangles, createRectangle(cur_node, attribute));
             }
         }
-        // Recursive call, passing the first nested node from the parent node
-        addElementsToSVG(svg, cur_node->children);
+
+        // Descend into the first nested node, remembering where to continue from
+        if (cur_node->children != NULL) {
+            if (depth == capacity) {
+                ElementFrame *grown = growStack(stack, &capacity, sizeof(ElementFrame));
+                if (grown == NULL) {
+                    svgFree(stack);
+                    return false;
+                }
+                stack = grown;
+            }
+            stack[depth].node = cur_node;
+            stack[depth].container = container;
+            depth++;
+
+            container = childContainer;
+            cur_node = cur_node->children;
+            continue;
+        }
+
+        // Move on to the next sibling, climbing out of every node that has none
+        while (cur_node->next == NULL && depth > 0) {
+            depth--;
+            cur_node = stack[depth].node;
+            container = stack[depth].container;
+        }
+        cur_node = cur_node->next;
     }
+
+    svgFree(stack);
+    return true;
+}
+
+/**
+ * @brief iterates xml tree starting from the root node,
+ * will sort/add elements and attributes into svg struct
+ * 
+ * @param svg pointer to SVG struct
+ * @param a_node 
+ * @return true
+ * @return false if the elements are nested deeper than getSVGMaxDepth
+ */
+bool addElementsToSVG(SVG* svg, xmlNode* a_node) {
+    return addElements(svg, NULL, a_node);
 }
 
 /**
@@ -76,11 +150,11 @@ void addElementsToSVG(SVG* svg, xmlNode* a_node) {
  * @return Rectangle* 
  */
 Rectangle* createRectangle(xmlNode* cur_node, xmlAttr* attribute) {
-    Rectangle *rect = malloc(sizeof(Rectangle));
+    Rectangle *rect = svgMalloc(sizeof(Rectangle));
     rect->otherAttributes = initializeList(&attributeToString, &deleteAttribute, &compareAttributes);
     rect->x = 0;
     rect->y = 0;
-    strcpy(rect->units, "");
+    rect->units = UNIT_NONE;
 
     while(attribute) { 
         if(attribute == NULL) continue;
@@ -88,29 +162,13 @@ Rectangle* createRectangle(xmlNode* cur_node, xmlAttr* attribute) {
         char *attrValue = (char*)attribute->children->content;
         
         if(strcasecmp(attrName, "x") == 0) {
-            char *units = checkForUnits(attrValue);
-            char *num = removeAllExceptDigits(attrValue);
-            if(strlen(units) > 0) strcpy(rect->units, units);
-            rect->x = strtof(attrValue, NULL);
-            free(num);
+            setLengthField(attrValue, &rect->x, &rect->units);
         } else if(strcasecmp(attrName, "y") == 0) {
-            char *units = checkForUnits(attrValue);
-            char *num = removeAllExceptDigits(attrValue);
-            if(strlen(units) > 0) strcpy(rect->units, units);
-            rect->y = strtof(num, NULL);
-            free(num);
+            setLengthField(attrValue, &rect->y, &rect->units);
         } else if(strcasecmp(attrName, "width") == 0) {
-            char *units = checkForUnits(attrValue);
-            char *num = removeAllExceptDigits(attrValue);
-            if(strlen(units) > 0) strcpy(rect->units, units);
-            rect->width = strtof(num, NULL);
-            free(num);
+            setLengthField(attrValue, &rect->width, &rect->units);
         } else if(strcasecmp(attrName, "height") == 0) {
-            char *units = checkForUnits(attrValue);
-            char *num = removeAllExceptDigits(attrValue);
-            if(strlen(units) > 0) strcpy(rect->units, units);
-            rect->height = strtof(num, NULL);
-            free(num);
+            setLengthField(attrValue, &rect->height, &rect->units);
         } else {
             insertBack(rect->otherAttributes, newAttribute(attribute));
         }
@@ -127,11 +185,11 @@ Rectangle* createRectangle(xmlNode* cur_node, xmlAttr* attribute) {
  * @return Circle* 
  */
 Circle* createCircle(xmlNode* cur_node, xmlAttr* attribute) {
-    Circle *circle = malloc(sizeof(Circle));
+    Circle *circle = svgMalloc(sizeof(Circle));
     circle->otherAttributes = initializeList(&attributeToString, &deleteAttribute, &compareAttributes);
     circle->cx = 0;
     circle->cy = 0;
-    strcpy(circle->units, "");
+    circle->units = UNIT_NONE;
     
     while(attribute) { 
         if(attribute == NULL) continue;
@@ -139,23 +197,11 @@ Circle* createCircle(xmlNode* cur_node, xmlAttr* attribute) {
         char *attrValue = (char*)attribute->children->content;
         
         if(strcasecmp(attrName, "cx") == 0) {
-            char *units = checkForUnits(attrValue);
-            char *num = removeAllExceptDigits(attrValue);
-            if(strlen(units) > 0) strcpy(circle->units, units);     
-            circle->cx = strtof(num, NULL);
-            free(num);
+            setLengthField(attrValue, &circle->cx, &circle->units);
         } else if(strcasecmp(attrName, "cy") == 0) {
-            char *units = checkForUnits(attrValue);
-            char *num = removeAllExceptDigits(attrValue);
-            if(strlen(units) > 0) strcpy(circle->units, units);      
-            circle->cy = strtof(num, NULL);
-            free(num);
+            setLengthField(attrValue, &circle->cy, &circle->units);
         } else if(strcasecmp(attrName, "r") == 0) {
-            char *units = checkForUnits(attrValue);
-            char *num = removeAllExceptDigits(attrValue);
-            if(strlen(units) > 0) strcpy(circle->units, units);     
-            circle->r = strtof(num, NULL);
-            free(num);
+            setLengthField(attrValue, &circle->r, &circle->units);
         } else {
             insertBack(circle->otherAttributes, newAttribute(attribute));
         }
@@ -172,7 +218,7 @@ Circle* createCircle(xmlNode* cur_node, xmlAttr* attribute) {
  * @return Path* 
  */
 Path* createPath(xmlNode* cur_node, xmlAttr* attribute) {
-    Path *p = malloc(sizeof(Path) + (strlen((char*)attribute->children->content) + 1) * sizeof(char));
+    Path *p = svgMalloc(sizeof(Path) + (strlen((char*)attribute->children->content) + 1) * sizeof(char));
     p->otherAttributes = initializeList(&attributeToString, &deleteAttribute, &compareAttributes);
     
     while(attribute) { 
@@ -181,7 +227,7 @@ Path* createPath(xmlNode* cur_node, xmlAttr* attribute) {
         char *attrValue = (char*)attribute->children->content;
         
         if(strcasecmp(attrName, "d") == 0) {
-            p = realloc(p, sizeof(Path) + (strlen((char*)attribute->children->content) + 1) * sizeof(char));
+            p = svgRealloc(p, sizeof(Path) + (strlen((char*)attribute->children->content) + 1) * sizeof(char));
             strcpy(p->data, attrValue);
         } else {
             insertBack(p->otherAttributes, newAttribute(attribute));
@@ -192,14 +238,15 @@ Path* createPath(xmlNode* cur_node, xmlAttr* attribute) {
 }
 
 /**
- * @brief Create a Group object
+ * @brief Create a Group object with the attributes of the group node.  Its contents
+ * are added by the walk that created it, or by iterateGroup
  * 
  * @param cur_node group node/element
  * @param attribute first attribute of group node
  * @return Group* 
  */
 Group* createGroup(xmlNode* cur_node, xmlAttr* attribute) {
-    Group *g = malloc(sizeof(Group));
+    Group *g = svgMalloc(sizeof(Group));
     g->rectangles = initializeList(&rectangleToString, &deleteRectangle, &compareRectangles);
     g->circles = initializeList(&circleToString, &deleteCircle, &compareCircles);
     g->paths = initializeList(&pathToString, &deletePath, &comparePaths);
@@ -213,37 +260,21 @@ Group* createGroup(xmlNode* cur_node, xmlAttr* attribute) {
         attribute = attribute->next;
     }   
 
-    iterateGroup(cur_node->children, g);
     return g;
 }
 
 /**
- * @brief recursively iterates a groups items
+ * @brief iterates a groups items, adding them and everything nested in them to the group
  * 
  * @param a_node first item in the group
  * @param g pointer to a Group struct
+ * @return true
+ * @return false if the items are nested deeper than getSVGMaxDepth
  */
-void iterateGroup(xmlNode* a_node, Group *g) {
-    xmlNode* cur_node = NULL;
-    
-    for (cur_node = a_node; cur_node; cur_node = cur_node->next) {
-        if (cur_node->type == XML_ELEMENT_NODE) {  
-            xmlAttr* tempAttribute = cur_node->properties;
-            char *name = (char*)cur_node->name;
+bool iterateGroup(xmlNode* a_node, Group *g) {
+    if(g == NULL) return false;
 
-            if (strcasecmp(name, "G") == 0) {
-                insertBack(g->groups, createGroup(cur_node, tempAttribute));
-                continue;
-            } else if (strcasecmp(name, "RECT") == 0) {
-                insertBack(g->rectangles, createRectangle(cur_node, tempAttribute));
-            } else if (strcasecmp(name, "CIRCLE") == 0) {
-                insertBack(g->circles, createCircle(cur_node, tempAttribute));
-            } else if (strcasecmp(name, "PATH") == 0) {
-                insertBack(g->paths, createPath(cur_node, tempAttribute));
-            }
-        }    
-        iterateGroup(cur_node->children, g);       
-    }
+    return addElements(NULL, g, a_node);
 }
 
 /**
@@ -256,8 +287,8 @@ Attribute *newAttribute(xmlAttr* xmlAttr) {
     char *attrName = (char*)xmlAttr->name;
     char *attrValue = (char*)xmlAttr->children->content;
     
-    Attribute *attr = malloc(sizeof(Attribute) + (strlen(attrValue) + 1) * sizeof(char));
-    attr->name = malloc(sizeof(char) * (strlen(attrName) + 1));
+    Attribute *attr = svgMalloc(sizeof(Attribute) + (strlen(attrValue) + 1) * sizeof(char));
+    attr->name = svgMalloc(sizeof(char) * (strlen(attrName) + 1));
 
     strcpy(attr->name, attrName);
     strcpy(attr->value, attrValue); 
@@ -265,425 +296,293 @@ Attribute *newAttribute(xmlAttr* xmlAttr) {
     return attr;    
 }
 
+// Supported length unit identifiers, indexed by lengthUnit
+static const char *unitNames[] = { "", "cm", "px", "em", "ex", "pt", "pc", "mm", "in", "%", "invalid" };
+
 /**
- * @brief removes all characters from a string except for digits,
- * modified to keep '-' for negative numbers and '.' for decimals.
- * 
- * https://www.codevscolor.com/c-remove-characters-string-keeping-numbers
- * @param string dirty string (any characters)
- * @return char* string containing only digits, or empty string if no digits present
+ * @brief parses an SVG length - an optional sign, digits with an optional fraction and exponent,
+ * then an optional unit identifier - in a single pass without allocating. Spaces are allowed around
+ * the number and the unit, and the unit is matched case insensitively
+ *
+ * @param str string to parse
+ * @param value set to the number, or to the numeric prefix (0 if none) when the string is not a valid length
+ * @param unit set to the unit, UNIT_NONE if there is none or UNIT_INVALID if the string is not a valid length
+ * @return true if the whole string is a valid length
+ * @return false
  */
-char *removeAllExceptDigits(char *string) {
-    if(strlen(string) < 1) return NULL;
-
-    char *digitsStr = malloc(sizeof(char) * (strlen(string) + 1));
-    strcpy(digitsStr, string); 
-    bool negative = false;
-    int j = 0;
-    
-    // Flags negative if '-' is present in string (added by me)
-    for (int i = 0; digitsStr[i] != '\0'; i++) {
-        if(digitsStr[i] == '-' && (digitsStr[i+1] >= '0' && digitsStr[i+1] <= '9')) {
-            negative = true;
-        }
-    }
-    
-    // Removes everything except digits
-    for (int i = 0; digitsStr[i]; i++) {
-        if ((digitsStr[i] >= '0' && digitsStr[i] <= '9') || digitsStr[i] == '.') {
-            digitsStr[j] = digitsStr[i];
-            j++;
+bool parseLength(const char *str, float *value, lengthUnit *unit) {
+    *value = 0;
+    *unit = UNIT_INVALID;
+    if(str == NULL) return false;
+
+    const char *p = str;
+    while(isspace((unsigned char)*p)) p++;
+
+    const char *number = p;
+    *value = parseFloat(number, &p);
+    if(p == number) return false;
+
+    while(isspace((unsigned char)*p)) p++;
+
+    lengthUnit found = UNIT_NONE;
+    if(*p == '%') {
+        found = UNIT_PERCENT;
+        p++;
+    } else if(isalpha((unsigned char)p[0]) && isalpha((unsigned char)p[1])) {
+        char first = tolower((unsigned char)p[0]);
+        char second = tolower((unsigned char)p[1]);
+
+        found = UNIT_INVALID;
+        for(int i = UNIT_CM; i <= UNIT_IN; i++) {
+            if(unitNames[i][0] == first && unitNames[i][1] == second) {
+                found = (lengthUnit)i;
+                break;
+            }
         }
+        p += 2;
     }
 
-    digitsStr[j] = '\0';
-
-    // Prepend minus sign if negative flaged
-    if(negative) digitsStr = prependChar('-', digitsStr);
+    while(isspace((unsigned char)*p)) p++;
+    if(found == UNIT_INVALID || *p != '\0') return false;
 
-    // Remove trailing decimal points if there is any
-    if(strlen(digitsStr) > 0)
-        if(digitsStr[strlen(digitsStr)-1] == '.') digitsStr[strlen(digitsStr)-1] = '\0';
-
-    return digitsStr;
-}
-
-/**
- * @brief prepends a character to a string
- * 
- * https://stackoverflow.com/questions/50052254/add-char-to-beginning-and-end-of-a-string
- * @param before char to prepend
- * @param str 
- * @return char* string with prepended character
- */
-char *prependChar(char before, char *str) {
-    size_t len = strlen(str);
-    if(before) {
-        memmove(str + 1, str, ++len);
-        *str = before;
-    }
-    return str;
+    *unit = found;
+    return true;
 }
 
 /**
- * @brief removes all spaces from a string
- * 
- * https://stackoverflow.com/questions/1726302/remove-spaces-from-a-string-in-c
- * @param s dirty string with possible spaces
+ * @brief returns the identifier of a length unit, "" for UNIT_NONE and "invalid" for UNIT_INVALID
+ *
+ * @param unit
+ * @return const char*
  */
-void remove_spaces(char* s) {
-    if(s == NULL) return;
+const char *lengthUnitName(lengthUnit unit) {
+    if(unit < UNIT_NONE || unit > UNIT_INVALID) return unitNames[UNIT_INVALID];
 
-    char* d = s;
-    do {
-        while (*d == ' ') {
-            ++d;
-        }
-    } while ((*s++ = *d++));
+    return unitNames[unit];
 }
 
 /**
- * @brief checks if a string contains a supported length unit identifier
- * 
- * @param string 
- * @return char* the unit that exists, or NULL if none found. Valid if digit comes before the unit.
+ * @brief returns the length unit with the given identifier, matched case insensitively
+ *
+ * @param name unit identifier, "" for no unit
+ * @return lengthUnit UNIT_INVALID if the identifier is not a supported unit
  */
-char *checkForUnits(char *string) {
-    const int NUM_UNITS = 9;
-    char *tempStr = malloc(sizeof(char) * (strlen(string) + 1));
+lengthUnit lengthUnitFromName(const char *name) {
+    if(name == NULL) return UNIT_INVALID;
 
-    /* The supported length unit identifiers in SVG are: 
-    /  emx, px, pt, pc, cm, mm, in, and percentages.
-    */
-    char *units[] = {"cm", "px", "em", "ex", "pt", "pc", "mm", "in", "%"};
+    for(int i = UNIT_NONE; i < UNIT_INVALID; i++)
+        if(strcasecmp(name, unitNames[i]) == 0) return (lengthUnit)i;
 
-    strcpy(tempStr, string);
-    
-    for(int i = 0; i < strlen(tempStr); i++)
-        tempStr[i] = tolower(tempStr[i]);
-    
-    remove_spaces(tempStr);
-    
-    // Remove number from string
-    char *tempStr2 = removeDigitsFromStr(tempStr);
-
-    remove_spaces(tempStr2);
-
-    if(strlen(tempStr2) < 1) {
-        free(tempStr);
-        free(tempStr2);
-        return "";
-    }
-
-    for(int i = 0; i < NUM_UNITS; i++) {
-        if(strcmp(tempStr2, units[i]) == 0) {
-            char *ret = strstr(tempStr, units[i]);
-            int pos = ret - tempStr;
-
-            if(isdigit(tempStr[pos-1])) {
-                free(tempStr);
-                free(tempStr2);
-                return units[i];
-            }
-        }
-    }
-    
-    free(tempStr);
-    free(tempStr2);
-    return "invalid";
+    return UNIT_INVALID;
 }
 
 /**
- * @brief removes all digits from a string, modified to keep decimals also
- * 
- * https://stackoverflow.com/questions/17557477/strip-numbers-from-a-string-in-c
- * @param stringToStrip dirty string with possible digits
+ * @brief parses a geometry attribute of a rectangle or circle into its field. The unit, or UNIT_INVALID if
+ * the value is not a valid length, is stored in the shape's units and an invalid unit is never overwritten
+ *
+ * @param attrValue
+ * @param field
+ * @param units units of the shape
  */
-char* removeDigitsFromStr(char *stringToStrip) {
-    char *stripped = malloc(sizeof(char) * (strlen(stringToStrip) + 1));
-    
-    const int stringLen = strlen(stringToStrip);
-    int j = 0;
-    char currentChar;
-    
-    for( int i = 0; i < stringLen; ++i ) {
-        currentChar = stringToStrip[i];
-        if (currentChar != '.' && !isdigit(currentChar)) {
-            stripped[j++] = currentChar;
-        }
-    }
-    
-    stripped[j] = '\0';
+void setLengthField(const char *attrValue, float *field, lengthUnit *units) {
+    lengthUnit unit;
+    bool valid = parseLength(attrValue, field, &unit);
 
-    return stripped;
+    if(*units == UNIT_INVALID) return;
+
+    if(!valid)
+        *units = UNIT_INVALID;
+    else if(unit != UNIT_NONE)
+        *units = unit;
 }
 
 /**
- * @brief recursively iterates a group and adds all rectangles to rectangles list
+ * @brief iterates a group and every group nested in it and adds all rectangles to rectangles list
  * 
  * @param group group to iterate
  * @param rectangles list to add to
  */
 void findRectanglesInGroup(List *group, List *rectangles) {
     if(group == NULL || rectangles == NULL) return;
-    Node *cur = group->head;
 
-    while(cur) {
-        Group *g = (Group*)cur->data;
-        
-        if(g->rectangles->length > 0) {
-            Node *curRect = g->rectangles->head;
-            while(curRect) {
-                Rectangle *r = (Rectangle*)curRect->data;
-                insertBack(rectangles, r);
-                curRect = curRect->next;
-            }
-        }
-        findRectanglesInGroup(g->groups, rectangles);
-        cur = cur->next;
-    }
+    SVGVisitor visitor = { VISIT_RECTS, 0, NULL, NULL, &appendElement, rectangles };
+    visitGroups(group, &visitor, 1);
 }
 
 /**
- * @brief recursively iterates a group and adds all circles to circles list
+ * @brief iterates a group and every group nested in it and adds all circles to circles list
  * 
  * @param group group to iterate
  * @param circles list to add to
  */
 void findCirclesInGroup(List *group, List *circles) {
     if(group == NULL || circles == NULL) return;
-    Node *cur = group->head;
 
-    while(cur) {
-        Group *g = (Group*)cur->data;
-        
-        if(g->circles->length > 0) {
-            Node *curCircle = g->circles->head;
-            while(curCircle) {
-                Circle *circle = (Circle*)curCircle->data;
-                insertBack(circles, circle);
-                curCircle = curCircle->next;
-            }
-        }
-        findCirclesInGroup(g->groups, circles);
-        cur = cur->next;
-    }
+    SVGVisitor visitor = { VISIT_CIRCLES, 0, NULL, NULL, &appendElement, circles };
+    visitGroups(group, &visitor, 1);
 }
 
 /**
- * @brief recursively iterates a group and adds all paths to paths list
+ * @brief iterates a group and every group nested in it and adds all paths to paths list
  * 
  * @param group group to iterate
  * @param paths list to add to
  */
 void findPathsInGroup(List *group, List *paths) {
     if(group == NULL || paths == NULL) return;
-    Node *cur = group->head;
 
-    while(cur) {
-        Group *g = (Group*)cur->data;
-        
-        if(g->paths->length > 0) {
-            Node *curPath = g->paths->head;
-            while(curPath) {
-                Circle *p = (Circle*)curPath->data;
-                insertBack(paths, p);
-                curPath = curPath->next;
-            }
-        }
-        findPathsInGroup(g->groups, paths);
-        cur = cur->next;
-    }
+    SVGVisitor visitor = { VISIT_PATHS, 0, NULL, NULL, &appendElement, paths };
+    visitGroups(group, &visitor, 1);
 }
 
 /**
- * @brief recursively iterates a group and adds all groups to groups list
+ * @brief iterates a group and adds it and every group nested in it to groups list
  * 
  * @param group group to iterate
  * @param groups list to add to
  */
 void findGroups(List *group, List *groups) {
     if(group == NULL || groups == NULL) return;
-    Node *cur = group->head;
 
-    while(cur) {
-        Group *g = (Group*)cur->data;
-        insertBack(groups, g);
+    SVGVisitor visitor = { VISIT_GROUPS, 0, NULL, NULL, &appendElement, groups };
+    visitGroups(group, &visitor, 1);
+}
 
-        if(g->groups->length > 0) {
-            findGroups(g->groups, groups);
-        }
-        cur = cur->next;
-    }
+/**
+ * @brief predicate of a rectangle whose area rounds up to the same value as the float arg
+ * 
+ * @param element 
+ * @param area 
+ * @return true 
+ * @return false 
+ */
+bool rectHasArea(const VisitedElement *element, const void *area) {
+    Rectangle *rect = (Rectangle*)element->data;
+    float rectArea = rect->width * rect->height;
+    return ceil(rectArea) == ceil(*(const float*)area);
+}
+
+/**
+ * @brief predicate of a circle whose area rounds up to the same value as the float arg
+ * 
+ * @param element 
+ * @param area 
+ * @return true 
+ * @return false 
+ */
+bool circleHasArea(const VisitedElement *element, const void *area) {
+    Circle *circle = (Circle*)element->data;
+    float circleArea = M_PI * circle->r * circle->r;
+    return ceil(circleArea) == ceil(*(const float*)area);
+}
+
+/**
+ * @brief predicate of a path whose data is the string arg
+ * 
+ * @param element 
+ * @param data 
+ * @return true 
+ * @return false 
+ */
+bool pathHasData(const VisitedElement *element, const void *data) {
+    return strcmp(((Path*)element->data)->data, (const char*)data) == 0;
+}
+
+/**
+ * @brief predicate of a group holding as many elements as the int arg
+ * 
+ * @param element 
+ * @param len 
+ * @return true 
+ * @return false 
+ */
+bool groupHasLength(const VisitedElement *element, const void *len) {
+    Group *g = (Group*)element->data;
+    int groupLen = g->rectangles->length + g->circles->length + g->paths->length + g->groups->length;
+    return groupLen == *(const int*)len;
 }
 
 /**
- * @brief Recursively iterates groups and checks if any rectangle found has
+ * @brief Iterates groups and every group nested in them and checks if any rectangle found has
  * the given area
  * 
- * @param group group to recusively search
+ * @param group group to search
  * @param found number of matches found
  * @param area area to check for
  */
 void searchGroupsForRectArea(List *group, int *found, float area) {
     if(group == NULL || area < 0) return;
 
-    Node *cur = group->head;
-
-    while (cur) {
-        Group *g = (Group*)cur->data;
-
-        if(g->rectangles->length > 0) {
-            Node *curRect = g->rectangles->head;
-
-            // Loop until no rectangles in list
-            while(curRect) {
-                Rectangle *rect = (Rectangle*)curRect->data;
-                float rectArea = rect->width * rect->height;
-                if(ceil(rectArea) == ceil(area)) *found+=1;
-                curRect = curRect->next;
-            }
-        }
-        // Recursive call to search groups inside of the current group
-        searchGroupsForRectArea(g->groups, found, area);
-        cur = cur->next;
-    }
+    SVGVisitor visitor = { VISIT_RECTS, 0, &rectHasArea, &area, &countElement, found };
+    visitGroups(group, &visitor, 1);
 }
 
 /**
- * @brief Recursively iterates groups and checks if any circle found has
+ * @brief Iterates groups and every group nested in them and checks if any circle found has
  * the given area
  * 
- * @param group group to recusively search
+ * @param group group to search
  * @param found number of matches found
  * @param area area to check for
  */
 void searchGroupsForCircleArea(List *group, int *found, float area) {
     if(group == NULL || area < 0) return;
 
-    Node *cur = group->head;
-
-    while (cur) {
-        Group *g = (Group*)cur->data;
-        if(g->circles->length > 0) {
-            Node *curCircle = g->circles->head;
-
-            // Loop until no circles in list
-            while(curCircle) {
-                Circle *circle = (Circle*)curCircle->data;
-                float circleArea = M_PI * circle->r * circle->r;
-                if(ceil(circleArea) == ceil(area)) *found+=1;
-                curCircle = curCircle->next;
-            }
-        }
-        // Recursive call to search groups inside of the current group
-        searchGroupsForCircleArea(g->groups, found, area);
-        cur = cur->next;
-    }
+    SVGVisitor visitor = { VISIT_CIRCLES, 0, &circleHasArea, &area, &countElement, found };
+    visitGroups(group, &visitor, 1);
 }
 
 /**
- * @brief Recursively iterates groups and checks if any path found has
+ * @brief Iterates groups and every group nested in them and checks if any path found has
  * the given data
  * 
- * @param group group to recusively search
+ * @param group group to search
  * @param found number of matches found
  * @param data data to check for
  */
 void searchGroupsForPathData(List *group, int *found, const char *data) {
     if(group == NULL || data == NULL) return;
 
-    Node *cur = group->head;
-
-    while(cur) {
-        Group *g = (Group*)cur->data;
-        if(g->paths->length > 0) {
-            Node *curPath = g->paths->head;
-
-            // Loop until no paths in list
-            while(curPath) {
-                Path *p = (Path*)curPath->data;
-                if(strcmp(p->data, data) == 0) *found+=1;
-                curPath = curPath->next;
-            }
-        }
-        // Recursive call to search groups inside of the current group
-        searchGroupsForPathData(g->groups, found, data);
-        cur = cur->next;
-    }
+    SVGVisitor visitor = { VISIT_PATHS, 0, &pathHasData, data, &countElement, found };
+    visitGroups(group, &visitor, 1);
 }
 
 /**
- * @brief Recursively iterates groups and checks if any group found has
+ * @brief Iterates groups and every group nested in them and checks if any group found has
  * the given length
  * 
- * @param group group to recusively search
+ * @param group group to search
  * @param found number of matches found
  * @param len length to check for
  */
 void searchGroupsForGroupLen(List *group, int *found, int len) {
     if(group == NULL) return;
 
-    Node *cur = group->head;
-    
-    // Loop until no groups in list
-    while(cur) {
-        Group *g = (Group*)cur->data;
-        int groupLen = g->rectangles->length + g->circles->length + g->paths->length + g->groups->length;
-        if(groupLen == len) *found+=1;
+    SVGVisitor visitor = { VISIT_GROUPS, 0, &groupHasLength, &len, &countElement, found };
+    visitGroups(group, &visitor, 1);
+}
 
-        // Recursive call to search groups inside of the current group
-        searchGroupsForGroupLen(g->groups, found, len);
-        cur = cur->next;
-    }
+/**
+ * @brief visitor that adds the number of other attributes of an element to the int passed as its context
+ * 
+ * @param element 
+ * @param found 
+ */
+void countOtherAttributes(const VisitedElement *element, void *found) {
+    *(int*)found += otherAttributesOf(element)->length;
 }
 
 /**
- * @brief Recrusive function that finds the number of other attributes in groups
+ * @brief finds the number of other attributes in groups, every group nested in them, and their shapes
  * 
- * @param group group to recursively search
+ * @param group group to search
  * @param found number of matches found
  */
 void searchGroupsForAttributes(List *group, int *found) {
     if(group == NULL) return;
 
-    Node *cur = group->head;
-
-    while(cur) {
-        Group *g = (Group*)cur->data;
-        
-        // Get otherAttributes from groups
-        *found += g->otherAttributes->length;
-
-        // Get num attributes from g->rectangles
-        Node *curRect = g->rectangles->head;
-        while(curRect) {
-            Rectangle *rect = (Rectangle*)curRect->data;
-            *found += rect->otherAttributes->length;
-            curRect = curRect->next;
-        }
-
-        // Get num attributes from g->circles
-        Node *curCircle = g->circles->head;
-        while(curCircle) {
-            Circle *circle = (Circle*)curCircle->data;
-            *found += circle->otherAttributes->length;
-            curCircle = curCircle->next;
-        }
-        
-        // Get num attributes from g->paths
-        Node *curPath = g->paths->head;
-        while(curPath) {
-            Path *p = (Path*)curPath->data;
-            *found += p->otherAttributes->length;
-            curPath = curPath->next;
-        }
-
-        if(g->groups->length > 0)
-            // Recursive call to search groups inside of the current group
-            searchGroupsForAttributes(g->groups, found);
-        cur = cur->next;
-    }
+    SVGVisitor visitor = { VISIT_ALL, 0, NULL, NULL, &countOtherAttributes, found };
+    visitGroups(group, &visitor, 1);
 }
 
 /**
@@ -712,6 +611,7 @@ xmlDoc* SVGtoDOC(const SVG *svg) {
     
     xmlDoc* doc = NULL;
     xmlNodePtr root_node = NULL;
+    PhaseTimer start = startPhase();
 
     doc = xmlNewDoc(BAD_CAST "1.0");
 
@@ -722,7 +622,6 @@ xmlDoc* SVGtoDOC(const SVG *svg) {
 
     if(nsPtr == NULL) {
         xmlFreeDoc(doc);
-        xmlCleanupParser();
         return NULL;
     }
 
@@ -757,6 +656,7 @@ xmlDoc* SVGtoDOC(const SVG *svg) {
     if(svg->groups->length > 0)
         addGroupsToParent(root_node, svg->groups);
     
+    endPhase(STAT_DOM, &start, 0, svg->numElements);
     return doc;
 }
 
@@ -774,14 +674,12 @@ void addRectanglesToParent(xmlNodePtr node, List *rectangles) {
         Rectangle* rect = (Rectangle*)cur->data;
         xmlNodePtr rectNode = xmlNewChild(node, NULL, BAD_CAST "rect", NULL);
 
-        char x[500], y[500], width[500], height[500];
-        char *units = malloc(sizeof(char) * (strlen(rect->units) + 1));
-        strcpy(units, rect->units);
+        char x[FLOAT_STRING_SIZE + 8], y[FLOAT_STRING_SIZE + 8], width[FLOAT_STRING_SIZE + 8], height[FLOAT_STRING_SIZE + 8];
 
-        sprintf(x, "%f%s", rect->x, units);
-        sprintf(y, "%f%s", rect->y, units);
-        sprintf(width, "%f%s", rect->width, units);
-        sprintf(height, "%f%s", rect->height, units);
+        strcpy(x + formatFloat(rect->x, x), lengthUnitName(rect->units));
+        strcpy(y + formatFloat(rect->y, y), lengthUnitName(rect->units));
+        strcpy(width + formatFloat(rect->width, width), lengthUnitName(rect->units));
+        strcpy(height + formatFloat(rect->height, height), lengthUnitName(rect->units));
 
         xmlNewProp(rectNode, BAD_CAST "x", BAD_CAST x);
         xmlNewProp(rectNode, BAD_CAST "y", BAD_CAST y);
@@ -789,7 +687,6 @@ void addRectanglesToParent(xmlNodePtr node, List *rectangles) {
         xmlNewProp(rectNode, BAD_CAST "height", BAD_CAST height);
 
         addOtherAttributesToNode(rectNode, rect->otherAttributes);
-        free(units);
         cur = cur->next;
     }
 }
@@ -808,20 +705,17 @@ void addCirclesToParent(xmlNodePtr node, List *circles) {
         Circle* circle = (Circle*)cur->data;
         xmlNodePtr circleNode = xmlNewChild(node, NULL, BAD_CAST "circle", NULL);
 
-        char cx[500], cy[500], radius[500];
-        char *units = malloc(sizeof(char) * (strlen(circle->units) + 1));
-        strcpy(units, circle->units);
+        char cx[FLOAT_STRING_SIZE + 8], cy[FLOAT_STRING_SIZE + 8], radius[FLOAT_STRING_SIZE + 8];
 
-        sprintf(cx, "%f%s", circle->cx, units);
-        sprintf(cy, "%f%s", circle->cy, units);
-        sprintf(radius, "%f%s", circle->r, units);
+        strcpy(cx + formatFloat(circle->cx, cx), lengthUnitName(circle->units));
+        strcpy(cy + formatFloat(circle->cy, cy), lengthUnitName(circle->units));
+        strcpy(radius + formatFloat(circle->r, radius), lengthUnitName(circle->units));
 
         xmlNewProp(circleNode, BAD_CAST "cx", BAD_CAST cx);
         xmlNewProp(circleNode, BAD_CAST "cy", BAD_CAST cy);
         xmlNewProp(circleNode, BAD_CAST "r", BAD_CAST radius);
 
         addOtherAttributesToNode(circleNode, circle->otherAttributes);
-        free(units);
         cur = cur->next;
     }
 }
@@ -855,11 +749,19 @@ void addPathsToParent(xmlNodePtr node, List *paths) {
 void addGroupsToParent(xmlNodePtr node, List *groups) {
     if(node == NULL || groups == NULL) return;
 
-    Node *cur = groups->head;
+    GroupWalk walk;
+    beginGroupWalk(&walk, groups);
 
-    while(cur) {
-        Group *g = (Group*)cur->data;
-        xmlNodePtr gNode = xmlNewChild(node, NULL, BAD_CAST "g", NULL);
+    // Node of the group added last, and its nesting level.  A group is added to the node of the group
+    // enclosing it, found by climbing from the last one
+    xmlNodePtr parent = node;
+    int parentDepth = 0;
+
+    for(Group *g = nextGroup(&walk); g; g = nextGroup(&walk)) {
+        for(; parentDepth >= walk.depth; parentDepth--)
+            parent = parent->parent;
+
+        xmlNodePtr gNode = xmlNewChild(parent, NULL, BAD_CAST "g", NULL);
 
         addOtherAttributesToNode(gNode, g->otherAttributes);
 
@@ -872,11 +774,10 @@ void addGroupsToParent(xmlNodePtr node, List *groups) {
         if(g->paths->length > 0)
             addPathsToParent(gNode, g->paths);
 
-        if(g->groups->length > 0)
-            addGroupsToParent(gNode, g->groups);
-
-        cur = cur->next;
+        parent = gNode;
+        parentDepth = walk.depth;
     }
+    endGroupWalk(&walk);
 }
 
 /**
@@ -934,7 +835,7 @@ bool isValidRectangles(List *rectangles) {
     while(cur) {
         Rectangle *rect = (Rectangle*)cur->data;
     
-        if(strcasecmp(rect->units, "invalid") == 0)
+        if(rect->units == UNIT_INVALID)
             return false;
         
         if(rect->height < 0 || rect->width < 0)
@@ -965,7 +866,7 @@ bool isValidCircles(List *circles) {
     while(cur) {
         Circle *c = (Circle*)cur->data;
     
-        if(strcasecmp(c->units, "invalid") == 0)
+        if(c->units == UNIT_INVALID)
             return false;
         
         if(c->r < 0)
@@ -1021,21 +922,60 @@ bool isValidPaths(List *paths) {
  */
 bool isValidGroups(List *groups) {
     if(groups == NULL) return false;
-    Node *cur = groups->head;
 
-    while(cur) {
-        Group *g = (Group*)cur->data;
+    GroupWalk walk;
+    beginGroupWalk(&walk, groups);
+    bool valid = true;
+    Group *g;
 
+    while(valid && (g = nextGroup(&walk)) != NULL) {
         if(!isValidAttributes(g->otherAttributes))
-            return false;
-
-        if(!isValidRectangles(g->rectangles) || !isValidCircles(g->circles) || !isValidPaths(g->paths) || !isValidGroups(g->groups))
-            return false;
+            valid = false;
 
-        cur = cur->next;
+        // The nested groups are checked by the walk, which cannot move into a missing list
+        if(!isValidRectangles(g->rectangles) || !isValidCircles(g->circles) || !isValidPaths(g->paths) || g->groups == NULL)
+            valid = false;
     }
 
-    return true;
+    valid = valid && !walk.failed;
+    endGroupWalk(&walk);
+    return valid;
+}
+
+/**
+ * @brief reads and compiles an xsd file.  The compiled schema is only read by validation, so one schema may be
+ * shared by validations running on several threads
+ * 
+ * @param schemaFile 
+ * @return xmlSchemaPtr NULL if the file cannot be read or is not a valid schema
+ */
+xmlSchemaPtr compileSchema(const char *schemaFile) {
+    PhaseTimer start = startPhase();
+    xmlSchemaParserCtxtPtr ctxt = xmlSchemaNewParserCtxt(schemaFile);
+    xmlSchemaPtr schema = xmlSchemaParse(ctxt);
+    xmlSchemaFreeParserCtxt(ctxt);
+    endPhase(STAT_SCHEMA_COMPILE, &start, 0, 0);
+
+    return schema;
+}
+
+/**
+ * @brief validates a xmlDoc (tree) against a compiled schema
+ * 
+ * @param doc 
+ * @param schema 
+ * @return int 0 if the document is valid
+ */
+int validateWithSchema(xmlDoc *doc, xmlSchemaPtr schema) {
+    PhaseTimer start = startPhase();
+    xmlSchemaValidCtxtPtr ctxtPtr = xmlSchemaNewValidCtxt(schema);
+
+    int ret = xmlSchemaValidateDoc(ctxtPtr, doc);
+
+    xmlSchemaFreeValidCtxt(ctxtPtr);
+    endPhase(STAT_VALIDATE, &start, 0, 0);
+
+    return ret;
 }
 
 /**
@@ -1052,21 +992,12 @@ int validateAgainstXSD(xmlDoc *doc, const char *schemaFile) {
         return 1;
 
     // Read schemaFile
-    xmlSchemaPtr schema = NULL;
-    xmlSchemaParserCtxtPtr ctxt;
-    ctxt = xmlSchemaNewParserCtxt(schemaFile);
-    schema = xmlSchemaParse(ctxt);
-    xmlSchemaFreeParserCtxt(ctxt);
-
-    xmlSchemaValidCtxtPtr ctxtPtr;
-    int ret;
-    ctxtPtr = xmlSchemaNewValidCtxt(schema);
-
-    ret = xmlSchemaValidateDoc(ctxtPtr, doc);
+    xmlSchemaPtr schema = compileSchema(schemaFile);
+    int ret = validateWithSchema(doc, schema);
 
-    xmlSchemaFreeValidCtxt(ctxtPtr);
+    // libxml2's global state, such as the built in schema types, is left for the life of the process, since
+    // freeing it is not safe while corpus queries use the library on other threads
     if(schema != NULL) xmlSchemaFree(schema);
-    xmlSchemaCleanupTypes();
 
     return ret;
 }
@@ -1085,7 +1016,7 @@ bool updateAttribute(Attribute *attr, List *otherAttributes) {
 
     while(cur) {        
         if(strcmp(((Attribute*)cur->data)->name, attr->name) == 0) {
-            cur->data = realloc(cur->data, sizeof(Attribute) + (strlen(attr->value) + 1) * sizeof(char));
+            cur->data = svgRealloc(cur->data, sizeof(Attribute) + (strlen(attr->value) + 1) * sizeof(char));
             strcpy(((Attribute*)cur->data)->value, attr->value);
             return true;
         }
@@ -1094,6 +1025,139 @@ bool updateAttribute(Attribute *attr, List *otherAttributes) {
     return false;
 }
 
+/**
+ * @brief sets cx, cy, r or another attribute of a circle. On success the
+ * attribute is either owned by the circle or freed
+ *
+ * @param img svg struct whose totals are updated, may be NULL
+ * @param circle
+ * @param newAttribute
+ * @return true
+ * @return false
+ */
+bool setCircleAttribute(SVG *img, Circle *circle, Attribute *newAttribute) {
+    if(circle == NULL || newAttribute == NULL) return false;
+
+    double oldArea = circleAreaKey(circle);
+    lengthUnit unit;
+    float length;
+
+    if(strcmp(newAttribute->name, "cx") == 0) {
+        if(!parseLength(newAttribute->value, &length, &unit)) return false;
+        circle->cx = length;
+    } else if(strcmp(newAttribute->name, "cy") == 0) {
+        if(!parseLength(newAttribute->value, &length, &unit)) return false;
+        circle->cy = length;
+    } else if(strcmp(newAttribute->name, "r") == 0) {
+        if(!parseLength(newAttribute->value, &length, &unit)) return false;
+        circle->r = length;
+        if(img != NULL) replaceAreaKey(img->circleAreas, oldArea, circleAreaKey(circle));
+    } else if(!updateAttribute(newAttribute, circle->otherAttributes)) {
+        insertBack(circle->otherAttributes, newAttribute);
+        if(img != NULL) img->totals.attributes++;
+        return true;
+    }
+
+    deleteAttribute(newAttribute);
+    return true;
+}
+
+/**
+ * @brief sets x, y, width, height or another attribute of a rectangle. On success the
+ * attribute is either owned by the rectangle or freed
+ *
+ * @param img svg struct whose totals are updated, may be NULL
+ * @param rect
+ * @param newAttribute
+ * @return true
+ * @return false
+ */
+bool setRectAttribute(SVG *img, Rectangle *rect, Attribute *newAttribute) {
+    if(rect == NULL || newAttribute == NULL) return false;
+
+    double oldArea = rectAreaKey(rect);
+    lengthUnit unit;
+    float length;
+
+    if(strcmp(newAttribute->name, "x") == 0) {
+        if(!parseLength(newAttribute->value, &length, &unit)) return false;
+        rect->x = length;
+    } else if(strcmp(newAttribute->name, "y") == 0) {
+        if(!parseLength(newAttribute->value, &length, &unit)) return false;
+        rect->y = length;
+    } else if(strcmp(newAttribute->name, "width") == 0) {
+        if(!parseLength(newAttribute->value, &length, &unit)) return false;
+        rect->width = length;
+        if(img != NULL) replaceAreaKey(img->rectAreas, oldArea, rectAreaKey(rect));
+    } else if(strcmp(newAttribute->name, "height") == 0) {
+        if(!parseLength(newAttribute->value, &length, &unit)) return false;
+        rect->height = length;
+        if(img != NULL) replaceAreaKey(img->rectAreas, oldArea, rectAreaKey(rect));
+    } else if(!updateAttribute(newAttribute, rect->otherAttributes)) {
+        insertBack(rect->otherAttributes, newAttribute);
+        if(img != NULL) img->totals.attributes++;
+        return true;
+    }
+
+    deleteAttribute(newAttribute);
+    return true;
+}
+
+/**
+ * @brief sets the data or another attribute of the path held by pathNode.
+ * Changing the data reallocates the path in place, so the node is passed instead of the path
+ *
+ * @param img svg struct whose totals are updated, may be NULL
+ * @param pathNode list node holding the path
+ * @param newAttribute
+ * @return true
+ * @return false
+ */
+bool setPathAttribute(SVG *img, Node *pathNode, Attribute *newAttribute) {
+    if(pathNode == NULL || pathNode->data == NULL || newAttribute == NULL) return false;
+
+    if(strcmp(newAttribute->name, "d") == 0) {
+        size_t oldLen = strlen(((Path*)pathNode->data)->data);
+        size_t newLen = strlen(newAttribute->value);
+
+        Path *p = svgRealloc(pathNode->data, sizeof(Path) + (newLen + 1) * sizeof(char));
+        if(p == NULL) return false;
+
+        strcpy(p->data, newAttribute->value);
+        pathNode->data = p;
+        if(img != NULL) img->totals.pathBytes += newLen - oldLen;
+    } else if(!updateAttribute(newAttribute, ((Path*)pathNode->data)->otherAttributes)) {
+        insertBack(((Path*)pathNode->data)->otherAttributes, newAttribute);
+        if(img != NULL) img->totals.attributes++;
+        return true;
+    }
+
+    deleteAttribute(newAttribute);
+    return true;
+}
+
+/**
+ * @brief sets an attribute of a group
+ *
+ * @param img svg struct whose totals are updated, may be NULL
+ * @param group
+ * @param newAttribute
+ * @return true
+ * @return false
+ */
+bool setGroupAttribute(SVG *img, Group *group, Attribute *newAttribute) {
+    if(group == NULL || newAttribute == NULL) return false;
+
+    if(!updateAttribute(newAttribute, group->otherAttributes)) {
+        insertBack(group->otherAttributes, newAttribute);
+        if(img != NULL) img->totals.attributes++;
+        return true;
+    }
+
+    deleteAttribute(newAttribute);
+    return true;
+}
+
 /**
  * @brief Get the Cirle At Pos
  * 
@@ -1182,74 +1246,6 @@ Group* getGroupAtPos(List *groups, int pos) {
     return NULL;
 }
 
-/**
- * @brief extract value out of JSON string
- * 
- * @param key 
- * @param string 
- * @return char* 
- */
-char *extractValue(char *key, const char *string) {
-    if(key == NULL) return NULL;
-
-    char *str = strstr(string, key);
-    if(str == NULL) return NULL;
-
-    char *str2 = strstr(str, ":");
-    if(str2 == NULL) return NULL;
-
-    char *str3 = strstr(str2, "\"");
-    if(str3 == NULL) return NULL;
-
-    int len = 2;
-    char *value = malloc(sizeof(char) * len);
-    
-    for(int i = 1; i < strlen(str3); i++) {
-        if(str3[i] == '\"' && (str3[i+1] == ',' || str3[i+1] == '}'))
-            break;
-        value[i-1] = str3[i];
-        len++;
-        value = realloc(value, sizeof(char) * (len));
-    }
-
-    value[len-2] = '\0';
-
-    return value;
-}
-
-/**
- * @brief extract integer value out of JSON string 
- * 
- * @param key 
- * @param string 
- * @return char* 
- */
-char *extractIntValue(char *key, const char *string) {
-    if(key == NULL) return NULL;
-
-    char *str = strstr(string, key);
-    if(str == NULL) return NULL;
-
-    char *str2 = strstr(str, ":");
-    if(str2 == NULL) return NULL;
-
-    int len = 2;
-    char *value = malloc(sizeof(char) * len);
-    
-    for(int i = 1; i < strlen(str2); i++) {
-        if(str2[i] == ',' && (str2[i+1] == '\"' || str2[i+1] == '}'))
-            break;
-        value[i-1] = str2[i];
-        len++;
-        value = realloc(value, sizeof(char) * (len));
-    }
-
-    value[len-2] = '\0';
-    value++;
-    value[strlen(value)-1] = 0;
-
-    return value;
-}
 
 
 
@@ -0,0 +1,708 @@
+/**
+ * @file SVGIndex.c
+ * @author Anthony Vidovic (1130891)
+ * @brief Element table and lookup functions for svg parser library
+ * @version 0.1
+ * @date 2022-04-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+// ~~~~~ Includes ~~~~~ //
+#include "SVGHelper.h"
+#include <limits.h>
+
+/**
+ * @brief sets the element table and cached views of a new svg struct to empty
+ *
+ * @param svg
+ */
+void initSVGCaches(SVG *svg) {
+    if(svg == NULL) return;
+
+    initElementTable(svg);
+    memset(&svg->totals, 0, sizeof(SVGTotals));
+    svg->rectView = NULL;
+    svg->circleView = NULL;
+    svg->pathView = NULL;
+    svg->groupView = NULL;
+    svg->rectAreas = NULL;
+    svg->circleAreas = NULL;
+    svg->spatialIndex = NULL;
+    svg->bounds = NULL;
+}
+
+/**
+ * @brief frees the element table and cached views of an svg struct
+ *
+ * @param svg
+ */
+void freeSVGCaches(SVG *svg) {
+    if(svg == NULL) return;
+
+    invalidateViews(svg);
+    invalidateAreaIndexes(svg);
+    invalidateSpatialIndex(svg);
+    invalidateBounds(svg);
+    svgFree(svg->elements);
+    initElementTable(svg);
+}
+
+/**
+ * @brief discards the cached flattened views, they are rebuilt on next use.
+ * Must be called whenever elements are added or reallocated
+ *
+ * @param svg
+ */
+void invalidateViews(SVG *svg) {
+    if(svg == NULL) return;
+
+    freeList(svg->rectView);
+    freeList(svg->circleView);
+    freeList(svg->pathView);
+    freeList(svg->groupView);
+
+    svg->rectView = NULL;
+    svg->circleView = NULL;
+    svg->pathView = NULL;
+    svg->groupView = NULL;
+}
+
+/**
+ * @brief discards the caches that do not track edits, must be called before any element
+ * of the struct is added, resized or reallocated
+ *
+ * @param svg
+ */
+void markSVGModified(SVG *svg) {
+    if(svg == NULL) return;
+
+    invalidateViews(svg);
+    invalidateSpatialIndex(svg);
+    invalidateBounds(svg);
+}
+
+/**
+ * @brief sets the element table of a new svg struct to empty
+ *
+ * @param svg
+ */
+void initElementTable(SVG *svg) {
+    if(svg == NULL) return;
+
+    svg->elements = NULL;
+    svg->numElements = 0;
+    svg->elementsCapacity = 0;
+}
+
+/**
+ * @brief makes room in the element table for more elements, so that registering them cannot fail
+ *
+ * @param svg
+ * @param count number of elements about to be registered
+ * @return true
+ * @return false if the table cannot grow, leaving it as it was
+ */
+bool reserveElements(SVG *svg, int count) {
+    if(svg == NULL || count < 0 || count > INT_MAX - svg->numElements) return false;
+    if(svg->numElements + count <= svg->elementsCapacity) return true;
+
+    // Grow table by doubling so appends stay amortized constant time
+    int capacity = svg->elementsCapacity > 0 ? svg->elementsCapacity : 16;
+    while(capacity < svg->numElements + count) capacity = capacity > INT_MAX / 2 ? INT_MAX : capacity * 2;
+
+    ElementRef *elements = svgRealloc(svg->elements, sizeof(ElementRef) * capacity);
+    if(elements == NULL) return false;
+
+    svg->elements = elements;
+    svg->elementsCapacity = capacity;
+    return true;
+}
+
+/**
+ * @brief appends the element held by node to the element table,
+ * its ID is its position in the table
+ *
+ * @param svg
+ * @param type type of the element held by node
+ * @param node list node holding the element
+ * @return true
+ * @return false
+ */
+bool registerElement(SVG *svg, elementType type, Node *node) {
+    if(svg == NULL || node == NULL || !reserveElements(svg, 1)) return false;
+
+    svg->elements[svg->numElements].type = type;
+    svg->elements[svg->numElements].node = node;
+    svg->numElements++;
+
+    return true;
+}
+
+/**
+ * @brief adds every node of a list to the element table
+ *
+ * @param svg
+ * @param type type of the elements in the list
+ * @param list
+ * @return true
+ * @return false if the table cannot grow, some of the list may have been added
+ */
+static bool registerList(SVG *svg, elementType type, List *list) {
+    Node *cur = list->head;
+
+    while(cur) {
+        if(!registerElement(svg, type, cur)) return false;
+        cur = cur->next;
+    }
+    return true;
+}
+
+/**
+ * @brief adds every group in the list to the element table, each followed by its shapes and then
+ * by the groups nested in it
+ *
+ * @param svg
+ * @param groups
+ * @return true
+ * @return false if the table or the walk cannot grow, some of the groups may have been added
+ */
+static bool registerGroups(SVG *svg, List *groups) {
+    GroupWalk walk;
+    beginGroupWalk(&walk, groups);
+    bool registered = true;
+
+    for(Group *g = nextGroup(&walk); g && registered; g = nextGroup(&walk)) {
+        registered = registerElement(svg, GROUP, walk.current) && registerList(svg, RECT, g->rectangles) &&
+                     registerList(svg, CIRC, g->circles) && registerList(svg, PATH, g->paths);
+    }
+
+    registered = registered && !walk.failed;
+    endGroupWalk(&walk);
+    return registered;
+}
+
+/**
+ * @brief counts the elements of an svg struct from the lengths of its lists, without visiting the shapes
+ *
+ * @param svg
+ * @return long long number of rectangles, circles, paths and groups, -1 if the walk cannot grow
+ */
+static long long countElements(const SVG *svg) {
+    long long count = (long long)svg->rectangles->length + svg->circles->length + svg->paths->length;
+
+    GroupWalk walk;
+    beginGroupWalk(&walk, svg->groups);
+    for(Group *g = nextGroup(&walk); g; g = nextGroup(&walk))
+        count += 1LL + g->rectangles->length + g->circles->length + g->paths->length;
+
+    if(walk.failed) count = -1;
+    endGroupWalk(&walk);
+    return count;
+}
+
+/**
+ * @brief adds the contents of a group to the element table,
+ * the group itself must already be registered
+ *
+ * @param svg
+ * @param g
+ * @return true
+ * @return false if the table cannot grow, some of the contents may have been added
+ */
+bool addGroupToElementTable(SVG *svg, Group *g) {
+    if(svg == NULL || g == NULL) return false;
+
+    return registerList(svg, RECT, g->rectangles) && registerList(svg, CIRC, g->circles) &&
+           registerList(svg, PATH, g->paths) && registerGroups(svg, g->groups);
+}
+
+/**
+ * @brief assigns an ID to every element in the svg struct. IDs follow document
+ * order: top level rectangles, circles and paths, then each group followed by its contents.
+ * The table is allocated once, at its full size
+ *
+ * @param svg
+ * @return true
+ * @return false if the table cannot be allocated, it is left empty
+ */
+bool buildElementTable(SVG *svg) {
+    if(svg == NULL) return false;
+
+    svgFree(svg->elements);
+    initElementTable(svg);
+
+    long long count = countElements(svg);
+    bool built = count >= 0 && count <= INT_MAX && reserveElements(svg, (int)count) &&
+                 registerList(svg, RECT, svg->rectangles) && registerList(svg, CIRC, svg->circles) &&
+                 registerList(svg, PATH, svg->paths) && registerGroups(svg, svg->groups);
+
+    if(!built) {
+        svgFree(svg->elements);
+        initElementTable(svg);
+    }
+    return built;
+}
+
+/**
+ * @brief returns the element with the given ID
+ *
+ * @param img
+ * @param elemID
+ * @param elemType set to the type of the element found, may be NULL
+ * @return void*
+ */
+void* getElementByID(const SVG* img, int elemID, elementType* elemType) {
+    if(img == NULL || elemID < 0 || elemID >= img->numElements) return NULL;
+
+    ElementRef *ref = &img->elements[elemID];
+    if(elemType != NULL) *elemType = ref->type;
+
+    return ref->node->data;
+}
+
+/**
+ * @brief function that updates or sets a new attribute on the element with the given ID
+ *
+ * @param img
+ * @param elemID
+ * @param newAttribute
+ * @return true
+ * @return false
+ */
+bool setAttributeByID(SVG* img, int elemID, Attribute* newAttribute) {
+    if(img == NULL || newAttribute == NULL || newAttribute->name == NULL)
+        return false;
+
+    if(elemID < 0 || elemID >= img->numElements)
+        return false;
+
+    ElementRef *ref = &img->elements[elemID];
+
+    markSVGModified(img);
+
+    switch (ref->type)
+    {
+    case CIRC:
+        return setCircleAttribute(img, (Circle*)ref->node->data, newAttribute);
+    case RECT:
+        return setRectAttribute(img, (Rectangle*)ref->node->data, newAttribute);
+    case PATH:
+        return setPathAttribute(img, ref->node, newAttribute);
+    case GROUP:
+        return setGroupAttribute(img, (Group*)ref->node->data, newAttribute);
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Returns the cached list of all rectangles in SVG struct, building it if needed
+ *
+ * @param img
+ * @return const List*
+ */
+const List* getRectView(const SVG* img) {
+    if(img == NULL) return NULL;
+
+    // The views are a cache, building one does not change the document
+    SVG *svg = (SVG*)img;
+
+    if(svg->rectView == NULL) {
+        svg->rectView = initializeList(&rectangleToString, &dummyDelete, &compareRectangles);
+
+        SVGVisitor visitor = { VISIT_RECTS, 0, NULL, NULL, &appendElement, svg->rectView };
+        visitSVG(img, &visitor, 1);
+    }
+
+    return svg->rectView;
+}
+
+/**
+ * @brief Returns the cached list of all circles in SVG struct, building it if needed
+ *
+ * @param img
+ * @return const List*
+ */
+const List* getCircleView(const SVG* img) {
+    if(img == NULL) return NULL;
+
+    SVG *svg = (SVG*)img;
+
+    if(svg->circleView == NULL) {
+        svg->circleView = initializeList(&circleToString, &dummyDelete, &compareCircles);
+
+        SVGVisitor visitor = { VISIT_CIRCLES, 0, NULL, NULL, &appendElement, svg->circleView };
+        visitSVG(img, &visitor, 1);
+    }
+
+    return svg->circleView;
+}
+
+/**
+ * @brief Returns the cached list of all paths in SVG struct, building it if needed
+ *
+ * @param img
+ * @return const List*
+ */
+const List* getPathView(const SVG* img) {
+    if(img == NULL) return NULL;
+
+    SVG *svg = (SVG*)img;
+
+    if(svg->pathView == NULL) {
+        svg->pathView = initializeList(&pathToString, &dummyDelete, &comparePaths);
+
+        SVGVisitor visitor = { VISIT_PATHS, 0, NULL, NULL, &appendElement, svg->pathView };
+        visitSVG(img, &visitor, 1);
+    }
+
+    return svg->pathView;
+}
+
+/**
+ * @brief Returns the cached list of all groups in SVG struct, building it if needed
+ *
+ * @param img
+ * @return const List*
+ */
+const List* getGroupView(const SVG* img) {
+    if(img == NULL) return NULL;
+
+    SVG *svg = (SVG*)img;
+
+    if(svg->groupView == NULL) {
+        svg->groupView = initializeList(&groupToString, &dummyDelete, &compareGroups);
+        findGroups(img->groups, svg->groupView);
+    }
+
+    return svg->groupView;
+}
+
+/**
+ * @brief visitor that adds an element to the SVGTotals passed as its context.  The shapes of a group are
+ * counted with the group, from the lengths of its lists
+ *
+ * @param element
+ * @param context
+ */
+static void addToTotals(const VisitedElement *element, void *context) {
+    SVGTotals *totals = (SVGTotals*)context;
+    totals->attributes += otherAttributesOf(element)->length;
+
+    if(element->type == PATH) {
+        totals->pathBytes += strlen(((Path*)element->data)->data);
+    } else if(element->type == GROUP) {
+        Group *g = (Group*)element->data;
+
+        if(element->depth > totals->maxGroupDepth)
+            totals->maxGroupDepth = element->depth;
+
+        totals->groups++;
+        totals->rects += g->rectangles->length;
+        totals->circles += g->circles->length;
+        totals->paths += g->paths->length;
+    }
+}
+
+/**
+ * @brief computes the totals of an svg struct with a full walk
+ *
+ * @param svg
+ * @param totals set to the totals of svg
+ */
+void computeSVGTotals(const SVG *svg, SVGTotals *totals) {
+    if(totals == NULL) return;
+    memset(totals, 0, sizeof(SVGTotals));
+    if(svg == NULL) return;
+
+    totals->rects = svg->rectangles->length;
+    totals->circles = svg->circles->length;
+    totals->paths = svg->paths->length;
+    totals->attributes = svg->otherAttributes->length;
+
+    SVGVisitor visitor = { VISIT_ALL, 0, NULL, NULL, &addToTotals, totals };
+    visitSVG(svg, &visitor, 1);
+}
+
+/**
+ * @brief checks the running totals of an svg struct against a full walk
+ *
+ * @param svg
+ * @return true if the totals match
+ * @return false
+ */
+bool checkSVGTotals(const SVG *svg) {
+    if(svg == NULL) return true;
+
+    SVGTotals walked;
+    computeSVGTotals(svg, &walked);
+
+    const SVGTotals *t = &svg->totals;
+    return t->rects == walked.rects && t->circles == walked.circles && t->paths == walked.paths
+        && t->groups == walked.groups && t->attributes == walked.attributes
+        && t->maxGroupDepth == walked.maxGroupDepth && t->pathBytes == walked.pathBytes;
+}
+
+/**
+ * @brief Returns the running totals of an svg struct
+ *
+ * @param img
+ * @return SVGTotals
+ */
+SVGTotals getSVGTotals(const SVG* img) {
+    SVGTotals totals;
+
+    if(img == NULL) {
+        memset(&totals, 0, sizeof(SVGTotals));
+        return totals;
+    }
+
+#ifdef SVG_CHECK_TOTALS
+    if(!checkSVGTotals(img)) {
+        fprintf(stderr, "SVG_CHECK_TOTALS: running totals do not match a full walk of the struct\n");
+        abort();
+    }
+#endif
+
+    return img->totals;
+}
+
+/**
+ * @brief returns the key a rectangle is stored under in an area index,
+ * rounded up the same way as numRectsWithArea
+ *
+ * @param rect
+ * @return double
+ */
+double rectAreaKey(const Rectangle *rect) {
+    float rectArea = rect->width * rect->height;
+    return ceil(rectArea);
+}
+
+/**
+ * @brief returns the key a circle is stored under in an area index,
+ * rounded up the same way as numCirclesWithArea
+ *
+ * @param circle
+ * @return double
+ */
+double circleAreaKey(const Circle *circle) {
+    float circleArea = M_PI * circle->r * circle->r;
+    return ceil(circleArea);
+}
+
+/**
+ * @brief compares two area keys for qsort
+ *
+ * @param first
+ * @param second
+ * @return int
+ */
+static int compareAreaKeys(const void *first, const void *second) {
+    double a = *(const double*)first;
+    double b = *(const double*)second;
+
+    return (a > b) - (a < b);
+}
+
+/**
+ * @brief returns the position of the first key in the index that is >= key
+ *
+ * @param index
+ * @param key
+ * @return int
+ */
+static int lowerBound(const AreaIndex *index, double key) {
+    int low = 0, high = index->length;
+
+    while(low < high) {
+        int mid = low + (high - low) / 2;
+        if(index->areas[mid] < key) low = mid + 1;
+        else high = mid;
+    }
+    return low;
+}
+
+/**
+ * @brief returns the position of the first key in the index that is > key
+ *
+ * @param index
+ * @param key
+ * @return int
+ */
+static int upperBound(const AreaIndex *index, double key) {
+    int low = 0, high = index->length;
+
+    while(low < high) {
+        int mid = low + (high - low) / 2;
+        if(index->areas[mid] <= key) low = mid + 1;
+        else high = mid;
+    }
+    return low;
+}
+
+/**
+ * @brief allocates an area index holding room for capacity keys
+ *
+ * @param capacity
+ * @return AreaIndex*
+ */
+static AreaIndex* newAreaIndex(int capacity) {
+    AreaIndex *index = svgMalloc(sizeof(AreaIndex));
+    if(index == NULL) return NULL;
+
+    index->length = 0;
+    index->capacity = capacity > 0 ? capacity : 16;
+    index->areas = svgMalloc(sizeof(double) * index->capacity);
+
+    if(index->areas == NULL) {
+        svgFree(index);
+        return NULL;
+    }
+    return index;
+}
+
+/**
+ * @brief frees an area index
+ *
+ * @param index
+ */
+void freeAreaIndex(AreaIndex *index) {
+    if(index == NULL) return;
+
+    svgFree(index->areas);
+    svgFree(index);
+}
+
+/**
+ * @brief discards the area indexes of an svg struct, they are rebuilt by the next area query.
+ * Must be called when shapes are resized without going through setAttribute
+ *
+ * @param svg
+ */
+void invalidateAreaIndexes(SVG *svg) {
+    if(svg == NULL) return;
+
+    freeAreaIndex(svg->rectAreas);
+    freeAreaIndex(svg->circleAreas);
+    svg->rectAreas = NULL;
+    svg->circleAreas = NULL;
+}
+
+/**
+ * @brief inserts a key into an area index, keeping it sorted. NaN keys never match
+ * a query so they are not stored
+ *
+ * @param index
+ * @param key
+ */
+void insertAreaKey(AreaIndex *index, double key) {
+    if(index == NULL || isnan(key)) return;
+
+    if(index->length == index->capacity) {
+        double *areas = svgRealloc(index->areas, sizeof(double) * index->capacity * 2);
+        if(areas == NULL) return;
+
+        index->areas = areas;
+        index->capacity *= 2;
+    }
+
+    int pos = upperBound(index, key);
+    memmove(&index->areas[pos + 1], &index->areas[pos], sizeof(double) * (index->length - pos));
+    index->areas[pos] = key;
+    index->length++;
+}
+
+/**
+ * @brief replaces one occurrence of oldKey in an area index with newKey
+ *
+ * @param index
+ * @param oldKey key of the shape before it changed
+ * @param newKey key of the shape after it changed
+ */
+void replaceAreaKey(AreaIndex *index, double oldKey, double newKey) {
+    if(index == NULL || oldKey == newKey) return;
+
+    if(!isnan(oldKey)) {
+        int pos = lowerBound(index, oldKey);
+
+        if(pos < index->length && index->areas[pos] == oldKey) {
+            memmove(&index->areas[pos], &index->areas[pos + 1], sizeof(double) * (index->length - pos - 1));
+            index->length--;
+        }
+    }
+    insertAreaKey(index, newKey);
+}
+
+/**
+ * @brief counts the keys in an area index between minKey and maxKey, inclusive
+ *
+ * @param index
+ * @param minKey
+ * @param maxKey
+ * @return int
+ */
+int countAreaKeys(const AreaIndex *index, double minKey, double maxKey) {
+    if(index == NULL || minKey > maxKey) return 0;
+
+    return upperBound(index, maxKey) - lowerBound(index, minKey);
+}
+
+/**
+ * @brief returns the area index of all rectangles in the svg struct, building it if needed
+ *
+ * @param svg
+ * @return AreaIndex*
+ */
+AreaIndex* getRectAreaIndex(const SVG *svg) {
+    if(svg == NULL) return NULL;
+
+    // The index is a cache, building it does not change the document
+    SVG *img = (SVG*)svg;
+
+    if(img->rectAreas == NULL) {
+        const List *rects = getRectView(svg);
+        AreaIndex *index = newAreaIndex(rects->length);
+        if(index == NULL) return NULL;
+
+        for(Node *cur = rects->head; cur; cur = cur->next) {
+            double key = rectAreaKey((Rectangle*)cur->data);
+            if(!isnan(key)) index->areas[index->length++] = key;
+        }
+
+        qsort(index->areas, index->length, sizeof(double), compareAreaKeys);
+        img->rectAreas = index;
+    }
+
+    return img->rectAreas;
+}
+
+/**
+ * @brief returns the area index of all circles in the svg struct, building it if needed
+ *
+ * @param svg
+ * @return AreaIndex*
+ */
+AreaIndex* getCircleAreaIndex(const SVG *svg) {
+    if(svg == NULL) return NULL;
+
+    SVG *img = (SVG*)svg;
+
+    if(img->circleAreas == NULL) {
+        const List *circles = getCircleView(svg);
+        AreaIndex *index = newAreaIndex(circles->length);
+        if(index == NULL) return NULL;
+
+        for(Node *cur = circles->head; cur; cur = cur->next) {
+            double key = circleAreaKey((Circle*)cur->data);
+            if(!isnan(key)) index->areas[index->length++] = key;
+        }
+
+        qsort(index->areas, index->length, sizeof(double), compareAreaKeys);
+        img->circleAreas = index;
+    }
+
+    return img->circleAreas;
+}
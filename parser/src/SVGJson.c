@@ -0,0 +1,591 @@
+/**
+ * @file SVGJson.c
+ * @author Anthony Vidovic (1130891)
+ * @brief Single pass JSON tokenizer used to read shapes and svg properties sent by the web app
+ * @version 0.1
+ * @date 2022-04-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+// ~~~~~ Includes ~~~~~ //
+#include "SVGHelper.h"
+
+// Initial size of the token array, enough for a single shape without reallocating
+#define JSON_INITIAL_TOKENS 16
+
+/**
+ * @brief appends a token, growing the token array if needed
+ *
+ * @param doc
+ * @param type
+ * @param start offset of the first character of the token
+ * @param parent index of the enclosing object or array, -1 for the root
+ * @return int index of the new token, -1 if out of memory
+ */
+static int addToken(JsonDocument *doc, jsonType type, int start, int parent) {
+    if(doc->numTokens == doc->capacity) {
+        int newCapacity = doc->capacity > 0 ? doc->capacity * 2 : JSON_INITIAL_TOKENS;
+        JsonToken *grown = svgRealloc(doc->tokens, sizeof(JsonToken) * newCapacity);
+        if(grown == NULL) return -1;
+
+        doc->tokens = grown;
+        doc->capacity = newCapacity;
+    }
+
+    JsonToken *token = &doc->tokens[doc->numTokens];
+    token->type = type;
+    token->start = start;
+    token->end = start;
+    token->size = 0;
+    token->parent = parent;
+    token->next = doc->numTokens + 1;
+
+    return doc->numTokens++;
+}
+
+/**
+ * @brief returns the number of hex digits at the start of a string, at most 4
+ *
+ * @param str
+ * @return int
+ */
+static int hexDigits(const char *str) {
+    int count = 0;
+    while(count < 4 && isxdigit((unsigned char)str[count])) count++;
+
+    return count;
+}
+
+/**
+ * @brief reads the value of 4 hex digits
+ *
+ * @param str
+ * @return unsigned long
+ */
+static unsigned long hexValue(const char *str) {
+    unsigned long value = 0;
+
+    for(int i = 0; i < 4; i++) {
+        char c = tolower((unsigned char)str[i]);
+        value = value * 16 + (isdigit((unsigned char)c) ? c - '0' : c - 'a' + 10);
+    }
+    return value;
+}
+
+/**
+ * @brief scans a string starting at its opening quote
+ *
+ * @param json
+ * @param pos offset of the opening quote
+ * @return int offset just past the closing quote, -1 if the string is malformed
+ */
+static int scanString(const char *json, int pos) {
+    for(pos++; json[pos] != '"'; pos++) {
+        unsigned char c = (unsigned char)json[pos];
+
+        if(c == '\0' || c < 0x20) return -1;
+        if(c != '\\') continue;
+
+        pos++;
+        if(json[pos] == 'u') {
+            if(hexDigits(json + pos + 1) != 4) return -1;
+            pos += 4;
+        } else if(strchr("\"\\/bfnrt", json[pos]) == NULL || json[pos] == '\0') {
+            return -1;
+        }
+    }
+
+    return pos + 1;
+}
+
+/**
+ * @brief scans a number following the JSON grammar
+ *
+ * @param json
+ * @param pos offset of the first character of the number
+ * @return int offset just past the number, -1 if the number is malformed
+ */
+static int scanNumber(const char *json, int pos) {
+    if(json[pos] == '-') pos++;
+
+    if(json[pos] == '0') {
+        pos++;
+    } else if(isdigit((unsigned char)json[pos])) {
+        while(isdigit((unsigned char)json[pos])) pos++;
+    } else {
+        return -1;
+    }
+
+    if(json[pos] == '.') {
+        pos++;
+        if(!isdigit((unsigned char)json[pos])) return -1;
+        while(isdigit((unsigned char)json[pos])) pos++;
+    }
+
+    if(json[pos] == 'e' || json[pos] == 'E') {
+        pos++;
+        if(json[pos] == '+' || json[pos] == '-') pos++;
+        if(!isdigit((unsigned char)json[pos])) return -1;
+        while(isdigit((unsigned char)json[pos])) pos++;
+    }
+
+    return pos;
+}
+
+/**
+ * @brief tokenizes a JSON document in a single pass. Tokens refer back to the JSON string, which must outlive
+ * the document - nothing is copied or decoded until a value is read. Containers are tracked through the parent
+ * link of each token, so nesting depth does not use the C stack
+ *
+ * @param json
+ * @param doc set to the tokens of the document, must be released with freeJSON even if parsing fails
+ * @return true if json holds exactly one valid JSON value, surrounded by optional whitespace
+ * @return false
+ */
+bool parseJSON(const char *json, JsonDocument *doc) {
+    doc->json = json;
+    doc->tokens = NULL;
+    doc->numTokens = 0;
+    doc->capacity = 0;
+    if(json == NULL) return false;
+
+    // Index of the innermost open container, and whether the next token must be a key, a ':' or a ',' / close
+    int parent = -1;
+    bool expectKey = false;
+    bool expectColon = false;
+    bool expectValue = true;
+    bool done = false;
+    int pos = 0;
+
+    while(json[pos] != '\0') {
+        char c = json[pos];
+
+        if(c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            pos++;
+            continue;
+        }
+        if(done) return false;
+
+        if(expectColon) {
+            if(c != ':') return false;
+            expectColon = false;
+            expectValue = true;
+            pos++;
+            continue;
+        }
+
+        if(c == '}' || c == ']') {
+            jsonType closing = c == '}' ? JSON_OBJECT : JSON_ARRAY;
+            if(parent < 0 || doc->tokens[parent].type != closing) return false;
+
+            // Only an empty container may close where a value or key is expected, and never right after a ':'
+            if(expectKey && doc->tokens[parent].size > 0) return false;
+            if(expectValue && (closing == JSON_OBJECT || doc->tokens[parent].size > 0)) return false;
+
+            doc->tokens[parent].end = pos + 1;
+            doc->tokens[parent].next = doc->numTokens;
+            parent = doc->tokens[parent].parent;
+
+            expectKey = false;
+            expectValue = false;
+            done = parent < 0;
+            pos++;
+            continue;
+        }
+
+        if(c == ',') {
+            if(parent < 0 || expectValue || expectKey) return false;
+
+            expectKey = doc->tokens[parent].type == JSON_OBJECT;
+            expectValue = !expectKey;
+            pos++;
+            continue;
+        }
+
+        if(expectKey) {
+            if(c != '"') return false;
+
+            int end = scanString(json, pos);
+            if(end < 0) return false;
+
+            int key = addToken(doc, JSON_STRING, pos, parent);
+            if(key < 0) return false;
+
+            doc->tokens[key].end = end;
+            expectKey = false;
+            expectColon = true;
+            pos = end;
+            continue;
+        }
+
+        if(!expectValue) return false;
+
+        int token = -1;
+        if(c == '{' || c == '[') {
+            token = addToken(doc, c == '{' ? JSON_OBJECT : JSON_ARRAY, pos, parent);
+            if(token < 0) return false;
+
+            if(parent >= 0) doc->tokens[parent].size++;
+            parent = token;
+            expectKey = c == '{';
+            expectValue = c == '[';
+            pos++;
+            continue;
+        }
+
+        int end;
+        jsonType type;
+        if(c == '"') {
+            type = JSON_STRING;
+            end = scanString(json, pos);
+        } else if(c == '-' || isdigit((unsigned char)c)) {
+            type = JSON_NUMBER;
+            end = scanNumber(json, pos);
+        } else if(strncmp(json + pos, "true", 4) == 0) {
+            type = JSON_TRUE;
+            end = pos + 4;
+        } else if(strncmp(json + pos, "false", 5) == 0) {
+            type = JSON_FALSE;
+            end = pos + 5;
+        } else if(strncmp(json + pos, "null", 4) == 0) {
+            type = JSON_NULL;
+            end = pos + 4;
+        } else {
+            return false;
+        }
+        if(end < 0) return false;
+
+        token = addToken(doc, type, pos, parent);
+        if(token < 0) return false;
+
+        doc->tokens[token].end = end;
+        if(parent >= 0) doc->tokens[parent].size++;
+
+        expectValue = false;
+        done = parent < 0;
+        pos = end;
+    }
+
+    return done;
+}
+
+/**
+ * @brief frees the tokens of a JSON document
+ *
+ * @param doc
+ */
+void freeJSON(JsonDocument *doc) {
+    if(doc == NULL) return;
+
+    svgFree(doc->tokens);
+    doc->tokens = NULL;
+    doc->numTokens = 0;
+    doc->capacity = 0;
+}
+
+/**
+ * @brief compares a key token with a name. Keys without escapes - nearly all of them - are compared in place
+ *
+ * @param doc
+ * @param key index of a string token
+ * @param name
+ * @return true if the decoded key is exactly name
+ * @return false
+ */
+static bool keyEquals(const JsonDocument *doc, int key, const char *name) {
+    const JsonToken *token = &doc->tokens[key];
+    int rawLength = token->end - token->start - 2;
+    const char *raw = doc->json + token->start + 1;
+    int nameLength = strlen(name);
+
+    if(memchr(raw, '\\', rawLength) == NULL)
+        return rawLength == nameLength && memcmp(raw, name, nameLength) == 0;
+
+    char decoded[256];
+    return jsonGetString(doc, key, decoded, sizeof(decoded)) == nameLength && strcmp(decoded, name) == 0;
+}
+
+/**
+ * @brief returns the value of a key in an object. Whole keys are compared after decoding escapes, so "x"
+ * never matches "cx"
+ *
+ * @param doc
+ * @param object index of an object token
+ * @param key
+ * @return int index of the value token, -1 if the key is not in the object
+ */
+int jsonObjectGet(const JsonDocument *doc, int object, const char *key) {
+    if(doc == NULL || object < 0 || object >= doc->numTokens || doc->tokens[object].type != JSON_OBJECT) return -1;
+
+    int child = object + 1;
+    for(int i = 0; i < doc->tokens[object].size; i++) {
+        if(keyEquals(doc, child, key)) return child + 1;
+
+        child = doc->tokens[child + 1].next;
+    }
+
+    return -1;
+}
+
+/**
+ * @brief appends a code point to a buffer as UTF-8, as far as it fits
+ *
+ * @param buffer
+ * @param size
+ * @param len current length, advanced by the encoded length
+ * @param codePoint
+ */
+static void appendUTF8(char *buffer, size_t size, int *len, unsigned long codePoint) {
+    char encoded[4];
+    int count;
+
+    if(codePoint < 0x80) {
+        encoded[0] = (char)codePoint;
+        count = 1;
+    } else if(codePoint < 0x800) {
+        encoded[0] = (char)(0xC0 | (codePoint >> 6));
+        encoded[1] = (char)(0x80 | (codePoint & 0x3F));
+        count = 2;
+    } else if(codePoint < 0x10000) {
+        encoded[0] = (char)(0xE0 | (codePoint >> 12));
+        encoded[1] = (char)(0x80 | ((codePoint >> 6) & 0x3F));
+        encoded[2] = (char)(0x80 | (codePoint & 0x3F));
+        count = 3;
+    } else {
+        encoded[0] = (char)(0xF0 | (codePoint >> 18));
+        encoded[1] = (char)(0x80 | ((codePoint >> 12) & 0x3F));
+        encoded[2] = (char)(0x80 | ((codePoint >> 6) & 0x3F));
+        encoded[3] = (char)(0x80 | (codePoint & 0x3F));
+        count = 4;
+    }
+
+    for(int i = 0; i < count; i++) {
+        if((size_t)*len + 1 < size) buffer[*len] = encoded[i];
+        (*len)++;
+    }
+}
+
+/**
+ * @brief copies the text of a string token into a buffer, decoding escapes. Numbers, true, false and null
+ * are copied as written
+ *
+ * @param doc
+ * @param token
+ * @param buffer always terminated, the text is truncated if it does not fit
+ * @param size size of the buffer
+ * @return int length of the full decoded text, which is >= size if it was truncated, -1 if token is not a string or primitive
+ */
+int jsonGetString(const JsonDocument *doc, int token, char *buffer, size_t size) {
+    if(doc == NULL || token < 0 || token >= doc->numTokens || size == 0) return -1;
+
+    const JsonToken *t = &doc->tokens[token];
+    if(t->type == JSON_OBJECT || t->type == JSON_ARRAY) return -1;
+
+    int len = 0;
+    if(t->type != JSON_STRING) {
+        for(int i = t->start; i < t->end; i++) {
+            if((size_t)len + 1 < size) buffer[len] = doc->json[i];
+            len++;
+        }
+        buffer[(size_t)len < size ? len : (int)size - 1] = '\0';
+        return len;
+    }
+
+    const char *p = doc->json + t->start + 1;
+    const char *end = doc->json + t->end - 1;
+
+    while(p < end) {
+        if(*p != '\\') {
+            if((size_t)len + 1 < size) buffer[len] = *p;
+            len++;
+            p++;
+            continue;
+        }
+
+        p++;
+        char escaped = *p++;
+        switch(escaped) {
+        case 'b': escaped = '\b'; break;
+        case 'f': escaped = '\f'; break;
+        case 'n': escaped = '\n'; break;
+        case 'r': escaped = '\r'; break;
+        case 't': escaped = '\t'; break;
+        case 'u': {
+            unsigned long codePoint = hexValue(p);
+            p += 4;
+
+            // A high surrogate followed by a low surrogate encodes one code point past U+FFFF
+            if(codePoint >= 0xD800 && codePoint <= 0xDBFF && p + 6 <= end && p[0] == '\\' && p[1] == 'u') {
+                unsigned long low = hexValue(p + 2);
+                if(low >= 0xDC00 && low <= 0xDFFF) {
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                    p += 6;
+                }
+            }
+            if(codePoint >= 0xD800 && codePoint <= 0xDFFF) codePoint = 0xFFFD;
+
+            appendUTF8(buffer, size, &len, codePoint);
+            continue;
+        }
+        default: break;
+        }
+
+        if((size_t)len + 1 < size) buffer[len] = escaped;
+        len++;
+    }
+
+    buffer[(size_t)len < size ? len : (int)size - 1] = '\0';
+    return len;
+}
+
+/**
+ * @brief reads a geometry value of a shape, either a JSON number or a string holding an SVG length
+ *
+ * @param doc
+ * @param token value token
+ * @param field set to the number
+ * @param units set to UNIT_INVALID if the value is not a length, or to its unit if it has one
+ */
+static void readLength(const JsonDocument *doc, int token, float *field, lengthUnit *units) {
+    char text[64];
+    jsonType type = doc->tokens[token].type;
+    int len = jsonGetString(doc, token, text, sizeof(text));
+
+    if((type != JSON_NUMBER && type != JSON_STRING) || len < 0 || (size_t)len >= sizeof(text)) {
+        *units = UNIT_INVALID;
+        return;
+    }
+    setLengthField(text, field, units);
+}
+
+/**
+ * @brief reads the "units" value of a shape
+ *
+ * @param doc
+ * @param token value token
+ * @return lengthUnit UNIT_INVALID if the value is not a supported unit
+ */
+static lengthUnit readUnits(const JsonDocument *doc, int token) {
+    char text[16];
+    int len = jsonGetString(doc, token, text, sizeof(text));
+
+    if(doc->tokens[token].type != JSON_STRING || len < 0 || (size_t)len >= sizeof(text)) return UNIT_INVALID;
+
+    return lengthUnitFromName(text);
+}
+
+/**
+ * @brief combines the units written in a shape's values with its "units" key. A unit written in a value
+ * wins over the key, and an invalid unit in either makes the shape's units invalid
+ *
+ * @param valueUnits
+ * @param keyUnits
+ * @return lengthUnit
+ */
+static lengthUnit combineUnits(lengthUnit valueUnits, lengthUnit keyUnits) {
+    if(valueUnits == UNIT_INVALID || keyUnits == UNIT_INVALID) return UNIT_INVALID;
+
+    return valueUnits != UNIT_NONE ? valueUnits : keyUnits;
+}
+
+/**
+ * @brief creates a rectangle from an object with the keys x, y, w, h and units, as written by rectToJSON.
+ * Other keys are ignored, missing keys keep their defaults, and a value that is not a length marks the units invalid
+ *
+ * @param doc
+ * @param object index of an object token
+ * @return Rectangle* NULL if the token is not an object, or the rectangle cannot be allocated
+ */
+Rectangle* rectFromJSON(const JsonDocument *doc, int object) {
+    if(doc == NULL || object < 0 || object >= doc->numTokens || doc->tokens[object].type != JSON_OBJECT) return NULL;
+
+    Rectangle *rect = svgMalloc(sizeof(Rectangle));
+    if(rect == NULL) return NULL;
+    rect->otherAttributes = initializeList(&attributeToString, &deleteAttribute, &compareAttributes);
+    if(rect->otherAttributes == NULL) {
+        svgFree(rect);
+        return NULL;
+    }
+    rect->x = 0;
+    rect->y = 0;
+    rect->width = 0;
+    rect->height = 0;
+    rect->units = UNIT_NONE;
+    lengthUnit keyUnits = UNIT_NONE;
+
+    // Each key is visited once, in document order
+    int key = object + 1;
+    for(int i = 0; i < doc->tokens[object].size; i++, key = doc->tokens[key + 1].next) {
+        if(keyEquals(doc, key, "x")) readLength(doc, key + 1, &rect->x, &rect->units);
+        else if(keyEquals(doc, key, "y")) readLength(doc, key + 1, &rect->y, &rect->units);
+        else if(keyEquals(doc, key, "w")) readLength(doc, key + 1, &rect->width, &rect->units);
+        else if(keyEquals(doc, key, "h")) readLength(doc, key + 1, &rect->height, &rect->units);
+        else if(keyEquals(doc, key, "units")) keyUnits = readUnits(doc, key + 1);
+    }
+    rect->units = combineUnits(rect->units, keyUnits);
+
+    return rect;
+}
+
+/**
+ * @brief creates a circle from an object with the keys cx, cy, r and units, as written by circleToJSON.
+ * Other keys are ignored, missing keys keep their defaults, and a value that is not a length marks the units invalid
+ *
+ * @param doc
+ * @param object index of an object token
+ * @return Circle* NULL if the token is not an object, or the circle cannot be allocated
+ */
+Circle* circleFromJSON(const JsonDocument *doc, int object) {
+    if(doc == NULL || object < 0 || object >= doc->numTokens || doc->tokens[object].type != JSON_OBJECT) return NULL;
+
+    Circle *circle = svgMalloc(sizeof(Circle));
+    if(circle == NULL) return NULL;
+    circle->otherAttributes = initializeList(&attributeToString, &deleteAttribute, &compareAttributes);
+    if(circle->otherAttributes == NULL) {
+        svgFree(circle);
+        return NULL;
+    }
+    circle->cx = 0;
+    circle->cy = 0;
+    circle->r = 0;
+    circle->units = UNIT_NONE;
+    lengthUnit keyUnits = UNIT_NONE;
+
+    int key = object + 1;
+    for(int i = 0; i < doc->tokens[object].size; i++, key = doc->tokens[key + 1].next) {
+        if(keyEquals(doc, key, "cx")) readLength(doc, key + 1, &circle->cx, &circle->units);
+        else if(keyEquals(doc, key, "cy")) readLength(doc, key + 1, &circle->cy, &circle->units);
+        else if(keyEquals(doc, key, "r")) readLength(doc, key + 1, &circle->r, &circle->units);
+        else if(keyEquals(doc, key, "units")) keyUnits = readUnits(doc, key + 1);
+    }
+    circle->units = combineUnits(circle->units, keyUnits);
+
+    return circle;
+}
+
+/**
+ * @brief creates a path from an object with a string value for the key d, as written by pathToJSON
+ *
+ * @param doc
+ * @param object index of an object token
+ * @return Path* NULL if the token is not an object or has no path data, or the path cannot be allocated
+ */
+Path* pathFromJSON(const JsonDocument *doc, int object) {
+    int data = jsonObjectGet(doc, object, "d");
+    if(data < 0 || doc->tokens[data].type != JSON_STRING) return NULL;
+
+    // The decoded data is never longer than the raw string
+    size_t size = doc->tokens[data].end - doc->tokens[data].start;
+    Path *path = svgMalloc(sizeof(Path) + size);
+    if(path == NULL) return NULL;
+    jsonGetString(doc, data, path->data, size);
+    path->otherAttributes = initializeList(&attributeToString, &deleteAttribute, &compareAttributes);
+    if(path->otherAttributes == NULL) {
+        svgFree(path);
+        return NULL;
+    }
+
+    return path;
+}
@@ -0,0 +1,447 @@
+/**
+ * @file SVGNumber.c
+ * @author Anthony Vidovic (1130891)
+ * @brief Locale independent float parsing and shortest round trip float formatting
+ * @version 0.1
+ * @date 2022-04-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+// ~~~~~ Includes ~~~~~ //
+#include "SVGHelper.h"
+#include <float.h>
+#include <stdint.h>
+
+// Significant digits kept when a decimal is compared exactly, enough to decide every float halfway point
+#define MAX_EXACT_DIGITS 128
+// 32 bit words in a big integer, enough for MAX_EXACT_DIGITS digits scaled by any float exponent
+#define BIGNUM_WORDS 80
+
+// Powers of ten that are exact floats
+static const float floatPowersOfTen[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+
+// Powers of ten that are exact doubles
+static const double doublePowersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Unsigned big integer, least significant word first
+typedef struct {
+    uint32_t words[BIGNUM_WORDS];
+    int length;
+} BigNum;
+
+static void bigFromDigits(BigNum *big, const char *digits, int count) {
+    big->length = 0;
+
+    for(int i = 0; i < count; i++) {
+        uint64_t carry = (uint64_t)(digits[i] - '0');
+
+        for(int w = 0; w < big->length; w++) {
+            uint64_t product = (uint64_t)big->words[w] * 10 + carry;
+            big->words[w] = (uint32_t)product;
+            carry = product >> 32;
+        }
+        if(carry && big->length < BIGNUM_WORDS) big->words[big->length++] = (uint32_t)carry;
+    }
+}
+
+static void bigMultiply(BigNum *big, uint32_t factor) {
+    uint64_t carry = 0;
+
+    for(int w = 0; w < big->length; w++) {
+        uint64_t product = (uint64_t)big->words[w] * factor + carry;
+        big->words[w] = (uint32_t)product;
+        carry = product >> 32;
+    }
+    if(carry && big->length < BIGNUM_WORDS) big->words[big->length++] = (uint32_t)carry;
+}
+
+static void bigMultiplyPow5(BigNum *big, int exponent) {
+    // 5^13 is the largest power of five that fits in 32 bits
+    for(; exponent >= 13; exponent -= 13) bigMultiply(big, 1220703125);
+
+    uint32_t factor = 1;
+    for(; exponent > 0; exponent--) factor *= 5;
+    bigMultiply(big, factor);
+}
+
+static void bigShiftLeft(BigNum *big, int shift) {
+    int wordShift = shift / 32;
+    int bitShift = shift % 32;
+
+    if(big->length == 0) return;
+    if(big->length + wordShift + 1 > BIGNUM_WORDS) return;
+
+    big->words[big->length + wordShift] = 0;
+    for(int w = big->length - 1; w >= 0; w--) {
+        uint64_t value = (uint64_t)big->words[w] << bitShift;
+        big->words[w + wordShift + 1] |= (uint32_t)(value >> 32);
+        big->words[w + wordShift] = (uint32_t)value;
+    }
+    for(int w = 0; w < wordShift; w++) big->words[w] = 0;
+
+    big->length += wordShift + 1;
+    while(big->length > 0 && big->words[big->length - 1] == 0) big->length--;
+}
+
+static int bigCompare(const BigNum *a, const BigNum *b) {
+    if(a->length != b->length) return a->length < b->length ? -1 : 1;
+
+    for(int w = a->length - 1; w >= 0; w--)
+        if(a->words[w] != b->words[w]) return a->words[w] < b->words[w] ? -1 : 1;
+
+    return 0;
+}
+
+/**
+ * @brief exactly compares digits * 10^exp10 against the point halfway between the positive float
+ * lower and the next float up
+ *
+ * @param digits significant digits, without leading zeros
+ * @param count number of digits
+ * @param exp10 power of ten applied to the digits
+ * @param lower
+ * @return int negative if the decimal is below the halfway point, 0 if equal, positive if above
+ */
+static int compareToHalfway(const char *digits, int count, int exp10, float lower) {
+    // lower = mantissa * 2^exp2, so the halfway point is (2 * mantissa + 1) * 2^(exp2 - 1).
+    // Subnormals and zero share the smallest exponent
+    int exp2 = -149;
+    if(lower != 0) {
+        frexpf(lower, &exp2);
+        exp2 -= FLT_MANT_DIG;
+        if(exp2 < -149) exp2 = -149;
+    }
+    uint32_t mantissa = (uint32_t)ldexpf(lower, -exp2);
+
+    BigNum decimal, halfway;
+    bigFromDigits(&decimal, digits, count);
+    halfway.words[0] = 2 * mantissa + 1;
+    halfway.length = 1;
+
+    // Move every negative power to the other side so both sides are integers
+    int twos = exp2 - 1;
+    if(exp10 >= 0) {
+        bigMultiplyPow5(&decimal, exp10);
+        twos -= exp10;
+    } else {
+        bigMultiplyPow5(&halfway, -exp10);
+        twos += -exp10;
+    }
+
+    if(twos >= 0) bigShiftLeft(&halfway, twos);
+    else bigShiftLeft(&decimal, -twos);
+
+    return bigCompare(&decimal, &halfway);
+}
+
+/**
+ * @brief copies the significant digits of a decimal number, skipping the sign, the decimal point and
+ * leading zeros. Past MAX_EXACT_DIGITS digits a final '1' stands in for any dropped non-zero digits, which
+ * keeps the value strictly between the kept digits and the next decimal up
+ *
+ * @param str start of the number
+ * @param digits buffer of at least MAX_EXACT_DIGITS + 1 characters, not terminated
+ * @return int number of digits copied
+ */
+static int gatherDigits(const char *str, char *digits) {
+    const char *p = str + (*str == '+' || *str == '-');
+    int count = 0;
+    bool leading = true;
+    bool point = false;
+    bool sticky = false;
+
+    for(; isdigit((unsigned char)*p) || (*p == '.' && !point); p++) {
+        if(*p == '.') {
+            point = true;
+        } else if(leading && *p == '0') {
+            continue;
+        } else if(count < MAX_EXACT_DIGITS) {
+            leading = false;
+            digits[count++] = *p;
+        } else {
+            sticky |= *p != '0';
+        }
+    }
+    if(sticky) digits[count++] = '1';
+
+    return count;
+}
+
+/**
+ * @brief parses a decimal number - an optional sign, digits with an optional fraction and an optional
+ * exponent - into the nearest float, rounding ties to even. Does not depend on the locale, does not skip
+ * leading spaces and does not accept inf, nan or hexadecimal numbers. An 'e' not followed by digits is not
+ * part of the number, so "5em" parses as 5
+ *
+ * @param str
+ * @param end if not NULL, set to the first character after the number, or to str if there is no number
+ * @return float the parsed number, 0 if there is none
+ */
+float parseFloat(const char *str, const char **end) {
+    const char *p = str;
+    if(end != NULL) *end = str;
+    if(str == NULL) return 0;
+
+    bool negative = false;
+    if(*p == '+' || *p == '-') negative = *p++ == '-';
+
+    // Significant digits are kept in place - they are read back from the string if an exact comparison is needed
+    uint64_t mantissa = 0;
+    int significant = 0;
+    int exponent = 0;
+    bool truncated = false;
+    bool anyDigits = false;
+
+    for(; isdigit((unsigned char)*p); p++) {
+        anyDigits = true;
+        if(significant < 19) {
+            mantissa = mantissa * 10 + (*p - '0');
+            if(mantissa > 0) significant++;
+        } else {
+            exponent++;
+            truncated |= *p != '0';
+        }
+    }
+    if(*p == '.') {
+        for(p++; isdigit((unsigned char)*p); p++) {
+            anyDigits = true;
+            if(significant < 19) {
+                mantissa = mantissa * 10 + (*p - '0');
+                if(mantissa > 0) significant++;
+                exponent--;
+            } else {
+                truncated |= *p != '0';
+            }
+        }
+    }
+    if(!anyDigits) return 0;
+
+    const char *e = p;
+    if(*e == 'e' || *e == 'E') {
+        e++;
+        bool negativeExp = false;
+        if(*e == '+' || *e == '-') negativeExp = *e++ == '-';
+
+        if(isdigit((unsigned char)*e)) {
+            int exp = 0;
+            for(; isdigit((unsigned char)*e); e++)
+                if(exp < 100000) exp = exp * 10 + (*e - '0');
+
+            exponent += negativeExp ? -exp : exp;
+            p = e;
+        }
+    }
+    if(end != NULL) *end = p;
+
+    if(mantissa == 0 && !truncated) return negative ? -0.0f : 0.0f;
+
+    // Clinger's fast path: an exact mantissa and power of ten give a correctly rounded result in one operation
+    if(!truncated && mantissa <= (1ULL << FLT_MANT_DIG) && exponent >= -10 && exponent <= 10) {
+        float f = (float)mantissa;
+        f = exponent < 0 ? f / floatPowersOfTen[-exponent] : f * floatPowersOfTen[exponent];
+        return negative ? -f : f;
+    }
+
+    // Out of range for any float
+    if(exponent + significant > 40) return negative ? -INFINITY : INFINITY;
+    if(exponent + significant < -46) return negative ? -0.0f : 0.0f;
+
+    // Estimate in long double, which is enough unless the value lies very close to a float halfway point
+    long double estimate = (long double)mantissa;
+    int remaining = exponent < 0 ? -exponent : exponent;
+    long double scale = 1;
+    while(remaining > 22) {
+        scale *= doublePowersOfTen[22];
+        remaining -= 22;
+    }
+    scale *= doublePowersOfTen[remaining];
+    estimate = exponent < 0 ? estimate / scale : estimate * scale;
+
+    float result = (float)estimate;
+    float lower = (long double)result > estimate ? nextafterf(result, 0) : result;
+    float upper = nextafterf(lower, INFINITY);
+    long double halfway = ((long double)lower + (long double)upper) / 2;
+    if(isinf(upper)) halfway = (long double)lower + ((long double)lower - (long double)nextafterf(lower, 0)) / 2;
+
+    // The estimate is off by a few units in its last place, a margin of 2^-(LDBL_MANT_DIG - 8) covers that
+    long double margin = ldexpl(estimate, -(LDBL_MANT_DIG - 8));
+    if(truncated || fabsl(estimate - halfway) <= margin) {
+        char digits[MAX_EXACT_DIGITS + 1];
+        int count = gatherDigits(str, digits);
+
+        // digits * 10^exp10 has the same value as mantissa * 10^exponent
+        int exp10 = exponent + significant - count;
+
+        int cmp = compareToHalfway(digits, count, exp10, lower);
+        uint32_t bits;
+        memcpy(&bits, &lower, sizeof(bits));
+
+        // Ties round to the even neighbour
+        result = cmp > 0 || (cmp == 0 && (bits & 1)) ? upper : lower;
+    }
+
+    return negative ? -result : result;
+}
+
+/**
+ * @brief writes digits * 10^exp10 in plain notation, or in exponent notation when the number is very
+ * large or very small
+ *
+ * @param buffer
+ * @param negative
+ * @param digits significant digits, non zero
+ * @param exp10
+ * @return int length of the string written
+ */
+static int writeDecimal(char *buffer, bool negative, uint64_t digits, int exp10) {
+    while(digits % 10 == 0) {
+        digits /= 10;
+        exp10++;
+    }
+
+    char reversed[20];
+    int count = 0;
+    for(; digits > 0; digits /= 10) reversed[count++] = (char)('0' + digits % 10);
+
+    // Decimal exponent of the first digit
+    int leading = count - 1 + exp10;
+    int len = 0;
+    if(negative) buffer[len++] = '-';
+
+    if(leading < -6 || leading > 20) {
+        buffer[len++] = reversed[count - 1];
+        if(count > 1) {
+            buffer[len++] = '.';
+            for(int i = count - 2; i >= 0; i--) buffer[len++] = reversed[i];
+        }
+        len += sprintf(buffer + len, "e%d", leading);
+        return len;
+    }
+
+    if(leading < 0) {
+        buffer[len++] = '0';
+        buffer[len++] = '.';
+        for(int i = -1; i > leading; i--) buffer[len++] = '0';
+    }
+    for(int i = count - 1; i >= 0; i--) {
+        buffer[len++] = reversed[i];
+        if(i > 0 && count - 1 - i == leading) buffer[len++] = '.';
+    }
+    for(int i = 0; i < exp10; i++) buffer[len++] = '0';
+
+    buffer[len] = '\0';
+    return len;
+}
+
+/**
+ * @brief multiplies a value by a power of ten in double precision
+ *
+ * @param value
+ * @param exp10
+ * @return double
+ */
+static double scaleByPowerOfTen(double value, int exp10) {
+    for(; exp10 > 22; exp10 -= 22) value *= doublePowersOfTen[22];
+    for(; exp10 < -22; exp10 += 22) value /= doublePowersOfTen[22];
+
+    return exp10 < 0 ? value / doublePowersOfTen[-exp10] : value * doublePowersOfTen[exp10];
+}
+
+/**
+ * @brief writes the shortest decimal string that parseFloat reads back as exactly the same float, choosing
+ * the one closest to the float when several have the same length. Does not depend on the locale.
+ * Every float rounds from an interval of reals whose bounds are exact doubles, so for 1 to 9 significant digits the
+ * decimal closest to the float is tested against that interval in double precision. Only a candidate too close to a
+ * bound to decide this way is checked by parsing it back
+ *
+ * @param value
+ * @param buffer at least FLOAT_STRING_SIZE characters
+ * @return int length of the string written
+ */
+int formatFloat(float value, char *buffer) {
+    if(isnan(value)) return sprintf(buffer, "nan");
+    if(isinf(value)) return sprintf(buffer, value < 0 ? "-inf" : "inf");
+    if(value == 0) return sprintf(buffer, signbit(value) ? "-0" : "0");
+
+    bool negative = value < 0;
+    float magnitude = negative ? -value : value;
+    double below = nextafterf(magnitude, 0);
+    double above = nextafterf(magnitude, INFINITY);
+    if(isinf(above)) above = (double)magnitude + ((double)magnitude - below);
+
+    // Bounds of the interval of reals that round to the float
+    double lowBound = ((double)magnitude + below) / 2;
+    double highBound = ((double)magnitude + above) / 2;
+
+    // Decimal exponent of the first digit, corrected when log10 is off at a power of ten
+    int leading = (int)floor(log10((double)magnitude));
+    double first = scaleByPowerOfTen(magnitude, -leading);
+    if(first >= 10) leading++;
+    else if(first < 1) leading--;
+
+    // Each extra digit multiplies the scaled values by ten
+    double scaled = first >= 10 ? first / 10 : (first < 1 ? first * 10 : first);
+    double low = scaleByPowerOfTen(lowBound, -leading);
+    double high = scaleByPowerOfTen(highBound, -leading);
+
+    for(int precision = 1; precision <= 9; precision++, scaled *= 10, low *= 10, high *= 10) {
+        int exp10 = leading - precision + 1;
+
+        // Scaling is off by a few units in the last place, anything within the margin of a bound is checked exactly
+        double margin = high * 1e-13;
+        double nearest = floor(scaled + 0.5);
+
+        // The closest decimal may fall outside the interval when the float is a power of two - the interval is
+        // lopsided then and the next decimal on the wide side can still be inside
+        double candidates[2] = { nearest, nearest < scaled ? nearest + 1 : nearest - 1 };
+
+        for(int i = 0; i < 2; i++) {
+            double c = candidates[i];
+            if(c <= 0 || c < low - margin || c > high + margin) continue;
+
+            bool inside = c > low + margin && c < high - margin;
+
+            int len = writeDecimal(buffer, negative, (uint64_t)c, exp10);
+            if(inside || parseFloat(buffer, NULL) == value) return len;
+        }
+    }
+
+    // Nine significant digits always identify a float, this is only reached if the estimates above were off
+    int len = sprintf(buffer, "%.8e", value);
+    for(int i = 0; i < len; i++)
+        if(buffer[i] == ',') buffer[i] = '.';
+
+    return len;
+}
+
+/**
+ * @brief writes a float rounded to at most the given number of digits after the decimal point, with trailing
+ * zeros dropped. The shortest round trip string from formatFloat is written instead when it is no longer
+ *
+ * @param value
+ * @param decimals digits kept after the decimal point, negative to always use formatFloat
+ * @param buffer at least FLOAT_STRING_SIZE characters
+ * @return int length of the string written
+ */
+int formatFloatFixed(float value, int decimals, char *buffer) {
+    int len = formatFloat(value, buffer);
+    if(decimals < 0 || !isfinite(value)) return len;
+
+    // Past 15 digits the rounded value is not exact in a double, and formatFloat is shorter anyway
+    double scaled = scaleByPowerOfTen(fabs((double)value), decimals);
+    if(scaled >= 1e15) return len;
+
+    char fixed[FLOAT_STRING_SIZE];
+    uint64_t digits = (uint64_t)floor(scaled + 0.5);
+    int fixedLen = digits == 0 ? sprintf(fixed, "0") : writeDecimal(fixed, value < 0, digits, -decimals);
+
+    if(fixedLen >= len) return len;
+
+    memcpy(buffer, fixed, fixedLen + 1);
+    return fixedLen;
+}
@@ -29,27 +29,33 @@ SVG* createSVG(const char* fileName) {
 
     // Use libxml2 to help us parse the svg file
     xmlDoc* doc = NULL;
-    xmlNode* root_element = NULL;
-    doc = xmlReadFile(fileName, NULL, 0);
+    doc = readSVGDoc(fileName);
 
     if (doc == NULL) {
         xmlFreeDoc(doc);
-        xmlCleanupParser();
         fclose(fp);
         return NULL;
     }
 
-    root_element = xmlDocGetRootElement(doc);
+    SVG* svg = svgFromDoc(doc);
 
-    SVG* svg = NULL;
-    svg = malloc(sizeof(SVG));
+    xmlFreeDoc(doc);
+    fclose(fp);
+    return svg;
+}
 
-    if(svg == NULL) {
-        xmlFreeDoc(doc);
-        xmlCleanupParser();
-        fclose(fp);
-        return NULL;
-    }
+/**
+ * @brief builds an svg struct from a parsed document, with its element table and totals.  The document is
+ * left for the caller to free, and libxml2's global state is not cleaned up, so worker threads may call it
+ * 
+ * @param doc 
+ * @return SVG* NULL if the struct cannot be allocated or the document is nested too deeply
+ */
+SVG* svgFromDoc(xmlDoc *doc) {
+    xmlNode* root_element = xmlDocGetRootElement(doc);
+
+    SVG* svg = svgMalloc(sizeof(SVG));
+    if(svg == NULL) return NULL;
 
     svg->rectangles = initializeList(&rectangleToString, &deleteRectangle, &compareRectangles);
     svg->circles = initializeList(&circleToString, &deleteCircle, &compareCircles);
@@ -59,20 +65,29 @@ SVG* createSVG(const char* fileName) {
     strcpy(svg->namespace, "");
     strcpy(svg->title, "");
     strcpy(svg->description, "");
+    initSVGCaches(svg);
     
-    if(svg == NULL || svg->rectangles == NULL || svg->circles  == NULL || svg->paths == NULL || svg->groups == NULL || svg->otherAttributes == NULL) {
-        xmlFreeDoc(doc);
-        xmlCleanupParser();
-        fclose(fp);
+    // deleteSVG skips the lists that were not created
+    if(svg->rectangles == NULL || svg->circles  == NULL || svg->paths == NULL || svg->groups == NULL || svg->otherAttributes == NULL) {
+        deleteSVG(svg);
         return NULL;
     }
     
     // Sort elements into proper svg struct properties
-    addElementsToSVG(svg, root_element);
+    PhaseTimer start = startPhase();
+    if(!addElementsToSVG(svg, root_element)) {
+        deleteSVG(svg);
+        return NULL;
+    }
+
+    // Assign every element an ID for constant time lookup
+    if(!buildElementTable(svg)) {
+        deleteSVG(svg);
+        return NULL;
+    }
+    computeSVGTotals(svg, &svg->totals);
+    endPhase(STAT_BUILD, &start, 0, svg->numElements);
 
-    xmlFreeDoc(doc);
-    xmlCleanupParser();
-    fclose(fp);
     return svg;
 }
 
@@ -101,7 +116,7 @@ char* SVGToString(const SVG* img) {
     int groupsLength = img->groups->length > 0 ? strlen(groups) : 0;
     int length = strlen(img->namespace) + strlen(img->title) + strlen(img->description) + otherAttributesLength + rectanglesLength + circlesLength + pathsLength + groupsLength;
 
-    char *str = malloc(sizeof(char) * (length + 300));
+    char *str = svgMalloc(sizeof(char) * (length + 300));
 
     strcpy(str, "namespace: ");
     strcat(str, strlen(img->namespace) > 0 ? img->namespace : "none");
@@ -128,11 +143,11 @@ char* SVGToString(const SVG* img) {
     strcat(str, img->groups->length > 0 ? groups : "none");
     strcat(str, "\n");
 
-    free(otherAttributes);
-    free(rectangles);
-    free(circles);
-    free(paths);
-    free(groups);
+    svgFree(otherAttributes);
+    svgFree(rectangles);
+    svgFree(circles);
+    svgFree(paths);
+    svgFree(groups);
     
     return str;
 }
@@ -149,7 +164,7 @@ char* attributeToString(void* data) {
     Attribute *attr = (Attribute*)data;;
 
     int length = strlen(attr->name) + strlen(attr->value) + 5;
-    char *str = malloc(sizeof(char) * length);
+    char *str = svgMalloc(sizeof(char) * length);
     int r = snprintf(str, length, "%s=%s, ", attr->name, attr->value);
     
     if(r < 0) return NULL;
@@ -169,23 +184,23 @@ char* rectangleToString(void* data) {
     Rectangle *rect = (Rectangle*)data;
 
     char *otherAttributes = toString(rect->otherAttributes);
-    int length = strlen(rect->units) + strlen(otherAttributes) + 100;
-    char *str = calloc(sizeof(char), length);
+    int length = strlen(otherAttributes) + 100;
+    char *str = svgCalloc(sizeof(char), length);
 
     int len = snprintf(NULL, 0, "%.2f", rect->x);
-    char *rectX = malloc(len + 1);
+    char *rectX = svgMalloc(len + 1);
     snprintf(rectX, len + 1, "%.2f", rect->x);
 
     len = snprintf(NULL, 0, "%.2f", rect->y);
-    char *rectY = malloc(len + 1);
+    char *rectY = svgMalloc(len + 1);
     snprintf(rectY, len + 1, "%.2f", rect->y);
 
     len = snprintf(NULL, 0, "%.2f", rect->width);
-    char *rectWidth = malloc(len + 1);
+    char *rectWidth = svgMalloc(len + 1);
     snprintf(rectWidth, len + 1, "%.2f", rect->width);
 
     len = snprintf(NULL, 0, "%.2f", rect->height);
-    char *rectHeight = malloc(len + 1);
+    char *rectHeight = svgMalloc(len + 1);
     snprintf(rectHeight, len + 1, "%.2f", rect->height);
     
     strcpy(str, "x: ");
@@ -201,17 +216,17 @@ char* rectangleToString(void* data) {
     strcat(str, rectHeight);
     strcat(str, "\n");
     strcat(str, "units: ");
-    strcat(str, rect->units);
+    strcat(str, lengthUnitName(rect->units));
     strcat(str, "\n");
     strcat(str, "Attributes: ");
     strcat(str, rect->otherAttributes->length > 0 ? otherAttributes : "none");
     strcat(str, "\n");
 
-    free(rectX);
-    free(rectY);
-    free(rectWidth);
-    free(rectHeight);
-    free(otherAttributes);
+    svgFree(rectX);
+    svgFree(rectY);
+    svgFree(rectWidth);
+    svgFree(rectHeight);
+    svgFree(otherAttributes);
 
     return str;
 }
@@ -229,18 +244,18 @@ char* circleToString(void* data) {
 
     char *otherAttributes = toString(c->otherAttributes);
     int length = strlen(otherAttributes) + 500;
-    char *str = calloc(sizeof(char), length);
+    char *str = svgCalloc(sizeof(char), length);
 
     int len = snprintf(NULL, 0, "%.2f", c->cx);
-    char *circleCX = malloc(len + 1);
+    char *circleCX = svgMalloc(len + 1);
     snprintf(circleCX, len + 1, "%.2f", c->cx);
 
     len = snprintf(NULL, 0, "%.2f", c->cy);
-    char *circleCY = malloc(len + 1);
+    char *circleCY = svgMalloc(len + 1);
     snprintf(circleCY, len + 1, "%.2f", c->cy);
 
     len = snprintf(NULL, 0, "%.2f", c->r);
-    char *circleR = malloc(len + 1);
+    char *circleR = svgMalloc(len + 1);
     snprintf(circleR, len + 1, "%.2f", c->r);
 
 
@@ -254,16 +269,16 @@ char* circleToString(void* data) {
     strcat(str, circleR);
     strcat(str, "\n");
     strcat(str, "units: ");
-    strcat(str, c->units);
+    strcat(str, lengthUnitName(c->units));
     strcat(str, "\n");
     strcat(str, "Attributes: ");
     strcat(str, c->otherAttributes->length > 0 ? otherAttributes : "none\n");
     strcat(str, "\n");
 
-    free(circleCX);
-    free(circleCY);
-    free(circleR);
-    free(otherAttributes);
+    svgFree(circleCX);
+    svgFree(circleCY);
+    svgFree(circleR);
+    svgFree(otherAttributes);
 
     return str;
 }
@@ -281,7 +296,7 @@ char* pathToString(void* data) {
 
     char *otherAttributes = toString(p->otherAttributes);
     int length = strlen(p->data) + strlen(otherAttributes) + 500;
-    char *str = calloc(sizeof(char), length);
+    char *str = svgCalloc(sizeof(char), length);
 
     int r = snprintf(
             str,
@@ -292,7 +307,7 @@ char* pathToString(void* data) {
     
     if(r < 0) return NULL;
 
-    free(otherAttributes);
+    svgFree(otherAttributes);
 
     return str;
 }
@@ -321,7 +336,7 @@ char* groupToString(void* data){
     int groupsLength = g->groups->length > 0 ? strlen(groups) : 0;
 
     int length = otherAttributesLength + rectanglesLength + circlesLength + pathsLength + groupsLength + 100;
-    char *str = calloc(sizeof(char), length);
+    char *str = svgCalloc(sizeof(char), length);
 
     sprintf(str, "\nGroup start\n\nAttributes: %s\nRectangles: %s\n\nCircles: %s\n\nPaths: %s\n\nGroups: %s\n\nGroup end\n", 
                 otherAttributes, 
@@ -331,11 +346,11 @@ char* groupToString(void* data){
                 groups
             );
 
-    free(otherAttributes);
-    free(rectangles);
-    free(circles);
-    free(paths);
-    free(groups);
+    svgFree(otherAttributes);
+    svgFree(rectangles);
+    svgFree(circles);
+    svgFree(paths);
+    svgFree(groups);
 
     return str;
 }
@@ -378,7 +393,8 @@ void deleteSVG(SVG* img) {
     freeList(img->circles);
     freeList(img->paths);
     freeList(img->groups);
-    free(img);
+    freeSVGCaches(img);
+    svgFree(img);
 }
 
 /**
@@ -392,8 +408,8 @@ void deleteAttribute(void* data) {
     if(data == NULL) return;
 
     attr = (Attribute*)data;
-    free(attr->name);
-    free(attr);
+    svgFree(attr->name);
+    svgFree(attr);
 }
 
 /**
@@ -402,17 +418,37 @@ void deleteAttribute(void* data) {
  * @param data 
  */
 void deleteGroup(void* data) {
-    Group *g;
-
     if(data == NULL) return;
-    g = (Group*)data;
 
-    freeList(g->otherAttributes);
-    freeList(g->rectangles);
-    freeList(g->circles);
-    freeList(g->paths);
-    freeList(g->groups);
-    free(g);
+    // Nested groups are moved onto a stack and freed in turn instead of through freeList,
+    // so deeply nested groups cannot overflow the call stack
+    Group **stack = NULL;
+    int depth = 0, capacity = 0;
+    Group *g = (Group*)data;
+
+    while(g != NULL) {
+        for(Node *cur = g->groups->head; cur; cur = cur->next) {
+            if(depth == capacity) {
+                Group **grown = growStack(stack, &capacity, sizeof(Group*));
+                if(grown == NULL) break;
+                stack = grown;
+            }
+            stack[depth++] = (Group*)cur->data;
+            cur->data = NULL;
+        }
+
+        // Groups that did not fit on the stack are freed by freeList
+        freeList(g->otherAttributes);
+        freeList(g->rectangles);
+        freeList(g->circles);
+        freeList(g->paths);
+        freeList(g->groups);
+        svgFree(g);
+
+        g = depth > 0 ? stack[--depth] : NULL;
+    }
+
+    svgFree(stack);
 }
 
 /**
@@ -428,7 +464,7 @@ void deleteRectangle(void* data) {
     rect = (Rectangle*)data;
 
     freeList(rect->otherAttributes);
-    free(rect);
+    svgFree(rect);
 }
 
 /**
@@ -444,7 +480,7 @@ void deleteCircle(void* data) {
     c = (Circle*)data;
 
     freeList(c->otherAttributes);
-    free(c);
+    svgFree(c);
 }
 
 /**
@@ -460,7 +496,7 @@ void deletePath(void* data) {
     path = (Path*)data;
 
     freeList(path->otherAttributes);
-    free(path);   
+    svgFree(path);   
 }
 
 /**
@@ -484,16 +520,12 @@ List* getRects(const SVG* img) {
 
     List *rectangles = initializeList(&rectangleToString, &dummyDelete, &compareRectangles);
 
-    Node* cur = img->rectangles->head;
+    Node* cur = getRectView(img)->head;
     while(cur != NULL) {
-        Rectangle *rect = (Rectangle*)cur->data;
-        insertBack(rectangles, (void*)rect);
+        insertBack(rectangles, cur->data);
         cur = cur->next;
     }
 
-    if(img->groups->length > 0) 
-        findRectanglesInGroup(img->groups, rectangles);
-
     return rectangles;
 }
 
@@ -507,17 +539,13 @@ List* getCircles(const SVG* img) {
     if(img == NULL) return NULL;
     
     List *circles = initializeList(&circleToString, &dummyDelete, &compareCircles);
-    Node* cur = img->circles->head;
-    
+
+    Node* cur = getCircleView(img)->head;
     while(cur != NULL) {
-        Circle *circle = (Circle*)cur->data;
-        insertBack(circles, (void*)circle);
+        insertBack(circles, cur->data);
         cur = cur->next;
     }
     
-    if(img->groups->length > 0) 
-        findCirclesInGroup(img->groups, circles);
-    
     return circles;
 }
 
@@ -531,15 +559,12 @@ List* getPaths(const SVG* img) {
     if(img == NULL) return NULL;
 
     List *paths = initializeList(&pathToString, &dummyDelete, &comparePaths);
-    Node* cur = img->paths->head;
 
+    Node* cur = getPathView(img)->head;
     while(cur != NULL) {
-        Path *p = (Path*)cur->data;
-        insertBack(paths, (void*)p);
+        insertBack(paths, cur->data);
         cur = cur->next;
     }
-    if(img->groups->length > 0) 
-        findPathsInGroup(img->groups, paths);
 
     return paths;
 }
@@ -555,8 +580,11 @@ List* getGroups(const SVG* img) {
 
     List *groups = initializeList(&groupToString, &dummyDelete, &compareGroups);
 
-    if(img->groups->length > 0)
-        findGroups(img->groups, groups);
+    Node* cur = getGroupView(img)->head;
+    while(cur != NULL) {
+        insertBack(groups, cur->data);
+        cur = cur->next;
+    }
 
     return groups;
 }
@@ -572,22 +600,9 @@ List* getGroups(const SVG* img) {
  * @return int 
  */
 int numRectsWithArea(const SVG* img, float area) {
-    if(img == NULL || area < 0 || (img->rectangles->length < 1 && img->groups->length < 1)) return 0;
-
-    int found = 0;
-    Node *cur = img->rectangles->head;
-
-    while(cur) {
-        Rectangle *rect = (Rectangle*)cur->data;
-        float rectArea = rect->width * rect->height;
-        if(ceil(rectArea) == ceil(area)) found++;
-        cur = cur->next;
-    }
-
-    if(img->groups->length > 0)
-        searchGroupsForRectArea(img->groups, &found, area);
+    if(img == NULL || area < 0) return 0;
 
-    return found;
+    return countAreaKeys(getRectAreaIndex(img), ceil(area), ceil(area));
 }
 
 /**
@@ -598,22 +613,39 @@ int numRectsWithArea(const SVG* img, float area) {
  * @return int 
  */
 int numCirclesWithArea(const SVG* img, float area) {
-    if(img == NULL || area < 0 || (img->circles->length < 1 && img->groups->length < 1)) return 0;
+    if(img == NULL || area < 0) return 0;
 
-    int found = 0;
-    Node *cur = img->circles->head;
+    return countAreaKeys(getCircleAreaIndex(img), ceil(area), ceil(area));
+}
 
-    while(cur) {
-        Circle *circle = (Circle*)cur->data;
-        float circleArea = M_PI * circle->r * circle->r;
-        if(ceil(circleArea) == ceil(area)) found++;
-        cur = cur->next;
-    }
+/**
+ * @brief Function that returns the number of all rectangles with an area in the given range,
+ * areas are rounded up the same way as numRectsWithArea
+ * 
+ * @param img 
+ * @param minArea 
+ * @param maxArea 
+ * @return int 
+ */
+int numRectsInAreaRange(const SVG* img, float minArea, float maxArea) {
+    if(img == NULL || maxArea < 0) return 0;
 
-    if(img->groups->length > 0)
-        searchGroupsForCircleArea(img->groups, &found, area);
+    return countAreaKeys(getRectAreaIndex(img), ceil(minArea), ceil(maxArea));
+}
 
-    return found;
+/**
+ * @brief Function that returns the number of all circles with an area in the given range,
+ * areas are rounded up the same way as numCirclesWithArea
+ * 
+ * @param img 
+ * @param minArea 
+ * @param maxArea 
+ * @return int 
+ */
+int numCirclesInAreaRange(const SVG* img, float minArea, float maxArea) {
+    if(img == NULL || maxArea < 0) return 0;
+
+    return countAreaKeys(getCircleAreaIndex(img), ceil(minArea), ceil(maxArea));
 }
 
 /**
@@ -627,16 +659,8 @@ int numPathsWithdata(const SVG* img, const char* data) {
     if(img == NULL || data == NULL || (img->paths->length < 1 && img->groups->length < 1)) return 0;
 
     int found = 0;
-    Node *cur = img->paths->head;
-
-    while(cur) {
-        Path *p = (Path*)cur->data;
-        if(strcmp(p->data, data) == 0) found++;
-        cur = cur->next;
-    }
-
-    if(img->groups->length > 0)
-        searchGroupsForPathData(img->groups, &found, data);
+    SVGVisitor visitor = { VISIT_PATHS, 0, &pathHasData, data, &countElement, &found };
+    visitSVG(img, &visitor, 1);
 
     return found;
 }
@@ -666,41 +690,7 @@ int numGroupsWithLen(const SVG* img, int len) {
 int numAttr(const SVG* img) {
     if(img == NULL) return 0;
 
-    int found = 0;
-
-    // Get num attributes from svg->otherAttributes
-    found += img->otherAttributes->length;
-
-    // Get num attributes from svg->rectangles
-    Node *curRect = img->rectangles->head;
-    while(curRect) {
-        
-        Rectangle *rect = (Rectangle*)curRect->data;
-        found += rect->otherAttributes->length;
-        curRect = curRect->next;
-    }
-
-    // Get num attributes from svg->circles
-    Node *curCircle = img->circles->head;
-    while(curCircle) {
-        Circle *circle = (Circle*)curCircle->data;
-        found += circle->otherAttributes->length;
-        curCircle = curCircle->next;
-    }
-    
-    // Get num attributes from svg->paths
-    Node *curPath = img->paths->head;
-    while(curPath) {
-        Path *p = (Path*)curPath->data;
-        found += p->otherAttributes->length;
-        curPath = curPath->next;
-    }
-    
-    // Get num attributes within all groups
-    if(img->groups->length > 0)
-        searchGroupsForAttributes(img->groups, &found);
-
-    return found;
+    return getSVGTotals(img).attributes;
 }
 
 
@@ -723,22 +713,23 @@ SVG* createValidSVG(const char* fileName, const char* schemaFile) {
         return NULL;
     
     if(!extensionMatches(schemaFile, ".xsd")) return false;
-    if(!extensionMatches(fileName, ".svg")) return NULL;
+    if(!isSVGFileName(fileName)) return NULL;
     
     FILE* fp = fopen(fileName, "r");
     if (fp == NULL) return NULL;
     
     FILE* schemaFp = fopen(schemaFile, "r");
-    if (schemaFp == NULL) return NULL;
+    if (schemaFp == NULL) {
+        fclose(fp);
+        return NULL;
+    }
     
     // Use libxml2 to help us parse the svg file
     xmlDoc* doc = NULL;
-    xmlNode* root_element = NULL;
-    doc = xmlReadFile(fileName, NULL, 0);
+    doc = readSVGDoc(fileName);
 
     if (doc == NULL) {
         xmlFreeDoc(doc);
-        xmlCleanupParser();
         fclose(fp);
         fclose(schemaFp);
         return NULL;
@@ -748,47 +739,14 @@ SVG* createValidSVG(const char* fileName, const char* schemaFile) {
 
     if(ret != 0) {
         xmlFreeDoc(doc);
-        xmlCleanupParser();
         fclose(fp);
         fclose(schemaFp);
         return NULL;
     }
 
-    root_element = xmlDocGetRootElement(doc);
-
-    SVG* svg = NULL;
-    svg = malloc(sizeof(SVG));
-
-    if(svg == NULL) {
-        xmlFreeDoc(doc);
-        xmlCleanupParser();
-        fclose(fp);
-        fclose(schemaFp);
-        return NULL;
-    }
-
-    svg->rectangles = initializeList(&rectangleToString, &deleteRectangle, &compareRectangles);
-    svg->circles = initializeList(&circleToString, &deleteCircle, &compareCircles);
-    svg->paths = initializeList(&pathToString, &deletePath, &comparePaths);
-    svg->groups = initializeList(&groupToString, &deleteGroup, &compareGroups);
-    svg->otherAttributes = initializeList(&attributeToString, &deleteAttribute, &compareAttributes);
-    strcpy(svg->namespace, "");
-    strcpy(svg->title, "");
-    strcpy(svg->description, "");
-    
-    if(svg == NULL || svg->rectangles == NULL || svg->circles == NULL || svg->paths == NULL || svg->groups == NULL || svg->otherAttributes == NULL) {
-        xmlFreeDoc(doc);
-        xmlCleanupParser();
-        fclose(fp);
-        fclose(schemaFp);
-        return NULL;
-    }
-    
-    // Sort elements into proper svg struct properties
-    addElementsToSVG(svg, root_element);
+    SVG* svg = svgFromDoc(doc);
 
     xmlFreeDoc(doc);
-    xmlCleanupParser();
     
     fclose(fp);
     fclose(schemaFp);
@@ -829,7 +787,6 @@ bool validateSVG(const SVG* img, const char* schemaFile) {
 
     if(doc == NULL) {
         xmlFreeDoc(doc);
-        xmlCleanupParser();
         fclose(schemaFp);   
         return false;
     }
@@ -839,12 +796,10 @@ bool validateSVG(const SVG* img, const char* schemaFile) {
 
     if(ret != 0) {
         xmlFreeDoc(doc);
-        xmlCleanupParser();
         fclose(schemaFp);   
         return false;
     }
     xmlFreeDoc(doc);
-    xmlCleanupParser();
     fclose(schemaFp);   
     return true;
 }
@@ -858,19 +813,31 @@ bool validateSVG(const SVG* img, const char* schemaFile) {
  * @return false 
  */
 bool writeSVG(const SVG* img, const char* fileName) {
+    return writeSVGWithOptions(img, fileName, NULL);
+}
+
+/**
+ * @brief Saves SVG struct to a file in SVG format, compacted or minified as set in options
+ * 
+ * @param img 
+ * @param fileName 
+ * @param options NULL for the same output as writeSVG
+ * @return true 
+ * @return false 
+ */
+bool writeSVGWithOptions(const SVG* img, const char* fileName, const SVGWriteOptions* options) {
     if(img == NULL || fileName == NULL || fileName[0] == '\0' || strlen(fileName) == 0)
         return false;
 
-    if(!extensionMatches(fileName, ".svg")) return false;
-    xmlDoc* doc = SVGtoDOC(img);
-    if(doc == NULL) return false;
+    if(!isSVGFileName(fileName)) return false;
 
-    // Save tree to file
-    xmlSaveFormatFileEnc(fileName, doc, "UTF-8", 1);
+    invalidateCachedSVGData(fileName);
+    invalidateCorpusFile(fileName);
 
-    xmlFreeDoc(doc);
-    xmlCleanupParser();
-    
+    // The struct is written directly, building an xmlDoc is only needed for validation
+    if(!serializeSVG(img, fileName, options)) return false;
+
+    indexWrittenSVG(img, fileName);
     return true;
 }
 
@@ -892,7 +859,7 @@ bool setAttribute(SVG* img, elementType elemType, int elemIndex, Attribute* newA
         return false;
 
     bool success = false;
-    char *floatStripped = checkForUnits(newAttribute->value);
+    markSVGModified(img);
 
     switch (elemType)
     {
@@ -909,6 +876,7 @@ bool setAttribute(SVG* img, elementType elemType, int elemIndex, Attribute* newA
         } else {
             if(!updateAttribute(newAttribute, img->otherAttributes)) {
                 insertBack(img->otherAttributes, newAttribute);
+                img->totals.attributes++;
                 return true;
             } else {
                 success = true;
@@ -926,37 +894,7 @@ bool setAttribute(SVG* img, elementType elemType, int elemIndex, Attribute* newA
         Circle *circle = getCirleAtPos(img->circles, elemIndex);
         if(circle == NULL) return false;
 
-        if(strcmp(newAttribute->name, "cx") == 0) {
-            if(strcasecmp(floatStripped, "invalid") == 0) {
-                return false;
-            }
-            circle->cx = strtof(newAttribute->value, NULL);
-            success = true;
-        } else if(strcmp(newAttribute->name, "cy") == 0) {
-            if(strcasecmp(floatStripped, "invalid") == 0) {
-                return false;
-            }
-            circle->cy = strtof(newAttribute->value, NULL);
-            success = true;
-        } else if(strcmp(newAttribute->name, "r") == 0) {
-            if(strcasecmp(floatStripped, "invalid") == 0) {
-                return false;
-            }
-            circle->r = strtof(newAttribute->value, NULL);
-            success = true;
-        } else {
-            if(!updateAttribute(newAttribute, circle->otherAttributes)) {
-                insertBack(circle->otherAttributes, newAttribute);
-                return true;
-            } else {
-                success = true;
-            }
-        }
-
-        if(!success) return false;
-
-        deleteAttribute(newAttribute);
-        return true;
+        return setCircleAttribute(img, circle, newAttribute);
     case RECT:
         if(elemIndex < 0 || elemIndex >= img->rectangles->length)
             return false;
@@ -964,77 +902,18 @@ bool setAttribute(SVG* img, elementType elemType, int elemIndex, Attribute* newA
         Rectangle *rect = getRectAtPos(img->rectangles, elemIndex);
         if(rect == NULL) return false;
 
-        if(strcmp(newAttribute->name, "x") == 0) {
-            if(strcasecmp(floatStripped, "invalid") == 0) {
-                return false;
-            }
-            rect->x = strtof(newAttribute->value, NULL);
-            success = true;
-        } else if(strcmp(newAttribute->name, "y") == 0) {
-            if(strcasecmp(floatStripped, "invalid") == 0) {
-                return false;
-            }
-            rect->y = strtof(newAttribute->value, NULL);
-            success = true;
-        } else if(strcmp(newAttribute->name, "width") == 0) {
-            if(strcasecmp(floatStripped, "invalid") == 0) {
-                return false;
-            }
-            rect->width = strtof(newAttribute->value, NULL);
-            success = true;
-        } else if(strcmp(newAttribute->name, "height") == 0) {
-            if(strcasecmp(floatStripped, "invalid") == 0) {
-                return false;
-            }
-            rect->height = strtof(newAttribute->value, NULL);
-            success = true;
-        } else {
-            if(!updateAttribute(newAttribute, rect->otherAttributes)) {
-                insertBack(rect->otherAttributes, newAttribute);
-                return true;
-            } else {
-                success = true;
-            }
-        }
-
-        if(!success) return false;
-
-        deleteAttribute(newAttribute);
-        return true;
+        return setRectAttribute(img, rect, newAttribute);
     case PATH:
         if(elemIndex < 0 || elemIndex >= img->paths->length)
             return false;
-            
-        Path* path = NULL;
-
-        if (strcmp(newAttribute->name, "d") == 0) {
-            Node *cur = img->paths->head;
-            int count = 0;
-
-            while(cur) {
-                if(count == elemIndex) {
-                    cur->data = realloc(cur->data, sizeof(Path) + (strlen(newAttribute->value) + 1) * sizeof(char));
-                    strcpy(((Path*)cur->data)->data, newAttribute->value);
-                    break;
-                } 
-                cur = cur->next;
-                count++;
-            }
-            success = true;
-        } else {
-            path = getPathAtPos(img->paths, elemIndex);
-            if(!updateAttribute(newAttribute, path->otherAttributes)) {
-                insertBack(path->otherAttributes, newAttribute);
-                return true;
-            } else {
-                success = true;
-            }
-        }
 
-        if(!success) return false;
-        
-        deleteAttribute(newAttribute);
-        return true;
+        Node *cur = img->paths->head;
+        for(int count = 0; cur && count < elemIndex; count++)
+            cur = cur->next;
+
+        if(cur == NULL) return false;
+
+        return setPathAttribute(img, cur, newAttribute);
     case GROUP:
         if(elemIndex < 0 || elemIndex >= img->groups->length)
             return false;
@@ -1042,18 +921,8 @@ bool setAttribute(SVG* img, elementType elemType, int elemIndex, Attribute* newA
         Group *group = getGroupAtPos(img->groups, elemIndex);
         
         if(group == NULL) return false;
-    
-        if(!updateAttribute(newAttribute, group->otherAttributes)) {
-            insertBack(group->otherAttributes, newAttribute);
-            return true;
-        } else {
-            success = true;
-        }
 
-        if(!success) return false;
-        
-        deleteAttribute(newAttribute);
-        return true;
+        return setGroupAttribute(img, group, newAttribute);
     default:
         return false;
     }
@@ -1070,16 +939,30 @@ bool setAttribute(SVG* img, elementType elemType, int elemIndex, Attribute* newA
  */
 void addComponent(SVG* img, elementType type, void* newElement) {
     if(img == NULL || newElement == NULL) return;
+
+    markSVGModified(img);
     
     if(type == CIRC) {
         Circle *circ = (Circle*)newElement;
         insertBack(img->circles, circ);
+        registerElement(img, CIRC, img->circles->tail);
+        img->totals.circles++;
+        img->totals.attributes += circ->otherAttributes->length;
+        insertAreaKey(img->circleAreas, circleAreaKey(circ));
     } else if(type == RECT) {
         Rectangle *rect = (Rectangle*)newElement;
         insertBack(img->rectangles, rect);
+        registerElement(img, RECT, img->rectangles->tail);
+        img->totals.rects++;
+        img->totals.attributes += rect->otherAttributes->length;
+        insertAreaKey(img->rectAreas, rectAreaKey(rect));
     } else if(type == PATH) {
         Path *path = (Path*)newElement;
         insertBack(img->paths, path);
+        registerElement(img, PATH, img->paths->tail);
+        img->totals.paths++;
+        img->totals.attributes += path->otherAttributes->length;
+        img->totals.pathBytes += strlen(path->data);
     }
 }
 
@@ -1091,12 +974,12 @@ void addComponent(SVG* img, elementType type, void* newElement) {
  */
 char* attrToJSON(const Attribute *a) {
     if(a == NULL) {
-        char *empty = malloc(sizeof(char) * 3);
+        char *empty = svgMalloc(sizeof(char) * 3);
         strcpy(empty, "{}");
         return empty;
     } 
     
-    char *json = malloc(sizeof(char) * (strlen(a->name) + strlen(a->value) + 23)); 
+    char *json = svgMalloc(sizeof(char) * (strlen(a->name) + strlen(a->value) + 23)); 
     sprintf(json, "{\"name\":\"%s\",\"value\":\"%s\"}", a->name, a->value);
     return json;
 }
@@ -1109,14 +992,19 @@ char* attrToJSON(const Attribute *a) {
  */
 char* circleToJSON(const Circle *c) {
     if(c == NULL || c->otherAttributes == NULL) {
-        char *empty = malloc(sizeof(char) * 3);
+        char *empty = svgMalloc(sizeof(char) * 3);
         strcpy(empty, "{}");
         return empty;
     }
 
-    int length = strlen(c->units) + 500;
-    char *json = malloc(sizeof(char) * (length + 1));
-    snprintf(json, length, "{\"cx\":%.2f,\"cy\":%.2f,\"r\":%.2f,\"numAttr\":%d,\"units\":\"%s\"}", c->cx, c->cy, c->r, c->otherAttributes->length, c->units);
+    char cx[FLOAT_STRING_SIZE], cy[FLOAT_STRING_SIZE], r[FLOAT_STRING_SIZE];
+    formatFloat(c->cx, cx);
+    formatFloat(c->cy, cy);
+    formatFloat(c->r, r);
+
+    int length = 500;
+    char *json = svgMalloc(sizeof(char) * (length + 1));
+    snprintf(json, length, "{\"cx\":%s,\"cy\":%s,\"r\":%s,\"numAttr\":%d,\"units\":\"%s\"}", cx, cy, r, c->otherAttributes->length, lengthUnitName(c->units));
 
     return json;
 }
@@ -1129,14 +1017,20 @@ char* circleToJSON(const Circle *c) {
  */
 char* rectToJSON(const Rectangle *r) {
     if(r == NULL || r->otherAttributes == NULL) {
-        char *empty = malloc(sizeof(char) * 3);
+        char *empty = svgMalloc(sizeof(char) * 3);
         strcpy(empty, "{}");
         return empty;
     }
 
-    int length = strlen(r->units) + 1000;
-    char *json = malloc(sizeof(char) * (length + 1));
-    snprintf(json, length, "{\"x\":%.2f,\"y\":%.2f,\"w\":%.2f,\"h\":%.2f,\"numAttr\":%d,\"units\":\"%s\"}", r->x, r->y, r->width, r->height, r->otherAttributes->length, r->units);
+    char x[FLOAT_STRING_SIZE], y[FLOAT_STRING_SIZE], w[FLOAT_STRING_SIZE], h[FLOAT_STRING_SIZE];
+    formatFloat(r->x, x);
+    formatFloat(r->y, y);
+    formatFloat(r->width, w);
+    formatFloat(r->height, h);
+
+    int length = 1000;
+    char *json = svgMalloc(sizeof(char) * (length + 1));
+    snprintf(json, length, "{\"x\":%s,\"y\":%s,\"w\":%s,\"h\":%s,\"numAttr\":%d,\"units\":\"%s\"}", x, y, w, h, r->otherAttributes->length, lengthUnitName(r->units));
 
     return json;
 }
@@ -1149,7 +1043,7 @@ char* rectToJSON(const Rectangle *r) {
  */
 char* pathToJSON(const Path *p) {
     if(p == NULL || p->otherAttributes == NULL) {
-        char *empty = malloc(sizeof(char) * 3);
+        char *empty = svgMalloc(sizeof(char) * 3);
         strcpy(empty, "{}");
         return empty;
     }
@@ -1158,7 +1052,7 @@ char* pathToJSON(const Path *p) {
     snprintf(data, sizeof(data), p->data);
 
     int length = strlen(p->data) + 100;
-    char *json = malloc(sizeof(char) * (length + 1));
+    char *json = svgMalloc(sizeof(char) * (length + 1));
     snprintf(json, length, "{\"d\":\"%s\",\"numAttr\":%d}", data, p->otherAttributes->length);
 
     return json;
@@ -1172,14 +1066,14 @@ char* pathToJSON(const Path *p) {
  */
 char* groupToJSON(const Group *g) {
     if(g == NULL || g->otherAttributes == NULL) {
-        char *empty = malloc(sizeof(char) * 3);
+        char *empty = svgMalloc(sizeof(char) * 3);
         strcpy(empty, "{}");
         return empty;
     }
 
     int num = g->rectangles->length + g->circles->length + g->paths->length + g->groups->length;
 
-    char *json = malloc(sizeof(char) * 250);
+    char *json = svgMalloc(sizeof(char) * 250);
     sprintf(json, "{\"children\":%d,\"numAttr\":%d}", num, g->otherAttributes->length);
 
     return json;
@@ -1193,23 +1087,15 @@ char* groupToJSON(const Group *g) {
  */
 char* SVGtoJSON(const SVG* img) {
     if(img == NULL || img->circles == NULL || img->rectangles == NULL || img->paths == NULL || img->groups == NULL || img->otherAttributes == NULL) {
-        char *empty = malloc(sizeof(char) * 3);
+        char *empty = svgMalloc(sizeof(char) * 3);
         strcpy(empty, "{}");
         return empty;
     }
 
-    List *rects = getRects(img);
-    List *circles = getCircles(img);
-    List *paths = getPaths(img);
-    List *groups = getGroups(img);
-
-    char *json = malloc(sizeof(char) * 500);
-    sprintf(json, "{\"numRect\":%d,\"numCirc\":%d,\"numPaths\":%d,\"numGroups\":%d}", rects->length, circles->length, paths->length, groups->length);
+    SVGTotals totals = getSVGTotals(img);
 
-    freeList(rects);
-    freeList(circles);
-    freeList(paths);
-    freeList(groups);
+    char *json = svgMalloc(sizeof(char) * 500);
+    sprintf(json, "{\"numRect\":%d,\"numCirc\":%d,\"numPaths\":%d,\"numGroups\":%d}", totals.rects, totals.circles, totals.paths, totals.groups);
 
     return json;
 }
@@ -1222,13 +1108,13 @@ char* SVGtoJSON(const SVG* img) {
  */
 char* attrListToJSON(const List *list) {
     if(list == NULL || list->length < 1) {
-        char *empty = malloc(sizeof(char) * 3);
+        char *empty = svgMalloc(sizeof(char) * 3);
         strcpy(empty, "[]");
         return empty;
     }
 
     int length = 2;
-    char *json = malloc(sizeof(char) * length);
+    char *json = svgMalloc(sizeof(char) * length);
     strcpy(json, "[");
 
     Node *cur = list->head;
@@ -1238,15 +1124,15 @@ char* attrListToJSON(const List *list) {
         char *attrJson = attrToJSON(attr);
         length += strlen(attrJson) + 2;
 
-        json = realloc(json, sizeof(char) * length);
+        json = svgRealloc(json, sizeof(char) * length);
         strcat(json, attrJson);
         if(cur->next != NULL) strcat(json, ",");
         
-        free(attrJson);
+        svgFree(attrJson);
         cur = cur->next;
     }
 
-    json = realloc(json, sizeof(char) * length + 1);
+    json = svgRealloc(json, sizeof(char) * length + 1);
     strcat(json, "]");
     
     return json;
@@ -1260,13 +1146,14 @@ char* attrListToJSON(const List *list) {
  */
 char* circListToJSON(const List *list) {
     if(list == NULL || list->length < 1) {
-        char *empty = malloc(sizeof(char) * 3);
+        char *empty = svgMalloc(sizeof(char) * 3);
         strcpy(empty, "[]");
         return empty;
     }
 
+    PhaseTimer start = startPhase();
     int length = 2;
-    char *json = malloc(sizeof(char) * length);
+    char *json = svgMalloc(sizeof(char) * length);
     strcpy(json, "[");
 
     Node *cur = list->head;
@@ -1276,17 +1163,18 @@ char* circListToJSON(const List *list) {
         char *cJson = circleToJSON(c);
         length += strlen(cJson) + 2;
 
-        json = realloc(json, sizeof(char) * length);
+        json = svgRealloc(json, sizeof(char) * length);
         strcat(json, cJson);
         if(cur->next != NULL) strcat(json, ",");
         
-        free(cJson);
+        svgFree(cJson);
         cur = cur->next;
     }
 
-    json = realloc(json, sizeof(char) * length + 1);
+    json = svgRealloc(json, sizeof(char) * length + 1);
     strcat(json, "]");
-    
+
+    endPhase(STAT_JSON, &start, length, list->length);
     return json;
 }
 
@@ -1298,13 +1186,14 @@ char* circListToJSON(const List *list) {
  */
 char* rectListToJSON(const List *list) {
     if(list == NULL || list->length < 1) {
-        char *empty = malloc(sizeof(char) * 3);
+        char *empty = svgMalloc(sizeof(char) * 3);
         strcpy(empty, "[]");
         return empty;
     }
 
+    PhaseTimer start = startPhase();
     int length = 2;
-    char *json = malloc(sizeof(char) * length);
+    char *json = svgMalloc(sizeof(char) * length);
     strcpy(json, "[");
 
     Node *cur = list->head;
@@ -1314,17 +1203,18 @@ char* rectListToJSON(const List *list) {
         char *rectJson = rectToJSON(rect);
         length += strlen(rectJson) + 2;
 
-        json = realloc(json, sizeof(char) * length);
+        json = svgRealloc(json, sizeof(char) * length);
         strcat(json, rectJson);
         if(cur->next != NULL) strcat(json, ",");
         
-        free(rectJson);
+        svgFree(rectJson);
         cur = cur->next;
     }
 
-    json = realloc(json, sizeof(char) * length + 1);
+    json = svgRealloc(json, sizeof(char) * length + 1);
     strcat(json, "]");
-    
+
+    endPhase(STAT_JSON, &start, length, list->length);
     return json;
 }
 
@@ -1336,13 +1226,14 @@ char* rectListToJSON(const List *list) {
  */
 char* pathListToJSON(const List *list) {
     if(list == NULL || list->length < 1) {
-        char *empty = malloc(sizeof(char) * 3);
+        char *empty = svgMalloc(sizeof(char) * 3);
         strcpy(empty, "[]");
         return empty;
     }
 
+    PhaseTimer start = startPhase();
     int length = 2;
-    char *json = malloc(sizeof(char) * length);
+    char *json = svgMalloc(sizeof(char) * length);
     strcpy(json, "[");
 
     Node *cur = list->head;
@@ -1351,16 +1242,17 @@ char* pathListToJSON(const List *list) {
         Path* path = (Path*)cur->data;
         char *pathJson = pathToJSON(path);
         length += strlen(pathJson) + 2;
-        json = realloc(json, sizeof(char) * length);
+        json = svgRealloc(json, sizeof(char) * length);
         strcat(json, pathJson);
         if(cur->next != NULL) strcat(json, ",");
         
-        free(pathJson);
+        svgFree(pathJson);
         cur = cur->next;
     }
-    json = realloc(json, sizeof(char) * length + 1);
+    json = svgRealloc(json, sizeof(char) * length + 1);
     strcat(json, "]");
-    
+
+    endPhase(STAT_JSON, &start, length, list->length);
     return json;
 }
 
@@ -1372,13 +1264,14 @@ char* pathListToJSON(const List *list) {
  */
 char* groupListToJSON(const List *list) {
     if(list == NULL || list->length < 1) {
-        char *empty = malloc(sizeof(char) * 3);
+        char *empty = svgMalloc(sizeof(char) * 3);
         strcpy(empty, "[]");
         return empty;
     }
 
+    PhaseTimer start = startPhase();
     int length = 2;
-    char *json = malloc(sizeof(char) * length);
+    char *json = svgMalloc(sizeof(char) * length);
     strcpy(json, "[");
 
     Node *cur = list->head;
@@ -1388,17 +1281,18 @@ char* groupListToJSON(const List *list) {
         char *gJson = groupToJSON(g);
         length += strlen(gJson) + 2;
 
-        json = realloc(json, sizeof(char) * length);
+        json = svgRealloc(json, sizeof(char) * length);
         strcat(json, gJson);
         if(cur->next != NULL) strcat(json, ",");
         
-        free(gJson);
+        svgFree(gJson);
         cur = cur->next;
     }
 
-    json = realloc(json, sizeof(char) * length + 1);
+    json = svgRealloc(json, sizeof(char) * length + 1);
     strcat(json, "]");
-    
+
+    endPhase(STAT_JSON, &start, length, list->length);
     return json;
 }
 
@@ -1411,7 +1305,7 @@ char* groupListToJSON(const List *list) {
 SVG* JSONtoSVG(const char* svgString) {
     if(svgString == NULL) return NULL;
 
-    SVG *svg = malloc(sizeof(SVG));
+    SVG *svg = svgMalloc(sizeof(SVG));
     svg->rectangles = initializeList(&rectangleToString, &deleteRectangle, &compareRectangles);
     svg->circles = initializeList(&circleToString, &deleteCircle, &compareCircles);
     svg->paths = initializeList(&pathToString, &deletePath, &comparePaths);
@@ -1420,19 +1314,14 @@ SVG* JSONtoSVG(const char* svgString) {
     strcpy(svg->namespace, "http://www.w3.org/2000/svg");
     strcpy(svg->title, "");
     strcpy(svg->description, "");
+    initSVGCaches(svg);
 
-    char *title = extractValue("title", svgString);
-    char *desc = extractValue("descr", svgString);
-
-    if(title != NULL) {
-        snprintf(svg->title, sizeof(svg->title), title);
-        free(title);
-    }
-
-    if(desc != NULL) {
-        snprintf(svg->description, sizeof(svg->description), desc);
-        free(desc);
+    JsonDocument doc;
+    if(parseJSON(svgString, &doc) && doc.tokens[0].type == JSON_OBJECT) {
+        jsonGetString(&doc, jsonObjectGet(&doc, 0, "title"), svg->title, sizeof(svg->title));
+        jsonGetString(&doc, jsonObjectGet(&doc, 0, "descr"), svg->description, sizeof(svg->description));
     }
+    freeJSON(&doc);
 
     return svg;
 }
@@ -1446,40 +1335,13 @@ SVG* JSONtoSVG(const char* svgString) {
 Rectangle* JSONtoRect(const char* svgString) {
     if(svgString == NULL) return NULL;
 
-    Rectangle *rect = malloc(sizeof(Rectangle));
-    rect->otherAttributes = initializeList(&attributeToString, &deleteAttribute, &compareAttributes);
-    rect->x = 0;
-    rect->y = 0;
-    strcpy(rect->units, "");
-
-    char *x = extractIntValue("x", svgString);
-    char *y = extractIntValue("y", svgString);
-    char *w = extractIntValue("w", svgString);
-    char *h = extractIntValue("h", svgString);
-    char *units = extractValue("units", svgString);
-
-    if(x != NULL) {
-        rect->x = strtof(x, NULL);
-    }
-
-    if(y != NULL) {
-        rect->y = strtof(y, NULL);
-    }
-    
-    if(w != NULL) {
-        rect->width = strtof(w, NULL);
-    }
-
-    if(h != NULL) {
-        rect->height = strtof(h, NULL);
-    }
+    JsonDocument doc;
+    Rectangle *rect = NULL;
+    if(parseJSON(svgString, &doc)) rect = rectFromJSON(&doc, 0);
 
-    if(units != NULL) {
-        strcpy(rect->units, units);
-    }
-    
+    freeJSON(&doc);
     return rect;
-}  
+}
 
 /**
  * @brief converts JSON format into a circle struct
@@ -1490,33 +1352,11 @@ Rectangle* JSONtoRect(const char* svgString) {
 Circle* JSONtoCircle(const char* svgString) {
     if(svgString == NULL) return NULL;
 
-    Circle *circ = malloc(sizeof(Circle));
-    circ->otherAttributes = initializeList(&attributeToString, &deleteAttribute, &compareAttributes);
-    circ->cx = 0;
-    circ->cy = 0;
-    strcpy(circ->units, "");
-
-    char *cx = extractIntValue("cx", svgString);
-    char *cy = extractIntValue("cy", svgString);
-    char *r = extractIntValue("r", svgString);
-    char *units = extractValue("units", svgString);
-
-    if(cx != NULL) {
-        circ->cx = strtof(cx, NULL);
-    }
+    JsonDocument doc;
+    Circle *circ = NULL;
+    if(parseJSON(svgString, &doc)) circ = circleFromJSON(&doc, 0);
 
-    if(cy != NULL) {
-        circ->cy = strtof(cy, NULL);
-    }
-    
-    if(r != NULL) {
-        circ->r = strtof(r, NULL);
-    }
-
-    if(units != NULL) {
-        strcpy(circ->units, units);
-    }
-    
+    freeJSON(&doc);
     return circ;
 }  
 
@@ -1563,7 +1403,7 @@ char *createSVGWrapper(char *filename, char *schemaFile) {
 
     if(json == NULL) {
         deleteSVG(svg);
-        free(json);
+        svgFree(json);
         return NULL;
     }
 
@@ -1591,21 +1431,21 @@ char *getSVGRects(char *filename, char *schemaFile) {
     char *svgRects = rectListToJSON(svg->rectangles);
     if(svgRects == NULL) {
         deleteSVG(svg);
-        free(svgRects);
+        svgFree(svgRects);
         return NULL;
     }
 
-    char *json = malloc(sizeof(char) * (strlen(svgRects)+1));
+    char *json = svgMalloc(sizeof(char) * (strlen(svgRects)+1));
     if(json == NULL) {
         deleteSVG(svg);
-        free(svgRects);
-        free(json);
+        svgFree(svgRects);
+        svgFree(json);
         return NULL;
     }
 
     strcpy(json, svgRects);
     
-    free(svgRects);
+    svgFree(svgRects);
     deleteSVG(svg);
     return json;
 }
@@ -1630,20 +1470,20 @@ char *getSVGCircs(char *filename, char *schemaFile) {
     char *svgCircs = circListToJSON(svg->circles);
     if(svgCircs == NULL) {
         deleteSVG(svg);
-        free(svgCircs);
+        svgFree(svgCircs);
         return NULL;
     }
-    char *json = malloc(sizeof(char) * (strlen(svgCircs)+1));
+    char *json = svgMalloc(sizeof(char) * (strlen(svgCircs)+1));
     if(json == NULL) {
         deleteSVG(svg);
-        free(svgCircs);
-        free(json);
+        svgFree(svgCircs);
+        svgFree(json);
         return NULL;
     }
 
     strcpy(json, svgCircs);
     
-    free(svgCircs);
+    svgFree(svgCircs);
     deleteSVG(svg);
 
     return json;
@@ -1669,21 +1509,21 @@ char *getSVGPaths(char *filename, char *schemaFile) {
     char *svgPaths = pathListToJSON(svg->paths);
     if(svgPaths == NULL) {
         deleteSVG(svg);
-        free(svgPaths);
+        svgFree(svgPaths);
         return NULL;
     }
 
-    char *json = malloc(sizeof(char) * (strlen(svgPaths)+1));
+    char *json = svgMalloc(sizeof(char) * (strlen(svgPaths)+1));
     if(json == NULL) {
         deleteSVG(svg);
-        free(svgPaths);
-        free(json);
+        svgFree(svgPaths);
+        svgFree(json);
         return NULL;
     }
 
     strcpy(json, svgPaths);
     
-    free(svgPaths);
+    svgFree(svgPaths);
     deleteSVG(svg);
 
     return json;
@@ -1709,20 +1549,20 @@ char *getSVGGroups(char *filename, char *schemaFile) {
     char *svgGroups = groupListToJSON(svg->groups);
     if(svgGroups == NULL) {
         deleteSVG(svg);
-        free(svgGroups);
+        svgFree(svgGroups);
         return NULL;
     }
 
-    char *json = malloc(sizeof(char) * (strlen(svgGroups)+1));
+    char *json = svgMalloc(sizeof(char) * (strlen(svgGroups)+1));
     if(json == NULL) {
         deleteSVG(svg);
-        free(svgGroups);
-        free(json);
+        svgFree(svgGroups);
+        svgFree(json);
         return NULL;
     }
     strcpy(json, svgGroups);
     
-    free(svgGroups);
+    svgFree(svgGroups);
     deleteSVG(svg);
 
     return json;
@@ -1746,7 +1586,7 @@ char *getSVGTitleAndDesc(char *filename, char *schemaFile) {
     }
     
     int len = strlen(svg->title) + strlen(svg->description) + 3;
-    char *json = malloc(sizeof(char) * len);
+    char *json = svgMalloc(sizeof(char) * len);
     strcpy(json, svg->title);
     strcat(json, ":");
     strcat(json, svg->description);
@@ -1773,7 +1613,7 @@ char *getRectOtherAttributes(char *filename, char *schemaFile) {
     }
 
     int len = 2;
-    char *json = malloc(sizeof(char) * len);
+    char *json = svgMalloc(sizeof(char) * len);
     strcpy(json, "");
 
     Node* cur = svg->rectangles->head;
@@ -1781,10 +1621,10 @@ char *getRectOtherAttributes(char *filename, char *schemaFile) {
         Rectangle *rect = (Rectangle*)cur->data;
         char *tempStr = attrListToJSON(rect->otherAttributes);
         len += strlen(tempStr) + 10;
-        json = realloc(json, sizeof(char) + len);
+        json = svgRealloc(json, sizeof(char) + len);
         strcat(json, tempStr);
         strcat(json, "|");
-        free(tempStr);
+        svgFree(tempStr);
         cur = cur->next;
     }
 
@@ -1810,7 +1650,7 @@ char *getCircOtherAttributes(char *filename, char *schemaFile) {
     }
 
     int len = 2;
-    char *json = malloc(sizeof(char) * len);
+    char *json = svgMalloc(sizeof(char) * len);
     strcpy(json, "");
 
     Node* cur = svg->circles->head;
@@ -1818,10 +1658,10 @@ char *getCircOtherAttributes(char *filename, char *schemaFile) {
         Circle *shape = (Circle*)cur->data;
         char *tempStr = attrListToJSON(shape->otherAttributes);
         len += strlen(tempStr) + 10;
-        json = realloc(json, sizeof(char) + len);
+        json = svgRealloc(json, sizeof(char) + len);
         strcat(json, tempStr);
         strcat(json, "|");
-        free(tempStr);
+        svgFree(tempStr);
         cur = cur->next;
     }
 
@@ -1847,7 +1687,7 @@ char *getPathOtherAttributes(char *filename, char *schemaFile) {
     }
 
     int len = 2;
-    char *json = malloc(sizeof(char) * len);
+    char *json = svgMalloc(sizeof(char) * len);
     strcpy(json, "");
 
     Node* cur = svg->paths->head;
@@ -1855,10 +1695,10 @@ char *getPathOtherAttributes(char *filename, char *schemaFile) {
         Path *shape = (Path*)cur->data;
         char *tempStr = attrListToJSON(shape->otherAttributes);
         len += strlen(tempStr) + 10;
-        json = realloc(json, sizeof(char) + len);
+        json = svgRealloc(json, sizeof(char) + len);
         strcat(json, tempStr);
         strcat(json, "|");
-        free(tempStr);
+        svgFree(tempStr);
         cur = cur->next;
     }
 
@@ -1884,7 +1724,7 @@ char *getGroupOtherAttributes(char *filename, char *schemaFile) {
     }
 
     int len = 2;
-    char *json = malloc(sizeof(char) * len);
+    char *json = svgMalloc(sizeof(char) * len);
     strcpy(json, "");
 
     Node* cur = svg->groups->head;
@@ -1892,10 +1732,10 @@ char *getGroupOtherAttributes(char *filename, char *schemaFile) {
         Group *shape = (Group*)cur->data;
         char *tempStr = attrListToJSON(shape->otherAttributes);
         len += strlen(tempStr) + 10;
-        json = realloc(json, sizeof(char) + len);
+        json = svgRealloc(json, sizeof(char) + len);
         strcat(json, tempStr);
         strcat(json, "|");
-        free(tempStr);
+        svgFree(tempStr);
         cur = cur->next;
     }
 
@@ -1924,8 +1764,8 @@ bool setAttributeWrapper(char *filename, char *schemaFile, char *name, char *val
         return false;
     }
     
-    Attribute *attr = malloc(sizeof(Attribute) + (strlen(value) + 1) * sizeof(char));
-    attr->name = malloc(sizeof(char) * (strlen(name) + 1));
+    Attribute *attr = svgMalloc(sizeof(Attribute) + (strlen(value) + 1) * sizeof(char));
+    attr->name = svgMalloc(sizeof(char) * (strlen(name) + 1));
     strcpy(attr->name, name);
     strcpy(attr->value, value); 
 
@@ -1960,6 +1800,51 @@ bool setAttributeWrapper(char *filename, char *schemaFile, char *name, char *val
     return true;
 }
 
+/**
+ * @brief Set or update attribute of any element, including ones nested in groups
+ * 
+ * @param filename 
+ * @param schemaFile 
+ * @param name 
+ * @param value 
+ * @param id element ID, see buildElementTable for the ordering
+ * @return true 
+ * @return false 
+ */
+bool setAttributeByIDWrapper(char *filename, char *schemaFile, char *name, char *value, int id) {
+    SVG *svg = createValidSVG(filename, schemaFile);
+    
+    bool isValid = validateSVG(svg, schemaFile);
+    if(!isValid) {
+        deleteSVG(svg);
+        return false;
+    }
+    
+    Attribute *attr = svgMalloc(sizeof(Attribute) + (strlen(value) + 1) * sizeof(char));
+    attr->name = svgMalloc(sizeof(char) * (strlen(name) + 1));
+    strcpy(attr->name, name);
+    strcpy(attr->value, value); 
+
+    bool isSet = setAttributeByID(svg, id, attr);
+    if(!isSet) {
+        deleteAttribute(attr);
+        deleteSVG(svg);
+        return false;
+    }
+
+    isValid = validateSVG(svg, schemaFile);
+
+    if(!isValid) {
+        deleteSVG(svg);
+        return false;
+    }
+
+    bool written = writeSVG(svg, filename);   
+    deleteSVG(svg);
+
+    return written;
+}
+
 /**
  * @brief adds a component to svg
  * 
@@ -1979,14 +1864,29 @@ bool addComponentWrapper(char *filename ,char *schemaFile, int elementType, char
         return false;
     }
 
-    if(elementType == RECT) {
-        Rectangle *rect = JSONtoRect(json);
-        addComponent(svg, RECT, rect);
-    } else if(elementType == CIRC) {
-        Circle *circ = JSONtoCircle(json);
-        addComponent(svg, CIRC, circ);
+    // json is either one shape or an array of shapes of the same type
+    JsonDocument doc;
+    if(!parseJSON(json, &doc) || (elementType != RECT && elementType != CIRC)) {
+        freeJSON(&doc);
+        deleteSVG(svg);
+        return false;
     }
 
+    bool isArray = doc.tokens[0].type == JSON_ARRAY;
+    int count = isArray ? doc.tokens[0].size : 1;
+    int token = isArray ? 1 : 0;
+
+    for(int i = 0; i < count; i++, token = doc.tokens[token].next) {
+        void *shape = elementType == RECT ? (void*)rectFromJSON(&doc, token) : (void*)circleFromJSON(&doc, token);
+        if(shape == NULL) {
+            freeJSON(&doc);
+            deleteSVG(svg);
+            return false;
+        }
+        addComponent(svg, elementType, shape);
+    }
+    freeJSON(&doc);
+
     bool written = writeSVG(svg, filename);   
     if(!written) {
         deleteSVG(svg);
@@ -2004,6 +1904,28 @@ bool addComponentWrapper(char *filename ,char *schemaFile, int elementType, char
     return true;
 }
 
+/**
+ * @brief visitor that scales the width and height of a rectangle by the int passed as its context
+ * 
+ * @param element 
+ * @param scaleVal 
+ */
+static void scaleRect(const VisitedElement *element, void *scaleVal) {
+    Rectangle *rect = (Rectangle*)element->data;
+    rect->width *= *(int*)scaleVal;
+    rect->height *= *(int*)scaleVal;
+}
+
+/**
+ * @brief visitor that scales the radius of a circle by the int passed as its context
+ * 
+ * @param element 
+ * @param scaleVal 
+ */
+static void scaleCircle(const VisitedElement *element, void *scaleVal) {
+    ((Circle*)element->data)->r *= *(int*)scaleVal;
+}
+
 /**
  * @brief scales all rects or circs in an svg by scaleval
  * 
@@ -2024,22 +1946,17 @@ bool scaleShape(char *filename, char *schemaFile, int elementType, int scaleVal)
     }
 
     if(elementType == RECT) {
-        Node *cur = svg->rectangles->head;
-        while(cur) {
-            Rectangle *rect = (Rectangle*)cur->data;
-            rect->width *= scaleVal; 
-            rect->height *= scaleVal;
-            cur = cur->next;
-        }
-        scaleRectsInGroups(scaleVal, svg->groups);
+        SVGVisitor visitor = { VISIT_RECTS, 0, NULL, NULL, &scaleRect, &scaleVal };
+        visitSVG(svg, &visitor, 1);
+        invalidateAreaIndexes(svg);
+        invalidateSpatialIndex(svg);
+        invalidateBounds(svg);
     } else if(elementType == CIRC) {
-        Node *cur = svg->circles->head;
-        while(cur) {
-            Circle *c = (Circle*)cur->data;
-            c->r *= scaleVal; 
-            cur = cur->next;
-        }
-        scaleCircsInGroups(scaleVal, svg->groups);
+        SVGVisitor visitor = { VISIT_CIRCLES, 0, NULL, NULL, &scaleCircle, &scaleVal };
+        visitSVG(svg, &visitor, 1);
+        invalidateAreaIndexes(svg);
+        invalidateSpatialIndex(svg);
+        invalidateBounds(svg);
     }
 
     bool written = writeSVG(svg, filename);   
@@ -2050,12 +1967,8 @@ bool scaleShape(char *filename, char *schemaFile, int elementType, int scaleVal)
 
     isValid = validateSVG(svg, schemaFile);
 
-    if(!isValid) {
-        deleteSVG(svg);
-        return false;
-    }
-
-    return true;
+    deleteSVG(svg);
+    return isValid;
 }
 
 /**
@@ -2065,25 +1978,8 @@ bool scaleShape(char *filename, char *schemaFile, int elementType, int scaleVal)
  * @param groups 
  */
 void scaleRectsInGroups(int scaleVal, List *groups) {
-    Node *cur = groups->head;
-
-    while (cur) {
-        Group *g = (Group*)cur->data;
-
-        if(g->rectangles->length > 0) {
-            Node *curRect = g->rectangles->head;
-
-            // Loop until no rectangles in list
-            while(curRect) {
-                Rectangle *rect = (Rectangle*)curRect->data;
-                rect->width *= scaleVal; 
-                rect->height *= scaleVal;
-                curRect = curRect->next;
-            }
-        }
-        scaleRectsInGroups(scaleVal, g->groups);
-        cur = cur->next;
-    }
+    SVGVisitor visitor = { VISIT_RECTS, 0, NULL, NULL, &scaleRect, &scaleVal };
+    visitGroups(groups, &visitor, 1);
 }
 
 /**
@@ -2093,24 +1989,8 @@ void scaleRectsInGroups(int scaleVal, List *groups) {
  * @param groups 
  */
 void scaleCircsInGroups(int scaleVal, List *groups) {
-    Node *cur = groups->head;
-
-    while (cur) {
-        Group *g = (Group*)cur->data;
-
-        if(g->circles->length > 0) {
-            Node *curCirc = g->circles->head;
-
-            // Loop until no circles in list
-            while(curCirc) {
-                Circle *circ = (Circle*)curCirc->data;
-                circ->r *= scaleVal; 
-                curCirc = curCirc->next;
-            }
-        }
-        scaleCircsInGroups(scaleVal, g->groups);
-        cur = cur->next;
-    }
+    SVGVisitor visitor = { VISIT_CIRCLES, 0, NULL, NULL, &scaleCircle, &scaleVal };
+    visitGroups(groups, &visitor, 1);
 }
 
 /**
@@ -2139,10 +2019,6 @@ bool createNewSVG(char *filename, char *schemaFile, char *json) {
 
     isValid = validateSVG(svg, schemaFile);
 
-    if(!isValid) {
-        deleteSVG(svg);
-        return false;
-    }
-
-    return true;
+    deleteSVG(svg);
+    return isValid;
 }
\ No newline at end of file
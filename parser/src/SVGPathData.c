@@ -0,0 +1,248 @@
+/**
+ * @file SVGPathData.c
+ * @author Anthony Vidovic (1130891)
+ * @brief Reads the commands of path data into the lines, curves and arcs they draw, for the bounding boxes and
+ * the rasterizer
+ * @version 0.1
+ * @date 2022-04-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+// ~~~~~ Includes ~~~~~ //
+#include "SVGHelper.h"
+
+/**
+ * @brief skips the whitespace and at most one comma between the numbers of path data
+ *
+ * @param c
+ * @return const char*
+ */
+static const char* skipPathSeparators(const char *c) {
+    while(isspace((unsigned char)*c)) c++;
+    if(*c == ',') c++;
+    while(isspace((unsigned char)*c)) c++;
+
+    return c;
+}
+
+/**
+ * @brief returns the number of numbers a path command takes
+ *
+ * @param command in upper case
+ * @return int -1 if it is not a command
+ */
+static int pathCommandArgs(char command) {
+    switch(command) {
+        case 'Z': return 0;
+        case 'H': case 'V': return 1;
+        case 'M': case 'L': case 'T': return 2;
+        case 'S': case 'Q': return 4;
+        case 'C': return 6;
+        case 'A': return 7;
+        default: return -1;
+    }
+}
+
+/**
+ * @brief reads the numbers of one path command.  The flags of an arc are single digits, which may be written
+ * without separators
+ *
+ * @param c
+ * @param command in upper case
+ * @param args
+ * @return const char* the character after the numbers, or NULL if they cannot be read
+ */
+static const char* readPathArgs(const char *c, char command, double *args) {
+    int numArgs = pathCommandArgs(command);
+
+    for(int i = 0; i < numArgs; i++) {
+        if(i > 0) c = skipPathSeparators(c);
+
+        if(command == 'A' && (i == 3 || i == 4)) {
+            if(*c != '0' && *c != '1') return NULL;
+            args[i] = *c++ == '1';
+            continue;
+        }
+
+        const char *end;
+        args[i] = parseFloat(c, &end);
+        if(end == c) return NULL;
+        c = end;
+    }
+
+    return c;
+}
+
+/**
+ * @brief reads path data into the segments it draws, in absolute coordinates, passing each one to a callback.
+ * Relative commands, implicit repeats and smooth curves are resolved, and quadratic curves are given as the
+ * cubic curves with the same shape.  The data is read up to its first error, as a renderer draws it
+ *
+ * @param data
+ * @param callback
+ * @param context passed to the callback
+ * @return true
+ * @return false if the data has an error, after the segments before it were passed to the callback
+ */
+bool walkPathData(const char *data, PathSegmentCallback callback, void *context) {
+    if(data == NULL) return false;
+
+    double x = 0, y = 0, startX = 0, startY = 0;
+    // Last control point of a curve, reflected by a smooth curve that follows it
+    double controlX = 0, controlY = 0;
+    char command = '\0', previous = '\0';
+
+    const char *c = data;
+    while(true) {
+        c = skipPathSeparators(c);
+        if(*c == '\0') return true;
+
+        if(isalpha((unsigned char)*c)) {
+            command = *c++;
+            if(pathCommandArgs(toupper((unsigned char)command)) < 0) return false;
+        } else if(command == '\0' || toupper((unsigned char)command) == 'Z') {
+            // Data starts with a command, and a close path takes no numbers
+            return false;
+        }
+
+        char upper = toupper((unsigned char)command);
+        double args[7];
+        if(upper != 'Z') {
+            c = readPathArgs(skipPathSeparators(c), upper, args);
+            if(c == NULL) return false;
+        }
+
+        // Relative commands are offsets from the current point
+        double ox = upper == command ? 0 : x, oy = upper == command ? 0 : y;
+        PathSegment segment = { PATH_LINE, { x, x, x, x }, { y, y, y, y }, 0, 0, 0, false, false, false };
+        bool smooth;
+
+        switch(upper) {
+            case 'M':
+                x = startX = ox + args[0];
+                y = startY = oy + args[1];
+                segment.type = PATH_MOVE;
+                // Numbers after a move are lines
+                command = upper == command ? 'L' : 'l';
+                break;
+            case 'Z':
+                x = startX;
+                y = startY;
+                segment.closes = true;
+                break;
+            case 'L': case 'H': case 'V':
+                if(upper != 'V') x = ox + args[0];
+                if(upper != 'H') y = oy + args[upper == 'V' ? 0 : 1];
+                break;
+            case 'C': case 'S':
+                smooth = upper == 'S';
+                segment.type = PATH_CUBIC;
+                segment.x[1] = smooth ? (previous == 'C' || previous == 'S' ? 2 * x - controlX : x) : ox + args[0];
+                segment.y[1] = smooth ? (previous == 'C' || previous == 'S' ? 2 * y - controlY : y) : oy + args[1];
+                segment.x[2] = controlX = ox + args[smooth ? 0 : 2];
+                segment.y[2] = controlY = oy + args[smooth ? 1 : 3];
+                x = ox + args[smooth ? 2 : 4];
+                y = oy + args[smooth ? 3 : 5];
+                break;
+            case 'Q': case 'T':
+                smooth = upper == 'T';
+                segment.type = PATH_CUBIC;
+                controlX = smooth ? (previous == 'Q' || previous == 'T' ? 2 * x - controlX : x) : ox + args[0];
+                controlY = smooth ? (previous == 'Q' || previous == 'T' ? 2 * y - controlY : y) : oy + args[1];
+                x = ox + args[smooth ? 0 : 2];
+                y = oy + args[smooth ? 1 : 3];
+                segment.x[1] = segment.x[0] + 2.0 / 3.0 * (controlX - segment.x[0]);
+                segment.y[1] = segment.y[0] + 2.0 / 3.0 * (controlY - segment.y[0]);
+                segment.x[2] = x + 2.0 / 3.0 * (controlX - x);
+                segment.y[2] = y + 2.0 / 3.0 * (controlY - y);
+                break;
+            case 'A':
+                segment.type = PATH_ARC;
+                segment.rx = args[0];
+                segment.ry = args[1];
+                segment.rotation = args[2];
+                segment.largeArc = args[3] != 0;
+                segment.sweep = args[4] != 0;
+                x = ox + args[5];
+                y = oy + args[6];
+                break;
+        }
+        previous = upper;
+
+        segment.x[3] = x;
+        segment.y[3] = y;
+        if(segment.type == PATH_LINE) {
+            segment.x[2] = x;
+            segment.y[2] = y;
+        }
+        callback(&segment, context);
+    }
+}
+
+/**
+ * @brief finds the ellipse an arc segment is drawn on, as in the conversion from endpoint to centre
+ * parameterization of the SVG implementation notes.  Radii too small to reach the end are scaled up
+ *
+ * @param arc
+ * @param center set to the ellipse and the angles the arc is swept through
+ * @return true
+ * @return false if the arc is drawn as a line, having a radius of 0, or is not drawn, ending where it starts
+ */
+bool getArcCenter(const PathSegment *arc, ArcCenter *center) {
+    double x1 = arc->x[0], y1 = arc->y[0], x2 = arc->x[3], y2 = arc->y[3];
+    double rx = fabs(arc->rx), ry = fabs(arc->ry);
+    if(rx == 0 || ry == 0 || (x1 == x2 && y1 == y2)) return false;
+
+    double phi = fmod(arc->rotation, 360) * M_PI / 180;
+    double cosPhi = cos(phi), sinPhi = sin(phi);
+
+    double dx = (x1 - x2) / 2, dy = (y1 - y2) / 2;
+    double x1p = cosPhi * dx + sinPhi * dy;
+    double y1p = -sinPhi * dx + cosPhi * dy;
+
+    double lambda = (x1p * x1p) / (rx * rx) + (y1p * y1p) / (ry * ry);
+    if(lambda > 1) {
+        rx *= sqrt(lambda);
+        ry *= sqrt(lambda);
+    }
+
+    double num = rx * rx * ry * ry - rx * rx * y1p * y1p - ry * ry * x1p * x1p;
+    double den = rx * rx * y1p * y1p + ry * ry * x1p * x1p;
+    double coef = den > 0 && num > 0 ? sqrt(num / den) : 0;
+    if(arc->largeArc == arc->sweep) coef = -coef;
+
+    double cxp = coef * rx * y1p / ry;
+    double cyp = -coef * ry * x1p / rx;
+
+    center->cx = cosPhi * cxp - sinPhi * cyp + (x1 + x2) / 2;
+    center->cy = sinPhi * cxp + cosPhi * cyp + (y1 + y2) / 2;
+    center->rx = rx;
+    center->ry = ry;
+    center->cosPhi = cosPhi;
+    center->sinPhi = sinPhi;
+
+    center->start = atan2((y1p - cyp) / ry, (x1p - cxp) / rx);
+    double end = atan2((-y1p - cyp) / ry, (-x1p - cxp) / rx);
+    center->delta = end - center->start;
+    if(arc->sweep && center->delta < 0) center->delta += 2 * M_PI;
+    else if(!arc->sweep && center->delta > 0) center->delta -= 2 * M_PI;
+
+    return true;
+}
+
+/**
+ * @brief returns the point of an arc's ellipse at an angle
+ *
+ * @param center
+ * @param angle
+ * @param x
+ * @param y
+ */
+void arcPoint(const ArcCenter *center, double angle, double *x, double *y) {
+    double cosA = cos(angle), sinA = sin(angle);
+
+    *x = center->cx + center->rx * center->cosPhi * cosA - center->ry * center->sinPhi * sinA;
+    *y = center->cy + center->rx * center->sinPhi * cosA + center->ry * center->cosPhi * sinA;
+}
@@ -0,0 +1,1491 @@
+/**
+ * @file SVGRaster.c
+ * @author Anthony Vidovic (1130891)
+ * @brief Draws the rectangles, circles, paths and groups of an svg struct with a scanline rasterizer, and
+ * encodes the pixels as PNG thumbnails
+ * @version 0.1
+ * @date 2022-04-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+// ~~~~~ Includes ~~~~~ //
+#include "SVGHelper.h"
+
+// Scanlines sampled in each row of pixels.  Coverage along a scanline is exact, so this only sets how finely
+// edges that are close to horizontal are smoothed
+#define RASTER_SUBSAMPLES 4
+
+// Farthest, in pixels, the lines a curve or arc is drawn with may stray from it
+#define RASTER_FLATNESS 0.1
+
+// Most lines a single curve, arc or circle is drawn with
+#define MAX_CURVE_STEPS 1024
+
+// Largest width or height of a rendered image
+#define MAX_RASTER_SIZE 4096
+
+// Grey that paint servers the library does not model, such as gradients, are drawn with
+#define UNMODELLED_PAINT 0.5f
+
+// Line from yTop down to yBottom, in pixels.  winding is +1 for lines drawn down the image and -1 for lines drawn up
+typedef struct {
+    double yTop;
+    double yBottom;
+    double xTop;
+    // Change in x for each pixel down
+    double slope;
+    int winding;
+} Edge;
+
+// Outline of a fill or stroke, with the box of its lines
+typedef struct {
+    Edge *edges;
+    int length;
+    int capacity;
+    double minX;
+    double minY;
+    double maxX;
+    double maxY;
+} EdgeList;
+
+// Where a scanline crosses an edge
+typedef struct {
+    double x;
+    int winding;
+} Crossing;
+
+typedef enum { CAP_BUTT, CAP_ROUND, CAP_SQUARE } lineCap;
+
+// Presentation attributes an element is drawn with, after inheriting from the elements enclosing it
+typedef struct {
+    bool fills;
+    float fill[3];
+    bool strokes;
+    float stroke[3];
+    double strokeWidth;
+    lineCap cap;
+    double fillOpacity;
+    double strokeOpacity;
+    // Product of the opacity of the element and of the groups enclosing it
+    double opacity;
+    bool evenOdd;
+    bool hidden;
+    // Set by display="none", which hides an element and everything in it
+    bool notDisplayed;
+    // From the coordinates of the element to those of the svg, the matrix (a b c d e f) of its transform and
+    // the transforms of the groups enclosing it
+    double transform[6];
+} Paint;
+
+// The image being drawn, and the outlines of the shape being drawn into it
+typedef struct {
+    // Premultiplied RGBA
+    float *pixels;
+    int width;
+    int height;
+    // Pixel position of user coordinate (x, y) is ((x - originX) * scale + offsetX, (y - originY) * scale + offsetY)
+    double scale;
+    double originX;
+    double originY;
+    double offsetX;
+    double offsetY;
+
+    // Coverage of the pixels of the row being filled, width + 1 entries.  Pixels a span partly covers are added
+    // to cover, and the pixels it covers completely are added to runs as a change at each end, summed along the row
+    float *cover;
+    float *runs;
+    Crossing *crossings;
+    int crossingsCapacity;
+    int *active;
+    int activeCapacity;
+
+    EdgeList fillEdges;
+    EdgeList strokeEdges;
+    // Pixel coordinates of the points of the subpath being drawn, x and y interleaved
+    double *points;
+    int numPoints;
+    int pointsCapacity;
+    // Whether the shape being drawn is filled or stroked, and half its stroke width in pixels
+    bool filling;
+    bool stroking;
+    double halfWidth;
+    lineCap cap;
+    // Transform of the shape being drawn, see Paint, and the most it stretches a length
+    double transform[6];
+    double stretch;
+
+    // Set when memory runs out, everything after it is dropped
+    bool failed;
+} Renderer;
+
+// Colours that can be given by name.  Other names are treated as if the attribute were not set
+static const struct {
+    const char *name;
+    unsigned char rgb[3];
+} namedColors[] = {
+    { "black", { 0, 0, 0 } },           { "white", { 255, 255, 255 } },     { "red", { 255, 0, 0 } },
+    { "lime", { 0, 255, 0 } },          { "blue", { 0, 0, 255 } },          { "yellow", { 255, 255, 0 } },
+    { "cyan", { 0, 255, 255 } },        { "aqua", { 0, 255, 255 } },        { "magenta", { 255, 0, 255 } },
+    { "fuchsia", { 255, 0, 255 } },     { "silver", { 192, 192, 192 } },    { "gray", { 128, 128, 128 } },
+    { "grey", { 128, 128, 128 } },      { "maroon", { 128, 0, 0 } },        { "olive", { 128, 128, 0 } },
+    { "green", { 0, 128, 0 } },         { "purple", { 128, 0, 128 } },      { "teal", { 0, 128, 128 } },
+    { "navy", { 0, 0, 128 } },          { "orange", { 255, 165, 0 } },      { "pink", { 255, 192, 203 } },
+    { "brown", { 165, 42, 42 } },       { "gold", { 255, 215, 0 } },        { "indigo", { 75, 0, 130 } },
+    { "violet", { 238, 130, 238 } },    { "tan", { 210, 180, 140 } },       { "beige", { 245, 245, 220 } },
+    { "salmon", { 250, 128, 114 } },    { "coral", { 255, 127, 80 } },      { "crimson", { 220, 20, 60 } },
+    { "khaki", { 240, 230, 140 } },     { "turquoise", { 64, 224, 208 } },  { "tomato", { 255, 99, 71 } },
+    { "orchid", { 218, 112, 214 } },    { "plum", { 221, 160, 221 } },      { "chocolate", { 210, 105, 30 } },
+    { "sienna", { 160, 82, 45 } },      { "wheat", { 245, 222, 179 } },     { "ivory", { 255, 255, 240 } },
+    { "lavender", { 230, 230, 250 } },  { "skyblue", { 135, 206, 235 } },   { "steelblue", { 70, 130, 180 } },
+    { "royalblue", { 65, 105, 225 } },  { "darkblue", { 0, 0, 139 } },      { "darkgreen", { 0, 100, 0 } },
+    { "darkred", { 139, 0, 0 } },       { "darkgray", { 169, 169, 169 } },  { "darkgrey", { 169, 169, 169 } },
+    { "lightgray", { 211, 211, 211 } }, { "lightgrey", { 211, 211, 211 } }, { "lightblue", { 173, 216, 230 } },
+    { "lightgreen", { 144, 238, 144 } }, { "darkorange", { 255, 140, 0 } }, { "limegreen", { 50, 205, 50 } },
+    { "forestgreen", { 34, 139, 34 } }, { "firebrick", { 178, 34, 34 } },   { "slategray", { 112, 128, 144 } },
+};
+
+/**
+ * @brief returns the value of a hex digit
+ *
+ * @param c
+ * @return int -1 if it is not a hex digit
+ */
+static int hexValue(char c) {
+    if(c >= '0' && c <= '9') return c - '0';
+    if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/**
+ * @brief reads the channels of an rgb() colour, each a number from 0 to 255 or a percentage
+ *
+ * @param value the text after "rgb("
+ * @param rgb set to the channels, from 0 to 1
+ * @return true
+ * @return false if the colour cannot be read
+ */
+static bool parseRGBFunction(const char *value, float *rgb) {
+    const char *c = value;
+
+    for(int i = 0; i < 3; i++) {
+        while(isspace((unsigned char)*c) || (i > 0 && *c == ',')) c++;
+
+        const char *end;
+        double channel = parseFloat(c, &end);
+        if(end == c) return false;
+        c = end;
+
+        if(*c == '%') {
+            channel = channel * 255 / 100;
+            c++;
+        }
+        rgb[i] = (float)(fmin(fmax(channel, 0), 255) / 255);
+    }
+
+    return true;
+}
+
+/**
+ * @brief reads a paint attribute: none, a colour by hex, rgb() or name, or a paint server
+ *
+ * @param value
+ * @param paints set to false for none
+ * @param rgb set to the colour, from 0 to 1
+ * @return true
+ * @return false if the value cannot be read, leaving the paint as inherited
+ */
+static bool parsePaint(const char *value, bool *paints, float *rgb) {
+    while(isspace((unsigned char)*value)) value++;
+
+    if(strncmp(value, "none", 4) == 0 || strncmp(value, "transparent", 11) == 0) {
+        *paints = false;
+        return true;
+    }
+
+    if(value[0] == '#') {
+        size_t length = 0;
+        while(hexValue(value[1 + length]) >= 0) length++;
+        if(length != 3 && length != 6) return false;
+
+        for(int i = 0; i < 3; i++) {
+            int channel = length == 3 ? hexValue(value[1 + i]) * 17
+                                      : hexValue(value[1 + 2 * i]) * 16 + hexValue(value[2 + 2 * i]);
+            rgb[i] = channel / 255.0f;
+        }
+        *paints = true;
+        return true;
+    }
+
+    if(strncmp(value, "rgb(", 4) == 0) {
+        if(!parseRGBFunction(value + 4, rgb)) return false;
+        *paints = true;
+        return true;
+    }
+
+    // Gradients and patterns are drawn with a flat grey, so the shapes still show
+    if(strncmp(value, "url(", 4) == 0) {
+        rgb[0] = rgb[1] = rgb[2] = UNMODELLED_PAINT;
+        *paints = true;
+        return true;
+    }
+
+    if(strncmp(value, "currentColor", 12) == 0) {
+        rgb[0] = rgb[1] = rgb[2] = 0;
+        *paints = true;
+        return true;
+    }
+
+    size_t length = 0;
+    while(isalpha((unsigned char)value[length])) length++;
+
+    for(size_t i = 0; i < sizeof(namedColors) / sizeof(namedColors[0]); i++) {
+        if(strlen(namedColors[i].name) != length || strncasecmp(namedColors[i].name, value, length) != 0) continue;
+
+        for(int j = 0; j < 3; j++) rgb[j] = namedColors[i].rgb[j] / 255.0f;
+        *paints = true;
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief reads an opacity, clamped to [0, 1]
+ *
+ * @param value
+ * @param opacity left as it is if the value cannot be read
+ */
+static void parseOpacity(const char *value, double *opacity) {
+    const char *end;
+    double parsed = parseFloat(value, &end);
+    if(end == value || !isfinite(parsed)) return;
+
+    if(*end == '%') parsed /= 100;
+    *opacity = fmin(fmax(parsed, 0), 1);
+}
+
+/**
+ * @brief multiplies a transform by another on its right, so that the other is applied first
+ *
+ * @param matrix (a b c d e f), set to the product
+ * @param other
+ */
+static void multiplyTransform(double *matrix, const double *other) {
+    double a = matrix[0] * other[0] + matrix[2] * other[1];
+    double b = matrix[1] * other[0] + matrix[3] * other[1];
+    double c = matrix[0] * other[2] + matrix[2] * other[3];
+    double d = matrix[1] * other[2] + matrix[3] * other[3];
+    double e = matrix[0] * other[4] + matrix[2] * other[5] + matrix[4];
+    double f = matrix[1] * other[4] + matrix[3] * other[5] + matrix[5];
+
+    matrix[0] = a;
+    matrix[1] = b;
+    matrix[2] = c;
+    matrix[3] = d;
+    matrix[4] = e;
+    matrix[5] = f;
+}
+
+/**
+ * @brief reads one function of a transform attribute, such as translate(10 20)
+ *
+ * @param c at the function's name
+ * @param matrix set to the function's matrix
+ * @return const char* the character after the function, or NULL if it cannot be read
+ */
+static const char* parseTransformFunction(const char *c, double *matrix) {
+    static const struct {
+        const char *name;
+        int minArgs;
+        int maxArgs;
+    } functions[] = {
+        { "matrix", 6, 6 }, { "translate", 1, 2 }, { "scale", 1, 2 },
+        { "rotate", 1, 3 }, { "skewX", 1, 1 },     { "skewY", 1, 1 },
+    };
+
+    int function = -1;
+    for(int i = 0; i < (int)(sizeof(functions) / sizeof(functions[0])); i++) {
+        size_t length = strlen(functions[i].name);
+        if(strncmp(c, functions[i].name, length) == 0) {
+            function = i;
+            c += length;
+            break;
+        }
+    }
+    if(function < 0) return NULL;
+
+    while(isspace((unsigned char)*c)) c++;
+    if(*c++ != '(') return NULL;
+
+    double args[6];
+    int numArgs = 0;
+    while(true) {
+        while(isspace((unsigned char)*c) || (numArgs > 0 && *c == ',')) c++;
+        if(*c == ')' || numArgs == functions[function].maxArgs) break;
+
+        const char *end;
+        args[numArgs] = parseFloat(c, &end);
+        if(end == c || !isfinite(args[numArgs])) return NULL;
+        numArgs++;
+        c = end;
+    }
+    if(*c++ != ')' || numArgs < functions[function].minArgs || (function == 3 && numArgs == 2)) return NULL;
+
+    double identity[6] = { 1, 0, 0, 1, 0, 0 };
+    memcpy(matrix, identity, sizeof(identity));
+    double angle = args[0] * M_PI / 180;
+
+    switch(function) {
+        case 0:
+            memcpy(matrix, args, sizeof(args));
+            break;
+        case 1:
+            matrix[4] = args[0];
+            matrix[5] = numArgs > 1 ? args[1] : 0;
+            break;
+        case 2:
+            matrix[0] = args[0];
+            matrix[3] = numArgs > 1 ? args[1] : args[0];
+            break;
+        case 3: {
+            // Rotating about a point is moving the point to the origin, rotating, and moving it back
+            double cx = numArgs > 1 ? args[1] : 0, cy = numArgs > 1 ? args[2] : 0;
+            matrix[0] = cos(angle);
+            matrix[1] = sin(angle);
+            matrix[2] = -sin(angle);
+            matrix[3] = cos(angle);
+            matrix[4] = cx - matrix[0] * cx - matrix[2] * cy;
+            matrix[5] = cy - matrix[1] * cx - matrix[3] * cy;
+            break;
+        }
+        case 4:
+            matrix[2] = tan(angle);
+            break;
+        case 5:
+            matrix[1] = tan(angle);
+            break;
+    }
+
+    return c;
+}
+
+/**
+ * @brief applies a transform attribute, a list of transform functions, to the transform of a paint.  A list
+ * that cannot be read is ignored, as if the attribute were not set
+ *
+ * @param transform
+ * @param value
+ */
+static void applyTransform(double *transform, const char *value) {
+    double list[6] = { 1, 0, 0, 1, 0, 0 };
+
+    const char *c = value;
+    while(true) {
+        while(isspace((unsigned char)*c) || *c == ',') c++;
+        if(*c == '\0') break;
+
+        double function[6];
+        c = parseTransformFunction(c, function);
+        if(c == NULL) return;
+        multiplyTransform(list, function);
+    }
+
+    multiplyTransform(transform, list);
+}
+
+/**
+ * @brief applies one presentation attribute to a paint.  Attributes the rasterizer does not model are ignored
+ *
+ * @param paint
+ * @param name
+ * @param value
+ */
+static void applyPaintAttribute(Paint *paint, const char *name, const char *value) {
+    while(isspace((unsigned char)*value)) value++;
+
+    // An inherited attribute takes the value of the enclosing element, which paint already holds
+    if(strncmp(value, "inherit", 7) == 0) return;
+
+    if(strcmp(name, "fill") == 0) {
+        parsePaint(value, &paint->fills, paint->fill);
+    } else if(strcmp(name, "stroke") == 0) {
+        parsePaint(value, &paint->strokes, paint->stroke);
+    } else if(strcmp(name, "stroke-width") == 0) {
+        const char *end;
+        double width = parseFloat(value, &end);
+        if(end != value && *end != '%' && isfinite(width) && width >= 0) paint->strokeWidth = width;
+    } else if(strcmp(name, "stroke-linecap") == 0) {
+        if(strncmp(value, "round", 5) == 0) paint->cap = CAP_ROUND;
+        else if(strncmp(value, "square", 6) == 0) paint->cap = CAP_SQUARE;
+        else if(strncmp(value, "butt", 4) == 0) paint->cap = CAP_BUTT;
+    } else if(strcmp(name, "fill-opacity") == 0) {
+        parseOpacity(value, &paint->fillOpacity);
+    } else if(strcmp(name, "stroke-opacity") == 0) {
+        parseOpacity(value, &paint->strokeOpacity);
+    } else if(strcmp(name, "opacity") == 0) {
+        // Group opacity is applied to each element in the group rather than to the group as a whole
+        double opacity = 1;
+        parseOpacity(value, &opacity);
+        paint->opacity *= opacity;
+    } else if(strcmp(name, "fill-rule") == 0) {
+        if(strncmp(value, "evenodd", 7) == 0) paint->evenOdd = true;
+        else if(strncmp(value, "nonzero", 7) == 0) paint->evenOdd = false;
+    } else if(strcmp(name, "visibility") == 0) {
+        if(strncmp(value, "visible", 7) == 0) paint->hidden = false;
+        else if(strncmp(value, "hidden", 6) == 0 || strncmp(value, "collapse", 8) == 0) paint->hidden = true;
+    } else if(strcmp(name, "display") == 0) {
+        if(strncmp(value, "none", 4) == 0) paint->notDisplayed = true;
+    } else if(strcmp(name, "transform") == 0) {
+        applyTransform(paint->transform, value);
+    }
+}
+
+/**
+ * @brief applies the declarations of a style attribute, such as "fill:red;stroke-width:2", to a paint
+ *
+ * @param paint
+ * @param style
+ */
+static void applyStyle(Paint *paint, const char *style) {
+    char name[32];
+    char value[128];
+
+    const char *c = style;
+    while(*c != '\0') {
+        while(isspace((unsigned char)*c) || *c == ';') c++;
+
+        size_t nameLength = 0;
+        while(*c != '\0' && *c != ':' && *c != ';') {
+            if(!isspace((unsigned char)*c) && nameLength < sizeof(name) - 1) name[nameLength++] = *c;
+            c++;
+        }
+        name[nameLength] = '\0';
+        if(*c != ':') continue;
+        c++;
+
+        size_t valueLength = 0;
+        while(*c != '\0' && *c != ';') {
+            if(valueLength < sizeof(value) - 1) value[valueLength++] = *c;
+            c++;
+        }
+        value[valueLength] = '\0';
+
+        applyPaintAttribute(paint, name, value);
+    }
+}
+
+/**
+ * @brief returns the paint of an element from the paint of the element enclosing it and its attributes.  A style
+ * attribute overrides the presentation attributes, wherever it is in the list
+ *
+ * @param inherited
+ * @param otherAttributes
+ * @return Paint
+ */
+static Paint paintOf(const Paint *inherited, const List *otherAttributes) {
+    Paint paint = *inherited;
+    const char *style = NULL;
+
+    for(Node *cur = otherAttributes->head; cur; cur = cur->next) {
+        Attribute *attr = (Attribute*)cur->data;
+        if(strcmp(attr->name, "style") == 0) style = attr->value;
+        else applyPaintAttribute(&paint, attr->name, attr->value);
+    }
+    if(style != NULL) applyStyle(&paint, style);
+
+    return paint;
+}
+
+/**
+ * @brief returns the paint elements have when nothing sets their attributes: filled black, without a stroke
+ *
+ * @return Paint
+ */
+static Paint defaultPaint(void) {
+    Paint paint = { true, { 0, 0, 0 }, false, { 0, 0, 0 }, 1, CAP_BUTT, 1, 1, 1, false, false, false,
+                    { 1, 0, 0, 1, 0, 0 } };
+    return paint;
+}
+
+/**
+ * @brief adds a line to an outline, in pixels.  Horizontal lines are left out since no scanline crosses them
+ *
+ * @param renderer
+ * @param list
+ * @param x0
+ * @param y0
+ * @param x1
+ * @param y1
+ */
+static void addEdge(Renderer *renderer, EdgeList *list, double x0, double y0, double x1, double y1) {
+    if(y0 == y1 || !isfinite(x0) || !isfinite(y0) || !isfinite(x1) || !isfinite(y1)) return;
+
+    if(list->length == list->capacity) {
+        Edge *grown = growStack(list->edges, &list->capacity, sizeof(Edge));
+        if(grown == NULL) {
+            renderer->failed = true;
+            return;
+        }
+        list->edges = grown;
+    }
+
+    Edge *edge = &list->edges[list->length++];
+    edge->winding = y1 > y0 ? 1 : -1;
+    edge->yTop = fmin(y0, y1);
+    edge->yBottom = fmax(y0, y1);
+    edge->xTop = y1 > y0 ? x0 : x1;
+    edge->slope = (x1 - x0) / (y1 - y0);
+
+    list->minX = fmin(list->minX, fmin(x0, x1));
+    list->maxX = fmax(list->maxX, fmax(x0, x1));
+    list->minY = fmin(list->minY, edge->yTop);
+    list->maxY = fmax(list->maxY, edge->yBottom);
+}
+
+/**
+ * @brief empties an outline, keeping its memory for the next shape
+ *
+ * @param list
+ */
+static void clearEdges(EdgeList *list) {
+    list->length = 0;
+    list->minX = list->minY = INFINITY;
+    list->maxX = list->maxY = -INFINITY;
+}
+
+/**
+ * @brief orders edges by the row they start on
+ *
+ * @param first
+ * @param second
+ * @return int
+ */
+static int compareEdgeTops(const void *first, const void *second) {
+    double a = ((const Edge*)first)->yTop, b = ((const Edge*)second)->yTop;
+    return (a > b) - (a < b);
+}
+
+/**
+ * @brief orders crossings from left to right
+ *
+ * @param first
+ * @param second
+ * @return int
+ */
+static int compareCrossings(const void *first, const void *second) {
+    double a = ((const Crossing*)first)->x, b = ((const Crossing*)second)->x;
+    return (a > b) - (a < b);
+}
+
+/**
+ * @brief sorts the crossings of a scanline.  A scanline usually crosses a few edges, so insertion sort is used
+ * below a handful
+ *
+ * @param crossings
+ * @param length
+ */
+static void sortCrossings(Crossing *crossings, int length) {
+    if(length > 16) {
+        qsort(crossings, length, sizeof(Crossing), compareCrossings);
+        return;
+    }
+
+    for(int i = 1; i < length; i++) {
+        Crossing crossing = crossings[i];
+        int j = i - 1;
+        while(j >= 0 && crossings[j].x > crossing.x) {
+            crossings[j + 1] = crossings[j];
+            j--;
+        }
+        crossings[j + 1] = crossing;
+    }
+}
+
+/**
+ * @brief adds the part of a scanline from x0 to x1 to the coverage of a row, with exact coverage of the pixels
+ * it partly crosses.  The cost does not depend on the length of the span
+ *
+ * @param cover
+ * @param runs
+ * @param x0
+ * @param x1
+ * @param colStart first column drawn
+ * @param colEnd column after the last one drawn
+ * @param weight coverage of a pixel the span crosses completely
+ */
+static void addSpan(float *cover, float *runs, double x0, double x1, int colStart, int colEnd, float weight) {
+    x0 = fmax(x0, colStart);
+    x1 = fmin(x1, colEnd);
+    if(x1 <= x0) return;
+
+    int first = (int)x0, last = (int)x1;
+    if(first == last) {
+        cover[first] += (float)(x1 - x0) * weight;
+        return;
+    }
+
+    cover[first] += (float)(first + 1 - x0) * weight;
+    runs[first + 1] += weight;
+    runs[last] -= weight;
+    cover[last] += (float)(x1 - last) * weight;
+}
+
+/**
+ * @brief makes sure the scratch arrays of a fill hold an entry for every edge of an outline
+ *
+ * @param renderer
+ * @param length
+ * @return true
+ * @return false if they cannot grow
+ */
+static bool reserveFillScratch(Renderer *renderer, int length) {
+    while(renderer->activeCapacity < length) {
+        int *grown = growStack(renderer->active, &renderer->activeCapacity, sizeof(int));
+        if(grown == NULL) return false;
+        renderer->active = grown;
+    }
+    while(renderer->crossingsCapacity < length) {
+        Crossing *grown = growStack(renderer->crossings, &renderer->crossingsCapacity, sizeof(Crossing));
+        if(grown == NULL) return false;
+        renderer->crossings = grown;
+    }
+
+    return true;
+}
+
+/**
+ * @brief fills an outline with a colour, row by row.  Each row is sampled with RASTER_SUBSAMPLES scanlines, each
+ * crossing the edges active at its height, and the parts of the scanlines inside the outline are added to the
+ * coverage of the row before it is blended into the image.  Only the columns the spans of a row touch are blended
+ * and cleared, so a thin outline costs little however large its box
+ *
+ * @param renderer
+ * @param list
+ * @param evenOdd true for the evenodd fill rule, false for nonzero
+ * @param rgb
+ * @param alpha
+ */
+static void fillOutline(Renderer *renderer, EdgeList *list, bool evenOdd, const float *rgb, float alpha) {
+    if(list->length == 0 || alpha <= 0) return;
+
+    int rowStart = (int)fmax(floor(list->minY), 0);
+    int rowEnd = (int)fmin(ceil(list->maxY), renderer->height);
+    int colStart = (int)fmax(floor(list->minX), 0);
+    int colEnd = (int)fmin(ceil(list->maxX), renderer->width);
+    if(rowStart >= rowEnd || colStart >= colEnd) return;
+
+    if(!reserveFillScratch(renderer, list->length)) {
+        renderer->failed = true;
+        return;
+    }
+
+    qsort(list->edges, list->length, sizeof(Edge), compareEdgeTops);
+
+    const Edge *edges = list->edges;
+    int *active = renderer->active;
+    Crossing *crossings = renderer->crossings;
+    float *cover = renderer->cover;
+    float *runs = renderer->runs;
+    int next = 0, numActive = 0;
+
+    for(int row = rowStart; row < rowEnd; row++) {
+        // Columns the spans of the row touch, the coverage of the rest being left at 0
+        int touchedStart = colEnd, touchedEnd = colStart - 1;
+
+        for(int sample = 0; sample < RASTER_SUBSAMPLES; sample++) {
+            double y = row + (sample + 0.5) / RASTER_SUBSAMPLES;
+            while(next < list->length && edges[next].yTop <= y) active[numActive++] = next++;
+
+            // Edges the scanline has passed the bottom of are dropped as the crossings are found
+            int numCrossings = 0, kept = 0;
+            for(int i = 0; i < numActive; i++) {
+                const Edge *edge = &edges[active[i]];
+                if(edge->yBottom <= y) continue;
+
+                active[kept++] = active[i];
+                crossings[numCrossings].x = edge->xTop + (y - edge->yTop) * edge->slope;
+                crossings[numCrossings].winding = edge->winding;
+                numCrossings++;
+            }
+            numActive = kept;
+
+            sortCrossings(crossings, numCrossings);
+
+            int winding = 0;
+            double spanStart = 0;
+            for(int i = 0; i < numCrossings; i++) {
+                bool wasInside = evenOdd ? (winding & 1) != 0 : winding != 0;
+                winding += crossings[i].winding;
+                bool inside = evenOdd ? (winding & 1) != 0 : winding != 0;
+
+                if(!wasInside && inside) spanStart = crossings[i].x;
+                else if(wasInside && !inside) {
+                    addSpan(cover, runs, spanStart, crossings[i].x, colStart, colEnd, 1.0f / RASTER_SUBSAMPLES);
+                    touchedStart = (int)fmin(touchedStart, fmax(spanStart, colStart));
+                    touchedEnd = (int)fmax(touchedEnd, fmin(crossings[i].x, colEnd));
+                }
+            }
+        }
+        if(touchedStart > touchedEnd) continue;
+
+        float *pixel = renderer->pixels + ((size_t)row * renderer->width + touchedStart) * 4;
+        float run = 0;
+        for(int col = touchedStart; col <= touchedEnd && col < colEnd; col++, pixel += 4) {
+            run += runs[col];
+            float coverage = run + cover[col];
+            if(coverage <= 0) continue;
+
+            float a = (coverage < 1 ? coverage : 1) * alpha;
+            pixel[0] = rgb[0] * a + pixel[0] * (1 - a);
+            pixel[1] = rgb[1] * a + pixel[1] * (1 - a);
+            pixel[2] = rgb[2] * a + pixel[2] * (1 - a);
+            pixel[3] = a + pixel[3] * (1 - a);
+        }
+
+        memset(cover + touchedStart, 0, sizeof(float) * (touchedEnd - touchedStart + 1));
+        memset(runs + touchedStart, 0, sizeof(float) * (touchedEnd - touchedStart + 1));
+    }
+}
+
+/**
+ * @brief returns how many lines an arc of a circle is drawn with, so that none strays more than RASTER_FLATNESS
+ * pixels from it
+ *
+ * @param radius in pixels
+ * @param angle swept by the arc, in radians
+ * @return int
+ */
+static int arcSteps(double radius, double angle) {
+    if(!(radius > RASTER_FLATNESS)) return 4;
+
+    double step = 2 * acos(1 - RASTER_FLATNESS / radius);
+    double steps = ceil(fabs(angle) / step);
+
+    if(!(steps < MAX_CURVE_STEPS)) return MAX_CURVE_STEPS;
+    return steps < 4 ? 4 : (int)steps;
+}
+
+/**
+ * @brief adds a polygon approximating a disc to the stroke outline, drawn in the same direction as the stroke's
+ * line segments so that overlapping parts do not cancel out
+ *
+ * @param renderer
+ * @param x centre, in pixels
+ * @param y
+ */
+static void addStrokeDisc(Renderer *renderer, double x, double y) {
+    double r = renderer->halfWidth;
+    int steps = arcSteps(r, 2 * M_PI);
+
+    double prevX = x + r, prevY = y;
+    for(int i = 1; i <= steps; i++) {
+        double angle = -2 * M_PI * i / steps;
+        double nextX = x + r * cos(angle), nextY = y + r * sin(angle);
+        addEdge(renderer, &renderer->strokeEdges, prevX, prevY, nextX, nextY);
+        prevX = nextX;
+        prevY = nextY;
+    }
+}
+
+/**
+ * @brief adds the rectangle a stroke covers along a line segment, extended past its ends by the given lengths
+ *
+ * @param renderer
+ * @param x0
+ * @param y0
+ * @param x1
+ * @param y1
+ * @param extendStart
+ * @param extendEnd
+ */
+static void addStrokeSegment(Renderer *renderer, double x0, double y0, double x1, double y1, double extendStart,
+                             double extendEnd) {
+    double length = hypot(x1 - x0, y1 - y0);
+    if(length == 0) return;
+
+    double ux = (x1 - x0) / length, uy = (y1 - y0) / length;
+    x0 -= ux * extendStart;
+    y0 -= uy * extendStart;
+    x1 += ux * extendEnd;
+    y1 += uy * extendEnd;
+
+    double nx = -uy * renderer->halfWidth, ny = ux * renderer->halfWidth;
+    EdgeList *list = &renderer->strokeEdges;
+    addEdge(renderer, list, x0 + nx, y0 + ny, x1 + nx, y1 + ny);
+    addEdge(renderer, list, x1 + nx, y1 + ny, x1 - nx, y1 - ny);
+    addEdge(renderer, list, x1 - nx, y1 - ny, x0 - nx, y0 - ny);
+    addEdge(renderer, list, x0 - nx, y0 - ny, x0 + nx, y0 + ny);
+}
+
+/**
+ * @brief returns true if the turn between two segments meeting at a point leaves a gap in the stroke wide
+ * enough to see, so that the point needs a round join
+ *
+ * @param renderer
+ * @param points
+ * @param before index of the point before the join
+ * @param at index of the join
+ * @param after index of the point after it
+ * @return true
+ * @return false
+ */
+static bool needsJoin(const Renderer *renderer, const double *points, int before, int at, int after) {
+    double ax = points[2 * at] - points[2 * before], ay = points[2 * at + 1] - points[2 * before + 1];
+    double bx = points[2 * after] - points[2 * at], by = points[2 * after + 1] - points[2 * at + 1];
+    double lengths = hypot(ax, ay) * hypot(bx, by);
+    if(lengths == 0) return false;
+
+    // The gap is about the half width times the sine of the turn, or the whole width when the stroke turns back
+    double sine = fabs(ax * by - ay * bx) / lengths;
+    bool turnsBack = ax * bx + ay * by < 0;
+
+    return turnsBack || renderer->halfWidth * sine > RASTER_FLATNESS;
+}
+
+/**
+ * @brief adds the stroke of the subpath being drawn to the stroke outline.  Joins are round, and the ends of an
+ * open subpath are capped as its stroke-linecap says
+ *
+ * @param renderer
+ * @param closed
+ */
+static void strokeSubpath(Renderer *renderer, bool closed) {
+    const double *points = renderer->points;
+    int numPoints = renderer->numPoints;
+
+    // A closed subpath ends where it starts, that point is its last join
+    if(closed && numPoints > 1 && points[0] == points[2 * numPoints - 2] && points[1] == points[2 * numPoints - 1])
+        numPoints--;
+
+    if(numPoints == 1 || (numPoints == 2 && closed && points[0] == points[2] && points[1] == points[3])) {
+        // A subpath of a single point only shows with round or square caps
+        if(!closed && renderer->cap == CAP_ROUND) addStrokeDisc(renderer, points[0], points[1]);
+        else if(!closed && renderer->cap == CAP_SQUARE) {
+            double h = renderer->halfWidth;
+            addStrokeSegment(renderer, points[0] - h, points[1], points[0] + h, points[1], 0, 0);
+        }
+        return;
+    }
+
+    int numSegments = closed ? numPoints : numPoints - 1;
+    double squareCap = renderer->cap == CAP_SQUARE && !closed ? renderer->halfWidth : 0;
+
+    for(int i = 0; i < numSegments; i++) {
+        int next = (i + 1) % numPoints;
+        addStrokeSegment(renderer, points[2 * i], points[2 * i + 1], points[2 * next], points[2 * next + 1],
+                         i == 0 ? squareCap : 0, i == numSegments - 1 ? squareCap : 0);
+    }
+
+    for(int i = closed ? 0 : 1; i < (closed ? numPoints : numPoints - 1); i++) {
+        int before = (i + numPoints - 1) % numPoints, after = (i + 1) % numPoints;
+        if(needsJoin(renderer, points, before, i, after)) addStrokeDisc(renderer, points[2 * i], points[2 * i + 1]);
+    }
+
+    if(!closed && renderer->cap == CAP_ROUND) {
+        addStrokeDisc(renderer, points[0], points[1]);
+        addStrokeDisc(renderer, points[2 * numPoints - 2], points[2 * numPoints - 1]);
+    }
+}
+
+/**
+ * @brief ends the subpath being drawn: an open subpath is closed for its fill, and its stroke is added
+ *
+ * @param renderer
+ * @param closed true if the subpath was closed with a close path command
+ */
+static void endSubpath(Renderer *renderer, bool closed) {
+    int numPoints = renderer->numPoints;
+    if(numPoints == 0) return;
+
+    const double *points = renderer->points;
+    if(renderer->filling && !closed)
+        addEdge(renderer, &renderer->fillEdges, points[2 * numPoints - 2], points[2 * numPoints - 1], points[0],
+                points[1]);
+    if(renderer->stroking) strokeSubpath(renderer, closed);
+
+    renderer->numPoints = 0;
+}
+
+/**
+ * @brief adds a point to the subpath being drawn, and the line to it to the fill outline
+ *
+ * @param renderer
+ * @param x in pixels
+ * @param y
+ */
+static void lineTo(Renderer *renderer, double x, double y) {
+    if(renderer->numPoints > 0) {
+        const double *last = &renderer->points[2 * renderer->numPoints - 2];
+        if(last[0] == x && last[1] == y) return;
+        if(renderer->filling) addEdge(renderer, &renderer->fillEdges, last[0], last[1], x, y);
+    }
+
+    if(!renderer->stroking && renderer->numPoints >= 1) {
+        // Only the first and last points are needed to close a fill
+        if(renderer->numPoints == 1) renderer->numPoints = 2;
+        renderer->points[2] = x;
+        renderer->points[3] = y;
+        return;
+    }
+
+    if(2 * renderer->numPoints + 2 > renderer->pointsCapacity) {
+        double *grown = growStack(renderer->points, &renderer->pointsCapacity, sizeof(double));
+        if(grown == NULL) {
+            renderer->failed = true;
+            return;
+        }
+        renderer->points = grown;
+    }
+
+    renderer->points[2 * renderer->numPoints] = x;
+    renderer->points[2 * renderer->numPoints + 1] = y;
+    renderer->numPoints++;
+}
+
+/**
+ * @brief starts a new subpath at a point
+ *
+ * @param renderer
+ * @param x in pixels
+ * @param y
+ */
+static void moveTo(Renderer *renderer, double x, double y) {
+    endSubpath(renderer, false);
+    lineTo(renderer, x, y);
+}
+
+/**
+ * @brief returns the pixel position of a point in user coordinates
+ *
+ * @param renderer
+ * @param x
+ * @param y
+ * @param px
+ * @param py
+ */
+static void toPixels(const Renderer *renderer, double x, double y, double *px, double *py) {
+    const double *m = renderer->transform;
+    double svgX = m[0] * x + m[2] * y + m[4], svgY = m[1] * x + m[3] * y + m[5];
+
+    *px = (svgX - renderer->originX) * renderer->scale + renderer->offsetX;
+    *py = (svgY - renderer->originY) * renderer->scale + renderer->offsetY;
+}
+
+/**
+ * @brief draws a cubic Bezier curve as lines, enough that none strays more than RASTER_FLATNESS pixels from it
+ *
+ * @param renderer
+ * @param x the start, control points and end, in pixels
+ * @param y
+ */
+static void cubicTo(Renderer *renderer, const double *x, const double *y) {
+    double dd = fmax(hypot(x[0] - 2 * x[1] + x[2], y[0] - 2 * y[1] + y[2]),
+                     hypot(x[1] - 2 * x[2] + x[3], y[1] - 2 * y[2] + y[3]));
+    double steps = ceil(sqrt(0.75 * dd / RASTER_FLATNESS));
+    int numSteps = !(steps < MAX_CURVE_STEPS) ? MAX_CURVE_STEPS : (steps < 1 ? 1 : (int)steps);
+
+    for(int i = 1; i <= numSteps; i++) {
+        double t = (double)i / numSteps, u = 1 - t;
+        double w0 = u * u * u, w1 = 3 * u * u * t, w2 = 3 * u * t * t, w3 = t * t * t;
+        lineTo(renderer, w0 * x[0] + w1 * x[1] + w2 * x[2] + w3 * x[3], w0 * y[0] + w1 * y[1] + w2 * y[2] + w3 * y[3]);
+    }
+}
+
+/**
+ * @brief draws the segments of path data, passed as the PathSegmentCallback of walkPathData
+ *
+ * @param segment
+ * @param context the Renderer
+ */
+static void drawPathSegment(const PathSegment *segment, void *context) {
+    Renderer *renderer = (Renderer*)context;
+    double x, y;
+
+    if(segment->type == PATH_MOVE) {
+        toPixels(renderer, segment->x[3], segment->y[3], &x, &y);
+        moveTo(renderer, x, y);
+        return;
+    }
+
+    // A subpath that follows a close path starts where the closed one did
+    if(renderer->numPoints == 0) {
+        toPixels(renderer, segment->x[0], segment->y[0], &x, &y);
+        lineTo(renderer, x, y);
+    }
+
+    ArcCenter center;
+    if(segment->type == PATH_CUBIC) {
+        double px[4], py[4];
+        for(int i = 0; i < 4; i++) toPixels(renderer, segment->x[i], segment->y[i], &px[i], &py[i]);
+        cubicTo(renderer, px, py);
+    } else if(segment->type == PATH_ARC && getArcCenter(segment, &center)) {
+        int steps = arcSteps(fmax(center.rx, center.ry) * renderer->stretch * renderer->scale, center.delta);
+        for(int i = 1; i <= steps; i++) {
+            arcPoint(&center, center.start + center.delta * i / steps, &x, &y);
+            toPixels(renderer, x, y, &x, &y);
+            lineTo(renderer, x, y);
+        }
+    } else {
+        toPixels(renderer, segment->x[3], segment->y[3], &x, &y);
+        lineTo(renderer, x, y);
+    }
+
+    if(segment->closes) endSubpath(renderer, true);
+}
+
+/**
+ * @brief builds the outlines of a rectangle, circle or path
+ *
+ * @param renderer
+ * @param type
+ * @param element
+ */
+static void buildOutline(Renderer *renderer, elementType type, const void *element) {
+    double x, y;
+
+    if(type == RECT) {
+        const Rectangle *r = (const Rectangle*)element;
+        if(!(r->width > 0 && r->height > 0)) return;
+
+        const double corners[4][2] = { { r->x, r->y }, { r->x + r->width, r->y },
+                                       { r->x + r->width, r->y + r->height }, { r->x, r->y + r->height } };
+        for(int i = 0; i < 4; i++) {
+            toPixels(renderer, corners[i][0], corners[i][1], &x, &y);
+            if(i == 0) moveTo(renderer, x, y);
+            else lineTo(renderer, x, y);
+        }
+        toPixels(renderer, corners[0][0], corners[0][1], &x, &y);
+        lineTo(renderer, x, y);
+        endSubpath(renderer, true);
+    } else if(type == CIRC) {
+        const Circle *c = (const Circle*)element;
+        if(!(c->r > 0)) return;
+
+        int steps = arcSteps(c->r * renderer->stretch * renderer->scale, 2 * M_PI);
+        for(int i = 0; i <= steps; i++) {
+            // The last point is the first, exactly
+            double angle = 2 * M_PI * (i % steps) / steps;
+            toPixels(renderer, c->cx + c->r * cos(angle), c->cy + c->r * sin(angle), &x, &y);
+            if(i == 0) moveTo(renderer, x, y);
+            else lineTo(renderer, x, y);
+        }
+        endSubpath(renderer, true);
+    } else if(type == PATH) {
+        walkPathData(((const Path*)element)->data, drawPathSegment, renderer);
+        endSubpath(renderer, false);
+    }
+}
+
+/**
+ * @brief draws a rectangle, circle or path: its fill, then its stroke over it
+ *
+ * @param renderer
+ * @param type
+ * @param element
+ * @param paint
+ */
+static void drawShape(Renderer *renderer, elementType type, const void *element, const Paint *paint) {
+    if(renderer->failed || paint->hidden || paint->notDisplayed) return;
+
+    renderer->filling = paint->fills && paint->fillOpacity * paint->opacity > 0;
+    renderer->stroking = paint->strokes && paint->strokeWidth > 0 && paint->strokeOpacity * paint->opacity > 0;
+    if(!renderer->filling && !renderer->stroking) return;
+
+    // A stroke is scaled by the area its transform scales by, and curves are drawn for the most it stretches
+    const double *m = paint->transform;
+    memcpy(renderer->transform, m, sizeof(renderer->transform));
+    renderer->stretch = fmax(hypot(m[0], m[1]), hypot(m[2], m[3]));
+    renderer->halfWidth = paint->strokeWidth * sqrt(fabs(m[0] * m[3] - m[1] * m[2])) * renderer->scale / 2;
+    renderer->cap = paint->cap;
+    renderer->numPoints = 0;
+    clearEdges(&renderer->fillEdges);
+    clearEdges(&renderer->strokeEdges);
+
+    buildOutline(renderer, type, element);
+
+    float fillAlpha = (float)(paint->fillOpacity * paint->opacity);
+    float strokeAlpha = (float)(paint->strokeOpacity * paint->opacity);
+    if(renderer->filling) fillOutline(renderer, &renderer->fillEdges, paint->evenOdd, paint->fill, fillAlpha);
+    if(renderer->stroking) fillOutline(renderer, &renderer->strokeEdges, false, paint->stroke, strokeAlpha);
+}
+
+/**
+ * @brief draws the shapes held directly by the svg struct or a group, in the order writeSVG writes them
+ *
+ * @param renderer
+ * @param rectangles
+ * @param circles
+ * @param paths
+ * @param inherited paint of the svg struct or group
+ */
+static void drawShapes(Renderer *renderer, const List *rectangles, const List *circles, const List *paths,
+                       const Paint *inherited) {
+    const List *lists[] = { rectangles, circles, paths };
+    const elementType listTypes[] = { RECT, CIRC, PATH };
+
+    for(int i = 0; i < 3; i++) {
+        for(Node *cur = lists[i]->head; cur; cur = cur->next) {
+            List *otherAttributes = listTypes[i] == RECT ? ((Rectangle*)cur->data)->otherAttributes
+                                  : listTypes[i] == CIRC ? ((Circle*)cur->data)->otherAttributes
+                                                         : ((Path*)cur->data)->otherAttributes;
+            Paint paint = paintOf(inherited, otherAttributes);
+            drawShape(renderer, listTypes[i], cur->data, &paint);
+        }
+    }
+}
+
+/**
+ * @brief draws every element of an svg struct.  Groups are drawn in the order of a group walk, each with the
+ * paint it inherits from the groups enclosing it
+ *
+ * @param renderer
+ * @param svg
+ */
+static void drawSVG(Renderer *renderer, const SVG *svg) {
+    Paint defaults = defaultPaint();
+    Paint root = paintOf(&defaults, svg->otherAttributes);
+    if(root.notDisplayed) return;
+
+    drawShapes(renderer, svg->rectangles, svg->circles, svg->paths, &root);
+
+    // Paint of the group returned at each level of the walk
+    Paint *paints = NULL;
+    int numPaints = 0;
+    GroupWalk walk;
+    beginGroupWalk(&walk, svg->groups);
+
+    for(Group *g = nextGroup(&walk); g && !renderer->failed; g = nextGroup(&walk)) {
+        if(walk.depth > numPaints) {
+            Paint *grown = growStack(paints, &numPaints, sizeof(Paint));
+            if(grown == NULL) {
+                renderer->failed = true;
+                break;
+            }
+            paints = grown;
+        }
+
+        paints[walk.depth - 1] = paintOf(walk.depth > 1 ? &paints[walk.depth - 2] : &root, g->otherAttributes);
+        if(paints[walk.depth - 1].notDisplayed) {
+            skipNestedGroups(&walk);
+            continue;
+        }
+
+        drawShapes(renderer, g->rectangles, g->circles, g->paths, &paints[walk.depth - 1]);
+    }
+
+    if(walk.failed) renderer->failed = true;
+    endGroupWalk(&walk);
+    svgFree(paints);
+}
+
+/**
+ * @brief finds the part of the user coordinates an image shows: the svg's viewBox, then its width and height,
+ * and otherwise the box of everything it draws
+ *
+ * @param svg
+ * @param view set to the area shown
+ * @return true
+ * @return false if there is nothing to show
+ */
+static bool getViewArea(const SVG *svg, BoundingBox *view) {
+    const char *viewBox = NULL, *width = NULL, *height = NULL;
+    for(Node *cur = svg->otherAttributes->head; cur; cur = cur->next) {
+        Attribute *attr = (Attribute*)cur->data;
+        if(strcmp(attr->name, "viewBox") == 0) viewBox = attr->value;
+        else if(strcmp(attr->name, "width") == 0) width = attr->value;
+        else if(strcmp(attr->name, "height") == 0) height = attr->value;
+    }
+
+    if(viewBox != NULL) {
+        double numbers[4];
+        const char *c = viewBox;
+        int found = 0;
+        for(; found < 4; found++) {
+            while(isspace((unsigned char)*c) || *c == ',') c++;
+            const char *end;
+            numbers[found] = parseFloat(c, &end);
+            if(end == c || !isfinite(numbers[found])) break;
+            c = end;
+        }
+
+        if(found == 4 && numbers[2] > 0 && numbers[3] > 0) {
+            *view = (BoundingBox){ numbers[0], numbers[1], numbers[0] + numbers[2], numbers[1] + numbers[3] };
+            return true;
+        }
+    }
+
+    if(width != NULL && height != NULL) {
+        const char *widthEnd, *heightEnd;
+        double w = parseFloat(width, &widthEnd), h = parseFloat(height, &heightEnd);
+
+        // Percentages are of a viewport the library does not know
+        if(widthEnd != width && heightEnd != height && *widthEnd != '%' && *heightEnd != '%' && w > 0 && h > 0 &&
+           isfinite(w) && isfinite(h)) {
+            *view = (BoundingBox){ 0, 0, w, h };
+            return true;
+        }
+    }
+
+    return getSVGBounds(svg, view) && view->maxX > view->minX && view->maxY > view->minY;
+}
+
+/**
+ * @brief frees the memory of a renderer
+ *
+ * @param renderer
+ */
+static void freeRenderer(Renderer *renderer) {
+    svgFree(renderer->pixels);
+    svgFree(renderer->cover);
+    svgFree(renderer->runs);
+    svgFree(renderer->crossings);
+    svgFree(renderer->active);
+    svgFree(renderer->fillEdges.edges);
+    svgFree(renderer->strokeEdges.edges);
+    svgFree(renderer->points);
+}
+
+/**
+ * @brief draws an svg struct into an image that fits in maxWidth by maxHeight pixels, keeping the proportions of
+ * the area it shows (see getViewArea).  Rectangles, circles and paths are filled and stroked with the fill,
+ * stroke, opacity, fill-rule, stroke-width, stroke-linecap, visibility, display and transform they have or
+ * inherit, as attributes or in a style attribute.  Units and clipping are not modelled, paint servers are drawn
+ * in grey, and joins are round
+ *
+ * @param svg
+ * @param maxWidth
+ * @param maxHeight
+ * @param width set to the width of the image
+ * @param height set to the height of the image
+ * @return unsigned char* width * height RGBA pixels, top row first and not premultiplied, or NULL if the image
+ * cannot be allocated
+ */
+unsigned char* rasterizeSVG(const SVG *svg, int maxWidth, int maxHeight, int *width, int *height) {
+    if(svg == NULL || maxWidth < 1 || maxHeight < 1 || width == NULL || height == NULL) return NULL;
+    if(maxWidth > MAX_RASTER_SIZE) maxWidth = MAX_RASTER_SIZE;
+    if(maxHeight > MAX_RASTER_SIZE) maxHeight = MAX_RASTER_SIZE;
+
+    Renderer renderer;
+    memset(&renderer, 0, sizeof(Renderer));
+    renderer.width = maxWidth;
+    renderer.height = maxHeight;
+
+    BoundingBox view;
+    bool hasView = getViewArea(svg, &view);
+    if(hasView) {
+        double viewWidth = (double)view.maxX - view.minX, viewHeight = (double)view.maxY - view.minY;
+        renderer.scale = fmin(maxWidth / viewWidth, maxHeight / viewHeight);
+        renderer.width = (int)fmax(round(viewWidth * renderer.scale), 1);
+        renderer.height = (int)fmax(round(viewHeight * renderer.scale), 1);
+        renderer.originX = view.minX;
+        renderer.originY = view.minY;
+        renderer.offsetX = (renderer.width - viewWidth * renderer.scale) / 2;
+        renderer.offsetY = (renderer.height - viewHeight * renderer.scale) / 2;
+    }
+
+    size_t numPixels = (size_t)renderer.width * renderer.height;
+    renderer.pixels = svgCalloc(numPixels * 4, sizeof(float));
+    renderer.cover = svgCalloc(renderer.width + 1, sizeof(float));
+    renderer.runs = svgCalloc(renderer.width + 1, sizeof(float));
+    if(renderer.pixels == NULL || renderer.cover == NULL || renderer.runs == NULL) {
+        freeRenderer(&renderer);
+        return NULL;
+    }
+
+    if(hasView) drawSVG(&renderer, svg);
+
+    unsigned char *rgba = svgMalloc(numPixels * 4);
+    if(rgba == NULL || renderer.failed) {
+        svgFree(rgba);
+        freeRenderer(&renderer);
+        return NULL;
+    }
+
+    for(size_t i = 0; i < numPixels; i++) {
+        const float *pixel = &renderer.pixels[4 * i];
+        float alpha = pixel[3] < 1 ? pixel[3] : 1;
+
+        for(int channel = 0; channel < 3; channel++) {
+            float value = alpha > 0 ? pixel[channel] / alpha : 0;
+            rgba[4 * i + channel] = (unsigned char)(fminf(fmaxf(value, 0), 1) * 255 + 0.5f);
+        }
+        rgba[4 * i + 3] = (unsigned char)(alpha * 255 + 0.5f);
+    }
+
+    *width = renderer.width;
+    *height = renderer.height;
+    freeRenderer(&renderer);
+
+    return rgba;
+}
+
+/**
+ * @brief writes a 32 bit number, most significant byte first as PNG stores them
+ *
+ * @param out
+ * @param value
+ */
+static void writeBigEndian(unsigned char *out, uint32_t value) {
+    out[0] = (unsigned char)(value >> 24);
+    out[1] = (unsigned char)(value >> 16);
+    out[2] = (unsigned char)(value >> 8);
+    out[3] = (unsigned char)value;
+}
+
+/**
+ * @brief writes a PNG chunk: its length, type, data and the CRC of the type and data
+ *
+ * @param out
+ * @param type
+ * @param data
+ * @param length
+ * @return unsigned char* the byte after the chunk
+ */
+static unsigned char* writeChunk(unsigned char *out, const char *type, const unsigned char *data, size_t length) {
+    writeBigEndian(out, (uint32_t)length);
+    memcpy(out + 4, type, 4);
+    // The image data is compressed straight into its chunk
+    if(length > 0 && data != out + 8) memcpy(out + 8, data, length);
+
+    uLong crc = crc32(0L, out + 4, (uInt)(length + 4));
+    writeBigEndian(out + 8 + length, (uint32_t)crc);
+
+    return out + 12 + length;
+}
+
+/**
+ * @brief returns the Paeth predictor of PNG filtering
+ *
+ * @param left
+ * @param up
+ * @param upLeft
+ * @return int
+ */
+static int paethPredictor(int left, int up, int upLeft) {
+    int p = left + up - upLeft;
+    int pa = abs(p - left), pb = abs(p - up), pc = abs(p - upLeft);
+
+    if(pa <= pb && pa <= pc) return left;
+    return pb <= pc ? up : upLeft;
+}
+
+/**
+ * @brief filters a row of pixels for compression, with whichever PNG filter gives the smallest sum of
+ * differences, the heuristic the PNG specification suggests.  The sums of every filter are found in one pass
+ * over the row, and only the chosen filter is written
+ *
+ * @param row
+ * @param previous row above it, NULL for the top row
+ * @param rowBytes
+ * @param out set to the filter type followed by the filtered row
+ */
+static void filterRow(const unsigned char *row, const unsigned char *previous, size_t rowBytes, unsigned char *out) {
+    unsigned long sums[5] = { 0 };
+
+    for(size_t i = 0; i < rowBytes; i++) {
+        int left = i >= 4 ? row[i - 4] : 0;
+        int up = previous != NULL ? previous[i] : 0;
+        int upLeft = previous != NULL && i >= 4 ? previous[i - 4] : 0;
+        unsigned char values[5] = { row[i], (unsigned char)(row[i] - left), (unsigned char)(row[i] - up),
+                                    (unsigned char)(row[i] - (left + up) / 2),
+                                    (unsigned char)(row[i] - paethPredictor(left, up, upLeft)) };
+
+        for(int filter = 0; filter <= 4; filter++)
+            sums[filter] += values[filter] < 128 ? values[filter] : 256 - values[filter];
+    }
+
+    int best = 0;
+    for(int filter = 1; filter <= 4; filter++)
+        if(sums[filter] < sums[best]) best = filter;
+
+    out[0] = (unsigned char)best;
+    out++;
+    for(size_t i = 0; i < rowBytes; i++) {
+        int left = i >= 4 ? row[i - 4] : 0;
+        int up = previous != NULL ? previous[i] : 0;
+        int upLeft = previous != NULL && i >= 4 ? previous[i - 4] : 0;
+
+        switch(best) {
+            case 0: out[i] = row[i]; break;
+            case 1: out[i] = (unsigned char)(row[i] - left); break;
+            case 2: out[i] = (unsigned char)(row[i] - up); break;
+            case 3: out[i] = (unsigned char)(row[i] - (left + up) / 2); break;
+            default: out[i] = (unsigned char)(row[i] - paethPredictor(left, up, upLeft)); break;
+        }
+    }
+}
+
+/**
+ * @brief encodes RGBA pixels as a PNG file
+ *
+ * @param rgba width * height pixels, top row first and not premultiplied
+ * @param width
+ * @param height
+ * @param length set to the size of the file
+ * @return unsigned char* the file, or NULL if it cannot be encoded
+ */
+unsigned char* encodePNG(const unsigned char *rgba, int width, int height, size_t *length) {
+    if(rgba == NULL || width < 1 || height < 1 || length == NULL) return NULL;
+
+    size_t rowBytes = (size_t)width * 4;
+    size_t filteredSize = (rowBytes + 1) * height;
+    unsigned char *filtered = svgMalloc(filteredSize);
+    uLong compressedSize = compressBound((uLong)filteredSize);
+    unsigned char *png = svgMalloc(8 + 25 + 12 + compressedSize + 12);
+    if(filtered == NULL || png == NULL) {
+        svgFree(filtered);
+        svgFree(png);
+        return NULL;
+    }
+
+    for(int row = 0; row < height; row++)
+        filterRow(rgba + row * rowBytes, row > 0 ? rgba + (row - 1) * rowBytes : NULL, rowBytes,
+                  filtered + row * (rowBytes + 1));
+
+    static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    memcpy(png, signature, 8);
+
+    // 8 bit RGBA, not interlaced
+    unsigned char header[13] = { 0 };
+    writeBigEndian(header, (uint32_t)width);
+    writeBigEndian(header + 4, (uint32_t)height);
+    header[8] = 8;
+    header[9] = 6;
+    unsigned char *out = writeChunk(png + 8, "IHDR", header, sizeof(header));
+
+    // Compressed after where the chunk's length and type go
+    int status = compress2(out + 8, &compressedSize, filtered, (uLong)filteredSize, Z_DEFAULT_COMPRESSION);
+    svgFree(filtered);
+    if(status != Z_OK) {
+        svgFree(png);
+        return NULL;
+    }
+    out = writeChunk(out, "IDAT", out + 8, compressedSize);
+    out = writeChunk(out, "IEND", NULL, 0);
+
+    *length = out - png;
+    return png;
+}
+
+/**
+ * @brief Function that renders an SVG struct as a PNG image
+ *
+ * @param img
+ * @param maxWidth
+ * @param maxHeight
+ * @param length
+ * @return unsigned char*
+ */
+unsigned char* renderSVGThumbnail(const SVG* img, int maxWidth, int maxHeight, size_t* length) {
+    int width, height;
+    unsigned char *rgba = rasterizeSVG(img, maxWidth, maxHeight, &width, &height);
+    if(rgba == NULL) return NULL;
+
+    unsigned char *png = encodePNG(rgba, width, height, length);
+    svgFree(rgba);
+
+    return png;
+}
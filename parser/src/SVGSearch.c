@@ -0,0 +1,1384 @@
+/**
+ * @file SVGSearch.c
+ * @author Anthony Vidovic (1130891)
+ * @brief Inverted index of the titles, descriptions, id and class values and element types of the svg files in
+ * a directory, kept on disk next to the files and updated as the library writes them
+ * @version 0.1
+ * @date 2022-04-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+// stat's nanosecond modification time, mmap and threads are POSIX, not C11
+#define _POSIX_C_SOURCE 200809L
+
+// ~~~~~ Includes ~~~~~ //
+#include "SVGHelper.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Files the index of a directory is kept in.  Files written since the index was last rebuilt are appended to
+// the journal, and a rebuilt index is written to the temporary file before it replaces the old one
+#define SEARCH_INDEX_FILE ".svgsearch"
+#define SEARCH_JOURNAL_FILE ".svgsearch.log"
+#define SEARCH_TEMP_FILE ".svgsearch.tmp"
+
+#define SEARCH_INDEX_MAGIC "SVGSRCH"
+#define SEARCH_INDEX_VERSION 1
+
+// Longest term in bytes, not counting its field.  Longer words and values are cut to it
+#define MAX_TERM_LENGTH 64
+
+// Longest string or term list of a journal record.  A longer one means the record is damaged
+#define MAX_JOURNAL_LENGTH (1 << 20)
+
+// The journal is folded into the index once it is larger than this and than a quarter of the index
+#define MIN_JOURNAL_COMPACT (64 * 1024)
+
+// Most terms a search matches together
+#define MAX_QUERY_TERMS 16
+
+// Fields a term is indexed under, written before the value as field:value
+static const char *searchFields[] = { "title", "desc", "id", "class", "type" };
+#define NUM_SEARCH_FIELDS 5
+
+// Layout of the index file: the header, the files sorted by name, the terms sorted by text, the postings of
+// every term and the strings.  Files are numbered by their position, and strings are offsets into the strings
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t numDocs;
+    uint32_t numTerms;
+    uint32_t numPostings;
+    uint64_t stringsSize;
+} IndexHeader;
+
+typedef struct {
+    uint64_t size;
+    int64_t mtimeSec;
+    int64_t mtimeNsec;
+    uint32_t name;
+    uint32_t title;
+    uint32_t description;
+    uint32_t unused;
+} IndexDoc;
+
+typedef struct {
+    uint32_t text;
+    // Position of the term's first posting, and the number of files that have the term
+    uint32_t postings;
+    uint32_t numPostings;
+} IndexTerm;
+
+// A file of the index.  Files read from the index point into it, parsed files own their strings
+typedef struct {
+    const char *name;
+    const char *title;
+    const char *description;
+    uint64_t size;
+    int64_t mtimeSec;
+    int64_t mtimeNsec;
+    // Sorted, without duplicates
+    const char **terms;
+    int numTerms;
+    bool ownsStrings;
+} SearchDoc;
+
+// Latest journal record of each file of a directory, kept between searches while the journal file is unchanged
+typedef struct JournalCache {
+    char *path;
+    dev_t device;
+    ino_t inode;
+    off_t size;
+    struct timespec mtime;
+    // Sorted by name
+    SearchDoc *records;
+    int numRecords;
+    // Indexes reading the records.  A cache replaced while it is read is freed by the last of them
+    int users;
+    bool replaced;
+    struct JournalCache *next;
+} JournalCache;
+
+// The index of a directory as read for a search or an update
+typedef struct {
+    // Mapping of the index file, NULL if the directory has none yet
+    void *map;
+    size_t mapSize;
+    const IndexHeader *header;
+    const IndexDoc *docs;
+    const IndexTerm *terms;
+    const uint32_t *postings;
+    const char *strings;
+    int numDocs;
+    // Files of the index file replaced by the journal
+    bool *superseded;
+    // Latest journal record of each file, sorted by name, from the directory's journal cache
+    JournalCache *journalCache;
+    const SearchDoc *journal;
+    int numJournal;
+} SearchIndex;
+
+// Terms of a file as they are collected
+typedef struct {
+    char **terms;
+    int numTerms;
+    int capacity;
+    // Element types already added
+    bool types[GROUP + 1];
+} TermSet;
+
+// A term of a search
+typedef struct {
+    // Index in searchFields, -1 to match any field
+    int field;
+    char *value;
+    size_t length;
+    bool prefix;
+} QueryTerm;
+
+// A file found by a search
+typedef struct {
+    const char *name;
+    const char *title;
+    const char *description;
+} SearchResult;
+
+// Held while an index is read, rebuilt or appended to by this process, and while the journal caches are used.
+// Other processes writing the same directory's index are not coordinated with
+static pthread_mutex_t searchLock = PTHREAD_MUTEX_INITIALIZER;
+
+// Journals read by this process, one for each directory searched or updated
+static JournalCache *journalCaches = NULL;
+
+/**
+ * @brief returns the path of one of the index files of a directory
+ *
+ * @param directory
+ * @param file
+ * @return char*
+ */
+static char* searchFilePath(const char *directory, const char *file) {
+    char *path = svgMalloc(strlen(directory) + strlen(file) + 2);
+    sprintf(path, "%s/%s", directory, file);
+    return path;
+}
+
+/**
+ * @brief copies a string into the library's allocator
+ *
+ * @param str
+ * @param length bytes of str copied
+ * @return char*
+ */
+static char* copySearchString(const char *str, size_t length) {
+    char *copy = svgMalloc(length + 1);
+    memcpy(copy, str, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+/**
+ * @brief returns a term as it is indexed and searched: the field, a colon and the value in lower case, the value
+ * cut to MAX_TERM_LENGTH bytes without splitting a UTF-8 character
+ *
+ * @param field
+ * @param value
+ * @param length bytes of the value
+ * @return char*
+ */
+static char* makeTerm(const char *field, const char *value, size_t length) {
+    if(length > MAX_TERM_LENGTH) {
+        length = MAX_TERM_LENGTH;
+        while(length > 0 && ((unsigned char)value[length] & 0xC0) == 0x80) length--;
+    }
+
+    size_t fieldLength = strlen(field);
+    char *term = svgMalloc(fieldLength + length + 2);
+    memcpy(term, field, fieldLength);
+    term[fieldLength] = ':';
+
+    for(size_t i = 0; i < length; i++) {
+        unsigned char c = (unsigned char)value[i];
+        term[fieldLength + 1 + i] = c < 0x80 ? (char)tolower(c) : (char)c;
+    }
+    term[fieldLength + 1 + length] = '\0';
+
+    return term;
+}
+
+/**
+ * @brief adds a term to the terms of a file
+ *
+ * @param set
+ * @param field
+ * @param value
+ * @param length bytes of the value, nothing is added if it is 0
+ */
+static void addTerm(TermSet *set, const char *field, const char *value, size_t length) {
+    if(length == 0) return;
+
+    if(set->numTerms == set->capacity) {
+        char **grown = growStack(set->terms, &set->capacity, sizeof(char*));
+        if(grown == NULL) return;
+        set->terms = grown;
+    }
+
+    set->terms[set->numTerms++] = makeTerm(field, value, length);
+}
+
+/**
+ * @brief returns whether a byte is part of a word of a title or description.  Bytes of UTF-8 characters are,
+ * so words in any script are kept whole
+ *
+ * @param c
+ * @return true
+ * @return false
+ */
+static bool isWordByte(unsigned char c) {
+    return c >= 0x80 || isalnum(c);
+}
+
+/**
+ * @brief adds each word of a title or description as a term
+ *
+ * @param set
+ * @param field
+ * @param text
+ */
+static void addWords(TermSet *set, const char *field, const char *text) {
+    const char *c = text;
+    while(*c) {
+        while(*c && !isWordByte((unsigned char)*c)) c++;
+
+        const char *start = c;
+        while(*c && isWordByte((unsigned char)*c)) c++;
+        addTerm(set, field, start, c - start);
+    }
+}
+
+/**
+ * @brief adds the id of an element, and each of its classes, as terms
+ *
+ * @param set
+ * @param attributes other attributes of the element
+ */
+static void addAttributeTerms(TermSet *set, const List *attributes) {
+    for(Node *cur = attributes->head; cur; cur = cur->next) {
+        const Attribute *attr = (const Attribute*)cur->data;
+        bool isClass = strcmp(attr->name, "class") == 0;
+        if(!isClass && strcmp(attr->name, "id") != 0) continue;
+
+        const char *c = attr->value;
+        while(*c) {
+            while(*c && isspace((unsigned char)*c)) c++;
+
+            const char *start = c;
+            while(*c && !isspace((unsigned char)*c)) c++;
+            addTerm(set, isClass ? "class" : "id", start, c - start);
+        }
+    }
+}
+
+/**
+ * @brief visitor adding the type and attribute terms of an element
+ *
+ * @param element
+ * @param context the TermSet of the file
+ */
+static void addElementTerms(const VisitedElement *element, void *context) {
+    TermSet *set = (TermSet*)context;
+
+    if(!set->types[element->type]) {
+        const char *name = element->type == RECT ? "rect" : element->type == CIRC ? "circle" :
+                           element->type == PATH ? "path" : "g";
+        addTerm(set, "type", name, strlen(name));
+        set->types[element->type] = true;
+    }
+
+    addAttributeTerms(set, otherAttributesOf(element));
+}
+
+/**
+ * @brief qsort comparison of strings by their pointers
+ *
+ * @param first
+ * @param second
+ * @return int
+ */
+static int compareStrings(const void *first, const void *second) {
+    return strcmp(*(const char* const*)first, *(const char* const*)second);
+}
+
+/**
+ * @brief qsort comparison of files by name
+ *
+ * @param first
+ * @param second
+ * @return int
+ */
+static int compareDocNames(const void *first, const void *second) {
+    return strcmp(((const SearchDoc*)first)->name, ((const SearchDoc*)second)->name);
+}
+
+/**
+ * @brief makes the index entry of a file from its struct
+ *
+ * @param svg NULL for a file that cannot be parsed or is not valid, which is indexed without terms
+ * @param name name of the file within its directory
+ * @param info the file's stat
+ * @param doc
+ */
+static void documentFromSVG(const SVG *svg, const char *name, const struct stat *info, SearchDoc *doc) {
+    TermSet set = { NULL, 0, 0, { false } };
+
+    if(svg != NULL) {
+        addWords(&set, "title", svg->title);
+        addWords(&set, "desc", svg->description);
+        addAttributeTerms(&set, svg->otherAttributes);
+
+        SVGVisitor visitor = { VISIT_ALL, 0, NULL, NULL, addElementTerms, &set };
+        visitSVG(svg, &visitor, 1);
+    }
+
+    // Each term is kept once
+    if(set.numTerms > 1) qsort(set.terms, set.numTerms, sizeof(char*), compareStrings);
+    int numUnique = 0;
+    for(int i = 0; i < set.numTerms; i++) {
+        if(numUnique > 0 && strcmp(set.terms[i], set.terms[numUnique - 1]) == 0) svgFree(set.terms[i]);
+        else set.terms[numUnique++] = set.terms[i];
+    }
+
+    doc->name = copySearchString(name, strlen(name));
+    doc->title = svg != NULL ? copySearchString(svg->title, strlen(svg->title)) : copySearchString("", 0);
+    doc->description = svg != NULL ? copySearchString(svg->description, strlen(svg->description)) : copySearchString("", 0);
+    doc->size = info->st_size;
+    doc->mtimeSec = info->st_mtim.tv_sec;
+    doc->mtimeNsec = info->st_mtim.tv_nsec;
+    doc->terms = (const char**)set.terms;
+    doc->numTerms = numUnique;
+    doc->ownsStrings = true;
+}
+
+/**
+ * @brief parses a file and makes its index entry
+ *
+ * @param file
+ * @param schema files that are not valid against it are indexed without terms.  NULL to only parse the file
+ * @param doc
+ */
+static void documentFromFile(const CorpusFile *file, xmlSchemaPtr schema, SearchDoc *doc) {
+    SVG *svg = NULL;
+
+    xmlDoc *xml = readSVGDoc(file->path);
+    if(xml != NULL && (schema == NULL || validateWithSchema(xml, schema) == 0))
+        svg = svgFromDoc(xml);
+    xmlFreeDoc(xml);
+
+    documentFromSVG(svg, file->name, &file->info, doc);
+    deleteSVG(svg);
+}
+
+/**
+ * @brief frees a file's terms, and its strings if it owns them
+ *
+ * @param doc
+ */
+static void freeSearchDoc(SearchDoc *doc) {
+    if(doc->ownsStrings) {
+        svgFree((char*)doc->name);
+        svgFree((char*)doc->title);
+        svgFree((char*)doc->description);
+        for(int i = 0; i < doc->numTerms; i++) svgFree((char*)doc->terms[i]);
+    }
+    svgFree(doc->terms);
+    doc->terms = NULL;
+    doc->numTerms = 0;
+}
+
+/**
+ * @brief returns a string of the index file
+ *
+ * @param index
+ * @param offset
+ * @return const char* empty if the offset is out of range
+ */
+static const char* indexString(const SearchIndex *index, uint32_t offset) {
+    return offset < index->header->stringsSize ? index->strings + offset : "";
+}
+
+/**
+ * @brief maps and checks the index file of a directory
+ *
+ * @param path
+ * @param index
+ * @return true if the file was mapped, or there is none
+ * @return false if it cannot be read or is damaged
+ */
+static bool mapSearchIndex(const char *path, SearchIndex *index) {
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) return errno == ENOENT;
+
+    struct stat info;
+    if(fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(IndexHeader)) {
+        close(fd);
+        return false;
+    }
+
+    void *map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED) return false;
+
+    index->map = map;
+    index->mapSize = info.st_size;
+    index->header = (const IndexHeader*)map;
+
+    const IndexHeader *header = index->header;
+    if(memcmp(header->magic, SEARCH_INDEX_MAGIC, sizeof(header->magic)) != 0 || header->version != SEARCH_INDEX_VERSION)
+        return false;
+
+    uint64_t expected = sizeof(IndexHeader) + (uint64_t)header->numDocs * sizeof(IndexDoc) +
+                        (uint64_t)header->numTerms * sizeof(IndexTerm) + (uint64_t)header->numPostings * sizeof(uint32_t) +
+                        header->stringsSize;
+    if(expected != index->mapSize || header->stringsSize == 0 || header->numDocs > INT_MAX) return false;
+
+    index->docs = (const IndexDoc*)(header + 1);
+    index->terms = (const IndexTerm*)(index->docs + header->numDocs);
+    index->postings = (const uint32_t*)(index->terms + header->numTerms);
+    index->strings = (const char*)(index->postings + header->numPostings);
+    index->numDocs = header->numDocs;
+
+    // Every string ends before the end of the file
+    return index->strings[header->stringsSize - 1] == '\0';
+}
+
+/**
+ * @brief reads a length prefixed string of a journal record
+ *
+ * @param file
+ * @return char* NULL at the end of the journal or if the string is damaged
+ */
+static char* readJournalString(FILE *file) {
+    uint32_t length;
+    if(fread(&length, sizeof(length), 1, file) != 1 || length > MAX_JOURNAL_LENGTH) return NULL;
+
+    char *str = svgMalloc(length + 1);
+    if(length > 0 && fread(str, length, 1, file) != 1) {
+        svgFree(str);
+        return NULL;
+    }
+    str[length] = '\0';
+
+    return str;
+}
+
+/**
+ * @brief reads the next record of a journal
+ *
+ * @param file
+ * @param doc
+ * @return true
+ * @return false at the end of the journal, or at a record cut short by a write that did not finish
+ */
+static bool readJournalRecord(FILE *file, SearchDoc *doc) {
+    memset(doc, 0, sizeof(SearchDoc));
+    doc->ownsStrings = true;
+
+    uint32_t numTerms;
+    doc->name = readJournalString(file);
+    if(doc->name == NULL || fread(&doc->size, sizeof(doc->size), 1, file) != 1 ||
+       fread(&doc->mtimeSec, sizeof(doc->mtimeSec), 1, file) != 1 || fread(&doc->mtimeNsec, sizeof(doc->mtimeNsec), 1, file) != 1 ||
+       (doc->title = readJournalString(file)) == NULL || (doc->description = readJournalString(file)) == NULL ||
+       fread(&numTerms, sizeof(numTerms), 1, file) != 1 || numTerms > MAX_JOURNAL_LENGTH) {
+        freeSearchDoc(doc);
+        return false;
+    }
+
+    doc->terms = svgMalloc((numTerms > 0 ? numTerms : 1) * sizeof(char*));
+    for(; doc->numTerms < (int)numTerms; doc->numTerms++) {
+        char *term = readJournalString(file);
+        if(term == NULL) {
+            freeSearchDoc(doc);
+            return false;
+        }
+        doc->terms[doc->numTerms] = term;
+    }
+
+    return true;
+}
+
+/**
+ * @brief qsort comparison of pointers to journal records by name, then by position in the journal, so the
+ * latest record of a file sorts last among its records
+ *
+ * @param first
+ * @param second
+ * @return int
+ */
+static int compareJournalRecords(const void *first, const void *second) {
+    const SearchDoc *a = *(const SearchDoc* const*)first;
+    const SearchDoc *b = *(const SearchDoc* const*)second;
+
+    int cmp = strcmp(a->name, b->name);
+    if(cmp != 0) return cmp;
+
+    return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+/**
+ * @brief reads a journal, keeping the latest record of each file.  The records are sorted once, rather than each
+ * being looked up among the records before it
+ *
+ * @param path
+ * @param numRecords set to the number of files
+ * @return SearchDoc* sorted by name, NULL if the journal cannot be read or has no records
+ */
+static SearchDoc* readJournal(const char *path, int *numRecords) {
+    *numRecords = 0;
+    FILE *file = fopen(path, "rb");
+    if(file == NULL) return NULL;
+
+    SearchDoc *all = NULL;
+    int numAll = 0, capacity = 0;
+    SearchDoc doc;
+    while(readJournalRecord(file, &doc)) {
+        if(numAll == capacity) {
+            SearchDoc *grown = growStack(all, &capacity, sizeof(SearchDoc));
+            if(grown == NULL) {
+                freeSearchDoc(&doc);
+                break;
+            }
+            all = grown;
+        }
+        all[numAll++] = doc;
+    }
+    fclose(file);
+
+    SearchDoc **order = svgMalloc((numAll > 0 ? numAll : 1) * sizeof(SearchDoc*));
+    SearchDoc *records = svgMalloc((numAll > 0 ? numAll : 1) * sizeof(SearchDoc));
+    if(order == NULL || records == NULL) {
+        for(int i = 0; i < numAll; i++) freeSearchDoc(&all[i]);
+        svgFree(all);
+        svgFree(order);
+        svgFree(records);
+        return NULL;
+    }
+
+    for(int i = 0; i < numAll; i++) order[i] = &all[i];
+    if(numAll > 1) qsort(order, numAll, sizeof(SearchDoc*), compareJournalRecords);
+
+    // The last record of each run of the same name is the latest, the ones before it are out of date
+    int count = 0;
+    for(int i = 0; i < numAll; i++) {
+        if(i + 1 < numAll && strcmp(order[i]->name, order[i + 1]->name) == 0) freeSearchDoc(order[i]);
+        else records[count++] = *order[i];
+    }
+
+    svgFree(order);
+    svgFree(all);
+
+    if(count == 0) {
+        svgFree(records);
+        return NULL;
+    }
+
+    *numRecords = count;
+    return records;
+}
+
+/**
+ * @brief frees a journal cache
+ *
+ * @param cache
+ */
+static void freeJournalCache(JournalCache *cache) {
+    for(int i = 0; i < cache->numRecords; i++) freeSearchDoc(&cache->records[i]);
+    svgFree(cache->records);
+    svgFree(cache->path);
+    svgFree(cache);
+}
+
+/**
+ * @brief takes a cache out of the list when its journal has changed or gone.  It is freed now if no index is
+ * reading it, or else by the last index to release it.  The caller holds searchLock
+ *
+ * @param link the pointer to the cache in the list
+ */
+static void retireJournalCache(JournalCache **link) {
+    JournalCache *cache = *link;
+    *link = cache->next;
+
+    if(cache->users == 0) freeJournalCache(cache);
+    else cache->replaced = true;
+}
+
+/**
+ * @brief returns the journal cache of a directory for an index to read, reading the journal again only if the file
+ * has changed since it was cached.  The caller holds searchLock, and releases the cache with releaseJournalCache
+ *
+ * @param path path of the journal
+ * @return JournalCache* NULL if the directory has no journal
+ */
+static JournalCache* acquireJournalCache(const char *path) {
+    JournalCache **link = &journalCaches;
+    while(*link != NULL && strcmp((*link)->path, path) != 0) link = &(*link)->next;
+
+    struct stat info;
+    if(stat(path, &info) != 0) {
+        if(*link != NULL) retireJournalCache(link);
+        return NULL;
+    }
+
+    JournalCache *cache = *link;
+    if(cache != NULL && cache->device == info.st_dev && cache->inode == info.st_ino && cache->size == info.st_size &&
+       cache->mtime.tv_sec == info.st_mtim.tv_sec && cache->mtime.tv_nsec == info.st_mtim.tv_nsec) {
+        cache->users++;
+        return cache;
+    }
+    if(cache != NULL) retireJournalCache(link);
+
+    // The status is taken before the journal is read, so a record appended meanwhile only makes the next
+    // search read it again
+    cache = svgCalloc(1, sizeof(JournalCache));
+    if(cache == NULL) return NULL;
+    cache->path = copySearchString(path, strlen(path));
+    cache->device = info.st_dev;
+    cache->inode = info.st_ino;
+    cache->size = info.st_size;
+    cache->mtime = info.st_mtim;
+    cache->records = readJournal(path, &cache->numRecords);
+    cache->users = 1;
+
+    cache->next = journalCaches;
+    journalCaches = cache;
+    return cache;
+}
+
+/**
+ * @brief stops an index reading a journal cache, freeing the cache if it was replaced and this was its last
+ * reader.  The caller holds searchLock
+ *
+ * @param cache may be NULL
+ */
+static void releaseJournalCache(JournalCache *cache) {
+    if(cache == NULL) return;
+
+    cache->users--;
+    if(cache->replaced && cache->users == 0) freeJournalCache(cache);
+}
+
+/**
+ * @brief finds a file of the index file by name
+ *
+ * @param index
+ * @param name
+ * @return int its number, or -1 if the index file does not have it
+ */
+static int findIndexDoc(const SearchIndex *index, const char *name) {
+    int low = 0, high = index->numDocs - 1;
+
+    while(low <= high) {
+        int mid = low + (high - low) / 2;
+        int cmp = strcmp(indexString(index, index->docs[mid].name), name);
+
+        if(cmp == 0) return mid;
+        if(cmp < 0) low = mid + 1;
+        else high = mid - 1;
+    }
+
+    return -1;
+}
+
+/**
+ * @brief frees what loadSearchIndex read, leaving an empty index.  The caller holds searchLock
+ *
+ * @param index
+ */
+static void freeSearchIndex(SearchIndex *index) {
+    if(index->map != NULL) munmap(index->map, index->mapSize);
+    svgFree(index->superseded);
+    releaseJournalCache(index->journalCache);
+
+    memset(index, 0, sizeof(SearchIndex));
+}
+
+/**
+ * @brief reads the index of a directory: maps its index file and takes its journal from the journal cache.
+ * The caller holds searchLock
+ *
+ * @param directory
+ * @param index empty if the directory has no index, or it is damaged
+ * @return true
+ * @return false if the index file is damaged or cannot be read
+ */
+static bool loadSearchIndex(const char *directory, SearchIndex *index) {
+    memset(index, 0, sizeof(SearchIndex));
+
+    char *path = searchFilePath(directory, SEARCH_INDEX_FILE);
+    bool mapped = mapSearchIndex(path, index);
+    svgFree(path);
+
+    if(!mapped) {
+        freeSearchIndex(index);
+        return false;
+    }
+
+    path = searchFilePath(directory, SEARCH_JOURNAL_FILE);
+    index->journalCache = acquireJournalCache(path);
+    svgFree(path);
+    if(index->journalCache != NULL) {
+        index->journal = index->journalCache->records;
+        index->numJournal = index->journalCache->numRecords;
+    }
+
+    index->superseded = svgCalloc(index->numDocs > 0 ? index->numDocs : 1, sizeof(bool));
+    for(int i = 0; i < index->numJournal; i++) {
+        int id = findIndexDoc(index, index->journal[i].name);
+        if(id >= 0) index->superseded[id] = true;
+    }
+
+    return true;
+}
+
+/**
+ * @brief returns every file of an index, the files of the index file with their terms gathered from the postings
+ * followed by the files of the journal.  The returned files point into the index, and own only their term lists
+ *
+ * @param index
+ * @param numDocs set to the number of files
+ * @return SearchDoc* sorted by name
+ */
+static SearchDoc* indexedDocs(const SearchIndex *index, int *numDocs) {
+    SearchDoc *docs = svgCalloc(index->numDocs + index->numJournal + 1, sizeof(SearchDoc));
+
+    for(int i = 0; i < index->numDocs; i++) {
+        const IndexDoc *doc = &index->docs[i];
+        docs[i].name = indexString(index, doc->name);
+        docs[i].title = indexString(index, doc->title);
+        docs[i].description = indexString(index, doc->description);
+        docs[i].size = doc->size;
+        docs[i].mtimeSec = doc->mtimeSec;
+        docs[i].mtimeNsec = doc->mtimeNsec;
+    }
+
+    // Terms are listed in order, so each file's terms come out sorted.  The first pass counts them
+    for(int pass = 0; pass < 2; pass++) {
+        for(uint32_t t = 0; index->map != NULL && t < index->header->numTerms; t++) {
+            const IndexTerm *term = &index->terms[t];
+            if(term->postings > index->header->numPostings || term->numPostings > index->header->numPostings - term->postings)
+                continue;
+
+            for(uint32_t p = term->postings; p < term->postings + term->numPostings; p++) {
+                uint32_t id = index->postings[p];
+                if(id >= (uint32_t)index->numDocs) continue;
+
+                if(pass == 1) docs[id].terms[docs[id].numTerms] = indexString(index, term->text);
+                docs[id].numTerms++;
+            }
+        }
+
+        for(int i = 0; i < index->numDocs && pass == 0; i++) {
+            docs[i].terms = svgMalloc((docs[i].numTerms > 0 ? docs[i].numTerms : 1) * sizeof(char*));
+            docs[i].numTerms = 0;
+        }
+    }
+
+    // Files replaced by the journal are dropped, the journal's records take their place
+    int count = 0;
+    for(int i = 0; i < index->numDocs; i++) {
+        if(index->superseded[i]) svgFree(docs[i].terms);
+        else docs[count++] = docs[i];
+    }
+
+    for(int i = 0; i < index->numJournal; i++) {
+        const SearchDoc *record = &index->journal[i];
+        docs[count] = *record;
+        docs[count].ownsStrings = false;
+        docs[count].terms = svgMalloc((record->numTerms > 0 ? record->numTerms : 1) * sizeof(char*));
+        memcpy(docs[count].terms, record->terms, record->numTerms * sizeof(char*));
+        count++;
+    }
+
+    if(count > 1) qsort(docs, count, sizeof(SearchDoc), compareDocNames);
+    *numDocs = count;
+
+    return docs;
+}
+
+// A term of a file, as the postings of a new index file are sorted
+typedef struct {
+    const char *term;
+    uint32_t doc;
+} TermPosting;
+
+/**
+ * @brief qsort comparison of postings by term, then by file
+ *
+ * @param first
+ * @param second
+ * @return int
+ */
+static int compareTermPostings(const void *first, const void *second) {
+    const TermPosting *a = (const TermPosting*)first;
+    const TermPosting *b = (const TermPosting*)second;
+
+    int cmp = strcmp(a->term, b->term);
+    if(cmp != 0) return cmp;
+    return (a->doc > b->doc) - (a->doc < b->doc);
+}
+
+/**
+ * @brief adds a string to the strings of a new index file
+ *
+ * @param strings
+ * @param str
+ * @return uint32_t its offset
+ */
+static uint32_t addIndexString(StringBuffer *strings, const char *str) {
+    uint32_t offset = (uint32_t)strings->length;
+    appendBytes(strings, str, strlen(str) + 1);
+    return offset;
+}
+
+/**
+ * @brief writes a new index file for a directory and empties its journal.  The file is written beside the old
+ * one and renamed over it, so a search never reads a partly written index.  The caller holds searchLock
+ *
+ * @param directory
+ * @param docs every file of the index, sorted here by name
+ * @param numDocs
+ * @return true
+ * @return false if the index cannot be built in memory or its file cannot be written
+ */
+static bool writeSearchIndex(const char *directory, SearchDoc *docs, int numDocs) {
+    if(numDocs > 1) qsort(docs, numDocs, sizeof(SearchDoc), compareDocNames);
+
+    size_t numPairs = 0;
+    for(int i = 0; i < numDocs; i++) numPairs += docs[i].numTerms;
+    if(numPairs >= UINT32_MAX) return false;
+
+    size_t numSlots = numPairs > 0 ? numPairs : 1;
+    TermPosting *pairs = svgMalloc(numSlots * sizeof(TermPosting));
+    IndexDoc *indexDocs = svgCalloc(numDocs > 0 ? numDocs : 1, sizeof(IndexDoc));
+    IndexTerm *terms = svgMalloc(numSlots * sizeof(IndexTerm));
+    uint32_t *postings = svgMalloc(numSlots * sizeof(uint32_t));
+    StringBuffer strings;
+    initStringBuffer(&strings, 4096);
+    if(pairs == NULL || indexDocs == NULL || terms == NULL || postings == NULL || strings.failed) {
+        svgFree(pairs);
+        svgFree(indexDocs);
+        svgFree(terms);
+        svgFree(postings);
+        svgFree(strings.data);
+        return false;
+    }
+
+    size_t pos = 0;
+    for(int i = 0; i < numDocs; i++) {
+        for(int t = 0; t < docs[i].numTerms; t++) {
+            pairs[pos].term = docs[i].terms[t];
+            pairs[pos++].doc = i;
+        }
+    }
+    if(numPairs > 1) qsort(pairs, numPairs, sizeof(TermPosting), compareTermPostings);
+
+    IndexHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SEARCH_INDEX_MAGIC, sizeof(header.magic));
+    header.version = SEARCH_INDEX_VERSION;
+    header.numDocs = numDocs;
+
+    for(int i = 0; i < numDocs; i++) {
+        indexDocs[i].size = docs[i].size;
+        indexDocs[i].mtimeSec = docs[i].mtimeSec;
+        indexDocs[i].mtimeNsec = docs[i].mtimeNsec;
+        indexDocs[i].name = addIndexString(&strings, docs[i].name);
+        indexDocs[i].title = addIndexString(&strings, docs[i].title);
+        indexDocs[i].description = addIndexString(&strings, docs[i].description);
+    }
+
+    for(size_t i = 0; i < numPairs; i++) {
+        bool newTerm = i == 0 || strcmp(pairs[i].term, pairs[i - 1].term) != 0;
+        if(!newTerm && pairs[i].doc == pairs[i - 1].doc) continue;
+
+        if(newTerm) {
+            terms[header.numTerms].text = addIndexString(&strings, pairs[i].term);
+            terms[header.numTerms].postings = header.numPostings;
+            terms[header.numTerms++].numPostings = 0;
+        }
+        postings[header.numPostings++] = pairs[i].doc;
+        terms[header.numTerms - 1].numPostings++;
+    }
+    // An index without files still has a string, so its strings are never empty
+    if(strings.length == 0) addIndexString(&strings, "");
+    header.stringsSize = strings.length;
+
+    char *tempPath = searchFilePath(directory, SEARCH_TEMP_FILE);
+    char *indexPath = searchFilePath(directory, SEARCH_INDEX_FILE);
+    char *journalPath = searchFilePath(directory, SEARCH_JOURNAL_FILE);
+
+    // Offsets of strings that could not be added would point past the end, so nothing is written
+    bool written = !strings.failed && strings.length <= UINT32_MAX;
+    FILE *file = written ? fopen(tempPath, "wb") : NULL;
+    if(file != NULL) {
+        written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                  (numDocs == 0 || fwrite(indexDocs, sizeof(IndexDoc), numDocs, file) == (size_t)numDocs) &&
+                  (header.numTerms == 0 || fwrite(terms, sizeof(IndexTerm), header.numTerms, file) == header.numTerms) &&
+                  (header.numPostings == 0 || fwrite(postings, sizeof(uint32_t), header.numPostings, file) == header.numPostings) &&
+                  fwrite(strings.data, strings.length, 1, file) == 1;
+        written = fclose(file) == 0 && written;
+
+        // The journal's records are in the new index, so it starts over once the index is replaced
+        written = written && rename(tempPath, indexPath) == 0;
+        if(written) unlink(journalPath);
+        else unlink(tempPath);
+    } else {
+        written = false;
+    }
+
+    svgFree(tempPath);
+    svgFree(indexPath);
+    svgFree(journalPath);
+    svgFree(pairs);
+    svgFree(strings.data);
+    svgFree(indexDocs);
+    svgFree(terms);
+    svgFree(postings);
+
+    return written;
+}
+
+/**
+ * @brief brings the index of a directory up to date with its svg files, creating it if the directory has none.
+ * Only files that are new or have changed size or modification time since they were indexed are parsed.
+ * Afterwards the library's writes to files in the directory keep the index up to date
+ *
+ * @param directory
+ * @param schemaFile files that are not valid against it are indexed without terms.  NULL or empty to only parse
+ * the files
+ * @return int number of files in the index, or -1 if the directory, the schema or the index cannot be read or
+ * written
+ */
+int updateSearchIndex(const char *directory, const char *schemaFile) {
+    if(directory == NULL) return -1;
+
+    xmlInitParser();
+
+    xmlSchemaPtr schema = NULL;
+    if(schemaFile != NULL && schemaFile[0] != '\0') {
+        if(!extensionMatches(schemaFile, ".xsd")) return -1;
+        schema = compileSchema(schemaFile);
+        if(schema == NULL) return -1;
+    }
+
+    int numFiles;
+    CorpusFile *files = listCorpusFiles(directory, &numFiles);
+    if(files == NULL) {
+        if(schema != NULL) xmlSchemaFree(schema);
+        return -1;
+    }
+
+    pthread_mutex_lock(&searchLock);
+
+    // A damaged index is rebuilt from the files
+    SearchIndex index;
+    bool loaded = loadSearchIndex(directory, &index);
+    int numIndexed;
+    SearchDoc *indexed = indexedDocs(&index, &numIndexed);
+
+    bool changed = !loaded || index.map == NULL || index.numJournal > 0;
+    int reused = 0;
+
+    SearchDoc *docs = svgCalloc(numFiles > 0 ? numFiles : 1, sizeof(SearchDoc));
+    for(int i = 0; i < numFiles; i++) {
+        SearchDoc key = { 0 };
+        key.name = files[i].name;
+        SearchDoc *found = numIndexed > 0 ? bsearch(&key, indexed, numIndexed, sizeof(SearchDoc), compareDocNames) : NULL;
+
+        if(found != NULL && found->size == (uint64_t)files[i].info.st_size &&
+           found->mtimeSec == files[i].info.st_mtim.tv_sec && found->mtimeNsec == files[i].info.st_mtim.tv_nsec) {
+            // The file's term list moves to the new index
+            docs[i] = *found;
+            found->terms = NULL;
+            reused++;
+        } else {
+            documentFromFile(&files[i], schema, &docs[i]);
+            changed = true;
+        }
+    }
+
+    // Files that have been removed leave the index
+    if(reused != numIndexed) changed = true;
+
+    int result = numFiles;
+    if(changed && !writeSearchIndex(directory, docs, numFiles)) result = -1;
+
+    for(int i = 0; i < numFiles; i++) freeSearchDoc(&docs[i]);
+    for(int i = 0; i < numIndexed; i++) freeSearchDoc(&indexed[i]);
+    svgFree(docs);
+    svgFree(indexed);
+    freeSearchIndex(&index);
+
+    pthread_mutex_unlock(&searchLock);
+
+    freeCorpusFiles(files, numFiles);
+    if(schema != NULL) xmlSchemaFree(schema);
+
+    return result;
+}
+
+/**
+ * @brief rebuilds the index file of a directory from the index file and its journal, without parsing any file.
+ * The caller holds searchLock
+ *
+ * @param directory
+ */
+static void compactSearchIndex(const char *directory) {
+    SearchIndex index;
+    if(!loadSearchIndex(directory, &index)) return;
+
+    int numDocs;
+    SearchDoc *docs = indexedDocs(&index, &numDocs);
+    writeSearchIndex(directory, docs, numDocs);
+
+    for(int i = 0; i < numDocs; i++) freeSearchDoc(&docs[i]);
+    svgFree(docs);
+    freeSearchIndex(&index);
+}
+
+/**
+ * @brief appends a value to a journal record
+ *
+ * @param record
+ * @param value
+ * @param size
+ */
+static void appendJournalValue(StringBuffer *record, const void *value, size_t size) {
+    appendBytes(record, (const char*)value, size);
+}
+
+/**
+ * @brief appends a length prefixed string to a journal record
+ *
+ * @param record
+ * @param str
+ */
+static void appendJournalString(StringBuffer *record, const char *str) {
+    uint32_t length = (uint32_t)strlen(str);
+    appendJournalValue(record, &length, sizeof(length));
+    appendBytes(record, str, length);
+}
+
+/**
+ * @brief updates the index of the directory of a file the library has written, if the directory has an index.
+ * The file's new terms are appended to the journal, which is folded into the index once it grows large
+ *
+ * @param svg the struct that was written
+ * @param fileName
+ */
+void indexWrittenSVG(const SVG *svg, const char *fileName) {
+    if(svg == NULL || fileName == NULL) return;
+
+    const char *slash = strrchr(fileName, '/');
+    char *directory = slash != NULL ? copySearchString(fileName, slash - fileName) : copySearchString(".", 1);
+    const char *name = slash != NULL ? slash + 1 : fileName;
+    if(directory[0] == '\0') {
+        svgFree(directory);
+        directory = copySearchString("/", 1);
+    }
+
+    char *indexPath = searchFilePath(directory, SEARCH_INDEX_FILE);
+    char *journalPath = searchFilePath(directory, SEARCH_JOURNAL_FILE);
+
+    pthread_mutex_lock(&searchLock);
+
+    // Directories without an index are not indexed
+    struct stat indexInfo, info;
+    if(stat(indexPath, &indexInfo) == 0 && stat(fileName, &info) == 0) {
+        SearchDoc doc;
+        documentFromSVG(svg, name, &info, &doc);
+
+        StringBuffer record;
+        initStringBuffer(&record, 1024);
+        uint32_t numTerms = doc.numTerms;
+        appendJournalString(&record, doc.name);
+        appendJournalValue(&record, &doc.size, sizeof(doc.size));
+        appendJournalValue(&record, &doc.mtimeSec, sizeof(doc.mtimeSec));
+        appendJournalValue(&record, &doc.mtimeNsec, sizeof(doc.mtimeNsec));
+        appendJournalString(&record, doc.title);
+        appendJournalString(&record, doc.description);
+        appendJournalValue(&record, &numTerms, sizeof(numTerms));
+        for(int i = 0; i < doc.numTerms; i++) appendJournalString(&record, doc.terms[i]);
+        freeSearchDoc(&doc);
+
+        // The record is written in one call, so a reader sees either all of it or a cut off record it skips.  A
+        // record that could not be built is not written, leaving the file's old terms until the next update
+        FILE *journal = record.failed ? NULL : fopen(journalPath, "ab");
+        if(journal != NULL) {
+            fwrite(record.data, record.length, 1, journal);
+            fclose(journal);
+        }
+        svgFree(record.data);
+
+        struct stat journalInfo;
+        if(stat(journalPath, &journalInfo) == 0 && journalInfo.st_size > MIN_JOURNAL_COMPACT &&
+           journalInfo.st_size > indexInfo.st_size / 4)
+            compactSearchIndex(directory);
+    }
+
+    pthread_mutex_unlock(&searchLock);
+
+    svgFree(indexPath);
+    svgFree(journalPath);
+    svgFree(directory);
+}
+
+/**
+ * @brief splits a search into its terms.  Terms are separated by spaces, may start with a field and a colon,
+ * and match as prefixes if they end with *
+ *
+ * @param query
+ * @param terms
+ * @return int number of terms, at most MAX_QUERY_TERMS
+ */
+static int parseSearchQuery(const char *query, QueryTerm *terms) {
+    int numTerms = 0;
+    const char *c = query;
+
+    while(*c && numTerms < MAX_QUERY_TERMS) {
+        while(*c && isspace((unsigned char)*c)) c++;
+
+        const char *start = c;
+        while(*c && !isspace((unsigned char)*c)) c++;
+        size_t length = c - start;
+
+        QueryTerm term = { -1, NULL, 0, false };
+        if(length > 0 && start[length - 1] == '*') {
+            term.prefix = true;
+            length--;
+        }
+
+        const char *colon = memchr(start, ':', length);
+        for(int f = 0; f < NUM_SEARCH_FIELDS && colon != NULL; f++) {
+            if(strlen(searchFields[f]) == (size_t)(colon - start) && strncmp(start, searchFields[f], colon - start) == 0) {
+                term.field = f;
+                length -= colon + 1 - start;
+                start = colon + 1;
+                break;
+            }
+        }
+        if(length == 0) continue;
+
+        // The value is made into a term the way indexed values are, and the field is put back per field searched
+        char *value = makeTerm("", start, length);
+        term.value = value;
+        term.length = strlen(value);
+        terms[numTerms++] = term;
+    }
+
+    return numTerms;
+}
+
+/**
+ * @brief returns whether an indexed term is matched by a search term
+ *
+ * @param text
+ * @param key the field and value searched for
+ * @param length
+ * @param prefix
+ * @return true
+ * @return false
+ */
+static bool termMatches(const char *text, const char *key, size_t length, bool prefix) {
+    return prefix ? strncmp(text, key, length) == 0 : strcmp(text, key) == 0;
+}
+
+/**
+ * @brief marks the files that have a term
+ *
+ * @param index
+ * @param key the field and value searched for
+ * @param prefix
+ * @param hits one per file of the index file, followed by one per file of the journal
+ */
+static void findTerm(const SearchIndex *index, const char *key, bool prefix, bool *hits) {
+    size_t length = strlen(key);
+
+    // First term not before the key
+    uint32_t low = 0, high = index->map != NULL ? index->header->numTerms : 0;
+    while(low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        if(strcmp(indexString(index, index->terms[mid].text), key) < 0) low = mid + 1;
+        else high = mid;
+    }
+
+    for(uint32_t t = low; index->map != NULL && t < index->header->numTerms; t++) {
+        const IndexTerm *term = &index->terms[t];
+        if(!termMatches(indexString(index, term->text), key, length, prefix)) break;
+        if(term->postings > index->header->numPostings || term->numPostings > index->header->numPostings - term->postings)
+            continue;
+
+        for(uint32_t p = term->postings; p < term->postings + term->numPostings; p++) {
+            if(index->postings[p] < (uint32_t)index->numDocs) hits[index->postings[p]] = true;
+        }
+    }
+
+    for(int j = 0; j < index->numJournal; j++) {
+        const SearchDoc *doc = &index->journal[j];
+
+        int first = 0, last = doc->numTerms;
+        while(first < last) {
+            int mid = first + (last - first) / 2;
+            if(strcmp(doc->terms[mid], key) < 0) first = mid + 1;
+            else last = mid;
+        }
+
+        if(first < doc->numTerms && termMatches(doc->terms[first], key, length, prefix))
+            hits[index->numDocs + j] = true;
+    }
+}
+
+/**
+ * @brief qsort comparison of search results by file name
+ *
+ * @param first
+ * @param second
+ * @return int
+ */
+static int compareResults(const void *first, const void *second) {
+    return strcmp(((const SearchResult*)first)->name, ((const SearchResult*)second)->name);
+}
+
+/**
+ * @brief searches the index of a directory for the files that have every term of a query.  A term is a word of
+ * the title or description, an id or class value or an element type (rect, circle, path or g), optionally
+ * limited to one field as title:, desc:, id:, class: or type:, and matched as a prefix if it ends with *.
+ * Terms are matched without regard to case
+ *
+ * @param directory
+ * @param query such as "type:circle title:sun*"
+ * @param callback called with each file found, in order of name
+ * @param context passed to the callback
+ * @return int number of files found, or -1 if the query has no terms or the index is damaged.  A directory
+ * without an index has no files to find
+ */
+int searchSVGIndex(const char *directory, const char *query, SVGSearchCallback callback, void *context) {
+    if(directory == NULL || query == NULL || callback == NULL) return -1;
+
+    QueryTerm terms[MAX_QUERY_TERMS];
+    int numTerms = parseSearchQuery(query, terms);
+    if(numTerms == 0) return -1;
+
+    // The index file stays mapped after a rebuild renames over it, and a journal cache replaced meanwhile is kept
+    // until it is released, so only reading and releasing the index need the lock
+    SearchIndex index;
+    pthread_mutex_lock(&searchLock);
+    bool loaded = loadSearchIndex(directory, &index);
+    pthread_mutex_unlock(&searchLock);
+
+    int numFound = -1;
+    if(loaded) {
+        int numDocs = index.numDocs + index.numJournal;
+        bool *matched = svgMalloc((numDocs > 0 ? numDocs : 1) * sizeof(bool));
+        bool *hits = svgMalloc((numDocs > 0 ? numDocs : 1) * sizeof(bool));
+        for(int i = 0; i < numDocs; i++) matched[i] = i >= index.numDocs || !index.superseded[i];
+
+        for(int t = 0; t < numTerms; t++) {
+            memset(hits, 0, numDocs * sizeof(bool));
+
+            for(int f = 0; f < NUM_SEARCH_FIELDS; f++) {
+                if(terms[t].field >= 0 && terms[t].field != f) continue;
+
+                char *key = svgMalloc(strlen(searchFields[f]) + terms[t].length + 2);
+                sprintf(key, "%s%s", searchFields[f], terms[t].value);
+                findTerm(&index, key, terms[t].prefix, hits);
+                svgFree(key);
+            }
+
+            for(int i = 0; i < numDocs; i++) matched[i] = matched[i] && hits[i];
+        }
+
+        SearchResult *results = svgMalloc((numDocs > 0 ? numDocs : 1) * sizeof(SearchResult));
+        numFound = 0;
+        for(int i = 0; i < numDocs; i++) {
+            if(!matched[i]) continue;
+
+            if(i < index.numDocs) {
+                results[numFound].name = indexString(&index, index.docs[i].name);
+                results[numFound].title = indexString(&index, index.docs[i].title);
+                results[numFound].description = indexString(&index, index.docs[i].description);
+            } else {
+                const SearchDoc *doc = &index.journal[i - index.numDocs];
+                results[numFound].name = doc->name;
+                results[numFound].title = doc->title;
+                results[numFound].description = doc->description;
+            }
+            numFound++;
+        }
+
+        if(numFound > 1) qsort(results, numFound, sizeof(SearchResult), compareResults);
+        for(int i = 0; i < numFound; i++)
+            callback(results[i].name, results[i].title, results[i].description, context);
+
+        svgFree(results);
+        svgFree(hits);
+        svgFree(matched);
+    }
+
+    pthread_mutex_lock(&searchLock);
+    freeSearchIndex(&index);
+    pthread_mutex_unlock(&searchLock);
+    for(int t = 0; t < numTerms; t++) svgFree(terms[t].value);
+
+    return numFound;
+}
+
+/**
+ * @brief callback of searchSVGIndexWrapper, adding a file to the JSON array of results
+ *
+ * @param fileName
+ * @param title
+ * @param description
+ * @param context the StringBuffer of the array
+ */
+static void appendSearchResult(const char *fileName, const char *title, const char *description, void *context) {
+    StringBuffer *results = (StringBuffer*)context;
+
+    appendString(results, results->length > 1 ? ",{\"file\":" : "{\"file\":");
+    appendJSONString(results, fileName);
+    appendString(results, ",\"title\":");
+    appendJSONString(results, title);
+    appendString(results, ",\"desc\":");
+    appendJSONString(results, description);
+    appendString(results, "}");
+}
+
+/**
+ * @brief searches the index of a directory for the server, returning [{"file":"name.svg","title":"","desc":""},...]
+ * in order of name
+ *
+ * @param directory
+ * @param query
+ * @return char* NULL if the query has no terms, the index is damaged or the results cannot be allocated
+ */
+char *searchSVGIndexWrapper(char *directory, char *query) {
+    StringBuffer results;
+    if(!initStringBuffer(&results, 256)) return NULL;
+    appendString(&results, "[");
+
+    if(searchSVGIndex(directory, query, appendSearchResult, &results) < 0) {
+        svgFree(results.data);
+        return NULL;
+    }
+
+    if(!appendString(&results, "]")) {
+        svgFree(results.data);
+        return NULL;
+    }
+    return results.data;
+}
@@ -0,0 +1,594 @@
+/**
+ * @file SVGSpatial.c
+ * @author Anthony Vidovic (1130891)
+ * @brief Spatial index (packed R-tree) over the rectangles and circles of an svg struct
+ * @version 0.1
+ * @date 2022-04-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+// ~~~~~ Includes ~~~~~ //
+#include "SVGHelper.h"
+
+/*
+ * The tree is bulk loaded with Sort-Tile-Recursive and stored packed: level 0 holds the
+ * element boxes in STR order, and node i of level k covers entries [i * RTREE_FANOUT, (i + 1) * RTREE_FANOUT)
+ * of level k - 1.  Children are never stored explicitly.
+ */
+#define RTREE_FANOUT 16
+
+/**
+ * @brief returns true if the two boxes overlap
+ *
+ * @param a
+ * @param b
+ * @return true
+ * @return false
+ */
+static bool boxesIntersect(const BoundingBox *a, const BoundingBox *b) {
+    return a->minX <= b->maxX && a->maxX >= b->minX && a->minY <= b->maxY && a->maxY >= b->minY;
+}
+
+/**
+ * @brief returns the squared distance from a point to the closest point of a box
+ *
+ * @param box
+ * @param x
+ * @param y
+ * @return double 0 if the point is inside the box
+ */
+static double boxDistanceSquared(const BoundingBox *box, double x, double y) {
+    double dx = x < box->minX ? box->minX - x : (x > box->maxX ? x - box->maxX : 0);
+    double dy = y < box->minY ? box->minY - y : (y > box->maxY ? y - box->maxY : 0);
+
+    return dx * dx + dy * dy;
+}
+
+/**
+ * @brief returns the squared distance from a point to an element, using the exact
+ * shape for circles
+ *
+ * @param img
+ * @param id
+ * @param box bounding box of the element
+ * @param x
+ * @param y
+ * @return double
+ */
+static double elementDistanceSquared(const SVG *img, int id, const BoundingBox *box, double x, double y) {
+    elementType type;
+    void *elem = getElementByID(img, id, &type);
+
+    if(type == CIRC) {
+        Circle *c = (Circle*)elem;
+        double d = sqrt((x - c->cx) * (x - c->cx) + (y - c->cy) * (y - c->cy)) - c->r;
+        return d > 0 ? d * d : 0;
+    }
+    return boxDistanceSquared(box, x, y);
+}
+
+/**
+ * @brief computes the bounding box of a rectangle or circle
+ *
+ * @param type
+ * @param elem
+ * @param box set to the bounding box
+ * @return true if the element has a finite box
+ * @return false
+ */
+static bool shapeBox(elementType type, void *elem, BoundingBox *box) {
+    if(type == RECT) {
+        Rectangle *r = (Rectangle*)elem;
+        box->minX = r->x;
+        box->minY = r->y;
+        box->maxX = r->x + r->width;
+        box->maxY = r->y + r->height;
+    } else if(type == CIRC) {
+        Circle *c = (Circle*)elem;
+        box->minX = c->cx - c->r;
+        box->minY = c->cy - c->r;
+        box->maxX = c->cx + c->r;
+        box->maxY = c->cy + c->r;
+    } else {
+        return false;
+    }
+
+    return isfinite(box->minX) && isfinite(box->minY) && isfinite(box->maxX) && isfinite(box->maxY);
+}
+
+/**
+ * @brief frees a spatial index
+ *
+ * @param index
+ */
+void freeSpatialIndex(SpatialIndex *index) {
+    if(index == NULL) return;
+
+    for(int i = 0; i < index->numLevels; i++)
+        svgFree(index->levels[i].boxes);
+
+    svgFree(index->levels);
+    svgFree(index->ids);
+    svgFree(index);
+}
+
+/**
+ * @brief discards the spatial index of an svg struct, it is rebuilt by the next spatial query
+ *
+ * @param svg
+ */
+void invalidateSpatialIndex(SVG *svg) {
+    if(svg == NULL) return;
+
+    freeSpatialIndex(svg->spatialIndex);
+    svg->spatialIndex = NULL;
+}
+
+// Entry used while sorting the leaves
+typedef struct {
+    BoundingBox box;
+    int id;
+    float centre;
+} STREntry;
+
+static int compareCentres(const void *first, const void *second) {
+    float a = ((const STREntry*)first)->centre;
+    float b = ((const STREntry*)second)->centre;
+
+    return (a > b) - (a < b);
+}
+
+/**
+ * @brief bulk loads a spatial index over every rectangle and circle in the svg struct
+ *
+ * @param svg
+ * @return SpatialIndex*
+ */
+static SpatialIndex* buildSpatialIndex(const SVG *svg) {
+    SpatialIndex *index = svgCalloc(1, sizeof(SpatialIndex));
+    if(index == NULL) return NULL;
+
+    STREntry *entries = svgMalloc(sizeof(STREntry) * (svg->numElements > 0 ? svg->numElements : 1));
+    if(entries == NULL) {
+        svgFree(index);
+        return NULL;
+    }
+
+    int n = 0;
+    for(int id = 0; id < svg->numElements; id++) {
+        elementType type;
+        void *elem = getElementByID(svg, id, &type);
+
+        if(shapeBox(type, elem, &entries[n].box)) {
+            entries[n].id = id;
+            n++;
+        }
+    }
+
+    // Sort-Tile-Recursive: cut the entries into vertical slices by x, then sort each slice by y
+    int numPages = (n + RTREE_FANOUT - 1) / RTREE_FANOUT;
+    int numSlices = (int)ceil(sqrt((double)numPages));
+    int sliceSize = numSlices * RTREE_FANOUT;
+
+    for(int i = 0; i < n; i++)
+        entries[i].centre = (entries[i].box.minX + entries[i].box.maxX) / 2;
+    qsort(entries, n, sizeof(STREntry), compareCentres);
+
+    for(int start = 0; start < n; start += sliceSize) {
+        int len = start + sliceSize > n ? n - start : sliceSize;
+
+        for(int i = start; i < start + len; i++)
+            entries[i].centre = (entries[i].box.minY + entries[i].box.maxY) / 2;
+        qsort(&entries[start], len, sizeof(STREntry), compareCentres);
+    }
+
+    // Level 0 holds the element boxes, each higher level packs RTREE_FANOUT boxes of the level below
+    int maxLevels = 1;
+    for(int len = n; len > 1; len = (len + RTREE_FANOUT - 1) / RTREE_FANOUT)
+        maxLevels++;
+
+    index->levels = svgMalloc(sizeof(RTreeLevel) * maxLevels);
+    index->ids = svgMalloc(sizeof(int) * (n > 0 ? n : 1));
+    if(index->levels != NULL) index->levels[0].boxes = svgMalloc(sizeof(BoundingBox) * (n > 0 ? n : 1));
+
+    if(index->levels == NULL || index->ids == NULL || index->levels[0].boxes == NULL) {
+        if(index->levels != NULL) svgFree(index->levels[0].boxes);
+        svgFree(entries);
+        freeSpatialIndex(index);
+        return NULL;
+    }
+    index->levels[0].length = n;
+    index->numLevels = 1;
+
+    for(int i = 0; i < n; i++) {
+        index->levels[0].boxes[i] = entries[i].box;
+        index->ids[i] = entries[i].id;
+    }
+    svgFree(entries);
+
+    while(index->levels[index->numLevels - 1].length > 1) {
+        RTreeLevel *below = &index->levels[index->numLevels - 1];
+        RTreeLevel *level = &index->levels[index->numLevels];
+
+        level->length = (below->length + RTREE_FANOUT - 1) / RTREE_FANOUT;
+        level->boxes = svgMalloc(sizeof(BoundingBox) * level->length);
+        if(level->boxes == NULL) {
+            freeSpatialIndex(index);
+            return NULL;
+        }
+
+        for(int i = 0; i < level->length; i++) {
+            int first = i * RTREE_FANOUT;
+            int last = first + RTREE_FANOUT > below->length ? below->length : first + RTREE_FANOUT;
+            BoundingBox box = below->boxes[first];
+
+            for(int j = first + 1; j < last; j++) {
+                if(below->boxes[j].minX < box.minX) box.minX = below->boxes[j].minX;
+                if(below->boxes[j].minY < box.minY) box.minY = below->boxes[j].minY;
+                if(below->boxes[j].maxX > box.maxX) box.maxX = below->boxes[j].maxX;
+                if(below->boxes[j].maxY > box.maxY) box.maxY = below->boxes[j].maxY;
+            }
+            level->boxes[i] = box;
+        }
+        index->numLevels++;
+    }
+
+    return index;
+}
+
+/**
+ * @brief returns the spatial index of the svg struct, building it if needed
+ *
+ * @param svg
+ * @return SpatialIndex*
+ */
+SpatialIndex* getSpatialIndex(const SVG *svg) {
+    if(svg == NULL) return NULL;
+
+    // The index is a cache, building it does not change the document
+    SVG *img = (SVG*)svg;
+
+    if(img->spatialIndex == NULL)
+        img->spatialIndex = buildSpatialIndex(svg);
+
+    return img->spatialIndex;
+}
+
+/**
+ * @brief appends an element ID to a growable result array
+ *
+ * @param results
+ * @param length
+ * @param capacity
+ * @param id
+ * @return true
+ * @return false if the array cannot grow, it is left as it was
+ */
+static bool appendResult(int **results, int *length, int *capacity, int id) {
+    if(*length == *capacity) {
+        int newCapacity = *capacity > 0 ? *capacity * 2 : 16;
+        int *grown = svgRealloc(*results, sizeof(int) * newCapacity);
+        if(grown == NULL) return false;
+
+        *results = grown;
+        *capacity = newCapacity;
+    }
+    (*results)[(*length)++] = id;
+    return true;
+}
+
+/**
+ * @brief collects the IDs of all elements whose box intersects the query box.
+ * If exact is true, circles are only reported when the circle itself touches the box
+ *
+ * @param img
+ * @param query
+ * @param exact
+ * @param numFound set to the number of IDs returned
+ * @return int* array of element IDs, NULL if none were found or memory ran out
+ */
+static int* searchSpatialIndex(const SVG *img, const BoundingBox *query, bool exact, int *numFound) {
+    *numFound = 0;
+
+    SpatialIndex *index = getSpatialIndex(img);
+    if(index == NULL || index->levels[0].length == 0) return NULL;
+
+    int *results = NULL;
+    int capacity = 0;
+
+    // Explicit stack of (level, node) pairs, at most RTREE_FANOUT entries per level are pending
+    int stackSize = RTREE_FANOUT * index->numLevels + 1;
+    int *stackLevels = svgMalloc(sizeof(int) * stackSize);
+    int *stackNodes = svgMalloc(sizeof(int) * stackSize);
+    int top = 0;
+
+    if(stackLevels == NULL || stackNodes == NULL) {
+        svgFree(stackLevels);
+        svgFree(stackNodes);
+        return NULL;
+    }
+
+    int rootLevel = index->numLevels - 1;
+    for(int i = 0; i < index->levels[rootLevel].length; i++) {
+        stackLevels[top] = rootLevel;
+        stackNodes[top++] = i;
+    }
+
+    double qx = (query->minX + query->maxX) / 2;
+    double qy = (query->minY + query->maxY) / 2;
+    bool isPoint = query->minX == query->maxX && query->minY == query->maxY;
+
+    while(top > 0) {
+        top--;
+        int level = stackLevels[top];
+        int node = stackNodes[top];
+        const BoundingBox *box = &index->levels[level].boxes[node];
+
+        if(!boxesIntersect(box, query)) continue;
+
+        if(level == 0) {
+            int id = index->ids[node];
+            elementType type;
+            Circle *c = (Circle*)getElementByID(img, id, &type);
+
+            if(exact && type == CIRC) {
+                // Distance from the centre to the closest point of the query box
+                double nx = c->cx < query->minX ? query->minX : (c->cx > query->maxX ? query->maxX : c->cx);
+                double ny = c->cy < query->minY ? query->minY : (c->cy > query->maxY ? query->maxY : c->cy);
+                if(isPoint) {
+                    nx = qx;
+                    ny = qy;
+                }
+                if((nx - c->cx) * (nx - c->cx) + (ny - c->cy) * (ny - c->cy) > (double)c->r * c->r)
+                    continue;
+            }
+            if(!appendResult(&results, numFound, &capacity, id)) {
+                // A partial answer would look complete to the caller
+                svgFree(results);
+                results = NULL;
+                *numFound = 0;
+                break;
+            }
+            continue;
+        }
+
+        int first = node * RTREE_FANOUT;
+        int last = first + RTREE_FANOUT > index->levels[level - 1].length ? index->levels[level - 1].length : first + RTREE_FANOUT;
+
+        for(int child = first; child < last; child++) {
+            stackLevels[top] = level - 1;
+            stackNodes[top++] = child;
+        }
+    }
+
+    svgFree(stackLevels);
+    svgFree(stackNodes);
+    return results;
+}
+
+/**
+ * @brief Function that returns the IDs of all rectangles and circles containing a point
+ *
+ * @param img
+ * @param x
+ * @param y
+ * @param numFound
+ * @return int*
+ */
+int* findElementsAtPoint(const SVG* img, float x, float y, int* numFound) {
+    if(numFound == NULL) return NULL;
+    *numFound = 0;
+    if(img == NULL) return NULL;
+
+    BoundingBox query = { x, y, x, y };
+    return searchSpatialIndex(img, &query, true, numFound);
+}
+
+/**
+ * @brief Function that returns the IDs of all rectangles and circles intersecting a region
+ *
+ * @param img
+ * @param minX
+ * @param minY
+ * @param maxX
+ * @param maxY
+ * @param numFound
+ * @return int*
+ */
+int* findElementsInRegion(const SVG* img, float minX, float minY, float maxX, float maxY, int* numFound) {
+    if(numFound == NULL) return NULL;
+    *numFound = 0;
+    if(img == NULL || minX > maxX || minY > maxY) return NULL;
+
+    BoundingBox query = { minX, minY, maxX, maxY };
+    return searchSpatialIndex(img, &query, true, numFound);
+}
+
+// Pending node or element of a nearest neighbour search, ordered by distance
+typedef struct {
+    double distance;
+    int level;
+    int node;
+} NearestCandidate;
+
+/**
+ * @brief pushes a candidate onto a binary min heap ordered by distance
+ *
+ * @param heap
+ * @param length
+ * @param capacity
+ * @param candidate
+ * @return true
+ * @return false if the heap cannot grow, it is left as it was
+ */
+static bool heapPush(NearestCandidate **heap, int *length, int *capacity, NearestCandidate candidate) {
+    if(*length == *capacity) {
+        int newCapacity = *capacity * 2;
+        NearestCandidate *grown = svgRealloc(*heap, sizeof(NearestCandidate) * newCapacity);
+        if(grown == NULL) return false;
+
+        *heap = grown;
+        *capacity = newCapacity;
+    }
+
+    int i = (*length)++;
+    while(i > 0) {
+        int parent = (i - 1) / 2;
+        if((*heap)[parent].distance <= candidate.distance) break;
+
+        (*heap)[i] = (*heap)[parent];
+        i = parent;
+    }
+    (*heap)[i] = candidate;
+    return true;
+}
+
+/**
+ * @brief removes and returns the closest candidate of a binary min heap
+ *
+ * @param heap
+ * @param length
+ * @return NearestCandidate
+ */
+static NearestCandidate heapPop(NearestCandidate *heap, int *length) {
+    NearestCandidate top = heap[0];
+    NearestCandidate last = heap[--(*length)];
+
+    int i = 0;
+    while(true) {
+        int child = i * 2 + 1;
+        if(child >= *length) break;
+        if(child + 1 < *length && heap[child + 1].distance < heap[child].distance) child++;
+        if(last.distance <= heap[child].distance) break;
+
+        heap[i] = heap[child];
+        i = child;
+    }
+    if(*length > 0) heap[i] = last;
+
+    return top;
+}
+
+/**
+ * @brief Function that returns the IDs of the k rectangles and circles closest to a point, closest first
+ *
+ * @param img
+ * @param x
+ * @param y
+ * @param k
+ * @param numFound
+ * @return int*
+ */
+int* findNearestElements(const SVG* img, float x, float y, int k, int* numFound) {
+    if(numFound == NULL) return NULL;
+    *numFound = 0;
+    if(img == NULL || k <= 0) return NULL;
+
+    SpatialIndex *index = getSpatialIndex(img);
+    if(index == NULL || index->levels[0].length == 0) return NULL;
+
+    int *results = svgMalloc(sizeof(int) * k);
+    int capacity = 64;
+    int length = 0;
+    NearestCandidate *heap = svgMalloc(sizeof(NearestCandidate) * capacity);
+    bool failed = results == NULL || heap == NULL;
+
+    // Best first search: nodes are expanded in order of their distance to the point, and an
+    // element popped from the heap is closer than anything still pending
+    int rootLevel = index->numLevels - 1;
+    for(int i = 0; i < index->levels[rootLevel].length && !failed; i++) {
+        NearestCandidate c = { boxDistanceSquared(&index->levels[rootLevel].boxes[i], x, y), rootLevel, i };
+        failed = !heapPush(&heap, &length, &capacity, c);
+    }
+
+    // A candidate that could not be queued might be among the closest, so a search that drops one fails
+    while(!failed && length > 0 && *numFound < k) {
+        NearestCandidate c = heapPop(heap, &length);
+
+        if(c.level < 0) {
+            results[(*numFound)++] = index->ids[c.node];
+            continue;
+        }
+
+        if(c.level == 0) {
+            // Re-queue the element with its exact distance
+            NearestCandidate exact = { elementDistanceSquared(img, index->ids[c.node], &index->levels[0].boxes[c.node], x, y), -1, c.node };
+            failed = !heapPush(&heap, &length, &capacity, exact);
+            continue;
+        }
+
+        int first = c.node * RTREE_FANOUT;
+        int last = first + RTREE_FANOUT > index->levels[c.level - 1].length ? index->levels[c.level - 1].length : first + RTREE_FANOUT;
+
+        for(int child = first; child < last && !failed; child++) {
+            NearestCandidate next = { boxDistanceSquared(&index->levels[c.level - 1].boxes[child], x, y), c.level - 1, child };
+            failed = !heapPush(&heap, &length, &capacity, next);
+        }
+    }
+
+    svgFree(heap);
+
+    if(failed) *numFound = 0;
+    if(*numFound == 0) {
+        svgFree(results);
+        return NULL;
+    }
+    return results;
+}
+
+// Point asked for by getElementsAtPointWrapper and the JSON answering it
+typedef struct {
+    float x;
+    float y;
+    char *json;
+} PointQuery;
+
+/**
+ * @brief writes the IDs of the elements containing a point of a cached struct as a JSON array
+ *
+ * @param svg
+ * @param context the PointQuery, its JSON is set
+ */
+static void elementsAtPointToJSON(SVG *svg, void *context) {
+    PointQuery *query = (PointQuery*)context;
+
+    int numFound = 0;
+    int *ids = findElementsAtPoint(svg, query->x, query->y, &numFound);
+
+    StringBuffer buffer;
+    if(!initStringBuffer(&buffer, 64)) {
+        svgFree(ids);
+        return;
+    }
+    appendBytes(&buffer, "[", 1);
+    for(int i = 0; i < numFound; i++) {
+        char id[16];
+        snprintf(id, sizeof(id), i > 0 ? ",%d" : "%d", ids[i]);
+        appendString(&buffer, id);
+    }
+    svgFree(ids);
+
+    if(!appendBytes(&buffer, "]", 1)) {
+        svgFree(buffer.data);
+        return;
+    }
+    query->json = buffer.data;
+}
+
+/**
+ * @brief gets the IDs of all rectangles and circles containing a point, as a JSON array.  The struct and its
+ * spatial index are cached until the file changes, so only the first query of a file builds the tree
+ *
+ * @param filename
+ * @param schemaFile
+ * @param x
+ * @param y
+ * @return char* NULL if the file cannot be read or is not valid, or the JSON cannot be allocated
+ */
+char *getElementsAtPointWrapper(char *filename, char *schemaFile, float x, float y) {
+    PointQuery query = { x, y, NULL };
+    useCachedSVG(filename, schemaFile, elementsAtPointToJSON, &query);
+    return query.json;
+}
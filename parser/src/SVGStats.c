@@ -0,0 +1,179 @@
+/**
+ * @file SVGStats.c
+ * @author Anthony Vidovic (1130891)
+ * @brief Timers and counters of the phases of parsing, validating, serializing and writing svg files
+ * @version 0.1
+ * @date 2022-04-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+// clock_gettime is POSIX, not C11
+#define _POSIX_C_SOURCE 200809L
+
+// ~~~~~ Includes ~~~~~ //
+#include "SVGHelper.h"
+#include <stdatomic.h>
+#include <time.h>
+
+// Name of each phase in the JSON of getParserStats, indexed by statPhase
+static const char *phaseNames[STAT_NUM_PHASES] = {
+    "read", "schemaCompile", "validate", "build", "dom", "json", "write"
+};
+
+// Counters of one thread.  Only the owning thread adds to them, so the relaxed loads and stores compile to
+// plain moves, and readers on other threads see whole values
+typedef struct StatsSlot {
+    _Atomic uint64_t calls[STAT_NUM_PHASES];
+    _Atomic uint64_t ns[STAT_NUM_PHASES];
+    _Atomic uint64_t bytes[STAT_NUM_PHASES];
+    _Atomic uint64_t elements[STAT_NUM_PHASES];
+    _Atomic uint64_t allocations[STAT_NUM_PHASES];
+    struct StatsSlot *next;
+} StatsSlot;
+
+static atomic_bool statsEnabled = false;
+
+// Slots of every thread that has recorded a phase.  Slots are never freed, so the counts of a thread that has
+// exited are kept
+static _Atomic(StatsSlot*) statsSlots = NULL;
+static _Atomic int numStatsSlots = 0;
+static _Thread_local StatsSlot *threadSlot = NULL;
+
+/**
+ * @brief turns the phase timers and counters on or off.  They start off, and while they are off
+ * startPhase and endPhase return without reading the clock
+ *
+ * @param enabled
+ */
+void setParserStatsEnabled(bool enabled) {
+    atomic_store_explicit(&statsEnabled, enabled, memory_order_relaxed);
+}
+
+/**
+ * @brief returns the slot of the calling thread, adding it to the list of slots on first use
+ *
+ * @return StatsSlot* NULL if it cannot be allocated
+ */
+static StatsSlot *getThreadSlot(void) {
+    if(threadSlot != NULL) return threadSlot;
+
+    // Slots outlive any allocator set with setSVGAllocator, so they come from calloc
+    StatsSlot *slot = calloc(1, sizeof(StatsSlot));
+    if(slot == NULL) return NULL;
+
+    slot->next = atomic_load(&statsSlots);
+    while(!atomic_compare_exchange_weak(&statsSlots, &slot->next, slot));
+    atomic_fetch_add(&numStatsSlots, 1);
+
+    return threadSlot = slot;
+}
+
+/**
+ * @brief adds to a counter owned by the calling thread
+ *
+ * @param counter
+ * @param value
+ */
+static void addToCounter(_Atomic uint64_t *counter, uint64_t value) {
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + value, memory_order_relaxed);
+}
+
+/**
+ * @brief returns the time a phase starts, and the allocations made on the calling thread so far, to be passed to endPhase
+ *
+ * @return PhaseTimer ns is the monotonic clock in nanoseconds, or 0 if stats are disabled
+ */
+PhaseTimer startPhase(void) {
+    PhaseTimer timer = { 0, 0 };
+    if(!atomic_load_explicit(&statsEnabled, memory_order_relaxed)) return timer;
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    // 0 means disabled, a clock reading of exactly 0 is moved by a nanosecond
+    timer.ns = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    if(timer.ns == 0) timer.ns = 1;
+    timer.allocations = threadAllocationCount();
+
+    return timer;
+}
+
+/**
+ * @brief records a call of a phase
+ *
+ * @param phase
+ * @param timer returned by startPhase.  Nothing is recorded if its time is 0
+ * @param bytes bytes read or written by the call
+ * @param elements elements handled by the call
+ */
+void endPhase(statPhase phase, const PhaseTimer *timer, size_t bytes, size_t elements) {
+    if(timer->ns == 0 || phase < 0 || phase >= STAT_NUM_PHASES) return;
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t now = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+
+    StatsSlot *slot = getThreadSlot();
+    if(slot == NULL) return;
+
+    addToCounter(&slot->calls[phase], 1);
+    addToCounter(&slot->ns[phase], now > timer->ns ? now - timer->ns : 0);
+    addToCounter(&slot->bytes[phase], bytes);
+    addToCounter(&slot->elements[phase], elements);
+    addToCounter(&slot->allocations[phase], threadAllocationCount() - timer->allocations);
+}
+
+/**
+ * @brief clears the counters of every thread.  A phase ending on another thread during the reset may keep its count
+ *
+ */
+void resetParserStats(void) {
+    for(StatsSlot *slot = atomic_load(&statsSlots); slot; slot = slot->next) {
+        for(int i = 0; i < STAT_NUM_PHASES; i++) {
+            atomic_store_explicit(&slot->calls[i], 0, memory_order_relaxed);
+            atomic_store_explicit(&slot->ns[i], 0, memory_order_relaxed);
+            atomic_store_explicit(&slot->bytes[i], 0, memory_order_relaxed);
+            atomic_store_explicit(&slot->elements[i], 0, memory_order_relaxed);
+            atomic_store_explicit(&slot->allocations[i], 0, memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * @brief returns the counters of every phase, summed over all threads, as JSON:
+ * {"enabled":true,"threads":1,"phases":{"read":{"calls":2,"ns":15000,"bytes":4096,"elements":0,"allocations":0},...}}.
+ * Allocations are only counted with the accounting allocator
+ *
+ * @return char*
+ */
+char* getParserStats(void) {
+    uint64_t calls[STAT_NUM_PHASES] = { 0 }, ns[STAT_NUM_PHASES] = { 0 };
+    uint64_t bytes[STAT_NUM_PHASES] = { 0 }, elements[STAT_NUM_PHASES] = { 0 }, allocations[STAT_NUM_PHASES] = { 0 };
+
+    for(StatsSlot *slot = atomic_load(&statsSlots); slot; slot = slot->next) {
+        for(int i = 0; i < STAT_NUM_PHASES; i++) {
+            calls[i] += atomic_load_explicit(&slot->calls[i], memory_order_relaxed);
+            ns[i] += atomic_load_explicit(&slot->ns[i], memory_order_relaxed);
+            bytes[i] += atomic_load_explicit(&slot->bytes[i], memory_order_relaxed);
+            elements[i] += atomic_load_explicit(&slot->elements[i], memory_order_relaxed);
+            allocations[i] += atomic_load_explicit(&slot->allocations[i], memory_order_relaxed);
+        }
+    }
+
+    // Each phase takes at most about 170 characters
+    size_t size = 64 + STAT_NUM_PHASES * 200;
+    char *json = svgMalloc(size);
+    int len = snprintf(json, size, "{\"enabled\":%s,\"threads\":%d,\"phases\":{",
+                       atomic_load(&statsEnabled) ? "true" : "false", atomic_load(&numStatsSlots));
+
+    for(int i = 0; i < STAT_NUM_PHASES; i++) {
+        len += snprintf(json + len, size - len, "%s\"%s\":{\"calls\":%llu,\"ns\":%llu,\"bytes\":%llu,\"elements\":%llu,\"allocations\":%llu}",
+                        i > 0 ? "," : "", phaseNames[i], (unsigned long long)calls[i], (unsigned long long)ns[i],
+                        (unsigned long long)bytes[i], (unsigned long long)elements[i], (unsigned long long)allocations[i]);
+    }
+    snprintf(json + len, size - len, "}}");
+
+    return json;
+}
@@ -0,0 +1,359 @@
+/**
+ * @file SVGWalk.c
+ * @author Anthony Vidovic (1130891)
+ * @brief Walks over nested groups without recursion, the visitors run over the elements of a walk, and the nesting
+ * limit of files read by the library
+ * @version 0.1
+ * @date 2022-04-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+// ~~~~~ Includes ~~~~~ //
+#include "SVGHelper.h"
+#include <stdatomic.h>
+
+// Capacity of a stack the first time it grows
+#define INITIAL_STACK_CAPACITY 16
+
+static atomic_int maxDepth = SVG_DEFAULT_MAX_DEPTH;
+
+/**
+ * @brief sets how deeply elements may be nested in the files read by createSVG and createValidSVG
+ *
+ * @param depth deepest nesting accepted, the svg element being at depth 1.  Values below 1 restore the default
+ */
+void setSVGMaxDepth(int depth) {
+    atomic_store(&maxDepth, depth >= 1 ? depth : SVG_DEFAULT_MAX_DEPTH);
+}
+
+int getSVGMaxDepth(void) {
+    return atomic_load(&maxDepth);
+}
+
+/**
+ * @brief doubles the capacity of a heap allocated stack
+ *
+ * @param items the stack, may be NULL when capacity is 0
+ * @param capacity updated to the new capacity
+ * @param itemSize
+ * @return void* the grown stack, or NULL if it cannot grow, leaving items as it was
+ */
+void* growStack(void *items, int *capacity, size_t itemSize) {
+    int grown = *capacity > 0 ? *capacity * 2 : INITIAL_STACK_CAPACITY;
+    if(grown < *capacity || (size_t)grown > SIZE_MAX / itemSize) return NULL;
+
+    void *resized = svgRealloc(items, grown * itemSize);
+    if(resized != NULL) *capacity = grown;
+
+    return resized;
+}
+
+/**
+ * @brief starts a walk over every group in a list and every group nested in them
+ *
+ * @param walk
+ * @param groups may be NULL or empty
+ */
+void beginGroupWalk(GroupWalk *walk, const List *groups) {
+    walk->cursors = NULL;
+    walk->depth = 0;
+    walk->capacity = 0;
+    walk->current = NULL;
+    walk->failed = false;
+
+    if(groups == NULL || groups->head == NULL) return;
+
+    walk->cursors = growStack(NULL, &walk->capacity, sizeof(Node*));
+    if(walk->cursors == NULL) {
+        walk->failed = true;
+        return;
+    }
+    walk->cursors[walk->depth++] = groups->head;
+}
+
+/**
+ * @brief returns the next group of a walk in document order, each group before the groups nested in it.
+ * After the call walk->depth is the nesting level of the group, 1 for the list the walk began with,
+ * and walk->current its node
+ *
+ * @param walk
+ * @return Group* NULL once every group has been returned, or if the stack cannot grow (walk->failed is set)
+ */
+Group* nextGroup(GroupWalk *walk) {
+    // The groups nested in the group returned last come before its siblings
+    Node *nested = walk->current != NULL ? ((Group*)walk->current->data)->groups->head : NULL;
+    walk->current = NULL;
+
+    if(nested != NULL) {
+        if(walk->depth == walk->capacity) {
+            Node **cursors = growStack(walk->cursors, &walk->capacity, sizeof(Node*));
+            if(cursors == NULL) {
+                walk->failed = true;
+                walk->depth = 0;
+                return NULL;
+            }
+            walk->cursors = cursors;
+        }
+        walk->cursors[walk->depth++] = nested;
+    }
+
+    // Leave every list that has been walked to its end
+    while(walk->depth > 0 && walk->cursors[walk->depth - 1] == NULL) walk->depth--;
+    if(walk->depth == 0) return NULL;
+
+    walk->current = walk->cursors[walk->depth - 1];
+    walk->cursors[walk->depth - 1] = walk->current->next;
+
+    return (Group*)walk->current->data;
+}
+
+/**
+ * @brief stops a walk from entering the groups nested in the group returned last
+ *
+ * @param walk
+ */
+void skipNestedGroups(GroupWalk *walk) {
+    walk->current = NULL;
+}
+
+void endGroupWalk(GroupWalk *walk) {
+    svgFree(walk->cursors);
+    walk->cursors = NULL;
+    walk->depth = 0;
+    walk->capacity = 0;
+    walk->current = NULL;
+}
+
+// Visitors of a walk by the element type they visit, found for one nesting level at a time
+typedef struct {
+    const SVGVisitor *visitors;
+    int numVisitors;
+    // Deepest level any visitor visits, 0 for every level
+    int deepest;
+    // Set if any visitor has a maxDepth.  Without one the active visitors are the same at every level and are
+    // found once
+    bool limited;
+    // Level the active visitors were found for, 0 before the first
+    int depth;
+    const SVGVisitor *active[GROUP + 1][MAX_WALK_VISITORS];
+    int numActive[GROUP + 1];
+} VisitPlan;
+
+/**
+ * @brief starts the plan of a walk
+ *
+ * @param plan
+ * @param visitors
+ * @param numVisitors at most MAX_WALK_VISITORS
+ */
+static void beginVisitPlan(VisitPlan *plan, const SVGVisitor *visitors, int numVisitors) {
+    plan->visitors = visitors;
+    plan->numVisitors = numVisitors;
+    plan->deepest = 0;
+    plan->limited = false;
+    plan->depth = 0;
+
+    bool unlimited = false;
+    for(int i = 0; i < numVisitors; i++) {
+        if(visitors[i].maxDepth <= 0) unlimited = true;
+        else plan->limited = true;
+
+        if(visitors[i].maxDepth > plan->deepest) plan->deepest = visitors[i].maxDepth;
+    }
+    if(unlimited) plan->deepest = 0;
+}
+
+/**
+ * @brief finds the visitors of each element type at a nesting level, so that the masks and depths are
+ * checked once for a level rather than for each element
+ *
+ * @param plan
+ * @param depth
+ */
+static void planLevel(VisitPlan *plan, int depth) {
+    if(plan->depth == depth || (plan->depth > 0 && !plan->limited)) return;
+    plan->depth = depth;
+
+    for(int type = 0; type <= GROUP; type++) {
+        plan->numActive[type] = 0;
+
+        for(int i = 0; i < plan->numVisitors; i++) {
+            const SVGVisitor *v = &plan->visitors[i];
+            if(!(v->types & (1 << type))) continue;
+            if(v->maxDepth > 0 && depth > v->maxDepth) continue;
+            plan->active[type][plan->numActive[type]++] = v;
+        }
+    }
+}
+
+/**
+ * @brief runs the visitors of an element's type on it, each one whose predicate accepts it
+ *
+ * @param plan
+ * @param element
+ */
+static void visitElement(const VisitPlan *plan, const VisitedElement *element) {
+    const SVGVisitor *const *active = plan->active[element->type];
+    int numActive = plan->numActive[element->type];
+
+    for(int i = 0; i < numActive; i++) {
+        if(active[i]->matches == NULL || active[i]->matches(element, active[i]->arg))
+            active[i]->visit(element, active[i]->context);
+    }
+}
+
+/**
+ * @brief visits the shapes held directly by the svg struct or a group, skipping the lists no visitor wants
+ *
+ * @param plan
+ * @param rectangles
+ * @param circles
+ * @param paths
+ * @param parent group holding the lists, NULL for the svg struct
+ * @param depth nesting level of the shapes
+ */
+static void visitShapes(VisitPlan *plan, const List *rectangles, const List *circles, const List *paths,
+                        Group *parent, int depth) {
+    const List *lists[] = { rectangles, circles, paths };
+    const elementType listTypes[] = { RECT, CIRC, PATH };
+
+    planLevel(plan, depth);
+
+    for(int i = 0; i < 3; i++) {
+        if(plan->numActive[listTypes[i]] == 0) continue;
+
+        VisitedElement element = { listTypes[i], NULL, parent, depth };
+        for(Node *cur = lists[i]->head; cur; cur = cur->next) {
+            element.data = cur->data;
+            visitElement(plan, &element);
+        }
+    }
+}
+
+/**
+ * @brief walks the groups of a list for visitGroups and visitSVG
+ *
+ * @param plan
+ * @param groups
+ * @return true
+ * @return false if the walk ran out of memory
+ */
+static bool walkPlan(VisitPlan *plan, const List *groups) {
+    // The group returned at each level of the walk, the parents of the elements below it
+    Group **parents = NULL;
+    int numParents = 0;
+    bool failed = false;
+
+    GroupWalk walk;
+    beginGroupWalk(&walk, groups);
+
+    for(Group *g = nextGroup(&walk); g; g = nextGroup(&walk)) {
+        if(walk.depth > numParents) {
+            Group **grown = growStack(parents, &numParents, sizeof(Group*));
+            if(grown == NULL) {
+                failed = true;
+                break;
+            }
+            parents = grown;
+        }
+        parents[walk.depth - 1] = g;
+
+        planLevel(plan, walk.depth);
+        if(plan->numActive[GROUP] > 0) {
+            VisitedElement element = { GROUP, g, walk.depth > 1 ? parents[walk.depth - 2] : NULL, walk.depth };
+            visitElement(plan, &element);
+        }
+
+        visitShapes(plan, g->rectangles, g->circles, g->paths, g, walk.depth + 1);
+
+        if(plan->deepest > 0 && walk.depth >= plan->deepest) skipNestedGroups(&walk);
+    }
+
+    failed = failed || walk.failed;
+    endGroupWalk(&walk);
+    svgFree(parents);
+
+    return !failed;
+}
+
+/**
+ * @brief runs visitors over every group in a list, in document order, each group followed by its shapes and
+ * then the groups nested in it.  The walk stops at the deepest level any visitor visits
+ *
+ * @param groups
+ * @param visitors
+ * @param numVisitors
+ * @return true
+ * @return false if the walk ran out of memory and did not visit every element, or there are more than
+ * MAX_WALK_VISITORS visitors
+ */
+bool visitGroups(const List *groups, const SVGVisitor *visitors, int numVisitors) {
+    if(groups == NULL || visitors == NULL || numVisitors < 1) return true;
+    if(numVisitors > MAX_WALK_VISITORS) return false;
+
+    VisitPlan plan;
+    beginVisitPlan(&plan, visitors, numVisitors);
+
+    return walkPlan(&plan, groups);
+}
+
+/**
+ * @brief runs visitors over every element of an svg struct in a single pass: its own rectangles, circles and
+ * paths, then its groups as visitGroups does
+ *
+ * @param svg
+ * @param visitors
+ * @param numVisitors
+ * @return true
+ * @return false if the walk ran out of memory and did not visit every element, or there are more than
+ * MAX_WALK_VISITORS visitors
+ */
+bool visitSVG(const SVG *svg, const SVGVisitor *visitors, int numVisitors) {
+    if(svg == NULL || visitors == NULL || numVisitors < 1) return true;
+    if(numVisitors > MAX_WALK_VISITORS) return false;
+
+    VisitPlan plan;
+    beginVisitPlan(&plan, visitors, numVisitors);
+
+    visitShapes(&plan, svg->rectangles, svg->circles, svg->paths, NULL, 1);
+    return walkPlan(&plan, svg->groups);
+}
+
+/**
+ * @brief visitor that adds each element to the list passed as its context
+ *
+ * @param element
+ * @param list
+ */
+void appendElement(const VisitedElement *element, void *list) {
+    insertBack((List*)list, element->data);
+}
+
+/**
+ * @brief visitor that adds 1 to the int passed as its context for each element
+ *
+ * @param element
+ * @param count
+ */
+void countElement(const VisitedElement *element, void *count) {
+    (void)element;
+    (*(int*)count)++;
+}
+
+/**
+ * @brief returns the other attributes of a visited element
+ *
+ * @param element
+ * @return List*
+ */
+List* otherAttributesOf(const VisitedElement *element) {
+    switch(element->type) {
+        case RECT: return ((Rectangle*)element->data)->otherAttributes;
+        case CIRC: return ((Circle*)element->data)->otherAttributes;
+        case PATH: return ((Path*)element->data)->otherAttributes;
+        case GROUP: return ((Group*)element->data)->otherAttributes;
+        default: return ((SVG*)element->data)->otherAttributes;
+    }
+}
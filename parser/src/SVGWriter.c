@@ -0,0 +1,583 @@
+/**
+ * @file SVGWriter.c
+ * @author Anthony Vidovic (1130891)
+ * @brief Serializes an svg struct straight to a file, without building an xmlDoc first
+ * @version 0.1
+ * @date 2022-04-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+// ~~~~~ Includes ~~~~~ //
+#include "SVGHelper.h"
+
+/*
+ * By default the output matches xmlSaveFormatFileEnc(..., "UTF-8", 1) on the tree built by SVGtoDOC: an XML
+ * declaration, two spaces of indentation per level, and empty elements closed with "/>".  SVGWriteOptions
+ * can drop the indentation, round lengths, and minify the document.
+ */
+#define WRITER_BUFFER_SIZE 65536
+// libxml2 stops indenting deeper than 60 spaces, which also keeps deeply nested output linear in size
+#define MAX_INDENT_DEPTH 30
+
+typedef struct {
+    // Exactly one of fp and gz is set, gz for compressed output
+    FILE *fp;
+    gzFile gz;
+    char buffer[WRITER_BUFFER_SIZE];
+    size_t length;
+    // Uncompressed bytes written so far
+    size_t written;
+    // Set by the first failed write, everything after it is dropped
+    bool failed;
+    // Content hash of the bytes written to a plain file, recorded as its ETag
+    uint64_t hash;
+    bool compact;
+    bool minify;
+    // Digits kept after the decimal point of a length, negative for full precision, as formatFloatFixed takes them
+    int decimals;
+} SVGWriter;
+
+// Attributes of the elements enclosing the one being written, outermost first
+typedef struct {
+    const List **attributes;
+    int depth;
+    int capacity;
+} Scope;
+
+// Presentation attributes whose value can be dropped when minifying.  An inherited attribute is only
+// dropped when no enclosing element sets it, since the default would then replace the inherited value
+static const struct {
+    const char *name;
+    const char *value;
+    bool inherited;
+} defaultAttributes[] = {
+    { "opacity", "1", false },
+    { "fill-opacity", "1", true },
+    { "stroke", "none", true },
+    { "stroke-opacity", "1", true },
+    { "stroke-width", "1", true },
+    { "stroke-linecap", "butt", true },
+    { "stroke-linejoin", "miter", true },
+    { "stroke-miterlimit", "4", true },
+    { "stroke-dasharray", "none", true },
+    { "stroke-dashoffset", "0", true },
+    { "fill-rule", "nonzero", true },
+    { "clip-rule", "nonzero", true },
+    { "visibility", "visible", true },
+};
+
+/**
+ * @brief writes bytes to the file, compressing them for a gzip file
+ *
+ * @param w
+ * @param bytes
+ * @param length
+ */
+static void writeOutput(SVGWriter *w, const char *bytes, size_t length) {
+    if(w->failed || length == 0) return;
+    w->written += length;
+
+    if(w->gz != NULL) {
+        if(gzwrite(w->gz, bytes, length) != (int)length) w->failed = true;
+    } else if(fwrite(bytes, 1, length, w->fp) != length) {
+        w->failed = true;
+    } else {
+        w->hash = updateSVGFileHash(w->hash, bytes, length);
+    }
+}
+
+/**
+ * @brief writes the buffered bytes to the file
+ *
+ * @param w
+ */
+static void flushWriter(SVGWriter *w) {
+    writeOutput(w, w->buffer, w->length);
+    w->length = 0;
+}
+
+/**
+ * @brief appends bytes to the output
+ *
+ * @param w
+ * @param bytes
+ * @param length
+ */
+static void writeBytes(SVGWriter *w, const char *bytes, size_t length) {
+    if(w->length + length > WRITER_BUFFER_SIZE) {
+        flushWriter(w);
+
+        // Anything larger than the buffer goes straight to the file
+        if(length > WRITER_BUFFER_SIZE) {
+            writeOutput(w, bytes, length);
+            return;
+        }
+    }
+
+    memcpy(w->buffer + w->length, bytes, length);
+    w->length += length;
+}
+
+/**
+ * @brief appends a string to the output
+ *
+ * @param w
+ * @param str
+ */
+static void writeString(SVGWriter *w, const char *str) {
+    writeBytes(w, str, strlen(str));
+}
+
+/**
+ * @brief appends bytes to the output with markup characters replaced by references, the way
+ * libxml2 escapes attribute values (isAttribute) or text content
+ *
+ * @param w
+ * @param str
+ * @param length
+ * @param isAttribute
+ */
+static void writeEscapedBytes(SVGWriter *w, const char *str, size_t length, bool isAttribute) {
+    const char *run = str;
+    const char *end = str + length;
+
+    for(const char *c = str; c < end; c++) {
+        const char *ref = NULL;
+
+        switch(*c) {
+            case '<': ref = "&lt;"; break;
+            case '>': ref = "&gt;"; break;
+            case '&': ref = "&amp;"; break;
+            case '\r': ref = "&#13;"; break;
+            case '"': ref = isAttribute ? "&quot;" : NULL; break;
+            case '\n': ref = isAttribute ? "&#10;" : NULL; break;
+            case '\t': ref = isAttribute ? "&#9;" : NULL; break;
+        }
+
+        if(ref != NULL) {
+            writeBytes(w, run, c - run);
+            writeString(w, ref);
+            run = c + 1;
+        }
+    }
+
+    writeBytes(w, run, end - run);
+}
+
+/**
+ * @brief appends a string to the output, escaped as in writeEscapedBytes
+ *
+ * @param w
+ * @param str
+ * @param isAttribute
+ */
+static void writeEscaped(SVGWriter *w, const char *str, bool isAttribute) {
+    writeEscapedBytes(w, str, strlen(str), isAttribute);
+}
+
+/**
+ * @brief starts a line at the given nesting depth
+ *
+ * @param w
+ * @param depth
+ */
+static void writeIndent(SVGWriter *w, int depth) {
+    if(w->compact) return;
+
+    writeBytes(w, "\n", 1);
+    for(int i = 0; i < depth && i < MAX_INDENT_DEPTH; i++) writeBytes(w, "  ", 2);
+}
+
+/**
+ * @brief appends name="value" with the value escaped
+ *
+ * @param w
+ * @param name
+ * @param value
+ */
+static void writeAttribute(SVGWriter *w, const char *name, const char *value) {
+    writeBytes(w, " ", 1);
+    writeString(w, name);
+    writeBytes(w, "=\"", 2);
+    writeEscaped(w, value, true);
+    writeBytes(w, "\"", 1);
+}
+
+/**
+ * @brief appends name="value" for a length, rounded to the writer's precision with the unit appended
+ *
+ * @param w
+ * @param name
+ * @param value
+ * @param units
+ * @param optional true if the attribute defaults to 0, it is dropped when minifying
+ */
+static void writeLength(SVGWriter *w, const char *name, float value, lengthUnit units, bool optional) {
+    char number[FLOAT_STRING_SIZE];
+    int length = formatFloatFixed(value, w->decimals, number);
+    const char *start = number;
+
+    if(w->minify) {
+        if(optional && length == 1 && number[0] == '0') return;
+
+        // 0.5 is written .5
+        if(number[0] == '0' && number[1] == '.') {
+            start++;
+            length--;
+        } else if(number[0] == '-' && number[1] == '0' && number[2] == '.') {
+            number[1] = '-';
+            start++;
+            length--;
+        }
+    }
+
+    writeBytes(w, " ", 1);
+    writeString(w, name);
+    writeBytes(w, "=\"", 2);
+    writeBytes(w, start, length);
+    writeString(w, lengthUnitName(units));
+    writeBytes(w, "\"", 1);
+}
+
+/**
+ * @brief returns true if an enclosing element sets an attribute, or may set it through a style attribute
+ *
+ * @param scope
+ * @param name
+ * @return true
+ * @return false
+ */
+static bool setByAncestor(const Scope *scope, const char *name) {
+    if(scope == NULL) return false;
+
+    for(int i = scope->depth - 1; i >= 0; i--) {
+        for(Node *cur = scope->attributes[i]->head; cur; cur = cur->next) {
+            Attribute *attr = (Attribute*)cur->data;
+            if(strcmp(attr->name, name) == 0 || strcmp(attr->name, "style") == 0) return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief returns true if writing an attribute does not change how the element renders
+ *
+ * @param attr
+ * @param scope attributes of the enclosing elements
+ * @return true
+ * @return false
+ */
+static bool isDefaultAttribute(const Attribute *attr, const Scope *scope) {
+    for(size_t i = 0; i < sizeof(defaultAttributes) / sizeof(defaultAttributes[0]); i++) {
+        if(strcmp(attr->name, defaultAttributes[i].name) != 0) continue;
+
+        // Numeric defaults match any spelling of the number, such as 1.0
+        const char *end;
+        const char *value = defaultAttributes[i].value;
+        bool matches = strcmp(attr->value, value) == 0;
+        if(!matches && isdigit((unsigned char)value[0]))
+            matches = parseFloat(attr->value, &end) == parseFloat(value, NULL) && end != attr->value && *end == '\0';
+
+        return matches && !(defaultAttributes[i].inherited && setByAncestor(scope, attr->name));
+    }
+
+    return false;
+}
+
+/**
+ * @brief appends every attribute in an otherAttributes list
+ *
+ * @param w
+ * @param otherAttributes
+ * @param scope attributes of the enclosing elements
+ */
+static void writeOtherAttributes(SVGWriter *w, const List *otherAttributes, const Scope *scope) {
+    for(Node *cur = otherAttributes->head; cur; cur = cur->next) {
+        Attribute *attr = (Attribute*)cur->data;
+        if(w->minify && isDefaultAttribute(attr, scope)) continue;
+
+        writeAttribute(w, attr->name, attr->value);
+    }
+}
+
+/**
+ * @brief returns true for the letters that start a path command
+ *
+ * @param c
+ * @return true
+ * @return false
+ */
+static bool isPathCommand(char c) {
+    return c != '\0' && strchr("MmZzLlHhVvCcSsQqTtAa", c) != NULL;
+}
+
+/**
+ * @brief appends path data with the whitespace a parser does not need removed: runs are collapsed to one
+ * space, and spaces next to a command, a comma or before a minus sign are dropped
+ *
+ * @param w
+ * @param data
+ */
+static void writeMinifiedPathData(SVGWriter *w, const char *data) {
+    writeBytes(w, " d=\"", 4);
+
+    const char *c = data;
+    while(isspace((unsigned char)*c)) c++;
+
+    while(*c) {
+        // Copy up to the next whitespace
+        const char *run = c;
+        while(*c && !isspace((unsigned char)*c)) c++;
+        writeEscapedBytes(w, run, c - run, true);
+
+        char previous = c[-1];
+        while(isspace((unsigned char)*c)) c++;
+
+        char next = *c;
+        if(next != '\0' && !isPathCommand(previous) && !isPathCommand(next) && previous != ',' && next != ',' && next != '-')
+            writeBytes(w, " ", 1);
+    }
+
+    writeBytes(w, "\"", 1);
+}
+
+/**
+ * @brief adds the attributes of an element to the scope of the elements nested in it
+ *
+ * @param scope
+ * @param attributes
+ * @return true
+ * @return false if the scope cannot grow
+ */
+static bool pushScope(Scope *scope, const List *attributes) {
+    if(scope->depth == scope->capacity) {
+        const List **grown = growStack(scope->attributes, &scope->capacity, sizeof(const List*));
+        if(grown == NULL) return false;
+        scope->attributes = grown;
+    }
+
+    scope->attributes[scope->depth++] = attributes;
+    return true;
+}
+
+/**
+ * @brief writes the shapes of the svg or of a group, one element per line
+ *
+ * @param w
+ * @param rectangles
+ * @param circles
+ * @param paths
+ * @param depth nesting depth of the shapes
+ * @param scope attributes of the svg or group and the elements enclosing it
+ */
+static void writeShapes(SVGWriter *w, const List *rectangles, const List *circles, const List *paths, int depth, const Scope *scope) {
+    for(Node *cur = rectangles->head; cur; cur = cur->next) {
+        Rectangle *rect = (Rectangle*)cur->data;
+
+        writeIndent(w, depth);
+        writeBytes(w, "<rect", 5);
+        writeLength(w, "x", rect->x, rect->units, true);
+        writeLength(w, "y", rect->y, rect->units, true);
+        writeLength(w, "width", rect->width, rect->units, false);
+        writeLength(w, "height", rect->height, rect->units, false);
+        writeOtherAttributes(w, rect->otherAttributes, scope);
+        writeBytes(w, "/>", 2);
+    }
+
+    for(Node *cur = circles->head; cur; cur = cur->next) {
+        Circle *circle = (Circle*)cur->data;
+
+        writeIndent(w, depth);
+        writeBytes(w, "<circle", 7);
+        writeLength(w, "cx", circle->cx, circle->units, true);
+        writeLength(w, "cy", circle->cy, circle->units, true);
+        writeLength(w, "r", circle->r, circle->units, false);
+        writeOtherAttributes(w, circle->otherAttributes, scope);
+        writeBytes(w, "/>", 2);
+    }
+
+    for(Node *cur = paths->head; cur; cur = cur->next) {
+        Path *path = (Path*)cur->data;
+
+        writeIndent(w, depth);
+        writeBytes(w, "<path", 5);
+        if(w->minify) writeMinifiedPathData(w, path->data);
+        else writeAttribute(w, "d", path->data);
+        writeOtherAttributes(w, path->otherAttributes, scope);
+        writeBytes(w, "/>", 2);
+    }
+}
+
+/**
+ * @brief writes the shapes and groups of the svg, one element per line.  Groups are written in document order by
+ * a walk without recursion, and each one is closed once everything nested in it has been written
+ *
+ * @param w
+ * @param svg
+ * @param scope holds the attributes of the svg, and those of each open group while writing
+ */
+static void writeChildren(SVGWriter *w, const SVG *svg, Scope *scope) {
+    writeShapes(w, svg->rectangles, svg->circles, svg->paths, 1, scope);
+
+    GroupWalk walk;
+    beginGroupWalk(&walk, svg->groups);
+
+    // A group is written at the depth of its nesting level, inside the groups still open above it
+    for(Group *group = nextGroup(&walk); group; group = nextGroup(&walk)) {
+        while(scope->depth > walk.depth) {
+            scope->depth--;
+            writeIndent(w, scope->depth);
+            writeBytes(w, "</g>", 4);
+        }
+
+        writeIndent(w, walk.depth);
+        writeBytes(w, "<g", 2);
+        writeOtherAttributes(w, group->otherAttributes, scope);
+
+        if(group->rectangles->length + group->circles->length + group->paths->length + group->groups->length == 0) {
+            writeBytes(w, "/>", 2);
+            continue;
+        }
+
+        writeBytes(w, ">", 1);
+        if(!pushScope(scope, group->otherAttributes)) {
+            w->failed = true;
+            break;
+        }
+        writeShapes(w, group->rectangles, group->circles, group->paths, scope->depth, scope);
+    }
+
+    if(walk.failed) w->failed = true;
+    endGroupWalk(&walk);
+
+    while(scope->depth > 1) {
+        scope->depth--;
+        writeIndent(w, scope->depth);
+        writeBytes(w, "</g>", 4);
+    }
+}
+
+/**
+ * @brief opens the output file of a writer, through zlib if the file is compressed
+ *
+ * @param w
+ * @param fileName
+ * @param options
+ * @return true
+ * @return false if the file cannot be opened
+ */
+static bool openOutput(SVGWriter *w, const char *fileName, const SVGWriteOptions *options) {
+    w->fp = NULL;
+    w->gz = NULL;
+
+    if(!isCompressedFileName(fileName)) {
+        w->fp = fopen(fileName, "wb");
+        return w->fp != NULL;
+    }
+
+    int level = options != NULL ? options->compressionLevel : 0;
+    if(level < 1 || level > 9) level = Z_DEFAULT_COMPRESSION;
+
+    char mode[8];
+    snprintf(mode, sizeof(mode), level == Z_DEFAULT_COMPRESSION ? "wb" : "wb%d", level);
+
+    w->gz = gzopen(fileName, mode);
+    return w->gz != NULL;
+}
+
+/**
+ * @brief closes the output file of a writer, flushing what zlib or stdio still buffers
+ *
+ * @param w
+ * @return true
+ * @return false if the final write failed
+ */
+static bool closeOutput(SVGWriter *w) {
+    if(w->gz != NULL) return gzclose(w->gz) == Z_OK;
+
+    return fclose(w->fp) == 0;
+}
+
+/**
+ * @brief writes an svg struct to a file as an SVG document, gzip compressed if the file name ends in .svgz
+ *
+ * @param svg
+ * @param fileName
+ * @param options NULL for indented, full precision output
+ * @return true
+ * @return false if the file could not be opened or a write failed
+ */
+bool serializeSVG(const SVG *svg, const char *fileName, const SVGWriteOptions *options) {
+    if(svg == NULL || fileName == NULL) return false;
+
+    PhaseTimer start = startPhase();
+    SVGWriter *w = svgMalloc(sizeof(SVGWriter));
+    if(w == NULL) return false;
+
+    if(!openOutput(w, fileName, options)) {
+        svgFree(w);
+        return false;
+    }
+
+    w->length = 0;
+    w->written = 0;
+    w->failed = false;
+    w->hash = SVG_HASH_SEED;
+    w->minify = options != NULL && options->minify;
+    w->compact = w->minify || (options != NULL && options->compact);
+
+    int precision = options != NULL ? options->precision : SVG_FULL_PRECISION;
+    if(precision == SVG_FULL_PRECISION) w->decimals = -1;
+    else w->decimals = precision == SVG_WHOLE_NUMBERS ? 0 : precision;
+
+    // UTF-8 and version 1.0 are what a parser assumes without a declaration
+    if(!w->minify) writeString(w, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+    writeString(w, "<svg");
+    writeAttribute(w, "xmlns", svg->namespace);
+    writeOtherAttributes(w, svg->otherAttributes, NULL);
+
+    bool hasChildren = svg->title[0] != '\0' || svg->description[0] != '\0' || svg->rectangles->length > 0 ||
+                       svg->circles->length > 0 || svg->paths->length > 0 || svg->groups->length > 0;
+
+    if(hasChildren) {
+        writeBytes(w, ">", 1);
+
+        if(svg->title[0] != '\0') {
+            writeIndent(w, 1);
+            writeBytes(w, "<title>", 7);
+            writeEscaped(w, svg->title, false);
+            writeBytes(w, "</title>", 8);
+        }
+
+        if(svg->description[0] != '\0') {
+            writeIndent(w, 1);
+            writeBytes(w, "<desc>", 6);
+            writeEscaped(w, svg->description, false);
+            writeBytes(w, "</desc>", 7);
+        }
+
+        Scope scope = { NULL, 0, 0 };
+        if(pushScope(&scope, svg->otherAttributes)) writeChildren(w, svg, &scope);
+        else w->failed = true;
+        svgFree(scope.attributes);
+
+        writeIndent(w, 0);
+        writeString(w, "</svg>");
+    } else {
+        writeString(w, "/>");
+    }
+    if(!w->minify) writeBytes(w, "\n", 1);
+
+    flushWriter(w);
+    bool written = closeOutput(w) && !w->failed;
+
+    // Compressed files are hashed from disk when their ETag is first asked for
+    if(written && w->gz == NULL) recordSVGFileHash(fileName, w->hash);
+
+    endPhase(STAT_WRITE, &start, w->written, svg->numElements);
+    svgFree(w);
+    return written;
+}
@@ -307,7 +307,17 @@ const populateFileLog = (data) => {
 
 		const svgImg = document.createElement("img");
 		svgImg.classList.add("image");
-		svgImg.src = `/uploads/${svg.filename}`;
+		// A small PNG drawn by the library rather than the whole svg, at twice the width of the image for
+		// high density screens
+		svgImg.src = `/thumbnail/${svg.filename}?w=400&h=400`;
+		// Files the library cannot draw are shown as the svg itself
+		svgImg.addEventListener(
+			"error",
+			() => {
+				svgImg.src = `/uploads/${svg.filename}`;
+			},
+			{ once: true }
+		);
 		a.appendChild(svgImg);
 		td.appendChild(a);
 
@@ -577,8 +587,7 @@ const createNewSVG = async () => {
 		filenameInput == null ||
 		filenameInput.value === undefined ||
 		filenameInput.value == "" ||
-		!filenameInput.value.toLowerCase().endsWith(".svg") ||
-		filenameInput.value.toLowerCase() === ".svg"
+		!/.\.svgz?$/i.test(filenameInput.value)
 	) {
 		showInvalidColour(filenameInput, "Please enter a value");
 		return;